@@ -0,0 +1,151 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+namespace reshadefx
+{
+	/// <summary>
+	/// Appends little-endian values to a buffer. Strings and lists are prefixed with their length.
+	/// </summary>
+	class binary_writer
+	{
+	public:
+		void write(uint32_t value)
+		{
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				_data += static_cast<char>((value >> (i * 8)) & 0xFF);
+			}
+		}
+		void write(uint64_t value)
+		{
+			write(static_cast<uint32_t>(value));
+			write(static_cast<uint32_t>(value >> 32));
+		}
+		void write(float value)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, 4);
+
+			write(bits);
+		}
+		void write(const std::string &value)
+		{
+			write(static_cast<uint32_t>(value.size()));
+
+			_data += value;
+		}
+		void write_raw(const char *data, size_t size)
+		{
+			_data.append(data, size);
+		}
+
+		std::string &data() { return _data; }
+
+	private:
+		std::string _data;
+	};
+
+	/// <summary>
+	/// Reads little-endian values from a buffer, failing instead of reading past its end.
+	/// </summary>
+	class binary_reader
+	{
+	public:
+		binary_reader(const uint8_t *data, size_t size) : _data(data), _size(size) { }
+
+		bool read(uint32_t &value)
+		{
+			if (!available(4))
+			{
+				return false;
+			}
+
+			value = static_cast<uint32_t>(_data[_offset]) | (static_cast<uint32_t>(_data[_offset + 1]) << 8) | (static_cast<uint32_t>(_data[_offset + 2]) << 16) | (static_cast<uint32_t>(_data[_offset + 3]) << 24);
+			_offset += 4;
+
+			return true;
+		}
+		bool read(uint64_t &value)
+		{
+			uint32_t low, high;
+
+			if (!read(low) || !read(high))
+			{
+				return false;
+			}
+
+			value = (static_cast<uint64_t>(high) << 32) | low;
+
+			return true;
+		}
+		bool read(float &value)
+		{
+			uint32_t bits;
+
+			if (!read(bits))
+			{
+				return false;
+			}
+
+			std::memcpy(&value, &bits, 4);
+
+			return true;
+		}
+		bool read(std::string &value)
+		{
+			uint32_t length;
+
+			if (!read(length) || !available(length))
+			{
+				return false;
+			}
+
+			value.assign(reinterpret_cast<const char *>(_data + _offset), length);
+			_offset += length;
+
+			return true;
+		}
+		/// <summary>
+		/// Read the length of a list and check that the remaining data can hold that many elements of the specified minimum size, so that a corrupted length cannot cause a huge allocation.
+		/// </summary>
+		bool read_count(uint32_t &count, size_t min_element_size)
+		{
+			return read(count) && count <= (_size - _offset) / min_element_size;
+		}
+		/// <summary>
+		/// Compare the next bytes with the specified ones and skip them if they match.
+		/// </summary>
+		bool expect(const char *data, size_t size)
+		{
+			if (!available(size) || std::memcmp(_data + _offset, data, size) != 0)
+			{
+				return false;
+			}
+
+			_offset += size;
+
+			return true;
+		}
+
+		bool available(size_t length) const
+		{
+			return length <= _size - _offset;
+		}
+		bool at_end() const
+		{
+			return _offset == _size;
+		}
+
+	private:
+		const uint8_t *_data;
+		size_t _size, _offset = 0;
+	};
+}
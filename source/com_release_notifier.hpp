@@ -0,0 +1,161 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <Unknwn.h>
+
+/// <summary>
+/// A COM object that invokes callbacks when it is destroyed. Attached to a resource as private data it is released together with that resource,
+/// which makes it possible to observe the destruction of objects whose reference counting is not hooked.
+/// </summary>
+class com_release_notifier : public IUnknown
+{
+public:
+	/// <summary>
+	/// The private data GUID notifiers are stored with.
+	/// </summary>
+	static REFGUID guid()
+	{
+		// {8F7A2D3C-51E6-4C4B-9B0E-2E7D3A4C6F10}
+		static const GUID s_guid = { 0x8f7a2d3c, 0x51e6, 0x4c4b, { 0x9b, 0x0e, 0x2e, 0x7d, 0x3a, 0x4c, 0x6f, 0x10 } };
+		return s_guid;
+	}
+
+	/// <summary>
+	/// Create a new notifier without any callbacks. The caller owns the initial reference.
+	/// </summary>
+	static com_release_notifier *create()
+	{
+		return new com_release_notifier();
+	}
+	/// <summary>
+	/// Register a callback with the notifier attached to a D3D10 or D3D11 object, attaching a new notifier first if there is none yet.
+	/// </summary>
+	/// <param name="object">The device child to observe.</param>
+	/// <param name="owner">Identifies the callback, a later registration with the same owner replaces it.</param>
+	/// <param name="callback">The function to call when the object is destroyed.</param>
+	template <typename T>
+	static bool attach(T *object, const void *owner, std::function<void()> callback)
+	{
+		return attach(owner, std::move(callback),
+			[object](IUnknown **existing) {
+				UINT size = sizeof(*existing);
+				return object->GetPrivateData(guid(), &size, existing);
+			},
+			[object](IUnknown *notifier) {
+				return object->SetPrivateDataInterface(guid(), notifier);
+			});
+	}
+#ifdef _d3d9_H_
+	/// <summary>
+	/// Register a callback with the notifier attached to a D3D9 surface, attaching a new notifier first if there is none yet.
+	/// </summary>
+	static bool attach(IDirect3DSurface9 *surface, const void *owner, std::function<void()> callback)
+	{
+		return attach(owner, std::move(callback),
+			[surface](IUnknown **existing) {
+				DWORD size = sizeof(*existing);
+				return surface->GetPrivateData(guid(), existing, &size);
+			},
+			[surface](IUnknown *notifier) {
+				return surface->SetPrivateData(guid(), notifier, sizeof(IUnknown *), D3DSPD_IUNKNOWN);
+			});
+	}
+#endif
+
+	/// <summary>
+	/// Register a callback, replacing the one previously registered by the same owner.
+	/// </summary>
+	void set_callback(const void *owner, std::function<void()> callback)
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+
+		for (auto &it : _callbacks)
+		{
+			if (it.first == owner)
+			{
+				it.second = std::move(callback);
+				return;
+			}
+		}
+
+		_callbacks.emplace_back(owner, std::move(callback));
+	}
+
+	HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppvObj) override
+	{
+		if (ppvObj == nullptr)
+		{
+			return E_POINTER;
+		}
+
+		if (riid == __uuidof(IUnknown))
+		{
+			AddRef();
+			*ppvObj = this;
+			return S_OK;
+		}
+
+		*ppvObj = nullptr;
+		return E_NOINTERFACE;
+	}
+	ULONG STDMETHODCALLTYPE AddRef() override
+	{
+		return InterlockedIncrement(&_ref);
+	}
+	ULONG STDMETHODCALLTYPE Release() override
+	{
+		const ULONG ref = InterlockedDecrement(&_ref);
+
+		if (ref == 0)
+		{
+			for (const auto &it : _callbacks)
+			{
+				it.second();
+			}
+
+			delete this;
+		}
+
+		return ref;
+	}
+
+private:
+	com_release_notifier() = default;
+	~com_release_notifier() = default;
+
+	template <typename G, typename S>
+	static bool attach(const void *owner, std::function<void()> callback, G get_private_data, S set_private_data)
+	{
+		IUnknown *existing = nullptr;
+
+		if (SUCCEEDED(get_private_data(&existing)) && existing != nullptr)
+		{
+			static_cast<com_release_notifier *>(existing)->set_callback(owner, std::move(callback));
+			existing->Release();
+
+			return true;
+		}
+
+		const auto notifier = create();
+		notifier->set_callback(owner, std::move(callback));
+
+		const bool success = SUCCEEDED(set_private_data(notifier));
+
+		// The object holds the only reference from now on
+		notifier->Release();
+
+		return success;
+	}
+
+	LONG _ref = 1;
+	std::mutex _mutex;
+	std::vector<std::pair<const void *, std::function<void()>>> _callbacks;
+};
@@ -6,6 +6,8 @@
 #include "syntax_tree.hpp"
 #include "constant_folding.hpp"
 
+#include <cmath>
+#include <cstring>
 #include <algorithm>
 
 namespace reshadefx
@@ -5,6 +5,9 @@
 
 #include "d3d10_runtime.hpp"
 #include "d3d10_effect_compiler.hpp"
+#include "optimizer.hpp"
+#include "log.hpp"
+#include <set>
 #include <assert.h>
 #include <iomanip>
 #include <algorithm>
@@ -15,10 +18,6 @@ namespace reshade::d3d10
 	using namespace reshadefx;
 	using namespace reshadefx::nodes;
 
-	static inline size_t roundto16(size_t size)
-	{
-		return (size + 15) & ~15;
-	}
 	static D3D10_BLEND literal_to_blend_func(unsigned int value)
 	{
 		switch (value)
@@ -184,11 +183,19 @@ namespace reshade::d3d10
 			return false;
 		}
 
-		_uniform_storage_offset = _runtime->get_uniform_value_storage().size();
+		// The reflection lays out all uniforms up front, so that the storage for them is allocated in one go
+		_reflection = reshadefx::reflect(_ast, uniform_layout::rules::hlsl_cbuffer);
+
+		_constant_buffer_size = _reflection.uniform_block_size;
+		_uniform_storage_offset = _runtime->allocate_uniform_storage(_constant_buffer_size);
 
 		for (auto node : _ast.structs)
 		{
-			visit(_global_code, node);
+			std::stringstream struct_code;
+
+			visit(struct_code, node);
+
+			_struct_code[node] = struct_code.str();
 		}
 		for (auto uniform : _ast.variables)
 		{
@@ -206,14 +213,22 @@ namespace reshade::d3d10
 			}
 			else
 			{
-				visit(_global_code, uniform);
+				std::stringstream variable_code;
 
-				_global_code << ";\n";
+				visit(variable_code, uniform);
+
+				variable_code << ";\n";
+
+				_variable_code[uniform] = variable_code.str();
 			}
 		}
 		for (auto function : _ast.functions)
 		{
-			visit(_global_code, function);
+			std::stringstream function_code;
+
+			visit(function_code, function);
+
+			_function_code[function] = function_code.str();
 		}
 		for (auto technique : _ast.techniques)
 		{
@@ -222,11 +237,8 @@ namespace reshade::d3d10
 
 		if (_constant_buffer_size != 0)
 		{
-			_constant_buffer_size = roundto16(_constant_buffer_size);
-			_runtime->get_uniform_value_storage().resize(_uniform_storage_offset + _constant_buffer_size);
-
 			const CD3D10_BUFFER_DESC globals_desc(static_cast<UINT>(_constant_buffer_size), D3D10_BIND_CONSTANT_BUFFER, D3D10_USAGE_DYNAMIC, D3D10_CPU_ACCESS_WRITE);
-			const D3D10_SUBRESOURCE_DATA globals_initial = { _runtime->get_uniform_value_storage().data(), static_cast<UINT>(_constant_buffer_size) };
+			const D3D10_SUBRESOURCE_DATA globals_initial = { _runtime->get_uniform_value_storage().data() + _uniform_storage_offset, static_cast<UINT>(_constant_buffer_size) };
 
 			com_ptr<ID3D10Buffer> constant_buffer;
 			_runtime->_device->CreateBuffer(&globals_desc, &globals_initial, &constant_buffer);
@@ -236,6 +248,9 @@ namespace reshade::d3d10
 
 		FreeLibrary(_d3dcompiler_module);
 
+		LOG(INFO) << "> Generated " << _emitted_code_size << " bytes of shader code after leaving out " << _unreachable_code_size << " bytes unreachable from the entry points and spent "
+		          << std::chrono::duration_cast<std::chrono::milliseconds>(_compile_time).count() << " ms in D3DCompile.";
+
 		return _success;
 	}
 
@@ -1456,16 +1471,18 @@ namespace reshade::d3d10
 
 	void d3d10_effect_compiler::visit_texture(const variable_declaration_node *node)
 	{
+		const auto &info = _reflection.textures[_texture_index++];
+
 		texture obj;
 		D3D10_TEXTURE2D_DESC texdesc = { };
-		obj.name = node->name;
-		obj.unique_name = node->unique_name;
-		obj.annotations = node->annotation_list;
-		texdesc.Width = obj.width = node->properties.width;
-		texdesc.Height = obj.height = node->properties.height;
-		texdesc.MipLevels = obj.levels = node->properties.levels;
+		obj.name = info.name;
+		obj.unique_name = info.unique_name;
+		obj.annotations = info.annotations;
+		texdesc.Width = obj.width = info.width;
+		texdesc.Height = obj.height = info.height;
+		texdesc.MipLevels = obj.levels = info.levels;
 		texdesc.ArraySize = 1;
-		texdesc.Format = literal_to_format(obj.format = node->properties.format);
+		texdesc.Format = literal_to_format(obj.format = info.format);
 		texdesc.SampleDesc.Count = 1;
 		texdesc.SampleDesc.Quality = 0;
 		texdesc.Usage = D3D10_USAGE_DEFAULT;
@@ -1474,7 +1491,7 @@ namespace reshade::d3d10
 
 		size_t texture_register_index, texture_register_index_srgb;
 
-		if (node->semantic == "COLOR" || node->semantic == "SV_TARGET")
+		if (info.reference == texture_reference::back_buffer)
 		{
 			obj.width = _runtime->frame_width();
 			obj.height = _runtime->frame_height();
@@ -1483,7 +1500,7 @@ namespace reshade::d3d10
 			texture_register_index = 0;
 			texture_register_index_srgb = 1;
 		}
-		else if (node->semantic == "DEPTH" || node->semantic == "SV_DEPTH")
+		else if (info.reference == texture_reference::depth_buffer)
 		{
 			obj.width = _runtime->frame_width();
 			obj.height = _runtime->frame_height();
@@ -1542,40 +1559,39 @@ namespace reshade::d3d10
 			}
 		}
 
-		_global_code << "Texture2D " <<
-			node->unique_name << " : register(t" << texture_register_index << "), __" <<
-			node->unique_name << "SRGB : register(t" << texture_register_index_srgb << ");\n";
+		// The declaration is emitted per pass, so that each pass gets its own compact register assignment
+		_texture_bindings[node] = std::make_pair(texture_register_index, texture_register_index_srgb);
 
 		_runtime->add_texture(std::move(obj));
 	}
 	void d3d10_effect_compiler::visit_sampler(const variable_declaration_node *node)
 	{
+		const auto &info = _reflection.samplers[_sampler_index++];
+
+		_sampler_variables.push_back(node);
+
 		D3D10_SAMPLER_DESC desc = { };
-		desc.Filter = static_cast<D3D10_FILTER>(node->properties.filter);
-		desc.AddressU = static_cast<D3D10_TEXTURE_ADDRESS_MODE>(node->properties.address_u);
-		desc.AddressV = static_cast<D3D10_TEXTURE_ADDRESS_MODE>(node->properties.address_v);
-		desc.AddressW = static_cast<D3D10_TEXTURE_ADDRESS_MODE>(node->properties.address_w);
-		desc.MipLODBias = node->properties.lod_bias;
+		desc.Filter = static_cast<D3D10_FILTER>(info.filter);
+		desc.AddressU = static_cast<D3D10_TEXTURE_ADDRESS_MODE>(info.address_u);
+		desc.AddressV = static_cast<D3D10_TEXTURE_ADDRESS_MODE>(info.address_v);
+		desc.AddressW = static_cast<D3D10_TEXTURE_ADDRESS_MODE>(info.address_w);
+		desc.MipLODBias = info.lod_bias;
 		desc.MaxAnisotropy = 1;
 		desc.ComparisonFunc = D3D10_COMPARISON_NEVER;
-		desc.MinLOD = node->properties.min_lod;
-		desc.MaxLOD = node->properties.max_lod;
+		desc.MinLOD = info.min_lod;
+		desc.MaxLOD = info.max_lod;
 
-		const auto texture = _runtime->find_texture(node->properties.texture->name);
+		const auto &texture_info = _reflection.textures[info.texture];
 
-		if (texture == nullptr)
+		if (_runtime->find_texture(texture_info.name) == nullptr)
 		{
-			error(node->location, "texture '" + node->properties.texture->name + "' for sampler '" + node->name + "' is missing due to previous error");
+			error(node->location, "texture '" + texture_info.name + "' for sampler '" + info.name + "' is missing due to previous error");
 			return;
 		}
 
-		size_t desc_hash = 2166136261;
-		for (size_t i = 0; i < sizeof(desc); ++i)
-			desc_hash = (desc_hash * 16777619) ^ reinterpret_cast<const uint8_t *>(&desc)[i];
-
-		auto it = _runtime->_effect_sampler_descs.find(desc_hash);
+		auto sampler_index = _runtime->_effect_sampler_descs.find(desc);
 
-		if (it == _runtime->_effect_sampler_descs.end())
+		if (sampler_index == nullptr)
 		{
 			ID3D10SamplerState *sampler = nullptr;
 
@@ -1588,21 +1604,26 @@ namespace reshade::d3d10
 			}
 
 			_runtime->_effect_sampler_states.push_back(sampler);
-			it = _runtime->_effect_sampler_descs.emplace(desc_hash, _runtime->_effect_sampler_states.size() - 1).first;
+			sampler_index = &_runtime->_effect_sampler_descs.insert(desc, _runtime->_effect_sampler_states.size() - 1);
 		}
 
-		_global_code << "static const __sampler2D " << node->unique_name << " = { ";
+		std::stringstream sampler_code;
 
-		if (node->properties.srgb_texture)
+		sampler_code << "static const __sampler2D " << node->unique_name << " = { ";
+
+		if (info.srgb)
 		{
-			_global_code << "__" << node->properties.texture->unique_name << "SRGB";
+			sampler_code << "__" << texture_info.unique_name << "SRGB";
 		}
 		else
 		{
-			_global_code << node->properties.texture->unique_name;
+			sampler_code << texture_info.unique_name;
 		}
 
-		_global_code << ", __SamplerState" << it->second << " };\n";
+		sampler_code << ", __SamplerState" << *sampler_index << " };\n";
+
+		_variable_code[node] = sampler_code.str();
+		_sampler_states[node] = *sampler_index;
 	}
 	void d3d10_effect_compiler::visit_uniform(const variable_declaration_node *node)
 	{
@@ -1624,43 +1645,15 @@ namespace reshade::d3d10
 
 		_global_uniforms << ";\n";
 
-		uniform obj;
-		obj.name = node->name;
-		obj.unique_name = node->unique_name;
-		obj.basetype = obj.displaytype = static_cast<uniform_datatype>(node->type.basetype - 1);
-		obj.rows = node->type.rows;
-		obj.columns = node->type.cols;
-		obj.elements = node->type.array_length;
-		obj.storage_size = node->type.rows * node->type.cols * std::max(1u, obj.elements) * 4;
-		obj.annotations = node->annotation_list;
-
-		const UINT alignment = 16 - (_constant_buffer_size % 16);
-		_constant_buffer_size += static_cast<UINT>((obj.storage_size > alignment && (alignment != 16 || obj.storage_size <= 16)) ? obj.storage_size + alignment : obj.storage_size);
-		obj.storage_offset = _uniform_storage_offset + _constant_buffer_size - obj.storage_size;
-
-		auto &uniform_storage = _runtime->get_uniform_value_storage();
-
-		if (_uniform_storage_offset + _constant_buffer_size >= uniform_storage.size())
-		{
-			uniform_storage.resize(uniform_storage.size() + 128);
-		}
-
-		if (node->initializer_expression != nullptr && node->initializer_expression->id == nodeid::literal_expression)
-		{
-			CopyMemory(uniform_storage.data() + obj.storage_offset, &static_cast<const literal_expression_node *>(node->initializer_expression)->value_float, obj.storage_size);
-		}
-		else
-		{
-			ZeroMemory(uniform_storage.data() + obj.storage_offset, obj.storage_size);
-		}
-
-		_runtime->add_uniform(std::move(obj));
+		_runtime->add_uniform(_reflection.uniforms[_uniform_index++], _uniform_storage_offset);
 	}
 	void d3d10_effect_compiler::visit_technique(const technique_declaration_node *node)
 	{
+		const auto &info = _reflection.techniques[_technique_index++];
+
 		technique obj;
-		obj.name = node->name;
-		obj.annotations = node->annotation_list;
+		obj.name = info.name;
+		obj.annotations = info.annotations;
 
 		if (_constant_buffer_size != 0)
 		{
@@ -1668,15 +1661,17 @@ namespace reshade::d3d10
 			obj.uniform_storage_offset = _uniform_storage_offset;
 		}
 
-		for (auto pass : node->pass_list)
+		for (size_t i = 0; i < node->pass_list.size(); i++)
 		{
 			obj.passes.emplace_back(std::make_unique<d3d10_pass_data>());
-			visit_pass(pass, *static_cast<d3d10_pass_data *>(obj.passes.back().get()));
+			visit_pass(node->pass_list[i], info.passes[i], *static_cast<d3d10_pass_data *>(obj.passes.back().get()));
+
+			obj.resource_bindings += static_cast<unsigned int>(obj.passes.back()->as<d3d10_pass_data>()->shader_resources.size());
 		}
 
 		_runtime->add_technique(std::move(obj));
 	}
-	void d3d10_effect_compiler::visit_pass(const pass_declaration_node *node, d3d10_pass_data &pass)
+	void d3d10_effect_compiler::visit_pass(const pass_declaration_node *node, const reshadefx::pass_info &info, d3d10_pass_data &pass)
 	{
 		pass.stencil_reference = 0;
 		pass.viewport.TopLeftX = pass.viewport.TopLeftY = pass.viewport.Width = pass.viewport.Height = 0;
@@ -1685,7 +1680,35 @@ namespace reshade::d3d10
 		pass.clear_render_targets = node->clear_render_targets;
 		ZeroMemory(pass.render_targets, sizeof(pass.render_targets));
 		ZeroMemory(pass.render_target_resources, sizeof(pass.render_target_resources));
-		pass.shader_resources = _runtime->_effect_shader_resources;
+		pass.shader_resources.clear();
+		pass.depth_texture_binding = UINT_MAX;
+
+		// Only bind the textures this pass actually samples from, packed into the lowest registers. The reflection lists the samplers in declaration order.
+		_pass_texture_registers.clear();
+
+		for (const size_t sampler : info.samplers)
+		{
+			const auto variable = _sampler_variables[sampler];
+			const auto binding = _texture_bindings.find(variable->properties.texture);
+
+			if (binding == _texture_bindings.end())
+			{
+				continue;
+			}
+
+			const size_t index = variable->properties.srgb_texture ? binding->second.second : binding->second.first;
+			const UINT texture_register = static_cast<UINT>(pass.shader_resources.size());
+
+			if (_pass_texture_registers.emplace(index, texture_register).second)
+			{
+				if (index == 2)
+				{
+					pass.depth_texture_binding = texture_register;
+				}
+
+				pass.shader_resources.push_back(_runtime->_effect_shader_resources[index]);
+			}
+		}
 
 		if (node->vertex_shader != nullptr)
 		{
@@ -1768,11 +1791,23 @@ namespace reshade::d3d10
 		ddesc.FrontFace.StencilDepthFailOp = ddesc.BackFace.StencilDepthFailOp = literal_to_stencil_op(node->stencil_op_depth_fail);
 		pass.stencil_reference = node->stencil_reference_value;
 
-		HRESULT hr = _runtime->_device->CreateDepthStencilState(&ddesc, &pass.depth_stencil_state);
-
-		if (FAILED(hr))
+		// Passes with equal states share the state objects that were created for the first of them
+		if (const auto depth_stencil_state = _runtime->_effect_depth_stencil_states.find(ddesc))
+		{
+			pass.depth_stencil_state = *depth_stencil_state;
+		}
+		else
 		{
-			warning(node->location, "'ID3D10Device::CreateDepthStencilState' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+			const HRESULT hr = _runtime->_device->CreateDepthStencilState(&ddesc, &pass.depth_stencil_state);
+
+			if (SUCCEEDED(hr))
+			{
+				_runtime->_effect_depth_stencil_states.insert(ddesc, pass.depth_stencil_state);
+			}
+			else
+			{
+				warning(node->location, "'ID3D10Device::CreateDepthStencilState' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+			}
 		}
 
 		D3D10_BLEND_DESC bdesc = { };
@@ -1790,11 +1825,22 @@ namespace reshade::d3d10
 			bdesc.BlendEnable[i] = bdesc.BlendEnable[0];
 		}
 
-		hr = _runtime->_device->CreateBlendState(&bdesc, &pass.blend_state);
-
-		if (FAILED(hr))
+		if (const auto blend_state = _runtime->_effect_blend_states.find(bdesc))
+		{
+			pass.blend_state = *blend_state;
+		}
+		else
 		{
-			warning(node->location, "'ID3D10Device::CreateBlendState' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+			const HRESULT hr = _runtime->_device->CreateBlendState(&bdesc, &pass.blend_state);
+
+			if (SUCCEEDED(hr))
+			{
+				_runtime->_effect_blend_states.insert(bdesc, pass.blend_state);
+			}
+			else
+			{
+				warning(node->location, "'ID3D10Device::CreateBlendState' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+			}
 		}
 
 		for (auto &srv : pass.shader_resources)
@@ -1888,44 +1934,192 @@ namespace reshade::d3d10
 			"inline float4 __tex2Dgather3(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).a, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).a, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).a, s.t.SampleLevel(s.s, c, 0).a); }\n"
 			"inline float4 __tex2Dgather3offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).a, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).a, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).a, s.t.SampleLevel(s.s, c, 0, offset).a); }\n";
 
-		source += "cbuffer __GLOBAL__ : register(b0)\n{\n" + _global_uniforms.str() + "};\n";
+		// Only the global variables and functions the entry point can reach are emitted, so that the compiler does not parse and optimize the rest of the effect again for every shader
+		// Declarations are limited to what that code references as well, so that a shader which does not depend on the rest of its effect is generated the same in every effect and can share one shader object
+		std::unordered_set<const variable_declaration_node *> variables;
+		std::unordered_set<const function_declaration_node *> functions;
+		find_references(node, variables, functions);
+
+		std::string code;
+
+		for (auto variable : _ast.variables)
+		{
+			const auto variable_code = _variable_code.find(variable);
+
+			if (variable_code == _variable_code.end())
+			{
+				continue;
+			}
+
+			if (variables.count(variable) != 0)
+			{
+				code += variable_code->second;
+			}
+			else
+			{
+				_unreachable_code_size += variable_code->second.size();
+			}
+		}
+		for (auto function : _ast.functions)
+		{
+			const auto &function_code = _function_code.at(function);
+
+			if (functions.count(function) != 0)
+			{
+				code += function_code;
+			}
+			else
+			{
+				_unreachable_code_size += function_code.size();
+			}
+		}
+
+		// Structures are found by name, going backwards so that those used in the fields of a later one are included too
+		std::string structs;
+
+		for (auto it = _ast.structs.rbegin(); it != _ast.structs.rend(); ++it)
+		{
+			const auto &struct_code = _struct_code.at(*it);
+
+			if (code.find((*it)->unique_name) != std::string::npos || structs.find((*it)->unique_name) != std::string::npos)
+			{
+				structs.insert(0, struct_code);
+			}
+			else
+			{
+				_unreachable_code_size += struct_code.size();
+			}
+		}
+
+		bool references_uniforms = false;
+		std::set<size_t> sampler_states;
+
+		for (auto variable : variables)
+		{
+			if (variable->type.is_sampler())
+			{
+				const auto sampler_state = _sampler_states.find(variable);
+
+				if (sampler_state != _sampler_states.end())
+				{
+					sampler_states.insert(sampler_state->second);
+				}
+			}
+			else if (!variable->type.is_texture() && variable->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				references_uniforms = true;
+			}
+		}
+
+		if (references_uniforms)
+		{
+			source += "cbuffer __GLOBAL__ : register(b0)\n{\n" + _global_uniforms.str() + "};\n";
+		}
+
+		for (auto index : sampler_states)
+		{
+			source += "SamplerState __SamplerState" + std::to_string(index) + " : register(s" + std::to_string(index) + ");\n";
+		}
 
-		for (const auto &samplerdesc : _runtime->_effect_sampler_descs)
+		for (auto variable : _ast.variables)
 		{
-			source += "SamplerState __SamplerState" + std::to_string(samplerdesc.second) + " : register(s" + std::to_string(samplerdesc.second) + ");\n";
+			const auto binding = _texture_bindings.find(variable);
+
+			if (binding == _texture_bindings.end() || variables.count(variable) == 0)
+			{
+				continue;
+			}
+
+			// Textures this pass does not sample from get no register, the compiler removes them together with the code that references them
+			const auto declare = [this, &source](const std::string &name, size_t index) {
+				source += name;
+
+				const auto texture_register = _pass_texture_registers.find(index);
+
+				if (texture_register != _pass_texture_registers.end())
+				{
+					source += " : register(t" + std::to_string(texture_register->second) + ")";
+				}
+			};
+
+			source += "Texture2D ";
+			declare(variable->unique_name, binding->second.first);
+			source += ", ";
+			declare("__" + variable->unique_name + "SRGB", binding->second.second);
+			source += ";\n";
 		}
 
-		source += _global_code.str();
+		source += structs;
+		source += code;
+
+		_emitted_code_size += source.size();
 
 		UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
-		com_ptr<ID3DBlob> compiled, errors;
 
 		if (_skip_shader_optimization)
 		{
 			flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 		}
 
-		const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
-		HRESULT hr = D3DCompile(source.c_str(), source.length(), nullptr, nullptr, nullptr, node->unique_name.c_str(), profile.c_str(), flags, 0, &compiled, &errors);
+		const std::string options = profile + ' ' + std::to_string(flags);
+		const std::string object_key = make_shader_object_key(source, node->unique_name, options);
+		shader_cache::compiled_shader compiled;
 
-		if (errors != nullptr)
+		// Passes that generate the same source share the shader object that was created for the first of them
+		if (shadertype == "vs" ? _runtime->_vertex_shader_cache.find(object_key, pass.vertex_shader, compiled.messages) : _runtime->_pixel_shader_cache.find(object_key, pass.pixel_shader, compiled.messages))
 		{
-			_errors.append(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
+			_errors += compiled.messages;
+			return;
 		}
 
-		if (FAILED(hr))
+		if (!_runtime->_shader_cache.find(source, node->unique_name, options, compiled))
 		{
-			error(node->location, "internal shader compilation failed");
-			return;
+			com_ptr<ID3DBlob> bytecode, errors;
+
+			const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
+			const auto compile_start = std::chrono::high_resolution_clock::now();
+			const HRESULT hr = D3DCompile(source.c_str(), source.length(), nullptr, nullptr, nullptr, node->unique_name.c_str(), profile.c_str(), flags, 0, &bytecode, &errors);
+			_compile_time += std::chrono::high_resolution_clock::now() - compile_start;
+
+			if (shadertype == "vs")
+			{
+				_runtime->_vertex_shader_cache.count_compilation();
+			}
+			else
+			{
+				_runtime->_pixel_shader_cache.count_compilation();
+			}
+
+			if (errors != nullptr)
+			{
+				compiled.messages.assign(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
+			}
+
+			if (FAILED(hr))
+			{
+				_errors += compiled.messages;
+
+				error(node->location, "internal shader compilation failed");
+				return;
+			}
+
+			compiled.bytecode.assign(static_cast<const char *>(bytecode->GetBufferPointer()), bytecode->GetBufferSize());
+
+			_runtime->_shader_cache.insert(source, node->unique_name, options, compiled);
 		}
 
+		// Warnings are reported again when the shader is taken from the cache
+		_errors += compiled.messages;
+
+		HRESULT hr = S_OK;
+
 		if (shadertype == "vs")
 		{
-			hr = _runtime->_device->CreateVertexShader(compiled->GetBufferPointer(), compiled->GetBufferSize(), &pass.vertex_shader);
+			hr = _runtime->_device->CreateVertexShader(compiled.bytecode.data(), compiled.bytecode.size(), &pass.vertex_shader);
 		}
 		else if (shadertype == "ps")
 		{
-			hr = _runtime->_device->CreatePixelShader(compiled->GetBufferPointer(), compiled->GetBufferSize(), &pass.pixel_shader);
+			hr = _runtime->_device->CreatePixelShader(compiled.bytecode.data(), compiled.bytecode.size(), &pass.pixel_shader);
 		}
 
 		if (FAILED(hr))
@@ -1933,5 +2127,14 @@ namespace reshade::d3d10
 			error(node->location, "'CreateShader' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
 			return;
 		}
+
+		if (shadertype == "vs")
+		{
+			_runtime->_vertex_shader_cache.insert(object_key, pass.vertex_shader, compiled.messages);
+		}
+		else
+		{
+			_runtime->_pixel_shader_cache.insert(object_key, pass.pixel_shader, compiled.messages);
+		}
 	}
 }
@@ -5,8 +5,10 @@
 
 #pragma once
 
+#include <chrono>
 #include <sstream>
 #include "syntax_tree.hpp"
+#include "effect_reflection.hpp"
 
 namespace reshade::d3d10
 {
@@ -60,16 +62,26 @@ namespace reshade::d3d10
 		void visit_sampler(const reshadefx::nodes::variable_declaration_node *node);
 		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node);
 		void visit_technique(const reshadefx::nodes::technique_declaration_node *node);
-		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, d3d10_pass_data &pass);
+		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, const reshadefx::pass_info &info, d3d10_pass_data &pass);
 		void visit_pass_shader(const reshadefx::nodes::function_declaration_node *node, const std::string &shadertype, d3d10_pass_data &pass);
 
 		d3d10_runtime *_runtime;
 		bool _success = true;
 		const reshadefx::syntax_tree &_ast;
 		std::string &_errors;
-		std::stringstream _global_code, _global_uniforms;
+		std::stringstream _global_uniforms;
+		std::unordered_map<const reshadefx::nodes::struct_declaration_node *, std::string> _struct_code;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, std::string> _variable_code;
+		std::unordered_map<const reshadefx::nodes::function_declaration_node *, std::string> _function_code;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, size_t> _sampler_states;
+		size_t _emitted_code_size = 0, _unreachable_code_size = 0;
+		std::chrono::high_resolution_clock::duration _compile_time = std::chrono::high_resolution_clock::duration::zero();
 		bool _skip_shader_optimization, _is_in_parameter_block = false, _is_in_function_block = false;
-		size_t _uniform_storage_offset = 0, _constant_buffer_size = 0;
+		size_t _uniform_storage_offset = 0, _constant_buffer_size = 0, _uniform_index = 0, _texture_index = 0, _sampler_index = 0, _technique_index = 0;
+		reshadefx::effect_reflection _reflection;
+		std::vector<const reshadefx::nodes::variable_declaration_node *> _sampler_variables;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, std::pair<size_t, size_t>> _texture_bindings;
+		std::unordered_map<size_t, UINT> _pass_texture_registers;
 		HMODULE _d3dcompiler_module = nullptr;
 	};
 }
@@ -9,6 +9,7 @@
 #include "lexer.hpp"
 #include "input.hpp"
 #include "resource_loading.hpp"
+#include "com_release_notifier.hpp"
 #include "..\deps\imgui\imgui.h"
 #include <algorithm>
 
@@ -428,6 +429,8 @@ namespace reshade::d3d10
 		_is_multisampling_enabled = desc.SampleDesc.Count > 1;
 		//_input = input::register_window(desc.OutputWindow);
 
+		_depth_source_tracker.on_resize(_width, _height);
+
 		if (!init_backbuffer_texture() ||
 			!init_default_depth_stencil() ||
 			!init_fx_resources() ||
@@ -462,6 +465,7 @@ namespace reshade::d3d10
 		_depthstencil_replacement.reset();
 		_depthstencil_texture.reset();
 		_depthstencil_texture_srv.reset();
+		_depth_source_tracker.reset();
 
 		_default_depthstencil.reset();
 		_copy_vertex_shader.reset();
@@ -494,12 +498,27 @@ namespace reshade::d3d10
 
 		_effect_sampler_descs.clear();
 		_effect_sampler_states.clear();
+		_effect_blend_states.clear();
+		_effect_depth_stencil_states.clear();
 		_constant_buffers.clear();
 
+		_vertex_shader_cache.clear();
+		_pixel_shader_cache.clear();
+
 		_effect_shader_resources.resize(3);
 		_effect_shader_resources[0] = _backbuffer_texture_srv[0].get();
 		_effect_shader_resources[1] = _backbuffer_texture_srv[1].get();
 		_effect_shader_resources[2] = _depthstencil_texture_srv.get();
+
+		// Without effects only a single texture is copied to the back buffer and the overlay is drawn
+		_stateblock.set_used_slots(1, 1, 1, 1);
+	}
+	shader_object_statistics d3d10_runtime::get_shader_statistics() const
+	{
+		auto statistics = _vertex_shader_cache.statistics();
+		statistics += _pixel_shader_cache.statistics();
+
+		return statistics;
 	}
 	void d3d10_runtime::on_present()
 	{
@@ -593,17 +612,11 @@ namespace reshade::d3d10
 			current_depthstencil = _depthstencil;
 		}
 
-		const auto it = _depth_source_table.find(current_depthstencil.get());
-
-		if (it != _depth_source_table.end())
-		{
-			it->second.drawcall_count = _drawcalls;
-			it->second.vertices_count += vertices;
-		}
+		_depth_source_tracker.on_draw(current_depthstencil.get(), 1, vertices);
 	}
 	void d3d10_runtime::on_set_depthstencil_view(ID3D10DepthStencilView *&depthstencil)
 	{
-		if (_depth_source_table.find(depthstencil) == _depth_source_table.end())
+		if (!_depth_source_tracker.is_tracked(depthstencil))
 		{
 			D3D10_TEXTURE2D_DESC texture_desc;
 			com_ptr<ID3D10Resource> resource;
@@ -624,11 +637,14 @@ namespace reshade::d3d10
 				return;
 			}
 
-			depthstencil->AddRef();
+			// Stop tracking when the view is destroyed, instead of holding a reference to it
+			if (!com_release_notifier::attach(depthstencil, _depth_source_tracker.owner(), _depth_source_tracker.release_callback(depthstencil)))
+			{
+				return;
+			}
 
 			// Begin tracking new depth stencil
-			const depth_source_info info = { texture_desc.Width, texture_desc.Height };
-			_depth_source_table.emplace(depthstencil, info);
+			_depth_source_tracker.track(depthstencil, texture_desc.Width, texture_desc.Height);
 		}
 
 		if (_depthstencil_replacement != nullptr && depthstencil == _depthstencil)
@@ -739,7 +755,25 @@ namespace reshade::d3d10
 	}
 	bool d3d10_runtime::load_effect(const reshadefx::syntax_tree &ast, std::string &errors)
 	{
-		return d3d10_effect_compiler(this, ast, errors, false).run();
+		if (!d3d10_effect_compiler(this, ast, errors, false).run())
+		{
+			return false;
+		}
+
+		// Only save and restore the slots effects are going to bind
+		UINT num_shader_resources = 1;
+
+		for (const auto &technique : _techniques)
+		{
+			for (const auto &pass_object : technique.passes)
+			{
+				num_shader_resources = std::max(num_shader_resources, static_cast<UINT>(pass_object->as<d3d10_pass_data>()->shader_resources.size()));
+			}
+		}
+
+		_stateblock.set_used_slots(1, 1, std::max(1u, static_cast<UINT>(_effect_sampler_states.size())), num_shader_resources);
+
+		return true;
 	}
 	bool d3d10_runtime::update_texture(texture &texture, const uint8_t *data)
 	{
@@ -816,17 +850,33 @@ namespace reshade::d3d10
 			_device->PSSetConstantBuffers(0, 1, &constant_buffer);
 		}
 
+		const d3d10_pass_data *previous_pass = nullptr;
+
 		for (const auto &pass_object : technique.passes)
 		{
 			const d3d10_pass_data &pass = *pass_object->as<d3d10_pass_data>();
 
-			// Setup states
-			_device->VSSetShader(pass.vertex_shader.get());
-			_device->PSSetShader(pass.pixel_shader.get());
+			// Setup states, consecutive passes share their shader and state objects if they are equal, so only those that changed are set again
+			if (previous_pass == nullptr || pass.vertex_shader != previous_pass->vertex_shader)
+			{
+				_device->VSSetShader(pass.vertex_shader.get());
+			}
+			if (previous_pass == nullptr || pass.pixel_shader != previous_pass->pixel_shader)
+			{
+				_device->PSSetShader(pass.pixel_shader.get());
+			}
+
+			if (previous_pass == nullptr || pass.blend_state != previous_pass->blend_state)
+			{
+				const float blendfactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+				_device->OMSetBlendState(pass.blend_state.get(), blendfactor, D3D10_DEFAULT_SAMPLE_MASK);
+			}
+			if (previous_pass == nullptr || pass.depth_stencil_state != previous_pass->depth_stencil_state || pass.stencil_reference != previous_pass->stencil_reference)
+			{
+				_device->OMSetDepthStencilState(pass.depth_stencil_state.get(), pass.stencil_reference);
+			}
 
-			const float blendfactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-			_device->OMSetBlendState(pass.blend_state.get(), blendfactor, D3D10_DEFAULT_SAMPLE_MASK);
-			_device->OMSetDepthStencilState(pass.depth_stencil_state.get(), pass.stencil_reference);
+			previous_pass = &pass;
 
 			// Save back buffer of previous pass
 			_device->CopyResource(_backbuffer_texture.get(), _backbuffer_resolved.get());
@@ -1032,44 +1082,12 @@ namespace reshade::d3d10
 
 	void d3d10_runtime::detect_depth_source()
 	{
-		if (_is_multisampling_enabled || _depth_source_table.empty())
+		if (_is_multisampling_enabled)
 		{
 			return;
 		}
 
-		depth_source_info best_info = { 0 };
-		ID3D10DepthStencilView *best_match = nullptr;
-
-		for (auto it = _depth_source_table.begin(); it != _depth_source_table.end();)
-		{
-			const auto depthstencil = it->first;
-			auto &depthstencil_info = it->second;
-
-			if ((depthstencil->AddRef(), depthstencil->Release()) == 1)
-			{
-				depthstencil->Release();
-
-				it = _depth_source_table.erase(it);
-				continue;
-			}
-			else
-			{
-				++it;
-			}
-
-			if (depthstencil_info.drawcall_count == 0)
-			{
-				continue;
-			}
-
-			if ((depthstencil_info.vertices_count * (1.2f - float(depthstencil_info.drawcall_count) / _drawcalls)) >= (best_info.vertices_count * (1.2f - float(best_info.drawcall_count) / _drawcalls)))
-			{
-				best_match = depthstencil;
-				best_info = depthstencil_info;
-			}
-
-			depthstencil_info.drawcall_count = depthstencil_info.vertices_count = 0;
-		}
+		const auto best_match = _depth_source_tracker.update(_drawcalls);
 
 		if (best_match != nullptr && _depthstencil != best_match)
 		{
@@ -1214,8 +1232,17 @@ namespace reshade::d3d10
 		// Update effect textures
 		_effect_shader_resources[2] = _depthstencil_texture_srv.get();
 		for (const auto &technique : _techniques)
-			for (const auto &pass : technique.passes)
-				pass->as<d3d10_pass_data>()->shader_resources[2] = _depthstencil_texture_srv.get();
+		{
+			for (const auto &pass_object : technique.passes)
+			{
+				const auto pass = pass_object->as<d3d10_pass_data>();
+
+				if (pass->depth_texture_binding < pass->shader_resources.size())
+				{
+					pass->shader_resources[pass->depth_texture_binding] = _depthstencil_texture_srv.get();
+				}
+			}
+		}
 
 		return true;
 	}
@@ -8,6 +8,10 @@
 #include <d3d10_1.h>
 #include "runtime.hpp"
 #include "d3d10_stateblock.hpp"
+#include "depth_source_tracker.hpp"
+#include "shader_cache.hpp"
+#include "shader_object_cache.hpp"
+#include "state_object_cache.hpp"
 
 namespace reshade::d3d10
 {
@@ -29,10 +33,14 @@ namespace reshade::d3d10
 		ID3D10ShaderResourceView *render_target_resources[D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT];
 		D3D10_VIEWPORT viewport;
 		std::vector<ID3D10ShaderResourceView *> shader_resources;
+		UINT depth_texture_binding;
 	};
 
 	class d3d10_runtime : public runtime
 	{
+		// The compiler uploads the initial values of an effect's uniforms
+		friend class d3d10_effect_compiler;
+
 	public:
 		d3d10_runtime(ID3D10Device1 *device, IDXGISwapChain *swapchain);
 
@@ -50,6 +58,7 @@ namespace reshade::d3d10
 		bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) override;
 		bool update_texture(texture &texture, const uint8_t *data) override;
 
+		shader_object_statistics get_shader_statistics() const override;
 		void render_technique(const technique &technique) override;
 		void render_imgui_draw_data(ImDrawData *data) override;
 
@@ -60,17 +69,16 @@ namespace reshade::d3d10
 		com_ptr<ID3D10RenderTargetView> _backbuffer_rtv[3];
 		com_ptr<ID3D10ShaderResourceView> _backbuffer_texture_srv[2], _depthstencil_texture_srv;
 		std::vector<ID3D10SamplerState *> _effect_sampler_states;
-		std::unordered_map<size_t, size_t> _effect_sampler_descs;
+		state_object_cache<D3D10_SAMPLER_DESC, size_t> _effect_sampler_descs;
+		state_object_cache<D3D10_BLEND_DESC, com_ptr<ID3D10BlendState>> _effect_blend_states;
+		state_object_cache<D3D10_DEPTH_STENCIL_DESC, com_ptr<ID3D10DepthStencilState>> _effect_depth_stencil_states;
 		std::vector<ID3D10ShaderResourceView *> _effect_shader_resources;
 		std::vector<com_ptr<ID3D10Buffer>> _constant_buffers;
+		shader_cache _shader_cache;
+		shader_object_cache<com_ptr<ID3D10VertexShader>> _vertex_shader_cache;
+		shader_object_cache<com_ptr<ID3D10PixelShader>> _pixel_shader_cache;
 
 	private:
-		struct depth_source_info
-		{
-			UINT width, height;
-			UINT drawcall_count, vertices_count;
-		};
-
 		bool init_backbuffer_texture();
 		bool init_default_depth_stencil();
 		bool init_fx_resources();
@@ -87,7 +95,7 @@ namespace reshade::d3d10
 		com_ptr<ID3D10DepthStencilView> _depthstencil, _depthstencil_replacement;
 		com_ptr<ID3D10Texture2D> _depthstencil_texture;
 		com_ptr<ID3D10DepthStencilView> _default_depthstencil;
-		std::unordered_map<ID3D10DepthStencilView *, depth_source_info> _depth_source_table;
+		depth_source_tracker<ID3D10DepthStencilView *> _depth_source_tracker;
 		com_ptr<ID3D10VertexShader> _copy_vertex_shader;
 		com_ptr<ID3D10PixelShader> _copy_pixel_shader;
 		com_ptr<ID3D10SamplerState> _copy_sampler;
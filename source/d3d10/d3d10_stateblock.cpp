@@ -4,6 +4,7 @@
  */
 
 #include "d3d10_stateblock.hpp"
+#include <algorithm>
 
 namespace reshade::d3d10
 {
@@ -22,18 +23,28 @@ namespace reshade::d3d10
 		ZeroMemory(this, sizeof(*this));
 
 		_device = device;
+
+		set_used_slots(UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX);
 	}
 	d3d10_stateblock::~d3d10_stateblock()
 	{
 		release_all_device_objects();
 	}
 
+	void d3d10_stateblock::set_used_slots(UINT vertex_buffers, UINT constant_buffers, UINT samplers, UINT shader_resources)
+	{
+		_num_vertex_buffers = std::min(vertex_buffers, static_cast<UINT>(D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT));
+		_num_constant_buffers = std::min(constant_buffers, static_cast<UINT>(D3D10_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT));
+		_num_samplers = std::min(samplers, static_cast<UINT>(D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT));
+		_num_shader_resources = std::min(shader_resources, static_cast<UINT>(D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT));
+	}
+
 	void d3d10_stateblock::capture()
 	{
 		_device->IAGetPrimitiveTopology(&_ia_primitive_topology);
 		_device->IAGetInputLayout(&_ia_input_layout);
 
-		_device->IAGetVertexBuffers(0, ARRAYSIZE(_ia_vertex_buffers), _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
+		_device->IAGetVertexBuffers(0, _num_vertex_buffers, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
 		_device->IAGetIndexBuffer(&_ia_index_buffer, &_ia_index_format, &_ia_index_offset);
 
 		_device->RSGetState(&_rs_state);
@@ -41,16 +52,16 @@ namespace reshade::d3d10
 		_device->RSGetViewports(&_rs_num_viewports, _rs_viewports);
 
 		_device->VSGetShader(&_vs);
-		_device->VSGetConstantBuffers(0, ARRAYSIZE(_vs_constant_buffers), _vs_constant_buffers);
-		_device->VSGetSamplers(0, ARRAYSIZE(_vs_sampler_states), _vs_sampler_states);
-		_device->VSGetShaderResources(0, ARRAYSIZE(_vs_shader_resources), _vs_shader_resources);
+		_device->VSGetConstantBuffers(0, _num_constant_buffers, _vs_constant_buffers);
+		_device->VSGetSamplers(0, _num_samplers, _vs_sampler_states);
+		_device->VSGetShaderResources(0, _num_shader_resources, _vs_shader_resources);
 
 		_device->GSGetShader(&_gs);
 
 		_device->PSGetShader(&_ps);
-		_device->PSGetConstantBuffers(0, ARRAYSIZE(_ps_constant_buffers), _ps_constant_buffers);
-		_device->PSGetSamplers(0, ARRAYSIZE(_ps_sampler_states), _ps_sampler_states);
-		_device->PSGetShaderResources(0, ARRAYSIZE(_ps_shader_resources), _ps_shader_resources);
+		_device->PSGetConstantBuffers(0, _num_constant_buffers, _ps_constant_buffers);
+		_device->PSGetSamplers(0, _num_samplers, _ps_sampler_states);
+		_device->PSGetShaderResources(0, _num_shader_resources, _ps_shader_resources);
 
 		_device->OMGetBlendState(&_om_blend_state, _om_blend_factor, &_om_sample_mask);
 		_device->OMGetDepthStencilState(&_om_depth_stencil_state, &_om_stencil_ref);
@@ -61,23 +72,23 @@ namespace reshade::d3d10
 		_device->IASetPrimitiveTopology(_ia_primitive_topology);
 		_device->IASetInputLayout(_ia_input_layout);
 
-		_device->IASetVertexBuffers(0, ARRAYSIZE(_ia_vertex_buffers), _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
+		_device->IASetVertexBuffers(0, _num_vertex_buffers, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
 		_device->IASetIndexBuffer(_ia_index_buffer, _ia_index_format, _ia_index_offset);
 
 		_device->RSSetState(_rs_state);
 		_device->RSSetViewports(_rs_num_viewports, _rs_viewports);
 
 		_device->VSSetShader(_vs);
-		_device->VSSetConstantBuffers(0, ARRAYSIZE(_vs_constant_buffers), _vs_constant_buffers);
-		_device->VSSetSamplers(0, ARRAYSIZE(_vs_sampler_states), _vs_sampler_states);
-		_device->VSSetShaderResources(0, ARRAYSIZE(_vs_shader_resources), _vs_shader_resources);
+		_device->VSSetConstantBuffers(0, _num_constant_buffers, _vs_constant_buffers);
+		_device->VSSetSamplers(0, _num_samplers, _vs_sampler_states);
+		_device->VSSetShaderResources(0, _num_shader_resources, _vs_shader_resources);
 
 		_device->GSSetShader(_gs);
 
 		_device->PSSetShader(_ps);
-		_device->PSSetConstantBuffers(0, ARRAYSIZE(_ps_constant_buffers), _ps_constant_buffers);
-		_device->PSSetSamplers(0, ARRAYSIZE(_ps_sampler_states), _ps_sampler_states);
-		_device->PSSetShaderResources(0, ARRAYSIZE(_ps_shader_resources), _ps_shader_resources);
+		_device->PSSetConstantBuffers(0, _num_constant_buffers, _ps_constant_buffers);
+		_device->PSSetSamplers(0, _num_samplers, _ps_sampler_states);
+		_device->PSSetShaderResources(0, _num_shader_resources, _ps_shader_resources);
 
 		_device->OMSetBlendState(_om_blend_state, _om_blend_factor, _om_sample_mask);
 		_device->OMSetDepthStencilState(_om_depth_stencil_state, _om_stencil_ref);
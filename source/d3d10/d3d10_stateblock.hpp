@@ -16,6 +16,11 @@ namespace reshade::d3d10
 		explicit d3d10_stateblock(const com_ptr<ID3D10Device> &device);
 		~d3d10_stateblock();
 
+		/// <summary>
+		/// Limit capture and restore to the leading slots the runtime actually binds, instead of every slot of the pipeline.
+		/// </summary>
+		void set_used_slots(UINT vertex_buffers, UINT constant_buffers, UINT samplers, UINT shader_resources);
+
 		void capture();
 		void apply_and_release();
 
@@ -23,6 +28,7 @@ namespace reshade::d3d10
 		void release_all_device_objects();
 
 		com_ptr<ID3D10Device> _device;
+		UINT _num_vertex_buffers, _num_constant_buffers, _num_samplers, _num_shader_resources;
 		ID3D10InputLayout *_ia_input_layout;
 		D3D10_PRIMITIVE_TOPOLOGY _ia_primitive_topology;
 		ID3D10Buffer *_ia_vertex_buffers[D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
@@ -113,6 +113,11 @@ ULONG STDMETHODCALLTYPE D3D11DeviceContext::Release()
 
 		LOG(INFO) << "Destroyed 'ID3D11DeviceContext" << (_interface_version > 0 ? std::to_string(_interface_version) : "") << "' object " << this << ".";
 
+		for (auto runtime : _device->_runtimes)
+		{
+			runtime->on_reset_context_state(_orig, false);
+		}
+
 		delete this;
 	}
 
@@ -267,24 +272,18 @@ void STDMETHODCALLTYPE D3D11DeviceContext::GSSetSamplers(UINT StartSlot, UINT Nu
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::OMSetRenderTargets(UINT NumViews, ID3D11RenderTargetView *const *ppRenderTargetViews, ID3D11DepthStencilView *pDepthStencilView)
 {
-	if (pDepthStencilView != nullptr)
+	for (auto runtime : _device->_runtimes)
 	{
-		for (auto runtime : _device->_runtimes)
-		{
-			runtime->on_set_depthstencil_view(pDepthStencilView);
-		}
+		runtime->on_set_depthstencil_view(_orig, pDepthStencilView);
 	}
 
 	_orig->OMSetRenderTargets(NumViews, ppRenderTargetViews, pDepthStencilView);
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::OMSetRenderTargetsAndUnorderedAccessViews(UINT NumRTVs, ID3D11RenderTargetView *const *ppRenderTargetViews, ID3D11DepthStencilView *pDepthStencilView, UINT UAVStartSlot, UINT NumUAVs, ID3D11UnorderedAccessView *const *ppUnorderedAccessViews, const UINT *pUAVInitialCounts)
 {
-	if (pDepthStencilView != nullptr)
+	for (auto runtime : _device->_runtimes)
 	{
-		for (auto runtime : _device->_runtimes)
-		{
-			runtime->on_set_depthstencil_view(pDepthStencilView);
-		}
+		runtime->on_set_depthstencil_view(_orig, pDepthStencilView);
 	}
 
 	_orig->OMSetRenderTargetsAndUnorderedAccessViews(NumRTVs, ppRenderTargetViews, pDepthStencilView, UAVStartSlot, NumUAVs, ppUnorderedAccessViews, pUAVInitialCounts);
@@ -419,6 +418,14 @@ void STDMETHODCALLTYPE D3D11DeviceContext::ResolveSubresource(ID3D11Resource *pD
 void STDMETHODCALLTYPE D3D11DeviceContext::ExecuteCommandList(ID3D11CommandList *pCommandList, BOOL RestoreContextState)
 {
 	_orig->ExecuteCommandList(pCommandList, RestoreContextState);
+
+	if (!RestoreContextState)
+	{
+		for (auto runtime : _device->_runtimes)
+		{
+			runtime->on_reset_context_state(_orig, true);
+		}
+	}
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::HSSetShaderResources(UINT StartSlot, UINT NumViews, ID3D11ShaderResourceView *const *ppShaderResourceViews)
 {
@@ -643,6 +650,11 @@ void STDMETHODCALLTYPE D3D11DeviceContext::CSGetConstantBuffers(UINT StartSlot,
 void STDMETHODCALLTYPE D3D11DeviceContext::ClearState()
 {
 	_orig->ClearState();
+
+	for (auto runtime : _device->_runtimes)
+	{
+		runtime->on_reset_context_state(_orig, true);
+	}
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::Flush()
 {
@@ -654,7 +666,17 @@ UINT STDMETHODCALLTYPE D3D11DeviceContext::GetContextFlags()
 }
 HRESULT STDMETHODCALLTYPE D3D11DeviceContext::FinishCommandList(BOOL RestoreDeferredContextState, ID3D11CommandList **ppCommandList)
 {
-	return _orig->FinishCommandList(RestoreDeferredContextState, ppCommandList);
+	const HRESULT hr = _orig->FinishCommandList(RestoreDeferredContextState, ppCommandList);
+
+	if (SUCCEEDED(hr) && !RestoreDeferredContextState)
+	{
+		for (auto runtime : _device->_runtimes)
+		{
+			runtime->on_reset_context_state(_orig, true);
+		}
+	}
+
+	return hr;
 }
 D3D11_DEVICE_CONTEXT_TYPE STDMETHODCALLTYPE D3D11DeviceContext::GetType()
 {
@@ -763,6 +785,11 @@ void STDMETHODCALLTYPE D3D11DeviceContext::SwapDeviceContextState(ID3DDeviceCont
 	assert(_interface_version >= 1);
 
 	static_cast<ID3D11DeviceContext1 *>(_orig)->SwapDeviceContextState(pState, ppPreviousState);
+
+	for (auto runtime : _device->_runtimes)
+	{
+		runtime->on_reset_context_state(_orig, false);
+	}
 }
 void STDMETHODCALLTYPE D3D11DeviceContext::ClearView(ID3D11View *pView, const FLOAT Color[4], const D3D11_RECT *pRect, UINT NumRects)
 {
@@ -5,6 +5,9 @@
 
 #include "d3d11_runtime.hpp"
 #include "d3d11_effect_compiler.hpp"
+#include "optimizer.hpp"
+#include "log.hpp"
+#include <set>
 #include <assert.h>
 #include <iomanip>
 #include <algorithm>
@@ -15,10 +18,6 @@ namespace reshade::d3d11
 	using namespace reshadefx;
 	using namespace reshadefx::nodes;
 
-	static inline size_t roundto16(size_t size)
-	{
-		return (size + 15) & ~15;
-	}
 	static D3D11_BLEND literal_to_blend_func(unsigned int value)
 	{
 		switch (value)
@@ -80,6 +79,21 @@ namespace reshade::d3d11
 
 		return DXGI_FORMAT_UNKNOWN;
 	}
+	static D3D11_SAMPLER_DESC make_sampler_desc(const sampler_info &info)
+	{
+		D3D11_SAMPLER_DESC desc = { };
+		desc.Filter = static_cast<D3D11_FILTER>(info.filter);
+		desc.AddressU = static_cast<D3D11_TEXTURE_ADDRESS_MODE>(info.address_u);
+		desc.AddressV = static_cast<D3D11_TEXTURE_ADDRESS_MODE>(info.address_v);
+		desc.AddressW = static_cast<D3D11_TEXTURE_ADDRESS_MODE>(info.address_w);
+		desc.MipLODBias = info.lod_bias;
+		desc.MaxAnisotropy = 1;
+		desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+		desc.MinLOD = info.min_lod;
+		desc.MaxLOD = info.max_lod;
+
+		return desc;
+	}
 	static std::string convert_semantic(const std::string &semantic)
 	{
 		if (semantic == "VERTEXID")
@@ -164,11 +178,20 @@ namespace reshade::d3d11
 
 	d3d11_effect_compiler::d3d11_effect_compiler(d3d11_runtime *runtime, const syntax_tree &ast, std::string &errors, bool skipoptimization) :
 		_runtime(runtime),
-		_ast(ast),
+		_ast(&ast),
 		_errors(errors),
 		_skip_shader_optimization(skipoptimization)
 	{
 	}
+	d3d11_effect_compiler::d3d11_effect_compiler(d3d11_runtime *runtime, const effect_reflection &reflection, const std::vector<std::string> &code, std::string &errors, bool skipoptimization) :
+		_runtime(runtime),
+		_ast(nullptr),
+		_loaded_code(&code),
+		_errors(errors),
+		_skip_shader_optimization(skipoptimization),
+		_reflection(reflection)
+	{
+	}
 
 	bool d3d11_effect_compiler::run()
 	{
@@ -184,47 +207,91 @@ namespace reshade::d3d11
 			return false;
 		}
 
-		_uniform_storage_offset = _runtime->get_uniform_value_storage().size();
-
-		for (auto node : _ast.structs)
+		if (_ast != nullptr)
+		{
+			// The reflection lays out all uniforms up front, so that the storage for them is allocated in one go
+			_reflection = reshadefx::reflect(*_ast, uniform_layout::rules::hlsl_cbuffer);
+		}
+		else if (!check_generated_code())
 		{
-			visit(_global_code, node);
+			FreeLibrary(_d3dcompiler_module);
+
+			_errors += "The stored shader code does not fit the current state of the runtime.\n";
+			return false;
 		}
-		for (auto uniform : _ast.variables)
+
+		_constant_buffer_size = _reflection.uniform_block_size;
+		_uniform_storage_offset = _runtime->allocate_uniform_storage(_constant_buffer_size);
+
+		if (_ast != nullptr)
 		{
-			if (uniform->type.is_texture())
+			for (auto node : _ast->structs)
 			{
-				visit_texture(uniform);
+				std::stringstream struct_code;
+
+				visit(struct_code, node);
+
+				_struct_code[node] = struct_code.str();
 			}
-			else if (uniform->type.is_sampler())
+			for (auto uniform : _ast->variables)
 			{
-				visit_sampler(uniform);
+				if (uniform->type.is_texture())
+				{
+					visit_texture(uniform->location);
+				}
+				else if (uniform->type.is_sampler())
+				{
+					visit_sampler(uniform);
+				}
+				else if (uniform->type.has_qualifier(type_node::qualifier_uniform))
+				{
+					visit_uniform(uniform);
+				}
+				else
+				{
+					std::stringstream variable_code;
+
+					visit(variable_code, uniform);
+
+					variable_code << ";\n";
+
+					_variable_code[uniform] = variable_code.str();
+				}
 			}
-			else if (uniform->type.has_qualifier(type_node::qualifier_uniform))
+
+			// The generated code refers to sampler states by their index in the runtime, so those are stored in front of it
+			_generated_code.emplace_back();
+
+			for (auto variable : _ast->variables)
 			{
-				visit_uniform(uniform);
+				const auto sampler_state = _sampler_states.find(variable);
+
+				if (sampler_state != _sampler_states.end())
+				{
+					_generated_code.back() += std::to_string(sampler_state->second) + ' ';
+				}
 			}
-			else
+
+			for (auto function : _ast->functions)
 			{
-				visit(_global_code, uniform);
+				std::stringstream function_code;
 
-				_global_code << ";\n";
+				visit(function_code, function);
+
+				_function_code[function] = function_code.str();
+			}
+			for (auto technique : _ast->techniques)
+			{
+				visit_technique(technique);
 			}
 		}
-		for (auto function : _ast.functions)
-		{
-			visit(_global_code, function);
-		}
-		for (auto technique : _ast.techniques)
+		else
 		{
-			visit_technique(technique);
+			run_generated();
 		}
 
 		if (_constant_buffer_size != 0)
 		{
-			_constant_buffer_size = roundto16(_constant_buffer_size);
-			_runtime->get_uniform_value_storage().resize(_uniform_storage_offset + _constant_buffer_size);
-
 			const CD3D11_BUFFER_DESC globals_desc(static_cast<UINT>(_constant_buffer_size), D3D11_BIND_CONSTANT_BUFFER, D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
 			const D3D11_SUBRESOURCE_DATA globals_initial = { _runtime->get_uniform_value_storage().data() + _uniform_storage_offset, static_cast<UINT>(_constant_buffer_size) };
 
@@ -236,6 +303,163 @@ namespace reshade::d3d11
 
 		FreeLibrary(_d3dcompiler_module);
 
+		if (_ast != nullptr)
+		{
+			LOG(INFO) << "> Generated " << _emitted_code_size << " bytes of shader code after leaving out " << _unreachable_code_size << " bytes unreachable from the entry points and spent "
+			          << std::chrono::duration_cast<std::chrono::milliseconds>(_compile_time).count() << " ms in D3DCompile.";
+		}
+		else
+		{
+			LOG(INFO) << "> Loaded " << _emitted_code_size << " bytes of stored shader code and spent " << std::chrono::duration_cast<std::chrono::milliseconds>(_compile_time).count() << " ms in D3DCompile.";
+		}
+
+		return _success;
+	}
+	void d3d11_effect_compiler::take_generated_code(effect_reflection &reflection, std::vector<std::string> &code)
+	{
+		reflection = std::move(_reflection);
+		code = std::move(_generated_code);
+	}
+
+	bool d3d11_effect_compiler::check_generated_code()
+	{
+		const auto &code = *_loaded_code;
+		size_t pass_count = 0;
+
+		for (const auto &technique : _reflection.techniques)
+		{
+			pass_count += technique.passes.size();
+		}
+
+		if (code.size() != 1 + pass_count * 7)
+		{
+			return false;
+		}
+
+		// Sampler states are numbered across all effects, so the code only fits if every sampler gets the same index as when it was generated
+		// The assignment is simulated first, so that nothing is created for an effect that is compiled from source after all
+		std::istringstream stored_indices(code[0]);
+		state_object_cache<D3D11_SAMPLER_DESC, size_t> new_sampler_descs;
+
+		for (const auto &info : _reflection.samplers)
+		{
+			size_t stored_index;
+
+			if (!(stored_indices >> stored_index))
+			{
+				return false;
+			}
+
+			const D3D11_SAMPLER_DESC desc = make_sampler_desc(info);
+			auto sampler_index = _runtime->_effect_sampler_descs.find(desc);
+
+			if (sampler_index == nullptr)
+			{
+				sampler_index = new_sampler_descs.find(desc);
+			}
+			if (sampler_index == nullptr)
+			{
+				sampler_index = &new_sampler_descs.insert(desc, _runtime->_effect_sampler_states.size() + new_sampler_descs.size());
+			}
+
+			if (*sampler_index != stored_index)
+			{
+				return false;
+			}
+		}
+
+		if (!(stored_indices >> std::ws).eof())
+		{
+			return false;
+		}
+
+		for (size_t i = 1; i < code.size(); i += 7)
+		{
+			// The position arguments of the fused stage are listed as a string of '0' and '1'
+			if (code[i + 6].find_first_not_of("01") != std::string::npos)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+	bool d3d11_effect_compiler::run_generated()
+	{
+		const auto &code = *_loaded_code;
+
+		// There is no source to point errors to, so they are reported by the name of the variable instead
+		for (const auto &info : _reflection.textures)
+		{
+			visit_texture(location(info.unique_name, 1));
+		}
+
+		for (const auto &info : _reflection.samplers)
+		{
+			size_t sampler_index;
+
+			create_sampler(info, location(info.unique_name, 1), sampler_index);
+		}
+
+		for (const auto &info : _reflection.uniforms)
+		{
+			_runtime->add_uniform(info, _uniform_storage_offset);
+		}
+
+		for (size_t technique_index = 0, code_index = 1; technique_index < _reflection.techniques.size(); technique_index++)
+		{
+			const auto &info = _reflection.techniques[technique_index];
+
+			technique obj;
+			create_technique(info, obj);
+
+			for (const auto &pass_desc : info.passes)
+			{
+				const location pass_location(info.name, 1);
+
+				obj.passes.emplace_back(std::make_unique<d3d11_pass_data>());
+				auto &pass = *static_cast<d3d11_pass_data *>(obj.passes.back().get());
+
+				bind_pass_textures(pass_desc, pass);
+
+				if (!code[code_index].empty())
+				{
+					compile_pass_shader(code[code_index], pass_desc.vertex_shader, "vs", pass_location, pass);
+				}
+				if (!code[code_index + 1].empty())
+				{
+					compile_pass_shader(code[code_index + 1], pass_desc.pixel_shader, "ps", pass_location, pass);
+				}
+
+				create_pass_states(pass_desc, pass_location, pass);
+
+				obj.resource_bindings += static_cast<unsigned int>(pass.shader_resources.size());
+
+				if (!code[code_index + 2].empty())
+				{
+					const auto stage = std::make_shared<d3d11_fused_stage>();
+					stage->srgb_write_enable = pass_desc.srgb_write_enable;
+					stage->function_name = code[code_index + 2];
+					stage->vertex_shader_code = code[code_index + 3];
+					stage->uniform_code = code[code_index + 4];
+					stage->code = code[code_index + 5];
+
+					for (const char position : code[code_index + 6])
+					{
+						stage->position_arguments.push_back(position == '1');
+					}
+
+					pass.fused_stage = stage;
+				}
+
+				_emitted_code_size += code[code_index].size() + code[code_index + 1].size();
+
+				code_index += 7;
+			}
+
+			_runtime->add_technique(std::move(obj));
+		}
+
 		return _success;
 	}
 
@@ -391,7 +615,7 @@ namespace reshade::d3d11
 				output << "__sampler2D";
 				break;
 			case type_node::datatype_struct:
-				output << type.definition->unique_name;
+				output << _name_prefix << type.definition->unique_name;
 				break;
 		}
 
@@ -406,7 +630,7 @@ namespace reshade::d3d11
 	}
 	void d3d11_effect_compiler::visit(std::stringstream &output, const lvalue_expression_node *node)
 	{
-		output << node->reference->unique_name;
+		output << _name_prefix << node->reference->unique_name;
 	}
 	void d3d11_effect_compiler::visit(std::stringstream &output, const literal_expression_node *node)
 	{
@@ -614,6 +838,13 @@ namespace reshade::d3d11
 	{
 		std::string part1, part2, part3, part4, part5;
 
+		// Reading the back buffer in a fused stage is replaced with the color the previous stage computed for this pixel
+		if (node->op == intrinsic_expression_node::texture && _fused_input != nullptr && node->arguments[0]->id == nodeid::lvalue_expression && static_cast<const lvalue_expression_node *>(node->arguments[0])->reference == _fused_input)
+		{
+			output << "__fused_color";
+			return;
+		}
+
 		switch (node->op)
 		{
 			case intrinsic_expression_node::abs:
@@ -1041,7 +1272,7 @@ namespace reshade::d3d11
 
 		visit(output, node->operand);
 
-		output << '.' << node->field_reference->unique_name << ')';
+		output << '.' << _name_prefix << node->field_reference->unique_name << ')';
 	}
 	void d3d11_effect_compiler::visit(std::stringstream &output, const assignment_expression_node *node)
 	{
@@ -1092,7 +1323,7 @@ namespace reshade::d3d11
 	}
 	void d3d11_effect_compiler::visit(std::stringstream &output, const call_expression_node *node)
 	{
-		output << node->callee->unique_name << '(';
+		output << _name_prefix << node->callee->unique_name << '(';
 
 		for (size_t i = 0, count = node->arguments.size(); i < count; i++)
 		{
@@ -1359,7 +1590,7 @@ namespace reshade::d3d11
 	}
 	void d3d11_effect_compiler::visit(std::stringstream &output, const struct_declaration_node *node)
 	{
-		output << "struct " << node->unique_name << "\n{\n";
+		output << "struct " << _name_prefix << node->unique_name << "\n{\n";
 
 		if (!node->field_list.empty())
 		{
@@ -1386,7 +1617,7 @@ namespace reshade::d3d11
 
 		if (!node->name.empty())
 		{
-			output << node->unique_name;
+			output << _name_prefix << node->unique_name;
 		}
 
 		if (node->type.is_array())
@@ -1422,7 +1653,7 @@ namespace reshade::d3d11
 	{
 		visit(output, node->return_type, false);
 
-		output << ' ' << node->unique_name << '(';
+		output << ' ' << _name_prefix << node->unique_name << '(';
 
 		_is_in_parameter_block = true;
 
@@ -1454,18 +1685,21 @@ namespace reshade::d3d11
 		_is_in_function_block = false;
 	}
 
-	void d3d11_effect_compiler::visit_texture(const variable_declaration_node *node)
+	void d3d11_effect_compiler::visit_texture(const location &location)
 	{
+		const size_t index = _texture_index++;
+		const auto &info = _reflection.textures[index];
+
 		texture obj;
 		D3D11_TEXTURE2D_DESC texdesc = { };
-		obj.name = node->name;
-		obj.unique_name = node->unique_name;
-		obj.annotations = node->annotation_list;
-		texdesc.Width = obj.width = node->properties.width;
-		texdesc.Height = obj.height = node->properties.height;
-		texdesc.MipLevels = obj.levels = node->properties.levels;
+		obj.name = info.name;
+		obj.unique_name = info.unique_name;
+		obj.annotations = info.annotations;
+		texdesc.Width = obj.width = info.width;
+		texdesc.Height = obj.height = info.height;
+		texdesc.MipLevels = obj.levels = info.levels;
 		texdesc.ArraySize = 1;
-		texdesc.Format = literal_to_format(obj.format = node->properties.format);
+		texdesc.Format = literal_to_format(obj.format = info.format);
 		texdesc.SampleDesc.Count = 1;
 		texdesc.SampleDesc.Quality = 0;
 		texdesc.Usage = D3D11_USAGE_DEFAULT;
@@ -1474,7 +1708,7 @@ namespace reshade::d3d11
 
 		size_t texture_register_index, texture_register_index_srgb;
 
-		if (node->semantic == "COLOR" || node->semantic == "SV_TARGET")
+		if (info.reference == texture_reference::back_buffer)
 		{
 			obj.width = _runtime->frame_width();
 			obj.height = _runtime->frame_height();
@@ -1483,7 +1717,7 @@ namespace reshade::d3d11
 			texture_register_index = 0;
 			texture_register_index_srgb = 1;
 		}
-		else if (node->semantic == "DEPTH" || node->semantic == "SV_DEPTH")
+		else if (info.reference == texture_reference::depth_buffer)
 		{
 			obj.width = _runtime->frame_width();
 			obj.height = _runtime->frame_height();
@@ -1497,11 +1731,21 @@ namespace reshade::d3d11
 			obj.impl = std::make_unique<d3d11_tex_data>();
 			const auto obj_data = obj.impl->as<d3d11_tex_data>();
 
+			// Render targets the size of the back buffer are rendered at the scale of the effect, images loaded from a file keep their size
+			const float render_scale = _runtime->effect_render_scale();
+			const bool is_scaled = render_scale < 1.0f && info.width == _runtime->frame_width() && info.height == _runtime->frame_height() && info.annotations.count("source") == 0;
+
+			if (is_scaled)
+			{
+				texdesc.Width = obj.width = std::max(1u, static_cast<unsigned int>(info.width * render_scale + 0.5f));
+				texdesc.Height = obj.height = std::max(1u, static_cast<unsigned int>(info.height * render_scale + 0.5f));
+			}
+
 			HRESULT hr = _runtime->_device->CreateTexture2D(&texdesc, nullptr, &obj_data->texture);
 
 			if (FAILED(hr))
 			{
-				error(node->location, "'ID3D11Device::CreateTexture2D' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+				error(location, "'ID3D11Device::CreateTexture2D' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
 				return;
 			}
 
@@ -1514,7 +1758,7 @@ namespace reshade::d3d11
 
 			if (FAILED(hr))
 			{
-				error(node->location, "'ID3D11Device::CreateShaderResourceView' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+				error(location, "'ID3D11Device::CreateShaderResourceView' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
 				return;
 			}
 
@@ -1529,7 +1773,7 @@ namespace reshade::d3d11
 
 				if (FAILED(hr))
 				{
-					error(node->location, "'ID3D11Device::CreateShaderResourceView' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+					error(location, "'ID3D11Device::CreateShaderResourceView' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
 					return;
 				}
 
@@ -1540,69 +1784,91 @@ namespace reshade::d3d11
 			{
 				texture_register_index_srgb = texture_register_index;
 			}
+
+			if (is_scaled)
+			{
+				D3D11_TEXTURE2D_DESC upscaled_desc = texdesc;
+				upscaled_desc.Width = info.width;
+				upscaled_desc.Height = info.height;
+				upscaled_desc.MipLevels = 1;
+				upscaled_desc.MiscFlags = 0;
+
+				hr = _runtime->_device->CreateTexture2D(&upscaled_desc, nullptr, &obj_data->upscaled_texture);
+
+				if (FAILED(hr))
+				{
+					error(location, "'ID3D11Device::CreateTexture2D' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+					return;
+				}
+
+				D3D11_RENDER_TARGET_VIEW_DESC rtvdesc = { };
+				rtvdesc.Format = make_format_normal(upscaled_desc.Format);
+				rtvdesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+
+				hr = _runtime->_device->CreateRenderTargetView(obj_data->upscaled_texture.get(), &rtvdesc, &obj_data->upscaled_rtv);
+
+				if (FAILED(hr))
+				{
+					error(location, "'ID3D11Device::CreateRenderTargetView' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+					return;
+				}
+
+				srvdesc.Texture2D.MipLevels = 1;
+
+				// The copy gets the same views as the texture, so that each one can be substituted by its counterpart
+				for (unsigned int i = 0, count = texture_register_index_srgb != texture_register_index ? 2 : 1; i < count; i++)
+				{
+					srvdesc.Format = i == 0 ? make_format_normal(upscaled_desc.Format) : make_format_srgb(upscaled_desc.Format);
+
+					hr = _runtime->_device->CreateShaderResourceView(obj_data->upscaled_texture.get(), &srvdesc, &obj_data->upscaled_srv[i]);
+
+					if (FAILED(hr))
+					{
+						error(location, "'ID3D11Device::CreateShaderResourceView' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+						return;
+					}
+
+					_upscaled_shader_resources[i == 0 ? texture_register_index : texture_register_index_srgb] = _runtime->_effect_shader_resources.size();
+					_runtime->_effect_shader_resources.push_back(obj_data->upscaled_srv[i].get());
+				}
+			}
 		}
 
-		_global_code << "Texture2D " <<
-			node->unique_name << " : register(t" << texture_register_index << "), __" <<
-			node->unique_name << "SRGB : register(t" << texture_register_index_srgb << ");\n";
+		// The declaration is emitted per pass, so that each pass gets its own compact register assignment
+		_texture_bindings[index] = std::make_pair(texture_register_index, texture_register_index_srgb);
 
 		_runtime->add_texture(std::move(obj));
 	}
 	void d3d11_effect_compiler::visit_sampler(const variable_declaration_node *node)
 	{
-		D3D11_SAMPLER_DESC desc = { };
-		desc.Filter = static_cast<D3D11_FILTER>(node->properties.filter);
-		desc.AddressU = static_cast<D3D11_TEXTURE_ADDRESS_MODE>(node->properties.address_u);
-		desc.AddressV = static_cast<D3D11_TEXTURE_ADDRESS_MODE>(node->properties.address_v);
-		desc.AddressW = static_cast<D3D11_TEXTURE_ADDRESS_MODE>(node->properties.address_w);
-		desc.MipLODBias = node->properties.lod_bias;
-		desc.MaxAnisotropy = 1;
-		desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-		desc.MinLOD = node->properties.min_lod;
-		desc.MaxLOD = node->properties.max_lod;
+		const auto &info = _reflection.samplers[_sampler_index++];
 
-		const auto texture = _runtime->find_texture(node->properties.texture->name);
+		size_t sampler_index;
 
-		if (texture == nullptr)
+		if (!create_sampler(info, node->location, sampler_index))
 		{
-			error(node->location, "texture '" + node->properties.texture->name + "' for sampler '" + node->name + "' is missing due to previous error");
 			return;
 		}
 
-		size_t desc_hash = 2166136261;
-		for (size_t i = 0; i < sizeof(desc); ++i)
-			desc_hash = (desc_hash * 16777619) ^ reinterpret_cast<const uint8_t *>(&desc)[i];
-
-		auto it = _runtime->_effect_sampler_descs.find(desc_hash);
-
-		if (it == _runtime->_effect_sampler_descs.end())
-		{
-			ID3D11SamplerState *sampler = nullptr;
-
-			HRESULT hr = _runtime->_device->CreateSamplerState(&desc, &sampler);
-
-			if (FAILED(hr))
-			{
-				error(node->location, "'ID3D11Device::CreateSamplerState' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
-				return;
-			}
+		const auto &texture_info = _reflection.textures[info.texture];
 
-			_runtime->_effect_sampler_states.push_back(sampler);
-			it = _runtime->_effect_sampler_descs.emplace(desc_hash, _runtime->_effect_sampler_states.size() - 1).first;
-		}
+		std::stringstream sampler_code;
 
-		_global_code << "static const __sampler2D " << node->unique_name << " = { ";
+		sampler_code << "static const __sampler2D " << node->unique_name << " = { ";
 
-		if (node->properties.srgb_texture)
+		if (info.srgb)
 		{
-			_global_code << "__" << node->properties.texture->unique_name << "SRGB";
+			sampler_code << "__" << texture_info.unique_name << "SRGB";
 		}
 		else
 		{
-			_global_code << node->properties.texture->unique_name;
+			sampler_code << texture_info.unique_name;
 		}
 
-		_global_code << ", __SamplerState" << it->second << " };\n";
+		sampler_code << ", __SamplerState" << sampler_index << " };\n";
+
+		_variable_code[node] = sampler_code.str();
+		_sampler_states[node] = sampler_index;
 	}
 	void d3d11_effect_compiler::visit_uniform(const variable_declaration_node *node)
 	{
@@ -1624,172 +1890,563 @@ namespace reshade::d3d11
 
 		_global_uniforms << ";\n";
 
-		uniform obj;
-		obj.name = node->name;
-		obj.unique_name = node->unique_name;
-		obj.basetype = obj.displaytype = static_cast<uniform_datatype>(node->type.basetype - 1);
-		obj.rows = node->type.rows;
-		obj.columns = node->type.cols;
-		obj.elements = node->type.array_length;
-		obj.storage_size = node->type.rows * node->type.cols * std::max(1u, obj.elements) * 4;
-		obj.annotations = node->annotation_list;
-
-		const UINT alignment = 16 - (_constant_buffer_size % 16);
-		_constant_buffer_size += static_cast<UINT>((obj.storage_size > alignment && (alignment != 16 || obj.storage_size <= 16)) ? obj.storage_size + alignment : obj.storage_size);
-		obj.storage_offset = _uniform_storage_offset + _constant_buffer_size - obj.storage_size;
-
-		auto &uniform_storage = _runtime->get_uniform_value_storage();
-
-		if (_uniform_storage_offset + _constant_buffer_size >= uniform_storage.size())
-		{
-			uniform_storage.resize(uniform_storage.size() + 128);
-		}
-
-		if (node->initializer_expression != nullptr && node->initializer_expression->id == nodeid::literal_expression)
-		{
-			CopyMemory(uniform_storage.data() + obj.storage_offset, &static_cast<const literal_expression_node *>(node->initializer_expression)->value_float, obj.storage_size);
-		}
-		else
-		{
-			ZeroMemory(uniform_storage.data() + obj.storage_offset, obj.storage_size);
-		}
-
-		_runtime->add_uniform(std::move(obj));
+		_runtime->add_uniform(_reflection.uniforms[_uniform_index++], _uniform_storage_offset);
 	}
 	void d3d11_effect_compiler::visit_technique(const technique_declaration_node *node)
 	{
-		technique obj;
-		obj.name = node->name;
-		obj.annotations = node->annotation_list;
+		const auto &info = _reflection.techniques[_technique_index++];
 
-		if (_constant_buffer_size != 0)
-		{
-			obj.uniform_storage_index = _runtime->_constant_buffers.size();
-			obj.uniform_storage_offset = _uniform_storage_offset;
-		}
+		technique obj;
+		create_technique(info, obj);
 
-		for (auto pass : node->pass_list)
+		for (size_t i = 0; i < node->pass_list.size(); i++)
 		{
 			obj.passes.emplace_back(std::make_unique<d3d11_pass_data>());
-			visit_pass(pass, *static_cast<d3d11_pass_data *>(obj.passes.back().get()));
-		}
-
-		_runtime->add_technique(std::move(obj));
-	}
-	void d3d11_effect_compiler::visit_pass(const pass_declaration_node *node, d3d11_pass_data &pass)
-	{
-		pass.stencil_reference = 0;
-		pass.viewport.TopLeftX = pass.viewport.TopLeftY = pass.viewport.Width = pass.viewport.Height = 0.0f;
-		pass.viewport.MinDepth = 0.0f;
-		pass.viewport.MaxDepth = 1.0f;
-		pass.clear_render_targets = node->clear_render_targets;
-		ZeroMemory(pass.render_targets, sizeof(pass.render_targets));
-		ZeroMemory(pass.render_target_resources, sizeof(pass.render_target_resources));
-		pass.shader_resources = _runtime->_effect_shader_resources;
+			auto &pass = *static_cast<d3d11_pass_data *>(obj.passes.back().get());
 
-		if (node->vertex_shader != nullptr)
-		{
-			visit_pass_shader(node->vertex_shader, "vs", pass);
-		}
-		if (node->pixel_shader != nullptr)
-		{
-			visit_pass_shader(node->pixel_shader, "ps", pass);
-		}
+			visit_pass(node->pass_list[i], info.passes[i], pass);
 
-		const int target_index = node->srgb_write_enable ? 1 : 0;
-		pass.render_targets[0] = _runtime->_backbuffer_rtv[target_index].get();
-		pass.render_target_resources[0] = _runtime->_backbuffer_texture_srv[target_index].get();
+			obj.resource_bindings += static_cast<unsigned int>(pass.shader_resources.size());
 
-		for (unsigned int i = 0; i < 8; i++)
-		{
-			if (node->render_targets[i] == nullptr)
+			// Techniques that only transform the color of each pixel can be merged with their neighbors into a single pass at runtime
+			if (node->pass_list.size() == 1 && _runtime->_device->GetFeatureLevel() >= D3D_FEATURE_LEVEL_10_0)
 			{
-				continue;
+				if (const auto input = find_point_wise_input(node->pass_list[0]))
+				{
+					pass.fused_stage = visit_fused_stage(node->pass_list[0], input);
+				}
 			}
 
-			const auto texture = _runtime->find_texture(node->render_targets[i]->name);
+			const auto stage = pass.fused_stage.get();
 
-			if (texture == nullptr)
+			_generated_code.push_back(stage != nullptr ? stage->function_name : std::string());
+			_generated_code.push_back(stage != nullptr ? stage->vertex_shader_code : std::string());
+			_generated_code.push_back(stage != nullptr ? stage->uniform_code : std::string());
+			_generated_code.push_back(stage != nullptr ? stage->code : std::string());
+			_generated_code.emplace_back();
+
+			if (stage != nullptr)
 			{
-				error(node->location, "texture not found");
-				return;
+				for (bool position : stage->position_arguments)
+				{
+					_generated_code.back() += position ? '1' : '0';
+				}
 			}
+		}
 
-			const auto texture_impl = texture->impl->as<d3d11_tex_data>();
-
-			D3D11_TEXTURE2D_DESC desc;
-			texture_impl->texture->GetDesc(&desc);
+		_runtime->add_technique(std::move(obj));
+	}
+	void d3d11_effect_compiler::visit_pass(const pass_declaration_node *node, const reshadefx::pass_info &info, d3d11_pass_data &pass)
+	{
+		bind_pass_textures(info, pass);
 
-			if (pass.viewport.Width != 0 && pass.viewport.Height != 0 && (desc.Width != static_cast<unsigned int>(pass.viewport.Width) || desc.Height != static_cast<unsigned int>(pass.viewport.Height)))
+		// The source of each entry point is kept, so that the effect can be loaded from it without the syntax tree
+		for (const auto shader : { node->vertex_shader, node->pixel_shader })
+		{
+			if (shader != nullptr)
 			{
-				error(node->location, "cannot use multiple rendertargets with different sized textures");
-				return;
+				visit_pass_shader(shader, shader == node->vertex_shader ? "vs" : "ps", pass);
 			}
 			else
 			{
-				pass.viewport.Width = static_cast<FLOAT>(desc.Width);
-				pass.viewport.Height = static_cast<FLOAT>(desc.Height);
-			}
-
-			D3D11_RENDER_TARGET_VIEW_DESC rtvdesc = { };
-			rtvdesc.Format = node->srgb_write_enable ? make_format_srgb(desc.Format) : make_format_normal(desc.Format);
-			rtvdesc.ViewDimension = desc.SampleDesc.Count > 1 ? D3D11_RTV_DIMENSION_TEXTURE2DMS : D3D11_RTV_DIMENSION_TEXTURE2D;
-
-			if (texture_impl->rtv[target_index] == nullptr)
-			{
-				HRESULT hr = _runtime->_device->CreateRenderTargetView(texture_impl->texture.get(), &rtvdesc, &texture_impl->rtv[target_index]);
-
-				if (FAILED(hr))
-				{
-					warning(node->location, "'ID3D11Device::CreateRenderTargetView' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
-				}
+				_generated_code.emplace_back();
 			}
-
-			pass.render_targets[i] = texture_impl->rtv[target_index].get();
-			pass.render_target_resources[i] = texture_impl->srv[target_index].get();
 		}
 
-		if (pass.viewport.Width == 0 && pass.viewport.Height == 0)
-		{
-			pass.viewport.Width = static_cast<FLOAT>(_runtime->frame_width());
-			pass.viewport.Height = static_cast<FLOAT>(_runtime->frame_height());
-		}
+		create_pass_states(info, node->location, pass);
+	}
+	void d3d11_effect_compiler::visit_pass_shader(const function_declaration_node *node, const std::string &shadertype, d3d11_pass_data &pass)
+	{
+		const D3D_FEATURE_LEVEL featurelevel = _runtime->_device->GetFeatureLevel();
 
-		D3D11_DEPTH_STENCIL_DESC ddesc;
-		ddesc.DepthEnable = FALSE;
-		ddesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
-		ddesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
-		ddesc.StencilEnable = node->stencil_enable;
-		ddesc.StencilReadMask = node->stencil_read_mask;
-		ddesc.StencilWriteMask = node->stencil_write_mask;
-		ddesc.FrontFace.StencilFunc = ddesc.BackFace.StencilFunc = static_cast<D3D11_COMPARISON_FUNC>(node->stencil_comparison_func);
-		ddesc.FrontFace.StencilPassOp = ddesc.BackFace.StencilPassOp = literal_to_stencil_op(node->stencil_op_pass);
-		ddesc.FrontFace.StencilFailOp = ddesc.BackFace.StencilFailOp = literal_to_stencil_op(node->stencil_op_fail);
-		ddesc.FrontFace.StencilDepthFailOp = ddesc.BackFace.StencilDepthFailOp = literal_to_stencil_op(node->stencil_op_depth_fail);
-		pass.stencil_reference = node->stencil_reference_value;
+		std::string source =
+			"#pragma warning(disable: 3571)\n"
+			"struct __sampler2D { Texture2D t; SamplerState s; };\n"
+			"inline float4 __tex2D(__sampler2D s, float2 c) { return s.t.Sample(s.s, c); }\n"
+			"inline float4 __tex2Dfetch(__sampler2D s, int4 c) { return s.t.Load(c.xyw); }\n"
+			"inline float4 __tex2Dgrad(__sampler2D s, float2 c, float2 ddx, float2 ddy) { return s.t.SampleGrad(s.s, c, ddx, ddy); }\n"
+			"inline float4 __tex2Dlod(__sampler2D s, float4 c) { return s.t.SampleLevel(s.s, c.xy, c.w); }\n"
+			"inline float4 __tex2Dlodoffset(__sampler2D s, float4 c, int2 offset) { return s.t.SampleLevel(s.s, c.xy, c.w, offset); }\n"
+			"inline float4 __tex2Doffset(__sampler2D s, float2 c, int2 offset) { return s.t.Sample(s.s, c, offset); }\n"
+			"inline float4 __tex2Dproj(__sampler2D s, float4 c) { return s.t.Sample(s.s, c.xy / c.w); }\n"
+			"inline int2 __tex2Dsize(__sampler2D s, int lod) { uint w, h, l; s.t.GetDimensions(lod, w, h, l); return int2(w, h); }\n";
+
+		if (featurelevel >= D3D_FEATURE_LEVEL_10_1)
+		{
+			source +=
+				"inline float4 __tex2Dgather0(__sampler2D s, float2 c) { return s.t.Gather(s.s, c); }\n"
+				"inline float4 __tex2Dgather0offset(__sampler2D s, float2 c, int2 offset) { return s.t.Gather(s.s, c, offset); }\n";
+		}
+		else
+		{
+			source +=
+				"inline float4 __tex2Dgather0(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).r, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).r, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).r, s.t.SampleLevel(s.s, c, 0).r); }\n"
+				"inline float4 __tex2Dgather0offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).r, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).r, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).r, s.t.SampleLevel(s.s, c, 0, offset).r); }\n";
+		}
+
+		if (featurelevel >= D3D_FEATURE_LEVEL_11_0)
+		{
+			source +=
+				"inline float4 __tex2Dgather1(__sampler2D s, float2 c) { return s.t.GatherGreen(s.s, c); }\n"
+				"inline float4 __tex2Dgather1offset(__sampler2D s, float2 c, int2 offset) { return s.t.GatherGreen(s.s, c, offset); }\n"
+				"inline float4 __tex2Dgather2(__sampler2D s, float2 c) { return s.t.GatherBlue(s.s, c); }\n"
+				"inline float4 __tex2Dgather2offset(__sampler2D s, float2 c, int2 offset) { return s.t.GatherBlue(s.s, c, offset); }\n"
+				"inline float4 __tex2Dgather3(__sampler2D s, float2 c) { return s.t.GatherAlpha(s.s, c); }\n"
+				"inline float4 __tex2Dgather3offset(__sampler2D s, float2 c, int2 offset) { return s.t.GatherAlpha(s.s, c, offset); }\n";
+		}
+		else
+		{
+			source +=
+				"inline float4 __tex2Dgather1(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).g, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).g, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).g, s.t.SampleLevel(s.s, c, 0).g); }\n"
+				"inline float4 __tex2Dgather1offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).g, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).g, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).g, s.t.SampleLevel(s.s, c, 0, offset).g); }\n"
+				"inline float4 __tex2Dgather2(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).b, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).b, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).b, s.t.SampleLevel(s.s, c, 0).b); }\n"
+				"inline float4 __tex2Dgather2offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).b, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).b, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).b, s.t.SampleLevel(s.s, c, 0, offset).b); }\n"
+				"inline float4 __tex2Dgather3(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).a, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).a, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).a, s.t.SampleLevel(s.s, c, 0).a); }\n"
+				"inline float4 __tex2Dgather3offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).a, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).a, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).a, s.t.SampleLevel(s.s, c, 0, offset).a); }\n";
+		}
+
+		// Only the global variables and functions the entry point can reach are emitted, so that the compiler does not parse and optimize the rest of the effect again for every shader
+		// Declarations are limited to what that code references as well, so that a shader which does not depend on the rest of its effect is generated the same in every effect and can share one shader object
+		std::unordered_set<const variable_declaration_node *> variables;
+		std::unordered_set<const function_declaration_node *> functions;
+		find_references(node, variables, functions);
+
+		std::string code;
+
+		for (auto variable : _ast->variables)
+		{
+			const auto variable_code = _variable_code.find(variable);
+
+			if (variable_code == _variable_code.end())
+			{
+				continue;
+			}
+
+			if (variables.count(variable) != 0)
+			{
+				code += variable_code->second;
+			}
+			else
+			{
+				_unreachable_code_size += variable_code->second.size();
+			}
+		}
+		for (auto function : _ast->functions)
+		{
+			const auto &function_code = _function_code.at(function);
+
+			if (functions.count(function) != 0)
+			{
+				code += function_code;
+			}
+			else
+			{
+				_unreachable_code_size += function_code.size();
+			}
+		}
+
+		// Structures are found by name, going backwards so that those used in the fields of a later one are included too
+		std::string structs;
+
+		for (auto it = _ast->structs.rbegin(); it != _ast->structs.rend(); ++it)
+		{
+			const auto &struct_code = _struct_code.at(*it);
+
+			if (code.find((*it)->unique_name) != std::string::npos || structs.find((*it)->unique_name) != std::string::npos)
+			{
+				structs.insert(0, struct_code);
+			}
+			else
+			{
+				_unreachable_code_size += struct_code.size();
+			}
+		}
+
+		bool references_uniforms = false;
+		std::set<size_t> sampler_states;
+
+		for (auto variable : variables)
+		{
+			if (variable->type.is_sampler())
+			{
+				const auto sampler_state = _sampler_states.find(variable);
+
+				if (sampler_state != _sampler_states.end())
+				{
+					sampler_states.insert(sampler_state->second);
+				}
+			}
+			else if (!variable->type.is_texture() && variable->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				references_uniforms = true;
+			}
+		}
+
+		if (references_uniforms)
+		{
+			source += "cbuffer __GLOBAL__ : register(b0)\n{\n" + _global_uniforms.str() + "};\n";
+		}
+
+		for (auto index : sampler_states)
+		{
+			source += "SamplerState __SamplerState" + std::to_string(index) + " : register(s" + std::to_string(index) + ");\n";
+		}
+
+		size_t texture_index = 0;
+
+		for (auto variable : _ast->variables)
+		{
+			if (!variable->type.is_texture())
+			{
+				continue;
+			}
+
+			const auto binding = _texture_bindings.find(texture_index++);
+
+			if (binding == _texture_bindings.end() || variables.count(variable) == 0)
+			{
+				continue;
+			}
+
+			// Textures this pass does not sample from get no register, the compiler removes them together with the code that references them
+			const auto declare = [this, &source](const std::string &name, size_t index) {
+				source += name;
 
-		HRESULT hr = _runtime->_device->CreateDepthStencilState(&ddesc, &pass.depth_stencil_state);
+				const auto texture_register = _pass_texture_registers.find(index);
+
+				if (texture_register != _pass_texture_registers.end())
+				{
+					source += " : register(t" + std::to_string(texture_register->second) + ")";
+				}
+			};
+
+			source += "Texture2D ";
+			declare(variable->unique_name, binding->second.first);
+			source += ", ";
+			declare("__" + variable->unique_name + "SRGB", binding->second.second);
+			source += ";\n";
+		}
+
+		source += structs;
+		source += code;
+
+		_emitted_code_size += source.size();
+
+		_generated_code.push_back(std::move(source));
+
+		compile_pass_shader(_generated_code.back(), node->unique_name, shadertype, node->location, pass);
+	}
+
+	std::shared_ptr<d3d11_fused_stage> d3d11_effect_compiler::visit_fused_stage(const pass_declaration_node *node, const variable_declaration_node *input)
+	{
+		const auto stage = std::make_shared<d3d11_fused_stage>();
+		stage->srgb_write_enable = node->srgb_write_enable;
+		stage->function_name = node->pixel_shader->unique_name;
+
+		std::stringstream vertex_shader_code, uniform_code, code;
+		visit(vertex_shader_code, node->vertex_shader);
+
+		// All names get a placeholder prefix, which is replaced with a different one for every stage of a fused pass, so that declarations from different effects cannot collide
+		_name_prefix = "__FUSED__";
+		_fused_input = input;
+
+		for (auto variable : _ast->variables)
+		{
+			if (!variable->type.is_texture() && !variable->type.is_sampler() && variable->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				visit(uniform_code, variable->type);
+
+				uniform_code << ' ' << _name_prefix << variable->unique_name;
+
+				if (variable->type.array_length > 0)
+				{
+					uniform_code << '[' << variable->type.array_length << ']';
+				}
+
+				uniform_code << ";\n";
+			}
+		}
+
+		std::unordered_set<const variable_declaration_node *> variables;
+		std::unordered_set<const function_declaration_node *> functions;
+		find_references(node->pixel_shader, variables, functions);
+
+		for (auto structure : _ast->structs)
+		{
+			visit(code, structure);
+		}
+		for (auto variable : _ast->variables)
+		{
+			if (variables.count(variable) != 0 && !variable->type.is_texture() && !variable->type.is_sampler() && !variable->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				visit(code, variable);
+
+				code << ";\n";
+			}
+		}
+		for (auto function : _ast->functions)
+		{
+			if (functions.count(function) != 0 && function != node->pixel_shader)
+			{
+				visit(code, function);
+			}
+		}
+
+		code << "float4 " << _name_prefix << stage->function_name << "(float4 __fused_color";
+
+		_is_in_parameter_block = true;
+
+		for (auto parameter : node->pixel_shader->parameter_list)
+		{
+			code << ", ";
+
+			visit(code, parameter);
+
+			stage->position_arguments.push_back(parameter->semantic.compare(0, 8, "TEXCOORD") != 0);
+		}
+
+		_is_in_parameter_block = false;
+
+		code << ")\n";
+
+		_is_in_function_block = true;
+
+		visit(code, node->pixel_shader->definition);
+
+		_is_in_function_block = false;
+
+		_name_prefix.clear();
+		_fused_input = nullptr;
+
+		stage->vertex_shader_code = vertex_shader_code.str();
+		stage->uniform_code = uniform_code.str();
+		stage->code = code.str();
+
+		return stage;
+	}
+
+	bool d3d11_effect_compiler::create_sampler(const sampler_info &info, const location &location, size_t &sampler_index)
+	{
+		const auto &texture_info = _reflection.textures[info.texture];
+
+		if (_runtime->find_texture(texture_info.name) == nullptr)
+		{
+			error(location, "texture '" + texture_info.name + "' for sampler '" + info.name + "' is missing due to previous error");
+			return false;
+		}
+
+		const D3D11_SAMPLER_DESC desc = make_sampler_desc(info);
+
+		if (const auto existing_index = _runtime->_effect_sampler_descs.find(desc))
+		{
+			sampler_index = *existing_index;
+			return true;
+		}
+
+		ID3D11SamplerState *sampler = nullptr;
+
+		HRESULT hr = _runtime->_device->CreateSamplerState(&desc, &sampler);
 
 		if (FAILED(hr))
 		{
-			warning(node->location, "'ID3D11Device::CreateDepthStencilState' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+			error(location, "'ID3D11Device::CreateSamplerState' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+			return false;
+		}
+
+		_runtime->_effect_sampler_states.push_back(sampler);
+		sampler_index = _runtime->_effect_sampler_descs.insert(desc, _runtime->_effect_sampler_states.size() - 1);
+
+		return true;
+	}
+	void d3d11_effect_compiler::create_technique(const technique_info &info, technique &obj)
+	{
+		obj.name = info.name;
+		obj.annotations = info.annotations;
+
+		if (_constant_buffer_size != 0)
+		{
+			obj.uniform_storage_index = _runtime->_constant_buffers.size();
+			obj.uniform_storage_offset = _uniform_storage_offset;
+		}
+	}
+	void d3d11_effect_compiler::bind_pass_textures(const pass_info &info, d3d11_pass_data &pass)
+	{
+		pass.shader_resources.clear();
+		pass.depth_texture_binding = UINT_MAX;
+
+		// Only bind the textures this pass actually samples from, packed into the lowest registers. The reflection lists the samplers in declaration order.
+		_pass_texture_registers.clear();
+
+		for (const size_t sampler_index : info.samplers)
+		{
+			const auto &sampler = _reflection.samplers[sampler_index];
+			const auto binding = _texture_bindings.find(sampler.texture);
+
+			if (binding == _texture_bindings.end())
+			{
+				continue;
+			}
+
+			const size_t index = sampler.srgb ? binding->second.second : binding->second.first;
+			const UINT texture_register = static_cast<UINT>(pass.shader_resources.size());
+
+			if (_pass_texture_registers.emplace(index, texture_register).second)
+			{
+				if (index == 2)
+				{
+					pass.depth_texture_binding = texture_register;
+				}
+
+				pass.shader_resources.push_back(_runtime->_effect_shader_resources[index]);
+			}
+		}
+	}
+	void d3d11_effect_compiler::create_pass_states(const pass_info &info, const location &location, d3d11_pass_data &pass)
+	{
+		pass.stencil_reference = 0;
+		pass.viewport.TopLeftX = pass.viewport.TopLeftY = pass.viewport.Width = pass.viewport.Height = 0.0f;
+		pass.viewport.MinDepth = 0.0f;
+		pass.viewport.MaxDepth = 1.0f;
+		pass.clear_render_targets = info.clear_render_targets;
+		ZeroMemory(pass.render_targets, sizeof(pass.render_targets));
+		ZeroMemory(pass.render_target_resources, sizeof(pass.render_target_resources));
+
+		const int target_index = info.srgb_write_enable ? 1 : 0;
+		pass.render_targets[0] = _runtime->_backbuffer_rtv[target_index].get();
+		pass.render_target_resources[0] = _runtime->_backbuffer_texture_srv[target_index].get();
+
+		for (size_t i = 0; i < info.render_targets.size(); i++)
+		{
+			if (info.render_targets[i] == pass_info::no_render_target)
+			{
+				continue;
+			}
+
+			const auto texture = _runtime->find_texture(_reflection.textures[info.render_targets[i]].name);
+
+			if (texture == nullptr)
+			{
+				error(location, "texture not found");
+				return;
+			}
+
+			const auto texture_impl = texture->impl->as<d3d11_tex_data>();
+
+			D3D11_TEXTURE2D_DESC desc;
+			texture_impl->texture->GetDesc(&desc);
+
+			if (pass.viewport.Width != 0 && pass.viewport.Height != 0 && (desc.Width != static_cast<unsigned int>(pass.viewport.Width) || desc.Height != static_cast<unsigned int>(pass.viewport.Height)))
+			{
+				error(location, "cannot use multiple rendertargets with different sized textures");
+				return;
+			}
+			else
+			{
+				pass.viewport.Width = static_cast<FLOAT>(desc.Width);
+				pass.viewport.Height = static_cast<FLOAT>(desc.Height);
+			}
+
+			D3D11_RENDER_TARGET_VIEW_DESC rtvdesc = { };
+			rtvdesc.Format = info.srgb_write_enable ? make_format_srgb(desc.Format) : make_format_normal(desc.Format);
+			rtvdesc.ViewDimension = desc.SampleDesc.Count > 1 ? D3D11_RTV_DIMENSION_TEXTURE2DMS : D3D11_RTV_DIMENSION_TEXTURE2D;
+
+			if (texture_impl->rtv[target_index] == nullptr)
+			{
+				HRESULT hr = _runtime->_device->CreateRenderTargetView(texture_impl->texture.get(), &rtvdesc, &texture_impl->rtv[target_index]);
+
+				if (FAILED(hr))
+				{
+					warning(location, "'ID3D11Device::CreateRenderTargetView' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+				}
+			}
+
+			pass.render_targets[i] = texture_impl->rtv[target_index].get();
+			pass.render_target_resources[i] = texture_impl->srv[target_index].get();
+
+			if (texture_impl->upscaled_rtv != nullptr)
+			{
+				pass.upscales.emplace_back(texture_impl->srv[0].get(), texture_impl->upscaled_rtv.get());
+			}
 		}
 
-		D3D11_BLEND_DESC bdesc;
+		if (pass.viewport.Width == 0 && pass.viewport.Height == 0)
+		{
+			pass.viewport.Width = static_cast<FLOAT>(_runtime->frame_width());
+			pass.viewport.Height = static_cast<FLOAT>(_runtime->frame_height());
+		}
+
+		// Passes at full resolution sample the upscaled copies of render targets that were created at a reduced scale
+		if (static_cast<unsigned int>(pass.viewport.Width) == _runtime->frame_width() && static_cast<unsigned int>(pass.viewport.Height) == _runtime->frame_height())
+		{
+			for (const auto &binding : _pass_texture_registers)
+			{
+				const auto upscaled = _upscaled_shader_resources.find(binding.first);
+
+				if (upscaled != _upscaled_shader_resources.end())
+				{
+					pass.shader_resources[binding.second] = _runtime->_effect_shader_resources[upscaled->second];
+				}
+			}
+		}
+
+		D3D11_DEPTH_STENCIL_DESC ddesc = { };
+		ddesc.DepthEnable = FALSE;
+		ddesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+		ddesc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+		ddesc.StencilEnable = info.stencil_enable;
+		ddesc.StencilReadMask = info.stencil_read_mask;
+		ddesc.StencilWriteMask = info.stencil_write_mask;
+		ddesc.FrontFace.StencilFunc = ddesc.BackFace.StencilFunc = static_cast<D3D11_COMPARISON_FUNC>(info.stencil_comparison_func);
+		ddesc.FrontFace.StencilPassOp = ddesc.BackFace.StencilPassOp = literal_to_stencil_op(info.stencil_op_pass);
+		ddesc.FrontFace.StencilFailOp = ddesc.BackFace.StencilFailOp = literal_to_stencil_op(info.stencil_op_fail);
+		ddesc.FrontFace.StencilDepthFailOp = ddesc.BackFace.StencilDepthFailOp = literal_to_stencil_op(info.stencil_op_depth_fail);
+		pass.stencil_reference = info.stencil_reference_value;
+
+		// Passes with equal states share the state objects that were created for the first of them
+		if (const auto depth_stencil_state = _runtime->_effect_depth_stencil_states.find(ddesc))
+		{
+			pass.depth_stencil_state = *depth_stencil_state;
+		}
+		else
+		{
+			const HRESULT hr = _runtime->_device->CreateDepthStencilState(&ddesc, &pass.depth_stencil_state);
+
+			if (SUCCEEDED(hr))
+			{
+				_runtime->_effect_depth_stencil_states.insert(ddesc, pass.depth_stencil_state);
+			}
+			else
+			{
+				warning(location, "'ID3D11Device::CreateDepthStencilState' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+			}
+		}
+
+		D3D11_BLEND_DESC bdesc = { };
 		bdesc.AlphaToCoverageEnable = FALSE;
 		bdesc.IndependentBlendEnable = FALSE;
-		bdesc.RenderTarget[0].RenderTargetWriteMask = node->color_write_mask;
-		bdesc.RenderTarget[0].BlendEnable = node->blend_enable;
-		bdesc.RenderTarget[0].BlendOp = static_cast<D3D11_BLEND_OP>(node->blend_op);
-		bdesc.RenderTarget[0].BlendOpAlpha = static_cast<D3D11_BLEND_OP>(node->blend_op_alpha);
-		bdesc.RenderTarget[0].SrcBlend = literal_to_blend_func(node->src_blend);
-		bdesc.RenderTarget[0].DestBlend = literal_to_blend_func(node->dest_blend);
+		bdesc.RenderTarget[0].RenderTargetWriteMask = info.color_write_mask;
+		bdesc.RenderTarget[0].BlendEnable = info.blend_enable;
+		bdesc.RenderTarget[0].BlendOp = static_cast<D3D11_BLEND_OP>(info.blend_op);
+		bdesc.RenderTarget[0].BlendOpAlpha = static_cast<D3D11_BLEND_OP>(info.blend_op_alpha);
+		bdesc.RenderTarget[0].SrcBlend = literal_to_blend_func(info.src_blend);
+		bdesc.RenderTarget[0].DestBlend = literal_to_blend_func(info.dest_blend);
 
-		hr = _runtime->_device->CreateBlendState(&bdesc, &pass.blend_state);
-
-		if (FAILED(hr))
+		if (const auto blend_state = _runtime->_effect_blend_states.find(bdesc))
+		{
+			pass.blend_state = *blend_state;
+		}
+		else
 		{
-			warning(node->location, "'ID3D11Device::CreateBlendState' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+			const HRESULT hr = _runtime->_device->CreateBlendState(&bdesc, &pass.blend_state);
+
+			if (SUCCEEDED(hr))
+			{
+				_runtime->_effect_blend_states.insert(bdesc, pass.blend_state);
+			}
+			else
+			{
+				warning(location, "'ID3D11Device::CreateBlendState' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
+			}
 		}
 
 		for (auto &srv : pass.shader_resources)
@@ -1820,12 +2477,11 @@ namespace reshade::d3d11
 			}
 		}
 	}
-	void d3d11_effect_compiler::visit_pass_shader(const function_declaration_node *node, const std::string &shadertype, d3d11_pass_data &pass)
+	void d3d11_effect_compiler::compile_pass_shader(const std::string &source, const std::string &entry_point, const std::string &shadertype, const location &location, d3d11_pass_data &pass)
 	{
 		std::string profile = shadertype;
-		const D3D_FEATURE_LEVEL featurelevel = _runtime->_device->GetFeatureLevel();
 
-		switch (featurelevel)
+		switch (_runtime->_device->GetFeatureLevel())
 		{
 			default:
 			case D3D_FEATURE_LEVEL_11_0:
@@ -1846,96 +2502,197 @@ namespace reshade::d3d11
 				break;
 		}
 
-		std::string source =
-			"#pragma warning(disable: 3571)\n"
-			"struct __sampler2D { Texture2D t; SamplerState s; };\n"
-			"inline float4 __tex2D(__sampler2D s, float2 c) { return s.t.Sample(s.s, c); }\n"
-			"inline float4 __tex2Dfetch(__sampler2D s, int4 c) { return s.t.Load(c.xyw); }\n"
-			"inline float4 __tex2Dgrad(__sampler2D s, float2 c, float2 ddx, float2 ddy) { return s.t.SampleGrad(s.s, c, ddx, ddy); }\n"
-			"inline float4 __tex2Dlod(__sampler2D s, float4 c) { return s.t.SampleLevel(s.s, c.xy, c.w); }\n"
-			"inline float4 __tex2Dlodoffset(__sampler2D s, float4 c, int2 offset) { return s.t.SampleLevel(s.s, c.xy, c.w, offset); }\n"
-			"inline float4 __tex2Doffset(__sampler2D s, float2 c, int2 offset) { return s.t.Sample(s.s, c, offset); }\n"
-			"inline float4 __tex2Dproj(__sampler2D s, float4 c) { return s.t.Sample(s.s, c.xy / c.w); }\n"
-			"inline int2 __tex2Dsize(__sampler2D s, int lod) { uint w, h, l; s.t.GetDimensions(lod, w, h, l); return int2(w, h); }\n";
+		UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
 
-		if (featurelevel >= D3D_FEATURE_LEVEL_10_1)
-		{
-			source +=
-				"inline float4 __tex2Dgather0(__sampler2D s, float2 c) { return s.t.Gather(s.s, c); }\n"
-				"inline float4 __tex2Dgather0offset(__sampler2D s, float2 c, int2 offset) { return s.t.Gather(s.s, c, offset); }\n";
-		}
-		else
+		if (_skip_shader_optimization)
 		{
-			source +=
-				"inline float4 __tex2Dgather0(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).r, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).r, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).r, s.t.SampleLevel(s.s, c, 0).r); }\n"
-				"inline float4 __tex2Dgather0offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).r, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).r, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).r, s.t.SampleLevel(s.s, c, 0, offset).r); }\n";
+			flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 		}
 
-		if (featurelevel >= D3D_FEATURE_LEVEL_11_0)
+		const std::string options = profile + ' ' + std::to_string(flags);
+		const std::string object_key = make_shader_object_key(source, entry_point, options);
+		shader_cache::compiled_shader compiled;
+
+		// Passes that generate the same source share the shader object that was created for the first of them
+		if (shadertype == "vs" ? _runtime->_vertex_shader_cache.find(object_key, pass.vertex_shader, compiled.messages) : _runtime->_pixel_shader_cache.find(object_key, pass.pixel_shader, compiled.messages))
 		{
-			source +=
-				"inline float4 __tex2Dgather1(__sampler2D s, float2 c) { return s.t.GatherGreen(s.s, c); }\n"
-				"inline float4 __tex2Dgather1offset(__sampler2D s, float2 c, int2 offset) { return s.t.GatherGreen(s.s, c, offset); }\n"
-				"inline float4 __tex2Dgather2(__sampler2D s, float2 c) { return s.t.GatherBlue(s.s, c); }\n"
-				"inline float4 __tex2Dgather2offset(__sampler2D s, float2 c, int2 offset) { return s.t.GatherBlue(s.s, c, offset); }\n"
-				"inline float4 __tex2Dgather3(__sampler2D s, float2 c) { return s.t.GatherAlpha(s.s, c); }\n"
-				"inline float4 __tex2Dgather3offset(__sampler2D s, float2 c, int2 offset) { return s.t.GatherAlpha(s.s, c, offset); }\n";
+			_errors += compiled.messages;
+			return;
 		}
-		else
+
+		if (!_runtime->_shader_cache.find(source, entry_point, options, compiled))
 		{
-			source +=
-				"inline float4 __tex2Dgather1(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).g, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).g, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).g, s.t.SampleLevel(s.s, c, 0).g); }\n"
-				"inline float4 __tex2Dgather1offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).g, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).g, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).g, s.t.SampleLevel(s.s, c, 0, offset).g); }\n"
-				"inline float4 __tex2Dgather2(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).b, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).b, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).b, s.t.SampleLevel(s.s, c, 0).b); }\n"
-				"inline float4 __tex2Dgather2offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).b, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).b, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).b, s.t.SampleLevel(s.s, c, 0, offset).b); }\n"
-				"inline float4 __tex2Dgather3(__sampler2D s, float2 c) { return float4( s.t.SampleLevel(s.s, c, 0, int2(0, 1)).a, s.t.SampleLevel(s.s, c, 0, int2(1, 1)).a, s.t.SampleLevel(s.s, c, 0, int2(1, 0)).a, s.t.SampleLevel(s.s, c, 0).a); }\n"
-				"inline float4 __tex2Dgather3offset(__sampler2D s, float2 c, int2 offset) { return float4( s.t.SampleLevel(s.s, c, 0, offset + int2(0, 1)).a, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 1)).a, s.t.SampleLevel(s.s, c, 0, offset + int2(1, 0)).a, s.t.SampleLevel(s.s, c, 0, offset).a); }\n";
-		}
+			com_ptr<ID3DBlob> bytecode, errors;
 
-		source += "cbuffer __GLOBAL__ : register(b0)\n{\n" + _global_uniforms.str() + "};\n";
+			const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
+			const auto compile_start = std::chrono::high_resolution_clock::now();
+			const HRESULT hr = D3DCompile(source.c_str(), source.length(), nullptr, nullptr, nullptr, entry_point.c_str(), profile.c_str(), flags, 0, &bytecode, &errors);
+			_compile_time += std::chrono::high_resolution_clock::now() - compile_start;
 
-		for (const auto &samplerdesc : _runtime->_effect_sampler_descs)
-		{
-			source += "SamplerState __SamplerState" + std::to_string(samplerdesc.second) + " : register(s" + std::to_string(samplerdesc.second) + ");\n";
-		}
+			if (shadertype == "vs")
+			{
+				_runtime->_vertex_shader_cache.count_compilation();
+			}
+			else
+			{
+				_runtime->_pixel_shader_cache.count_compilation();
+			}
 
-		source += _global_code.str();
+			if (errors != nullptr)
+			{
+				compiled.messages.assign(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
+			}
 
-		UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
-		com_ptr<ID3DBlob> compiled, errors;
+			if (FAILED(hr))
+			{
+				_errors += compiled.messages;
 
-		if (_skip_shader_optimization)
-		{
-			flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
+				error(location, "internal shader compilation failed");
+				return;
+			}
+
+			compiled.bytecode.assign(static_cast<const char *>(bytecode->GetBufferPointer()), bytecode->GetBufferSize());
+
+			_runtime->_shader_cache.insert(source, entry_point, options, compiled);
 		}
 
-		const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
-		HRESULT hr = D3DCompile(source.c_str(), source.length(), nullptr, nullptr, nullptr, node->unique_name.c_str(), profile.c_str(), flags, 0, &compiled, &errors);
+		// Warnings are reported again when the shader is taken from the cache
+		_errors += compiled.messages;
 
-		if (errors != nullptr)
+		HRESULT hr = S_OK;
+
+		if (shadertype == "vs")
+		{
+			hr = _runtime->_device->CreateVertexShader(compiled.bytecode.data(), compiled.bytecode.size(), nullptr, &pass.vertex_shader);
+		}
+		else if (shadertype == "ps")
 		{
-			_errors.append(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
+			hr = _runtime->_device->CreatePixelShader(compiled.bytecode.data(), compiled.bytecode.size(), nullptr, &pass.pixel_shader);
 		}
 
 		if (FAILED(hr))
 		{
-			error(node->location, "internal shader compilation failed");
+			error(location, "'CreateShader' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
 			return;
 		}
 
 		if (shadertype == "vs")
 		{
-			hr = _runtime->_device->CreateVertexShader(compiled->GetBufferPointer(), compiled->GetBufferSize(), nullptr, &pass.vertex_shader);
+			_runtime->_vertex_shader_cache.insert(object_key, pass.vertex_shader, compiled.messages);
 		}
-		else if (shadertype == "ps")
+		else
 		{
-			hr = _runtime->_device->CreatePixelShader(compiled->GetBufferPointer(), compiled->GetBufferSize(), nullptr, &pass.pixel_shader);
+			_runtime->_pixel_shader_cache.insert(object_key, pass.pixel_shader, compiled.messages);
 		}
+	}
 
-		if (FAILED(hr))
+	bool d3d11_effect_compiler::compile_fused_pass(d3d11_runtime *runtime, const std::vector<const d3d11_fused_stage *> &stages, bool saturate, std::string &bytecode, std::string &errors)
+	{
+		std::string profile;
+
+		// The feature level the runtime was created with, the device itself is not used on this thread
+		switch (static_cast<D3D_FEATURE_LEVEL>(runtime->_renderer_id))
 		{
-			error(node->location, "'CreateShader' failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
-			return;
+			default:
+			case D3D_FEATURE_LEVEL_11_0:
+				profile = "ps_5_0";
+				break;
+			case D3D_FEATURE_LEVEL_10_1:
+				profile = "ps_4_1";
+				break;
+			case D3D_FEATURE_LEVEL_10_0:
+				profile = "ps_4_0";
+				break;
+		}
+
+		const auto replace_prefix = [](std::string code, const std::string &prefix) {
+			for (size_t offset = 0; (offset = code.find("__FUSED__", offset)) != std::string::npos; offset += prefix.size())
+			{
+				code.replace(offset, 9, prefix);
+			}
+
+			return code;
+		};
+
+		// The first stage reads the back buffer, all following ones continue with the color computed by their predecessor
+		std::string source =
+			"#pragma warning(disable: 3571)\n"
+			"Texture2D __fused_backbuffer : register(t0);\n";
+		std::string main =
+			"float4 __fused_main(float4 __fused_position : SV_POSITION, float2 __fused_texcoord : TEXCOORD0) : SV_TARGET\n"
+			"{\n"
+			"\tfloat4 __fused_color = __fused_backbuffer.Load(int3(__fused_position.xy, 0));\n";
+
+		for (size_t i = 0; i < stages.size(); i++)
+		{
+			const std::string prefix = "__f" + std::to_string(i) + '_';
+
+			if (!stages[i]->uniform_code.empty())
+			{
+				source += "cbuffer " + prefix + "GLOBAL__ : register(b" + std::to_string(i) + ")\n{\n" + replace_prefix(stages[i]->uniform_code, prefix) + "};\n";
+			}
+
+			source += replace_prefix(stages[i]->code, prefix);
+
+			main += "\t__fused_color = " + prefix + stages[i]->function_name + "(__fused_color";
+
+			for (bool position : stages[i]->position_arguments)
+			{
+				main += position ? ", __fused_position" : ", __fused_texcoord";
+			}
+
+			main += ");\n";
+
+			// Rendered one by one, every technique writes its result to the back buffer, which clamps it before the next one reads it
+			if (saturate && i + 1 < stages.size())
+			{
+				main += "\t__fused_color = saturate(__fused_color);\n";
+			}
 		}
+
+		source += main + "\treturn __fused_color;\n}\n";
+
+		const std::string options = profile + ' ' + std::to_string(D3DCOMPILE_ENABLE_STRICTNESS);
+		shader_cache::compiled_shader compiled;
+
+		if (!runtime->_shader_cache.find(source, "__fused_main", options, compiled))
+		{
+			HMODULE d3dcompiler_module = LoadLibraryW(L"d3dcompiler_47.dll");
+
+			if (d3dcompiler_module == nullptr)
+			{
+				d3dcompiler_module = LoadLibraryW(L"d3dcompiler_43.dll");
+			}
+			if (d3dcompiler_module == nullptr)
+			{
+				errors += "Unable to load D3DCompiler library.\n";
+				return false;
+			}
+
+			com_ptr<ID3DBlob> compile_output, compile_errors;
+
+			const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(d3dcompiler_module, "D3DCompile"));
+			const HRESULT hr = D3DCompile(source.c_str(), source.length(), nullptr, nullptr, nullptr, "__fused_main", profile.c_str(), D3DCOMPILE_ENABLE_STRICTNESS, 0, &compile_output, &compile_errors);
+
+			if (compile_errors != nullptr)
+			{
+				errors.append(static_cast<const char *>(compile_errors->GetBufferPointer()), compile_errors->GetBufferSize() - 1);
+			}
+
+			FreeLibrary(d3dcompiler_module);
+
+			if (FAILED(hr))
+			{
+				return false;
+			}
+
+			compiled.bytecode.assign(static_cast<const char *>(compile_output->GetBufferPointer()), compile_output->GetBufferSize());
+
+			runtime->_shader_cache.insert(source, "__fused_main", options, compiled);
+		}
+
+		bytecode = std::move(compiled.bytecode);
+
+		return true;
 	}
 }
\ No newline at end of file
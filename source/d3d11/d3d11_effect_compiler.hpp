@@ -5,23 +5,51 @@
 
 #pragma once
 
+#include <chrono>
 #include <sstream>
 #include "syntax_tree.hpp"
+#include "effect_reflection.hpp"
 
 namespace reshade::d3d11
 {
 	#pragma region Forward Declarations
 	struct d3d11_pass_data;
+	struct d3d11_fused_stage;
 	class d3d11_runtime;
 	#pragma endregion
 
 	class d3d11_effect_compiler
 	{
 	public:
+		/// <summary>
+		/// Incremented whenever the generated code or its layout changes, so that code stored by an older version is not loaded again.
+		/// </summary>
+		static constexpr unsigned int generated_code_version = 1;
+
 		d3d11_effect_compiler(d3d11_runtime *runtime, const reshadefx::syntax_tree &ast, std::string &errors, bool skipoptimization = false);
+		/// <summary>
+		/// Create a compiler that loads an effect from its reflection and the code generated for it by an earlier run, without a syntax tree.
+		/// </summary>
+		d3d11_effect_compiler(d3d11_runtime *runtime, const reshadefx::effect_reflection &reflection, const std::vector<std::string> &code, std::string &errors, bool skipoptimization = false);
 
 		bool run();
 
+		/// <summary>
+		/// Hand out the reflection and the code generated by a successful run from a syntax tree, so that they can be passed to the other constructor later.
+		/// </summary>
+		void take_generated_code(reshadefx::effect_reflection &reflection, std::vector<std::string> &code);
+
+		/// <summary>
+		/// Compile the bytecode of a pixel shader that evaluates the specified stages one after another on the color of each pixel. The uniforms of stage N are read from constant buffer slot N.
+		/// Touches neither the device nor the device context, so it can be called from a worker thread. The shader object has to be created on the render thread, since the device may have been created single-threaded.
+		/// </summary>
+		/// <param name="runtime">The runtime to compile for.</param>
+		/// <param name="stages">The stages to chain, in rendering order.</param>
+		/// <param name="saturate">Clamp the color between stages, like writing it to a normalized back buffer does when the techniques are rendered one by one.</param>
+		/// <param name="bytecode">Receives the compiled bytecode on success.</param>
+		/// <param name="errors">A reference to a buffer to store errors which occur during compilation.</param>
+		static bool compile_fused_pass(d3d11_runtime *runtime, const std::vector<const d3d11_fused_stage *> &stages, bool saturate, std::string &bytecode, std::string &errors);
+
 	private:
 		void error(const reshadefx::location &location, const std::string &message);
 		void warning(const reshadefx::location &location, const std::string &message);
@@ -56,20 +84,51 @@ namespace reshade::d3d11
 		void visit(std::stringstream &output, const reshadefx::nodes::variable_declaration_node *node, bool with_type = true);
 		void visit(std::stringstream &output, const reshadefx::nodes::function_declaration_node *node);
 
-		void visit_texture(const reshadefx::nodes::variable_declaration_node *node);
+		/// <summary>
+		/// Check that the loaded code has the layout this version generates and that the samplers would get the indices it refers to. Has no side effects.
+		/// </summary>
+		bool check_generated_code();
+		bool run_generated();
+
+		void visit_texture(const reshadefx::location &location);
 		void visit_sampler(const reshadefx::nodes::variable_declaration_node *node);
 		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node);
 		void visit_technique(const reshadefx::nodes::technique_declaration_node *node);
-		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, d3d11_pass_data &pass);
+		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, const reshadefx::pass_info &info, d3d11_pass_data &pass);
 		void visit_pass_shader(const reshadefx::nodes::function_declaration_node *node, const std::string &shadertype, d3d11_pass_data &pass);
+		std::shared_ptr<d3d11_fused_stage> visit_fused_stage(const reshadefx::nodes::pass_declaration_node *node, const reshadefx::nodes::variable_declaration_node *input);
+
+		bool create_sampler(const reshadefx::sampler_info &info, const reshadefx::location &location, size_t &sampler_index);
+		void create_technique(const reshadefx::technique_info &info, technique &obj);
+		void bind_pass_textures(const reshadefx::pass_info &info, d3d11_pass_data &pass);
+		void create_pass_states(const reshadefx::pass_info &info, const reshadefx::location &location, d3d11_pass_data &pass);
+		void compile_pass_shader(const std::string &source, const std::string &entry_point, const std::string &shadertype, const reshadefx::location &location, d3d11_pass_data &pass);
 
 		d3d11_runtime *_runtime;
 		bool _success = true;
-		const reshadefx::syntax_tree &_ast;
+		// Null when the effect is loaded from generated code
+		const reshadefx::syntax_tree *_ast;
+		const std::vector<std::string> *_loaded_code = nullptr;
 		std::string &_errors;
-		std::stringstream _global_code, _global_uniforms;
+		std::stringstream _global_uniforms;
+		std::unordered_map<const reshadefx::nodes::struct_declaration_node *, std::string> _struct_code;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, std::string> _variable_code;
+		std::unordered_map<const reshadefx::nodes::function_declaration_node *, std::string> _function_code;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, size_t> _sampler_states;
+		// The sampler state indices and the source of every pass shader, see <see cref="take_generated_code"/>
+		std::vector<std::string> _generated_code;
+		size_t _emitted_code_size = 0, _unreachable_code_size = 0;
+		std::chrono::high_resolution_clock::duration _compile_time = std::chrono::high_resolution_clock::duration::zero();
+		std::string _name_prefix;
+		const reshadefx::nodes::variable_declaration_node *_fused_input = nullptr;
 		bool _skip_shader_optimization, _is_in_parameter_block = false, _is_in_function_block = false;
-		size_t _uniform_storage_offset = 0, _constant_buffer_size = 0;
+		size_t _uniform_storage_offset = 0, _constant_buffer_size = 0, _uniform_index = 0, _texture_index = 0, _sampler_index = 0, _technique_index = 0;
+		reshadefx::effect_reflection _reflection;
+		// Maps the index of a texture in the reflection to its shader resources, without and with sRGB
+		std::unordered_map<size_t, std::pair<size_t, size_t>> _texture_bindings;
+		std::unordered_map<size_t, UINT> _pass_texture_registers;
+		// Maps the shader resources of render targets created at a reduced scale to their full resolution copies
+		std::unordered_map<size_t, size_t> _upscaled_shader_resources;
 		HMODULE _d3dcompiler_module = nullptr;
 	};
 }
@@ -9,6 +9,7 @@
 #include "lexer.hpp"
 #include "input.hpp"
 #include "resource_loading.hpp"
+#include "com_release_notifier.hpp"
 #include "..\deps\imgui\imgui.h"
 #include <algorithm>
 #include <map>
@@ -99,7 +100,8 @@ void
 __stdcall
 SK_ReShade_OnSetDepthStencilViewD3D11 (void* user, ID3D11DepthStencilView *&depthstencil)
 {
-  ((reshade::d3d11::d3d11_runtime *)user)->on_set_depthstencil_view (depthstencil);
+  // The signature is part of the contract with Special K, which does not pass the context, so the binding is not remembered for the draw call path
+  ((reshade::d3d11::d3d11_runtime *)user)->on_set_depthstencil_view (nullptr, depthstencil);
 }
 
 void
@@ -195,6 +197,29 @@ namespace reshade::d3d11
 	extern DXGI_FORMAT make_format_normal   (DXGI_FORMAT format);
 	extern DXGI_FORMAT make_format_typeless (DXGI_FORMAT format);
 
+	static bool
+	is_normalized_format (DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+			case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+			case DXGI_FORMAT_R8G8B8A8_UNORM:
+			case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+			case DXGI_FORMAT_B8G8R8A8_UNORM:
+			case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+			case DXGI_FORMAT_B8G8R8X8_UNORM:
+			case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+			case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+			case DXGI_FORMAT_R10G10B10A2_UNORM:
+			case DXGI_FORMAT_R16G16B16A16_UNORM:
+				return true;
+			default:
+				return false;
+		}
+	}
+
 	d3d11_runtime::d3d11_runtime (ID3D11Device *device, IDXGISwapChain *swapchain) : runtime     (device->GetFeatureLevel ()),
 	                                                                                 _device     (device),
 	                                                                                 _swapchain  (swapchain),
@@ -411,6 +436,23 @@ namespace reshade::d3d11
 			}
 		}
 
+		{
+			const D3D11_SAMPLER_DESC desc = {
+				D3D11_FILTER_MIN_MAG_MIP_LINEAR,
+				D3D11_TEXTURE_ADDRESS_CLAMP,
+				D3D11_TEXTURE_ADDRESS_CLAMP,
+				D3D11_TEXTURE_ADDRESS_CLAMP
+			};
+
+			hr =
+				_device->CreateSamplerState (&desc, &_upscale_sampler);
+
+			if (FAILED (hr))
+			{
+				return false;
+			}
+		}
+
 		return true;
 	}
 
@@ -472,6 +514,8 @@ namespace reshade::d3d11
 		_backbuffer_format        = desc.BufferDesc.Format;
 		_is_multisampling_enabled = desc.SampleDesc.Count > 1;
 
+		_depth_source_tracker.on_resize (_width, _height);
+
 		if ( (! init_backbuffer_texture    ()) ||
 			   (! init_default_depth_stencil ()) ||
 			   (! init_fx_resources          ()) )
@@ -510,8 +554,7 @@ namespace reshade::d3d11
 
 		_depthstencil.reset                 ();
 		_depthstencil_replacement.reset     ();
-    for ( auto it : _depth_source_table ) it.first->Release  ();
-		                _depth_source_table.clear           ();
+		_depth_source_tracker.reset         ();
 		_depthstencil_texture.reset         ();
 		_depthstencil_texture_srv.reset     ();
 
@@ -519,6 +562,7 @@ namespace reshade::d3d11
 		_copy_vertex_shader.reset           ();
 		_copy_pixel_shader.reset            ();
 		_copy_sampler.reset                 ();
+		_upscale_sampler.reset              ();
 
 		_effect_rasterizer_state.reset      ();
 	}
@@ -533,14 +577,39 @@ namespace reshade::d3d11
 			it->Release ();
 		}
 
-		_effect_sampler_descs.clear  ();
-		_effect_sampler_states.clear ();
+		_effect_sampler_descs.clear        ();
+		_effect_sampler_states.clear       ();
+		_effect_blend_states.clear         ();
+		_effect_depth_stencil_states.clear ();
 		_constant_buffers.clear      ();
 
+		_vertex_shader_cache.clear ();
+		_pixel_shader_cache.clear  ();
+
+		_fusion_enabled_techniques.clear ();
+		_fused_groups.clear              ();
+		_fused_techniques.clear          ();
+		_fused_shaders.clear             ();
+		_fused_shaders_pending = 0;
+
+		_generated_code.clear ();
+
 		_effect_shader_resources.resize (3);
 		_effect_shader_resources [0] = _backbuffer_texture_srv [0].get ();
 		_effect_shader_resources [1] = _backbuffer_texture_srv [1].get ();
 		_effect_shader_resources [2] = _depthstencil_texture_srv.get   ();
+
+		// Without effects only a single texture is copied to the back buffer
+		_stateblock.set_used_slots (1, 1, 1, 1);
+	}
+
+	shader_object_statistics
+	d3d11_runtime::get_shader_statistics (void) const
+	{
+		auto statistics = _vertex_shader_cache.statistics ();
+		statistics     += _pixel_shader_cache.statistics  ();
+
+		return statistics;
 	}
 
 	void
@@ -562,6 +631,19 @@ namespace reshade::d3d11
       first = false;
     }
 
+		// Merge the draw call statistics every thread has handed over since the last present, which are those of the frame before
+		// The last draw call index is counted per submitting thread, so with deferred contexts it only approximates the position in the frame
+		const auto frame_counters =
+			_draw_call_tracker.merge (
+				[this] (ID3D11DepthStencilView *depthstencil, const auto &counters)
+				{
+					_depth_source_tracker.on_draw (depthstencil, counters.last_drawcall, counters.vertices);
+				}
+			);
+
+		_drawcalls += frame_counters.drawcalls;
+		_vertices  += frame_counters.vertices;
+
 		if ((! is_initialized ()) || _drawcalls.load () == 0)
 		{
 			return;
@@ -980,39 +1062,47 @@ namespace reshade::d3d11
 	void
 	d3d11_runtime::on_draw_call (ID3D11DeviceContext *context, unsigned int vertices)
 	{
-		_vertices  += vertices;
-		_drawcalls += 1;
-
-		com_ptr <ID3D11DepthStencilView> current_depthstencil = nullptr;
+		ID3D11DepthStencilView *current_depthstencil = nullptr;
 
-		context->OMGetRenderTargets ( 0, nullptr,
-                                    &current_depthstencil );
-
-		if ( current_depthstencil == nullptr ||
-			   current_depthstencil == _default_depthstencil )
+		// Only ask the driver if the binding was changed behind our back
+		if (! _draw_call_tracker.find_binding (context, current_depthstencil))
 		{
-			return;
+			context->OMGetRenderTargets ( 0, nullptr,
+			                                &current_depthstencil );
+
+			if (current_depthstencil != nullptr)
+			{
+				current_depthstencil->Release ();
+			}
 		}
 
-		if (current_depthstencil == _depthstencil_replacement)
+		if ( current_depthstencil == _default_depthstencil )
 		{
-			current_depthstencil = _depthstencil;
+			current_depthstencil = nullptr;
 		}
-
-		const auto it =
-			_depth_source_table.find (current_depthstencil.get ());
-
-		if (it != _depth_source_table.cend () && (! it->second.invalidated))
+		else if ( current_depthstencil != nullptr &&
+		          current_depthstencil == _depthstencil_replacement )
 		{
-			it->second.drawcall_count = _drawcalls.load ();
-			it->second.vertices_count += vertices;
+			current_depthstencil = _depthstencil.get ();
 		}
+
+		_draw_call_tracker.on_draw (current_depthstencil, vertices);
 	}
 
 	void
-	d3d11_runtime::on_set_depthstencil_view (ID3D11DepthStencilView *&depthstencil)
+	d3d11_runtime::on_set_depthstencil_view (ID3D11DeviceContext *context, ID3D11DepthStencilView *&depthstencil)
 	{
-		if ( (! _depth_source_table.count (depthstencil)) || _depth_source_table [depthstencil].invalidated )
+		if (context != nullptr)
+		{
+			_draw_call_tracker.track_binding (context, depthstencil);
+		}
+
+		if (depthstencil == nullptr)
+		{
+			return;
+		}
+
+		if (! _depth_source_tracker.is_tracked (depthstencil))
 		{
 			D3D11_TEXTURE2D_DESC texture_desc = { };
 
@@ -1028,24 +1118,23 @@ namespace reshade::d3d11
 
 			texture->GetDesc (&texture_desc);
 
-			// Early depth stencil rejection
-			if ( texture_desc.Width            != _width  ||
-			     texture_desc.Height           != _height ||
-			     texture_desc.SampleDesc.Count >  1 )
+			// Early depth stencil rejection, with the same size tolerance as the tracker and the other backends
+			if (   texture_desc.SampleDesc.Count > 1                                              ||
+			     ( texture_desc.Width  < _width  * 0.95 || texture_desc.Width  > _width  * 1.05 ) ||
+			     ( texture_desc.Height < _height * 0.95 || texture_desc.Height > _height * 1.05 ) )
 			{
 				return;
 			}
 
-			depthstencil->AddRef ();
+			// Stop tracking when the view is destroyed, instead of holding a reference to it
+			if (! com_release_notifier::attach (depthstencil, _depth_source_tracker.owner           (),
+			                                                  _depth_source_tracker.release_callback (depthstencil)))
+			{
+				return;
+			}
 
 			// Begin tracking new depth stencil
-			const depth_source_info info =
-				{ texture_desc.Width, texture_desc.Height,
-				  0,                  0,
-				  false
-				};
-
-			_depth_source_table [depthstencil] = info;
+			_depth_source_tracker.track (depthstencil, texture_desc.Width, texture_desc.Height);
 		}
 
 		if (_depthstencil_replacement != nullptr && depthstencil == _depthstencil)
@@ -1054,6 +1143,19 @@ namespace reshade::d3d11
 		}
 	}
 
+	void
+	d3d11_runtime::on_reset_context_state (ID3D11DeviceContext *context, bool cleared)
+	{
+		if (cleared)
+		{
+			_draw_call_tracker.track_binding  (context, nullptr);
+		}
+		else
+		{
+			_draw_call_tracker.forget_binding (context);
+		}
+	}
+
 	void
 	d3d11_runtime::on_get_depthstencil_view (ID3D11DepthStencilView *&depthstencil)
 	{
@@ -1178,7 +1280,84 @@ namespace reshade::d3d11
 	bool
 	d3d11_runtime::load_effect (const reshadefx::syntax_tree &ast, std::string &errors)
 	{
-		return d3d11_effect_compiler (this, ast, errors, false).run ();
+		d3d11_effect_compiler compiler (this, ast, errors, false);
+
+		if (! compiler.run ())
+		{
+			return false;
+		}
+
+		compiler.take_generated_code (_generated_reflection, _generated_code);
+
+		update_used_slots ();
+
+		return true;
+	}
+
+	std::string
+	d3d11_runtime::generated_effect_backend (void) const
+	{
+		// The code depends on the feature level it was generated for, which is what the renderer id holds
+		return "d3d11 " + std::to_string (_renderer_id) + ' ' + std::to_string (d3d11_effect_compiler::generated_code_version);
+	}
+
+	bool
+	d3d11_runtime::take_generated_effect (reshadefx::effect_reflection &reflection, std::vector <std::string> &code)
+	{
+		if (_generated_code.empty ())
+		{
+			return false;
+		}
+
+		reflection = std::move (_generated_reflection);
+		code       = std::move (_generated_code);
+
+		_generated_code.clear ();
+
+		return true;
+	}
+
+	bool
+	d3d11_runtime::load_generated_effect (const reshadefx::effect_reflection &reflection, const std::vector <std::string> &code, std::string &errors)
+	{
+		if (! d3d11_effect_compiler (this, reflection, code, errors, false).run ())
+		{
+			return false;
+		}
+
+		update_used_slots ();
+
+		return true;
+	}
+
+	void
+	d3d11_runtime::update_used_slots (void)
+	{
+		// Only save and restore the slots effects are going to bind
+		UINT num_shader_resources = 1;
+		UINT num_fused_stages     = 0;
+
+		for (const auto &technique : _techniques)
+		{
+			for (const auto &pass_object : technique.passes)
+			{
+				num_shader_resources =
+					std::max (num_shader_resources, static_cast <UINT> (pass_object->as <d3d11_pass_data> ()->shader_resources.size ()));
+
+				if (pass_object->as <d3d11_pass_data> ()->fused_stage != nullptr)
+				{
+					num_fused_stages++;
+				}
+			}
+		}
+
+		// A fused pass binds the constant buffers of all its techniques at once
+		const UINT num_constant_buffers =
+			std::min (std::max (1u, num_fused_stages), static_cast <UINT> (D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT));
+
+		_stateblock.set_used_slots ( 1, num_constant_buffers,
+		                               std::max (1u, static_cast <UINT> (_effect_sampler_states.size ())),
+		                                 num_shader_resources );
 	}
 
 	bool
@@ -1238,6 +1417,223 @@ namespace reshade::d3d11
 		return true;
 	}
 
+	ID3D11Buffer *
+	d3d11_runtime::update_constant_buffer (const technique &technique)
+	{
+		const auto constant_buffer =
+			_constant_buffers [technique.uniform_storage_index].get ();
+
+		D3D11_MAPPED_SUBRESOURCE mapped = { };
+
+		const HRESULT hr =
+			_immediate_context->Map (constant_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+
+		if (SUCCEEDED (hr))
+		{
+			CopyMemory (mapped.pData, get_uniform_value_storage().data() + technique.uniform_storage_offset, mapped.RowPitch);
+
+			_immediate_context->Unmap (constant_buffer, 0);
+		}
+		else
+		{
+			LOG(ERROR) << "Failed to map constant buffer! HRESULT is '" << std::hex << hr << std::dec << "'!";
+		}
+
+		return constant_buffer;
+	}
+
+	void
+	d3d11_runtime::update_technique_fusion (void)
+	{
+		std::vector <const technique *> enabled_techniques;
+
+		for (const auto &technique : _techniques)
+		{
+			if (technique.enabled && ! technique.suspended)
+			{
+				enabled_techniques.push_back (&technique);
+			}
+		}
+
+		bool finished_compiling = false;
+
+		for (auto it = _fused_shaders.begin (); _fused_shaders_pending != 0 && it != _fused_shaders.end (); ++it)
+		{
+			auto &shader = it->second;
+
+			if ( shader.pending.valid () &&
+			     shader.pending.wait_for (std::chrono::seconds (0)) == std::future_status::ready )
+			{
+				const auto result = shader.pending.get ();
+
+				// Only the bytecode is compiled on the worker, the shader object is created here, since the device may not be thread-safe
+				if (result.bytecode.empty () || FAILED (_device->CreatePixelShader (result.bytecode.data (), result.bytecode.size (), nullptr, &shader.pixel_shader)))
+				{
+					LOG(WARNING) << "Failed to merge " << it->first.size () << " techniques into a single pass:\n" << result.errors;
+
+					shader.pixel_shader.reset ();
+					shader.failed = true;
+				}
+
+				_fused_shaders_pending--;
+				finished_compiling    = true;
+			}
+		}
+
+		// Only rebuild the groups when the set or order of enabled techniques changed, or a merged shader became available
+		if (enabled_techniques == _fusion_enabled_techniques && ! finished_compiling)
+		{
+			return;
+		}
+
+		_fusion_enabled_techniques = enabled_techniques;
+		_fused_groups.clear      ();
+		_fused_techniques.clear  ();
+
+		const auto fused_stage = [] (const technique *technique) -> std::shared_ptr <const d3d11_fused_stage> {
+			return technique->passes.size () == 1 ? technique->passes [0]->as <d3d11_pass_data> ()->fused_stage : nullptr;
+		};
+
+		for (size_t begin = 0, end; begin < enabled_techniques.size (); begin = end)
+		{
+			const auto first =
+				fused_stage (enabled_techniques [begin]);
+
+			std::vector <std::shared_ptr <const d3d11_fused_stage>> stages = { first };
+
+			// Consecutive stages can only share a pass if they get the same texture coordinates and write in the same color space, each one needs a constant buffer slot
+			for (end = begin + 1; first != nullptr && end < enabled_techniques.size () && stages.size () < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; end++)
+			{
+				const auto stage =
+					fused_stage (enabled_techniques [end]);
+
+				if (stage == nullptr || stage->vertex_shader_code != first->vertex_shader_code || stage->srgb_write_enable != first->srgb_write_enable)
+				{
+					break;
+				}
+
+				stages.push_back (stage);
+			}
+
+			if (stages.size () < 2)
+			{
+				continue;
+			}
+
+			fused_group group;
+			group.techniques.assign (enabled_techniques.begin () + begin, enabled_techniques.begin () + end);
+
+			auto &shader =
+				_fused_shaders [group.techniques];
+
+			// The techniques are simply rendered one by one until the merged shader was built, or if it cannot be built
+			if (shader.pixel_shader == nullptr)
+			{
+				if (! shader.failed && ! shader.pending.valid ())
+				{
+					// A floating-point back buffer keeps values outside of [0, 1] between techniques, a normalized one clamps them
+					const bool saturate =
+						is_normalized_format (_backbuffer_format);
+
+					// The task holds references to the stages, so they stay valid while it runs
+					shader.pending =
+						std::async (std::launch::async, [this, stages, saturate] {
+							std::vector <const d3d11_fused_stage *> stage_pointers;
+
+							for (const auto &stage : stages)
+							{
+								stage_pointers.push_back (stage.get ());
+							}
+
+							fused_shader::result result;
+
+							if (! d3d11_effect_compiler::compile_fused_pass (this, stage_pointers, saturate, result.bytecode, result.errors))
+							{
+								result.bytecode.clear ();
+							}
+
+							return result;
+						});
+
+					_fused_shaders_pending++;
+				}
+
+				continue;
+			}
+
+			group.pixel_shader = shader.pixel_shader;
+
+			const auto head = group.techniques [0];
+
+			_fused_techniques.insert (group.techniques.begin (), group.techniques.end ());
+			_fused_groups [head] = std::move (group);
+		}
+	}
+
+	unsigned int
+	d3d11_runtime::get_technique_group_size (const technique &technique) const
+	{
+		if (_fused_techniques.count (&technique) == 0)
+		{
+			return 1;
+		}
+
+		const auto group =
+			_fused_groups.find (&technique);
+
+		return group != _fused_groups.end () ? static_cast <unsigned int> (group->second.techniques.size ()) : 0;
+	}
+
+	void
+	d3d11_runtime::render_fused_techniques (const std::vector <const technique *> &techniques, ID3D11PixelShader *pixel_shader)
+	{
+		const d3d11_pass_data &pass =
+			*techniques [0]->passes [0]->as <d3d11_pass_data> ();
+
+		// The uniforms of the N-th technique are bound to slot N
+		ID3D11Buffer *constant_buffers [D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT] = { nullptr };
+
+		for (size_t i = 0; i < techniques.size (); i++)
+		{
+			if (techniques [i]->uniform_storage_index >= 0)
+			{
+				constant_buffers [i] = update_constant_buffer (*techniques [i]);
+			}
+		}
+
+		_immediate_context->PSSetConstantBuffers (0, static_cast <UINT> (techniques.size ()), constant_buffers);
+
+		_immediate_context->VSSetShader (pass.vertex_shader.get (), nullptr, 0);
+		_immediate_context->PSSetShader (pixel_shader,              nullptr, 0);
+
+		static const float blendfactor [4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+		_immediate_context->OMSetBlendState        (pass.blend_state.get         (), blendfactor, D3D11_DEFAULT_SAMPLE_MASK);
+		_immediate_context->OMSetDepthStencilState (pass.depth_stencil_state.get (), pass.stencil_reference);
+
+		_immediate_context->CopyResource ( _backbuffer_texture.get    (),
+		                                     _backbuffer_resolved.get () );
+
+		// Point-wise passes write the back buffer in the same color space they read it in
+		ID3D11ShaderResourceView *const backbuffer =
+			_backbuffer_texture_srv [techniques [0]->passes [0]->as <d3d11_pass_data> ()->fused_stage->srgb_write_enable ? 1 : 0].get ();
+
+		_immediate_context->PSSetShaderResources (0, 1, &backbuffer);
+		_immediate_context->OMSetRenderTargets   (1, pass.render_targets, nullptr);
+		_immediate_context->RSSetViewports       (1, &pass.viewport);
+
+		_immediate_context->Draw (3, 0);
+
+		_vertices  += 3;
+		_drawcalls += 1;
+
+		_immediate_context->OMSetRenderTargets ( 0, nullptr, nullptr );
+
+		ID3D11ShaderResourceView *const null = nullptr;
+
+		_immediate_context->PSSetShaderResources (0, 1, &null);
+	}
+
 	void
 	d3d11_runtime::render_technique (const technique &technique)
 	{ 
@@ -1260,50 +1656,56 @@ namespace reshade::d3d11
     }
 #endif
 
+		// Techniques of a fused group are all drawn by the pass of the first one
+		if (_fused_techniques.count (&technique) != 0)
+		{
+			const auto group =
+				_fused_groups.find (&technique);
+
+			if (group != _fused_groups.end ())
+			{
+				render_fused_techniques (group->second.techniques, group->second.pixel_shader.get ());
+			}
+
+			return;
+		}
+
 		bool is_default_depthstencil_cleared = false;
 
 		// Setup shader constants
 		if (technique.uniform_storage_index >= 0)
 		{
 			const auto constant_buffer =
-				_constant_buffers [technique.uniform_storage_index].get ();
-
-			D3D11_MAPPED_SUBRESOURCE mapped = { };
-
-			const HRESULT hr =
-				_immediate_context->Map (constant_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-
-			if (SUCCEEDED (hr))
-			{
-				CopyMemory (mapped.pData, get_uniform_value_storage().data() + technique.uniform_storage_offset, mapped.RowPitch);
-
-				_immediate_context->Unmap (constant_buffer, 0);
-			}
-			else
-			{
-				LOG(ERROR) << "Failed to map constant buffer! HRESULT is '" << std::hex << hr << std::dec << "'!";
-			}
+				update_constant_buffer (technique);
 
 			_immediate_context->VSSetConstantBuffers (0, 1, &constant_buffer);
 			_immediate_context->PSSetConstantBuffers (0, 1, &constant_buffer);
 		}
 
+		const d3d11_pass_data *previous_pass = nullptr;
+
 		for (const auto &pass_object : technique.passes)
 		{
 			const d3d11_pass_data &pass =
 			  *pass_object->as <d3d11_pass_data> ();
 
-			// Setup states
-			_immediate_context->VSSetShader (pass.vertex_shader.get (), nullptr, 0);
-			_immediate_context->PSSetShader (pass.pixel_shader.get  (), nullptr, 0);
+			// Setup states, consecutive passes share their shader and state objects if they are equal, so only those that changed are set again
+			if (previous_pass == nullptr || pass.vertex_shader != previous_pass->vertex_shader)
+				_immediate_context->VSSetShader (pass.vertex_shader.get (), nullptr, 0);
+			if (previous_pass == nullptr || pass.pixel_shader  != previous_pass->pixel_shader)
+				_immediate_context->PSSetShader (pass.pixel_shader.get  (), nullptr, 0);
 
       //if (pass.shader_resources.empty ())
       //  continue;
 
 			static const float blendfactor [4] = { 1.0f, 1.0f, 1.0f, 1.0f };
 
-			_immediate_context->OMSetBlendState        (pass.blend_state.get         (), blendfactor, D3D11_DEFAULT_SAMPLE_MASK);
-			_immediate_context->OMSetDepthStencilState (pass.depth_stencil_state.get (), pass.stencil_reference);
+			if (previous_pass == nullptr || pass.blend_state         != previous_pass->blend_state)
+				_immediate_context->OMSetBlendState        (pass.blend_state.get         (), blendfactor, D3D11_DEFAULT_SAMPLE_MASK);
+			if (previous_pass == nullptr || pass.depth_stencil_state != previous_pass->depth_stencil_state || pass.stencil_reference != previous_pass->stencil_reference)
+				_immediate_context->OMSetDepthStencilState (pass.depth_stencil_state.get (), pass.stencil_reference);
+
+			previous_pass = &pass;
 
 			// Save back buffer of previous pass
 			_immediate_context->CopyResource ( _backbuffer_texture.get    (),
@@ -1377,6 +1779,41 @@ namespace reshade::d3d11
 					_immediate_context->GenerateMips (resource);
 				}
 			}
+
+			// Upscale the render targets this pass rendered at a reduced scale into the copies that passes at full resolution sample from
+			if (! pass.upscales.empty ())
+			{
+				const D3D11_VIEWPORT viewport = { 0.0f, 0.0f, static_cast <FLOAT> (_width), static_cast <FLOAT> (_height), 0.0f, 1.0f };
+				const auto           sampler  = _upscale_sampler.get ();
+
+				_immediate_context->VSSetShader     (_copy_vertex_shader.get (), nullptr, 0);
+				_immediate_context->PSSetShader     (_copy_pixel_shader.get  (), nullptr, 0);
+				_immediate_context->OMSetBlendState (nullptr, nullptr, D3D11_DEFAULT_SAMPLE_MASK);
+				_immediate_context->PSSetSamplers   (0, 1, &sampler);
+				_immediate_context->RSSetViewports  (1, &viewport);
+
+				for (const auto &upscale : pass.upscales)
+				{
+					_immediate_context->OMSetRenderTargets   (1, &upscale.second, nullptr);
+					_immediate_context->PSSetShaderResources (0, 1, &upscale.first);
+
+					_immediate_context->Draw (3, 0);
+
+					_vertices  += 3;
+					_drawcalls += 1;
+				}
+
+				_immediate_context->OMSetRenderTargets   (0, nullptr, nullptr);
+				_immediate_context->PSSetShaderResources (0, 1, null);
+
+				// The effect samplers start at the first slot, and the next pass has to set all of its states again
+				if (! _effect_sampler_states.empty ())
+				{
+					_immediate_context->PSSetSamplers (0, 1, _effect_sampler_states.data ());
+				}
+
+				previous_pass = nullptr;
+			}
 		}
 
 
@@ -1406,65 +1843,13 @@ namespace reshade::d3d11
 	void
 	d3d11_runtime::detect_depth_source (void)
 	{
-		if ( _is_multisampling_enabled || _depth_source_table.empty () )
+		if (_is_multisampling_enabled)
 		{
 			return;
 		}
 
-		depth_source_info       best_info  = { 0 };
-		ID3D11DepthStencilView *best_match = nullptr;
-
-		for (auto it = _depth_source_table.begin (); it != _depth_source_table.end ();)
-		{
-			const auto  depthstencil      = it->first;
-			      auto &depthstencil_info = it->second;
-
-			if ((! depthstencil_info.invalidated) && (depthstencil->AddRef (), depthstencil->Release ()) == 1)
-			{
-				depthstencil_info.invalidated = TRUE;
-				depthstencil->Release ();
-
-				++it;
-
-				continue;
-			}
-
-			else
-			{
-				++it;
-			}
-
-			if (depthstencil_info.drawcall_count == 0)
-			{
-				continue;
-			}
-
-			if ((depthstencil_info.vertices_count * (1.2f - float(depthstencil_info.drawcall_count) / _drawcalls.load ())) >= (best_info.vertices_count * (1.2f - float(best_info.drawcall_count) / _drawcalls.load ())))
-			{
-				best_match = depthstencil;
-				best_info  = depthstencil_info;
-			}
-
-			depthstencil_info.drawcall_count = depthstencil_info.vertices_count = 0;
-		}
-
-    static int overload_iters = 0;
-
-		if (_depth_source_table.load_factor () > 0.75f && (! (overload_iters++ % 15)))
-		{
-			concurrency::concurrent_unordered_map <ID3D11DepthStencilView *, depth_source_info> live_map;
-
-			// Trim the table
-			for (auto& it : _depth_source_table)
-			{
-				if (! it.second.invalidated)
-				{
-					live_map.insert (std::make_pair (it.first, it.second));
-				}
-			}
-
-			_depth_source_table.swap (live_map);
-		}
+		ID3D11DepthStencilView *best_match =
+			_depth_source_tracker.update (_drawcalls.load ());
 
 		if (best_match != nullptr && _depthstencil != best_match)
 		{
@@ -1621,9 +2006,18 @@ namespace reshade::d3d11
 		// Update effect textures
 		_effect_shader_resources [2] = _depthstencil_texture_srv.get ();
 
-		for (const auto   &technique : _techniques)
-			for (const auto &pass      :  technique.passes)
-				pass->as <d3d11_pass_data> ()->shader_resources [2] = _depthstencil_texture_srv.get ();
+		for (const auto &technique : _techniques)
+		{
+			for (const auto &pass_object : technique.passes)
+			{
+				const auto pass = pass_object->as <d3d11_pass_data> ();
+
+				if (pass->depth_texture_binding < pass->shader_resources.size ())
+				{
+					pass->shader_resources [pass->depth_texture_binding] = _depthstencil_texture_srv.get ();
+				}
+			}
+		}
 
 		return true;
 	}
@@ -4849,10 +4849,18 @@ protected:
 };
 
 #include <concurrent_vector.h>
-#include <concurrent_unordered_map.h>
+#include <map>
+#include <future>
+#include <unordered_set>
 
 #include "runtime.hpp"
+#include "effect_reflection.hpp"
+#include "draw_call_tracker.hpp"
+#include "depth_source_tracker.hpp"
 #include "d3d11_stateblock.hpp"
+#include "shader_cache.hpp"
+#include "shader_object_cache.hpp"
+#include "state_object_cache.hpp"
 
 namespace reshade::d3d11
 {
@@ -4861,7 +4869,21 @@ namespace reshade::d3d11
 		com_ptr<ID3D11Texture2D> texture;
 		com_ptr<ID3D11ShaderResourceView> srv[2];
 		com_ptr<ID3D11RenderTargetView> rtv[2];
+		// Full resolution copy of a render target that is created at a reduced scale, updated after every pass that renders to it
+		com_ptr<ID3D11Texture2D> upscaled_texture;
+		com_ptr<ID3D11ShaderResourceView> upscaled_srv[2];
+		com_ptr<ID3D11RenderTargetView> upscaled_rtv;
 	};
+	/// <summary>
+	/// The pixel shader of a point-wise pass rewritten as a function that transforms the color of a single pixel, so that it can be chained with those of other techniques in one pass.
+	/// </summary>
+	struct d3d11_fused_stage
+	{
+		std::string vertex_shader_code, uniform_code, code, function_name;
+		std::vector<bool> position_arguments;
+		bool srgb_write_enable;
+	};
+
 	struct d3d11_pass_data : base_object
 	{
 		com_ptr<ID3D11VertexShader> vertex_shader;
@@ -4874,10 +4896,16 @@ namespace reshade::d3d11
 		ID3D11ShaderResourceView *render_target_resources[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
 		D3D11_VIEWPORT viewport;
 		std::vector<ID3D11ShaderResourceView *> shader_resources;
+		UINT depth_texture_binding;
+		std::vector<std::pair<ID3D11ShaderResourceView *, ID3D11RenderTargetView *>> upscales;
+		std::shared_ptr<const d3d11_fused_stage> fused_stage;
 	};
 
 	class d3d11_runtime : public runtime
 	{
+		// The compiler uploads the initial values of an effect's uniforms
+		friend class d3d11_effect_compiler;
+
 	public:
 		d3d11_runtime(ID3D11Device *device, IDXGISwapChain *swapchain);
 
@@ -4886,7 +4914,8 @@ namespace reshade::d3d11
 		void on_reset_effect() override;
 		void on_present();
 		void on_draw_call(ID3D11DeviceContext *context, unsigned int vertices);
-		void on_set_depthstencil_view(ID3D11DepthStencilView *&depthstencil);
+		void on_set_depthstencil_view(ID3D11DeviceContext *context, ID3D11DepthStencilView *&depthstencil);
+		void on_reset_context_state(ID3D11DeviceContext *context, bool cleared);
 		void on_get_depthstencil_view(ID3D11DepthStencilView *&depthstencil);
 		void on_clear_depthstencil_view(ID3D11DepthStencilView *&depthstencil);
 		void on_copy_resource(ID3D11Resource *&dest, ID3D11Resource *&source);
@@ -4895,6 +4924,15 @@ namespace reshade::d3d11
 		bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) override;
 		bool update_texture(texture &texture, const uint8_t *data) override;
 
+		std::string generated_effect_backend() const override;
+		bool take_generated_effect(reshadefx::effect_reflection &reflection, std::vector<std::string> &code) override;
+		bool load_generated_effect(const reshadefx::effect_reflection &reflection, const std::vector<std::string> &code, std::string &errors) override;
+
+		bool supports_render_scale() const override { return true; }
+
+		void update_technique_fusion() override;
+		unsigned int get_technique_group_size(const technique &technique) const override;
+		shader_object_statistics get_shader_statistics() const override;
 		void render_technique(const technique &technique) override;
 		void render_imgui_draw_data(ImDrawData *data) override;
 
@@ -4907,19 +4945,16 @@ namespace reshade::d3d11
 		com_ptr<ID3D11RenderTargetView> _backbuffer_rtv[3];
 		com_ptr<ID3D11ShaderResourceView> _depthstencil_texture_srv;
 		std::vector<ID3D11SamplerState *> _effect_sampler_states;
-		std::unordered_map<size_t, size_t> _effect_sampler_descs;
+		state_object_cache<D3D11_SAMPLER_DESC, size_t> _effect_sampler_descs;
+		state_object_cache<D3D11_BLEND_DESC, com_ptr<ID3D11BlendState>> _effect_blend_states;
+		state_object_cache<D3D11_DEPTH_STENCIL_DESC, com_ptr<ID3D11DepthStencilState>> _effect_depth_stencil_states;
 		std::vector<ID3D11ShaderResourceView *> _effect_shader_resources;
 		std::vector<com_ptr<ID3D11Buffer>> _constant_buffers;
+		shader_cache _shader_cache;
+		shader_object_cache<com_ptr<ID3D11VertexShader>> _vertex_shader_cache;
+		shader_object_cache<com_ptr<ID3D11PixelShader>> _pixel_shader_cache;
 
 	private:
-		struct depth_source_info
-		{
-			UINT width, height;
-			UINT drawcall_count,
-			     vertices_count;
-			BOOL invalidated;    // For concurrency, we cannot remove elements; we will recycle them.
-		};
-
 		bool init_backbuffer_texture();
 		bool init_default_depth_stencil();
 		bool init_fx_resources();
@@ -4927,6 +4962,27 @@ namespace reshade::d3d11
 		void detect_depth_source();
 		bool create_depthstencil_replacement(ID3D11DepthStencilView *depthstencil);
 
+		void update_used_slots();
+		ID3D11Buffer *update_constant_buffer(const technique &technique);
+		void render_fused_techniques(const std::vector<const technique *> &techniques, ID3D11PixelShader *pixel_shader);
+
+		struct fused_group
+		{
+			std::vector<const technique *> techniques;
+			com_ptr<ID3D11PixelShader> pixel_shader;
+		};
+		struct fused_shader
+		{
+			struct result
+			{
+				std::string bytecode, errors;
+			};
+
+			std::future<result> pending;
+			com_ptr<ID3D11PixelShader> pixel_shader;
+			bool failed = false;
+		};
+
 		bool                            _is_multisampling_enabled = false;
 		DXGI_FORMAT                     _backbuffer_format        = DXGI_FORMAT_UNKNOWN;
 		d3d11_stateblock                _stateblock;
@@ -4934,11 +4990,22 @@ namespace reshade::d3d11
 		com_ptr<ID3D11Texture2D>        _depthstencil_texture;
 		com_ptr<ID3D11DepthStencilView> _default_depthstencil;
 		com_ptr <ID3D11DepthStencilView>                    _depthstencil, _depthstencil_replacement;
-		concurrency::concurrent_unordered_map <         ID3D11DepthStencilView *, depth_source_info> _depth_source_table;
+		depth_source_tracker <ID3D11DepthStencilView *>                                              _depth_source_tracker;
+		draw_call_tracker <ID3D11DeviceContext *, ID3D11DepthStencilView *>                          _draw_call_tracker;
     com_ptr<ID3D11VertexShader>     _copy_vertex_shader;
 		com_ptr<ID3D11PixelShader>      _copy_pixel_shader;
-		com_ptr<ID3D11SamplerState>     _copy_sampler;
+		com_ptr<ID3D11SamplerState>     _copy_sampler, _upscale_sampler;
 		hybrid_spinlock                 _mutex;
 		com_ptr<ID3D11RasterizerState>  _effect_rasterizer_state;
+		std::vector<const technique *>  _fusion_enabled_techniques;
+		std::unordered_map<const technique *, fused_group> _fused_groups;
+		std::unordered_set<const technique *> _fused_techniques;
+		// The reflection and code of the effect that was last compiled from a syntax tree, until the runtime takes them to store them
+		reshadefx::effect_reflection    _generated_reflection;
+		std::vector<std::string>        _generated_code;
+		// Merged shaders are compiled on a worker thread and kept for every group that was formed, so enabling or suspending a technique never compiles on the render thread
+		// Declared last, so that the destructor waits for pending compilations before anything they use is destroyed
+		std::map<std::vector<const technique *>, fused_shader> _fused_shaders;
+		size_t _fused_shaders_pending = 0;
 	};
 }
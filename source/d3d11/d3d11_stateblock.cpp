@@ -4,6 +4,7 @@
  */
 
 #include "d3d11_stateblock.hpp"
+#include <algorithm>
 
 namespace reshade::d3d11
 {
@@ -23,12 +24,23 @@ namespace reshade::d3d11
 
 		_device = device;
 		_device_feature_level = device->GetFeatureLevel();
+		_max_vertex_buffers = _device_feature_level > D3D_FEATURE_LEVEL_10_0 ? D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT : D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+
+		set_used_slots(UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX);
 	}
 	d3d11_stateblock::~d3d11_stateblock()
 	{
 		release_all_device_objects();
 	}
 
+	void d3d11_stateblock::set_used_slots(UINT vertex_buffers, UINT constant_buffers, UINT samplers, UINT shader_resources)
+	{
+		_num_vertex_buffers = std::min(vertex_buffers, _max_vertex_buffers);
+		_num_constant_buffers = std::min(constant_buffers, static_cast<UINT>(D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT));
+		_num_samplers = std::min(samplers, static_cast<UINT>(D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT));
+		_num_shader_resources = std::min(shader_resources, static_cast<UINT>(D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT));
+	}
+
 	void d3d11_stateblock::capture(const com_ptr<ID3D11DeviceContext> &devicecontext)
 	{
 		_device_context = devicecontext;
@@ -36,14 +48,7 @@ namespace reshade::d3d11
 		_device_context->IAGetPrimitiveTopology(&_ia_primitive_topology);
 		_device_context->IAGetInputLayout(&_ia_input_layout);
 
-		if (_device_feature_level > D3D_FEATURE_LEVEL_10_0)
-		{
-			_device_context->IAGetVertexBuffers(0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
-		}
-		else
-		{
-			_device_context->IAGetVertexBuffers(0, D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
-		}
+		_device_context->IAGetVertexBuffers(0, _num_vertex_buffers, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
 
 		_device_context->IAGetIndexBuffer(&_ia_index_buffer, &_ia_index_format, &_ia_index_offset);
 
@@ -53,9 +58,9 @@ namespace reshade::d3d11
 
 		_vs_num_class_instances = ARRAYSIZE(_vs_class_instances);
 		_device_context->VSGetShader(&_vs, _vs_class_instances, &_vs_num_class_instances);
-		_device_context->VSGetConstantBuffers(0, ARRAYSIZE(_vs_constant_buffers), _vs_constant_buffers);
-		_device_context->VSGetSamplers(0, ARRAYSIZE(_vs_sampler_states), _vs_sampler_states);
-		_device_context->VSGetShaderResources(0, ARRAYSIZE(_vs_shader_resources), _vs_shader_resources);
+		_device_context->VSGetConstantBuffers(0, _num_constant_buffers, _vs_constant_buffers);
+		_device_context->VSGetSamplers(0, _num_samplers, _vs_sampler_states);
+		_device_context->VSGetShaderResources(0, _num_shader_resources, _vs_shader_resources);
 
 		if (_device_feature_level >= D3D_FEATURE_LEVEL_10_0)
 		{
@@ -74,9 +79,9 @@ namespace reshade::d3d11
 
 		_ps_num_class_instances = ARRAYSIZE(_ps_class_instances);
 		_device_context->PSGetShader(&_ps, _ps_class_instances, &_ps_num_class_instances);
-		_device_context->PSGetConstantBuffers(0, ARRAYSIZE(_ps_constant_buffers), _ps_constant_buffers);
-		_device_context->PSGetSamplers(0, ARRAYSIZE(_ps_sampler_states), _ps_sampler_states);
-		_device_context->PSGetShaderResources(0, ARRAYSIZE(_ps_shader_resources), _ps_shader_resources);
+		_device_context->PSGetConstantBuffers(0, _num_constant_buffers, _ps_constant_buffers);
+		_device_context->PSGetSamplers(0, _num_samplers, _ps_sampler_states);
+		_device_context->PSGetShaderResources(0, _num_shader_resources, _ps_shader_resources);
 
 		_device_context->OMGetBlendState(&_om_blend_state, _om_blend_factor, &_om_sample_mask);
 		_device_context->OMGetDepthStencilState(&_om_depth_stencil_state, &_om_stencil_ref);
@@ -87,14 +92,7 @@ namespace reshade::d3d11
 		_device_context->IASetPrimitiveTopology(_ia_primitive_topology);
 		_device_context->IASetInputLayout(_ia_input_layout);
 
-		if (_device_feature_level > D3D_FEATURE_LEVEL_10_0)
-		{
-			_device_context->IASetVertexBuffers(0, D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
-		}
-		else
-		{
-			_device_context->IASetVertexBuffers(0, D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
-		}
+		_device_context->IASetVertexBuffers(0, _num_vertex_buffers, _ia_vertex_buffers, _ia_vertex_strides, _ia_vertex_offsets);
 
 		_device_context->IASetIndexBuffer(_ia_index_buffer, _ia_index_format, _ia_index_offset);
 
@@ -102,9 +100,9 @@ namespace reshade::d3d11
 		_device_context->RSSetViewports(_rs_num_viewports, _rs_viewports);
 
 		_device_context->VSSetShader(_vs, _vs_class_instances, _vs_num_class_instances);
-		_device_context->VSSetConstantBuffers(0, ARRAYSIZE(_vs_constant_buffers), _vs_constant_buffers);
-		_device_context->VSSetSamplers(0, ARRAYSIZE(_vs_sampler_states), _vs_sampler_states);
-		_device_context->VSSetShaderResources(0, ARRAYSIZE(_vs_shader_resources), _vs_shader_resources);
+		_device_context->VSSetConstantBuffers(0, _num_constant_buffers, _vs_constant_buffers);
+		_device_context->VSSetSamplers(0, _num_samplers, _vs_sampler_states);
+		_device_context->VSSetShaderResources(0, _num_shader_resources, _vs_shader_resources);
 
 		if (_device_feature_level >= D3D_FEATURE_LEVEL_10_0)
 		{
@@ -119,9 +117,9 @@ namespace reshade::d3d11
 		}
 
 		_device_context->PSSetShader(_ps, _ps_class_instances, _ps_num_class_instances);
-		_device_context->PSSetConstantBuffers(0, ARRAYSIZE(_ps_constant_buffers), _ps_constant_buffers);
-		_device_context->PSSetSamplers(0, ARRAYSIZE(_ps_sampler_states), _ps_sampler_states);
-		_device_context->PSSetShaderResources(0, ARRAYSIZE(_ps_shader_resources), _ps_shader_resources);
+		_device_context->PSSetConstantBuffers(0, _num_constant_buffers, _ps_constant_buffers);
+		_device_context->PSSetSamplers(0, _num_samplers, _ps_sampler_states);
+		_device_context->PSSetShaderResources(0, _num_shader_resources, _ps_shader_resources);
 
 		_device_context->OMSetBlendState(_om_blend_state, _om_blend_factor, _om_sample_mask);
 		_device_context->OMSetDepthStencilState(_om_depth_stencil_state, _om_stencil_ref);
@@ -16,6 +16,11 @@ namespace reshade::d3d11
 		explicit d3d11_stateblock(const com_ptr<ID3D11Device> &device);
 		~d3d11_stateblock();
 
+		/// <summary>
+		/// Limit capture and restore to the leading slots the runtime actually binds, instead of every slot of the pipeline.
+		/// </summary>
+		void set_used_slots(UINT vertex_buffers, UINT constant_buffers, UINT samplers, UINT shader_resources);
+
 		void capture(const com_ptr<ID3D11DeviceContext> &devicecontext);
 		void apply_and_release();
 
@@ -23,6 +28,8 @@ namespace reshade::d3d11
 		void release_all_device_objects();
 
 		D3D_FEATURE_LEVEL _device_feature_level;
+		UINT _max_vertex_buffers;
+		UINT _num_vertex_buffers, _num_constant_buffers, _num_samplers, _num_shader_resources;
 		com_ptr<ID3D11Device> _device;
 		com_ptr<ID3D11DeviceContext> _device_context;
 		ID3D11InputLayout *_ia_input_layout;
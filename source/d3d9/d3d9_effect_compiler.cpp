@@ -5,7 +5,6 @@
 
 #include "d3d9_runtime.hpp"
 #include "d3d9_effect_compiler.hpp"
-#include "constant_folding.hpp"
 #include <assert.h>
 #include <iomanip>
 #include <algorithm>
@@ -133,7 +132,11 @@ namespace reshade::d3d9
 			return false;
 		}
 
-		_uniform_storage_offset = _runtime->get_uniform_value_storage().size();
+		// The reflection lays out all uniforms up front, so that the storage for them is allocated in one go
+		_reflection = reshadefx::reflect(_ast, uniform_layout::rules::d3d9_registers);
+
+		_constant_register_count = _reflection.uniform_block_size / 16;
+		_uniform_storage_offset = _runtime->allocate_uniform_storage(_reflection.uniform_block_size);
 
 		for (auto node : _ast.structs)
 		{
@@ -1417,24 +1420,22 @@ namespace reshade::d3d9
 
 	void d3d9_effect_compiler::visit_texture(const variable_declaration_node *node)
 	{
+		const auto &info = _reflection.textures[_texture_index++];
+
 		texture obj;
 		obj.impl = std::make_unique<d3d9_tex_data>();
 		const auto obj_data = obj.impl->as<d3d9_tex_data>();
-		obj.name = node->name;
-		obj.unique_name = node->unique_name;
-		obj.annotations = node->annotation_list;
-		UINT width = obj.width = node->properties.width;
-		UINT height = obj.height = node->properties.height;
-		UINT levels = obj.levels = node->properties.levels;
-		const D3DFORMAT format = literal_to_format(obj.format = node->properties.format);
+		obj.name = info.name;
+		obj.unique_name = info.unique_name;
+		obj.annotations = info.annotations;
+		UINT width = obj.width = info.width;
+		UINT height = obj.height = info.height;
+		UINT levels = obj.levels = info.levels;
+		const D3DFORMAT format = literal_to_format(obj.format = info.format);
 
-		if (node->semantic == "COLOR" || node->semantic == "SV_TARGET")
-		{
-			_runtime->update_texture_reference(obj, texture_reference::back_buffer);
-		}
-		else if (node->semantic == "DEPTH" || node->semantic == "SV_DEPTH")
+		if (info.reference != texture_reference::none)
 		{
-			_runtime->update_texture_reference(obj, texture_reference::depth_buffer);
+			_runtime->update_texture_reference(obj, info.reference);
 		}
 		else
 		{
@@ -1479,7 +1480,8 @@ namespace reshade::d3d9
 	}
 	void d3d9_effect_compiler::visit_sampler(const variable_declaration_node *node)
 	{
-		const auto texture = _runtime->find_texture(node->properties.texture->name);
+		const auto &info = _reflection.samplers[_sampler_index++];
+		const auto texture = _runtime->find_texture(_reflection.textures[info.texture].name);
 
 		if (texture == nullptr)
 		{
@@ -1489,19 +1491,19 @@ namespace reshade::d3d9
 
 		d3d9_sampler sampler;
 		sampler.texture = texture->impl->as<d3d9_tex_data>();
-		sampler.states[D3DSAMP_ADDRESSU] = static_cast<D3DTEXTUREADDRESS>(node->properties.address_u);
-		sampler.states[D3DSAMP_ADDRESSV] = static_cast<D3DTEXTUREADDRESS>(node->properties.address_v);
-		sampler.states[D3DSAMP_ADDRESSW] = static_cast<D3DTEXTUREADDRESS>(node->properties.address_w);
+		sampler.states[D3DSAMP_ADDRESSU] = static_cast<D3DTEXTUREADDRESS>(info.address_u);
+		sampler.states[D3DSAMP_ADDRESSV] = static_cast<D3DTEXTUREADDRESS>(info.address_v);
+		sampler.states[D3DSAMP_ADDRESSW] = static_cast<D3DTEXTUREADDRESS>(info.address_w);
 		sampler.states[D3DSAMP_BORDERCOLOR] = 0;
-		sampler.states[D3DSAMP_MAGFILTER] = 1 + ((static_cast<unsigned int>(node->properties.filter) & 0x0C) >> 2);
-		sampler.states[D3DSAMP_MINFILTER] = 1 + ((static_cast<unsigned int>(node->properties.filter) & 0x30) >> 4);
-		sampler.states[D3DSAMP_MIPFILTER] = 1 + ((static_cast<unsigned int>(node->properties.filter) & 0x03));
-		sampler.states[D3DSAMP_MIPMAPLODBIAS] = *reinterpret_cast<const DWORD *>(&node->properties.lod_bias);
-		sampler.states[D3DSAMP_MAXMIPLEVEL] = static_cast<DWORD>(std::max(0.0f, node->properties.min_lod));
+		sampler.states[D3DSAMP_MAGFILTER] = 1 + ((static_cast<unsigned int>(info.filter) & 0x0C) >> 2);
+		sampler.states[D3DSAMP_MINFILTER] = 1 + ((static_cast<unsigned int>(info.filter) & 0x30) >> 4);
+		sampler.states[D3DSAMP_MIPFILTER] = 1 + ((static_cast<unsigned int>(info.filter) & 0x03));
+		sampler.states[D3DSAMP_MIPMAPLODBIAS] = *reinterpret_cast<const DWORD *>(&info.lod_bias);
+		sampler.states[D3DSAMP_MAXMIPLEVEL] = static_cast<DWORD>(std::max(0.0f, info.min_lod));
 		sampler.states[D3DSAMP_MAXANISOTROPY] = 1;
-		sampler.states[D3DSAMP_SRGBTEXTURE] = node->properties.srgb_texture;
+		sampler.states[D3DSAMP_SRGBTEXTURE] = info.srgb;
 
-		_samplers[node->name] = sampler;
+		_samplers[info.name] = sampler;
 	}
 	void d3d9_effect_compiler::visit_uniform(const variable_declaration_node *node)
 	{
@@ -1523,48 +1525,19 @@ namespace reshade::d3d9
 			_global_code << ']';
 		}
 
-		_global_code << " : register(c" << _constant_register_count << ");\n";
-
-		uniform obj;
-		obj.name = node->name;
-		obj.unique_name = node->unique_name;
-		obj.basetype = uniform_datatype::floating_point;
-		obj.displaytype = static_cast<uniform_datatype>(node->type.basetype - 1);
-		obj.rows = node->type.rows;
-		obj.columns = node->type.cols;
-		obj.elements = node->type.array_length;
-		obj.storage_size = obj.rows * obj.columns * std::max(1u, obj.elements) * 4;
-		obj.annotations = node->annotation_list;
-
-		obj.storage_offset = _uniform_storage_offset + _constant_register_count * 16;
-		_constant_register_count += (obj.storage_size / 4 + 4 - ((obj.storage_size / 4) % 4)) / 4;
+		const auto &info = _reflection.uniforms[_uniform_index++];
 
-		auto &uniform_storage = _runtime->get_uniform_value_storage();
-
-		if (_uniform_storage_offset + _constant_register_count * 16 >= uniform_storage.size())
-		{
-			uniform_storage.resize(uniform_storage.size() + 4096);
-		}
-
-		if (node->initializer_expression != nullptr && node->initializer_expression->id == nodeid::literal_expression)
-		{
-			for (size_t i = 0; i < obj.storage_size / 4; i++)
-			{
-				scalar_literal_cast(static_cast<const literal_expression_node *>(node->initializer_expression), i, reinterpret_cast<float *>(uniform_storage.data() + obj.storage_offset)[i]);
-			}
-		}
-		else
-		{
-			ZeroMemory(uniform_storage.data() + obj.storage_offset, obj.storage_size);
-		}
+		_global_code << " : register(c" << info.offset / 16 << ");\n";
 
-		_runtime->add_uniform(std::move(obj));
+		_runtime->add_uniform(info, _uniform_storage_offset, true);
 	}
 	void d3d9_effect_compiler::visit_technique(const technique_declaration_node *node)
 	{
+		const auto &info = _reflection.techniques[_technique_index++];
+
 		technique obj;
-		obj.name = node->name;
-		obj.annotations = node->annotation_list;
+		obj.name = info.name;
+		obj.annotations = info.annotations;
 
 		if (_constant_register_count != 0)
 		{
@@ -1958,35 +1931,71 @@ namespace reshade::d3d9
 		source << "}\n";
 
 		UINT flags = 0;
-		com_ptr<ID3DBlob> compiled, errors;
 
 		if (_skip_shader_optimization)
 		{
 			flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 		}
 
-		const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
 		const std::string source_str = source.str();
-		HRESULT hr = D3DCompile(source_str.c_str(), source_str.size(), nullptr, nullptr, nullptr, "__main", (shadertype + "_3_0").c_str(), flags, 0, &compiled, &errors);
+		const std::string profile = shadertype + "_3_0";
+		const std::string options = profile + ' ' + std::to_string(flags);
+		const std::string object_key = make_shader_object_key(source_str, "__main", options);
+		shader_cache::compiled_shader compiled;
 
-		if (errors != nullptr)
+		// Passes that generate the same source share the shader object that was created for the first of them
+		if (shadertype == "vs" ? _runtime->_vertex_shader_cache.find(object_key, pass.vertex_shader, compiled.messages) : _runtime->_pixel_shader_cache.find(object_key, pass.pixel_shader, compiled.messages))
 		{
-			_errors.append(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
+			_errors += compiled.messages;
+			return;
 		}
 
-		if (FAILED(hr))
+		if (!_runtime->_shader_cache.find(source_str, "__main", options, compiled))
 		{
-			error(node->location, "internal shader compilation failed");
-			return;
+			com_ptr<ID3DBlob> bytecode, errors;
+
+			const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(_d3dcompiler_module, "D3DCompile"));
+			const HRESULT hr = D3DCompile(source_str.c_str(), source_str.size(), nullptr, nullptr, nullptr, "__main", profile.c_str(), flags, 0, &bytecode, &errors);
+
+			if (shadertype == "vs")
+			{
+				_runtime->_vertex_shader_cache.count_compilation();
+			}
+			else
+			{
+				_runtime->_pixel_shader_cache.count_compilation();
+			}
+
+			if (errors != nullptr)
+			{
+				compiled.messages.assign(static_cast<const char *>(errors->GetBufferPointer()), errors->GetBufferSize() - 1);
+			}
+
+			if (FAILED(hr))
+			{
+				_errors += compiled.messages;
+
+				error(node->location, "internal shader compilation failed");
+				return;
+			}
+
+			compiled.bytecode.assign(static_cast<const char *>(bytecode->GetBufferPointer()), bytecode->GetBufferSize());
+
+			_runtime->_shader_cache.insert(source_str, "__main", options, compiled);
 		}
 
+		// Warnings are reported again when the shader is taken from the cache
+		_errors += compiled.messages;
+
+		HRESULT hr = S_OK;
+
 		if (shadertype == "vs")
 		{
-			hr = _runtime->_device->CreateVertexShader(static_cast<const DWORD *>(compiled->GetBufferPointer()), &pass.vertex_shader);
+			hr = _runtime->_device->CreateVertexShader(reinterpret_cast<const DWORD *>(compiled.bytecode.data()), &pass.vertex_shader);
 		}
 		else if (shadertype == "ps")
 		{
-			hr = _runtime->_device->CreatePixelShader(static_cast<const DWORD *>(compiled->GetBufferPointer()), &pass.pixel_shader);
+			hr = _runtime->_device->CreatePixelShader(reinterpret_cast<const DWORD *>(compiled.bytecode.data()), &pass.pixel_shader);
 		}
 
 		if (FAILED(hr))
@@ -1994,5 +2003,14 @@ namespace reshade::d3d9
 			error(node->location, "internal shader creation failed with error code " + std::to_string(static_cast<unsigned long>(hr)) + "!");
 			return;
 		}
+
+		if (shadertype == "vs")
+		{
+			_runtime->_vertex_shader_cache.insert(object_key, pass.vertex_shader, compiled.messages);
+		}
+		else
+		{
+			_runtime->_pixel_shader_cache.insert(object_key, pass.pixel_shader, compiled.messages);
+		}
 	}
 }
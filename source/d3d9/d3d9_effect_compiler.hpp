@@ -8,6 +8,7 @@
 #include <sstream>
 #include <unordered_set>
 #include "syntax_tree.hpp"
+#include "effect_reflection.hpp"
 
 namespace reshade::d3d9
 {
@@ -76,7 +77,8 @@ namespace reshade::d3d9
 		bool _success = true;
 		const reshadefx::syntax_tree &_ast;
 		std::string &_errors;
-		size_t _uniform_storage_offset = 0, _constant_register_count = 0;
+		size_t _uniform_storage_offset = 0, _constant_register_count = 0, _uniform_index = 0, _texture_index = 0, _sampler_index = 0, _technique_index = 0;
+		reshadefx::effect_reflection _reflection;
 		std::stringstream _global_code, _global_uniforms;
 		bool _skip_shader_optimization;
 		const reshadefx::nodes::function_declaration_node *_current_function;
@@ -8,6 +8,7 @@
 #include "d3d9_effect_compiler.hpp"
 #include "lexer.hpp"
 #include "input.hpp"
+#include "com_release_notifier.hpp"
 #include "..\deps\imgui\imgui.h"
 #include <algorithm>
 
@@ -160,6 +161,8 @@ namespace reshade::d3d9
 		_is_multisampling_enabled = pp.MultiSampleType != D3DMULTISAMPLE_NONE;
 		//_input = input::register_window(pp.hDeviceWindow);
 
+		_depth_source_tracker.on_resize(_width, _height);
+
 		if (FAILED(_device->CreateStateBlock(D3DSBT_ALL, &_stateblock)))
 		{
 			return false;
@@ -201,12 +204,21 @@ namespace reshade::d3d9
 		_effect_triangle_layout.reset();
 
 		// Clear depth source table
-		for (auto &it : _depth_source_table)
-		{
-			it.first->Release();
-		}
+		_depth_source_tracker.reset();
+	}
+	void d3d9_runtime::on_reset_effect()
+	{
+		runtime::on_reset_effect();
 
-		_depth_source_table.clear();
+		_vertex_shader_cache.clear();
+		_pixel_shader_cache.clear();
+	}
+	shader_object_statistics d3d9_runtime::get_shader_statistics() const
+	{
+		auto statistics = _vertex_shader_cache.statistics();
+		statistics += _pixel_shader_cache.statistics();
+
+		return statistics;
 	}
 	void d3d9_runtime::on_present()
 	{
@@ -326,18 +338,12 @@ namespace reshade::d3d9
 				depthstencil = _depthstencil;
 			}
 
-			const auto it = _depth_source_table.find(depthstencil.get());
-
-			if (it != _depth_source_table.end())
-			{
-				it->second.drawcall_count = _drawcalls;
-				it->second.vertices_count += vertices;
-			}
+			_depth_source_tracker.on_draw(depthstencil.get(), _drawcalls, vertices);
 		}
 	}
 	void d3d9_runtime::on_set_depthstencil_surface(IDirect3DSurface9 *&depthstencil)
 	{
-		if (_depth_source_table.find(depthstencil) == _depth_source_table.end())
+		if (!_depth_source_tracker.is_tracked(depthstencil))
 		{
 			D3DSURFACE_DESC desc;
 			depthstencil->GetDesc(&desc);
@@ -349,12 +355,15 @@ namespace reshade::d3d9
 			{
 				return;
 			}
-	
-			depthstencil->AddRef();
+
+			// Stop tracking when the surface is destroyed, instead of holding a reference to it
+			if (!com_release_notifier::attach(depthstencil, _depth_source_tracker.owner(), _depth_source_tracker.release_callback(depthstencil)))
+			{
+				return;
+			}
 
 			// Begin tracking
-			const depth_source_info info = { desc.Width, desc.Height };
-			_depth_source_table.emplace(depthstencil, info);
+			_depth_source_tracker.track(depthstencil, desc.Width, desc.Height);
 		}
 
 		if (_depthstencil_replacement != nullptr && depthstencil == _depthstencil)
@@ -657,44 +666,12 @@ namespace reshade::d3d9
 
 	void d3d9_runtime::detect_depth_source()
 	{
-		if (_is_multisampling_enabled || _depth_source_table.empty())
+		if (_is_multisampling_enabled)
 		{
 			return;
 		}
 
-		depth_source_info best_info = { 0 };
-		IDirect3DSurface9 *best_match = nullptr;
-
-		for (auto it = _depth_source_table.begin(); it != _depth_source_table.end();)
-		{
-			const auto depthstencil = it->first;
-			auto &depthstencil_info = it->second;
-
-			if ((depthstencil->AddRef(), depthstencil->Release()) == 1)
-			{
-				depthstencil->Release();
-
-				it = _depth_source_table.erase(it);
-				continue;
-			}
-			else
-			{
-				++it;
-			}
-
-			if (depthstencil_info.drawcall_count == 0)
-			{
-				continue;
-			}
-
-			if ((depthstencil_info.vertices_count * (1.2f - float(depthstencil_info.drawcall_count) / _drawcalls)) >= (best_info.vertices_count * (1.2f - float(best_info.drawcall_count) / _drawcalls)))
-			{
-				best_match = depthstencil;
-				best_info = depthstencil_info;
-			}
-
-			depthstencil_info.drawcall_count = depthstencil_info.vertices_count = 0;
-		}
+		const auto best_match = _depth_source_tracker.update(_drawcalls);
 
 		if (best_match != nullptr && _depthstencil != best_match)
 		{
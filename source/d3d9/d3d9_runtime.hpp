@@ -8,6 +8,9 @@
 #include <d3d9.h>
 #include "runtime.hpp"
 #include "com_ptr.hpp"
+#include "depth_source_tracker.hpp"
+#include "shader_cache.hpp"
+#include "shader_object_cache.hpp"
 
 namespace reshade::d3d9
 {
@@ -40,6 +43,7 @@ namespace reshade::d3d9
 
 		bool on_init(const D3DPRESENT_PARAMETERS &pp);
 		void on_reset();
+		void on_reset_effect() override;
 		void on_present();
 		void on_draw_call(D3DPRIMITIVETYPE type, UINT count);
 		void on_set_depthstencil_surface(IDirect3DSurface9 *&depthstencil);
@@ -50,6 +54,7 @@ namespace reshade::d3d9
 		bool update_texture(texture &texture, const uint8_t *data) override;
 		bool update_texture_reference(texture &texture, texture_reference id);
 
+		shader_object_statistics get_shader_statistics() const override;
 		void render_technique(const technique &technique) override;
 		void render_imgui_draw_data(ImDrawData *data) override;
 
@@ -61,14 +66,11 @@ namespace reshade::d3d9
 		com_ptr<IDirect3DTexture9> _backbuffer_texture;
 		com_ptr<IDirect3DSurface9> _backbuffer_texture_surface;
 		com_ptr<IDirect3DTexture9> _depthstencil_texture;
+		shader_cache _shader_cache;
+		shader_object_cache<com_ptr<IDirect3DVertexShader9>> _vertex_shader_cache;
+		shader_object_cache<com_ptr<IDirect3DPixelShader9>> _pixel_shader_cache;
 
 	private:
-		struct depth_source_info
-		{
-			UINT width, height;
-			UINT drawcall_count, vertices_count;
-		};
-
 		bool init_backbuffer_texture();
 		bool init_default_depth_stencil();
 		bool init_fx_resources();
@@ -82,7 +84,7 @@ namespace reshade::d3d9
 		D3DFORMAT _backbuffer_format = D3DFMT_UNKNOWN;
 		com_ptr<IDirect3DStateBlock9> _stateblock;
 		com_ptr<IDirect3DSurface9> _depthstencil, _depthstencil_replacement, _default_depthstencil;
-		std::unordered_map<IDirect3DSurface9 *, depth_source_info> _depth_source_table;
+		depth_source_tracker<IDirect3DSurface9 *> _depth_source_tracker;
 
 		com_ptr<IDirect3DVertexBuffer9> _effect_triangle_buffer;
 		com_ptr<IDirect3DVertexDeclaration9> _effect_triangle_layout;
@@ -0,0 +1,489 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+namespace reshade
+{
+	/// <summary>
+	/// Selects the depth stencil that most likely contains the scene depth, based on the vertices each candidate received every frame and how late in the frame it was last drawn to.
+	/// Scores are averaged over a short history and a challenger has to beat the current selection by a margin for several consecutive frames before the selection changes,
+	/// so that single frames with unusual draw call distributions do not cause the replacement resources to be recreated.
+	/// </summary>
+	/// <typeparam name="T">Depth stencil handle type.</typeparam>
+	/// <typeparam name="I">Additional backend specific information stored alongside each candidate.</typeparam>
+	template <typename T, typename I = std::nullptr_t>
+	class depth_source_tracker
+	{
+	public:
+		enum : unsigned int
+		{
+			history_length = 8,
+			switch_frames = 4,
+			// Number of slots in the index that answers whether a depth stencil is tracked without locking
+			index_capacity = 1024,
+		};
+
+		struct candidate
+		{
+			T depthstencil;
+			unsigned int width, height;
+			I info;
+			float history[history_length];
+			unsigned int frames;
+		};
+
+		/// <param name="size_tolerance">Relative difference between the candidate and the frame dimensions that is still considered a match.</param>
+		/// <param name="switch_margin">Factor by which a challenger has to score better than the current selection to replace it.</param>
+		explicit depth_source_tracker(float size_tolerance = 0.05f, float switch_margin = 1.25f) :
+			_state(std::make_shared<state>()), _size_tolerance(size_tolerance), _switch_margin(switch_margin) { }
+		depth_source_tracker(const depth_source_tracker &) = delete;
+		depth_source_tracker &operator=(const depth_source_tracker &) = delete;
+
+		/// <summary>
+		/// Update the dimensions depth stencils have to match to be selected. Changing them discards the score history, so that the selection adapts immediately.
+		/// </summary>
+		void on_resize(unsigned int width, unsigned int height)
+		{
+			const std::lock_guard<std::mutex> lock(_state->mutex);
+
+			if (width == _width && height == _height)
+			{
+				return;
+			}
+
+			_width = width;
+			_height = height;
+
+			for (auto &c : _state->candidates)
+			{
+				reset_history(c);
+			}
+
+			_frame.clear();
+
+			_challenger = T();
+			_challenger_frames = 0;
+		}
+
+		/// <summary>
+		/// Check whether a depth stencil is a known candidate already. Does not lock, so that it is cheap enough to be called every time a depth stencil is bound.
+		/// </summary>
+		bool is_tracked(T depthstencil) const
+		{
+			return _state->contains(depthstencil);
+		}
+		/// <summary>
+		/// Begin tracking a depth stencil as candidate.
+		/// </summary>
+		/// <returns>Returns <c>false</c> if the depth stencil was tracked already.</returns>
+		bool track(T depthstencil, unsigned int width, unsigned int height, const I &info = I())
+		{
+			const std::lock_guard<std::mutex> lock(_state->mutex);
+
+			if (find(depthstencil) != _state->candidates.end())
+			{
+				return false;
+			}
+
+			const candidate c = { depthstencil, width, height, info, { }, 0 };
+
+			_state->candidates.push_back(c);
+			_state->insert(depthstencil);
+
+			return true;
+		}
+		/// <summary>
+		/// Stop tracking a depth stencil, because it was destroyed. Can be called from any thread.
+		/// </summary>
+		void on_release(T depthstencil)
+		{
+			_state->erase(depthstencil);
+		}
+		/// <summary>
+		/// Get a callback that stops tracking a depth stencil when invoked. The callback stays safe to call after this tracker was destroyed.
+		/// </summary>
+		std::function<void()> release_callback(T depthstencil) const
+		{
+			std::weak_ptr<state> weak_state = _state;
+
+			return [weak_state, depthstencil]() {
+				if (const auto s = weak_state.lock())
+				{
+					s->erase(depthstencil);
+				}
+			};
+		}
+		/// <summary>
+		/// Identifies this tracker to objects that store release callbacks of multiple trackers.
+		/// </summary>
+		const void *owner() const
+		{
+			return _state.get();
+		}
+
+		/// <summary>
+		/// Add draw calls to the statistics of a depth stencil for the current frame. Draw calls to unknown depth stencils are ignored when the frame is scored.
+		/// Has to be called on the same thread as <see cref="update"/>, it does not lock, so that it is cheap enough to be called for every draw call.
+		/// </summary>
+		/// <param name="drawcall">The index of the last of these draw calls within the frame.</param>
+		/// <param name="vertices">The number of vertices drawn.</param>
+		void on_draw(T depthstencil, unsigned int drawcall, unsigned int vertices)
+		{
+			auto &stats = _frame[depthstencil];
+			stats.last_drawcall = std::max(stats.last_drawcall, drawcall);
+			stats.vertices += vertices;
+		}
+
+		/// <summary>
+		/// Score all candidates with the statistics of the frame that just ended and update the selection.
+		/// </summary>
+		/// <param name="total_drawcalls">The number of draw calls in the frame that just ended.</param>
+		/// <param name="info">Receives the information stored with the selected depth stencil.</param>
+		/// <returns>The selected depth stencil, or a default constructed handle if there is no candidate.</returns>
+		T update(unsigned int total_drawcalls, I *info = nullptr)
+		{
+			const std::lock_guard<std::mutex> lock(_state->mutex);
+
+			const candidate *best = nullptr, *current = nullptr;
+			float best_score = 0.0f, current_score = 0.0f;
+
+			for (auto &c : _state->candidates)
+			{
+				float score = 0.0f;
+				const auto stats = _frame.find(c.depthstencil);
+
+				// Depth stencils that are last drawn to late in the frame are less likely to contain the scene
+				if (stats != _frame.end() && stats->second.last_drawcall != 0 && total_drawcalls != 0)
+				{
+					score = stats->second.vertices * (1.2f - float(stats->second.last_drawcall) / total_drawcalls);
+				}
+
+				c.history[c.frames++ % history_length] = score;
+
+				if (!matches_size(c))
+				{
+					continue;
+				}
+
+				float average = 0.0f;
+
+				for (unsigned int i = 0; i < history_length; i++)
+				{
+					average += c.history[i];
+				}
+
+				average /= history_length;
+
+				if (c.depthstencil == _current)
+				{
+					current = &c;
+					current_score = average;
+				}
+
+				if (average > best_score)
+				{
+					best = &c;
+					best_score = average;
+				}
+			}
+
+			_frame.clear();
+
+			if (current == nullptr)
+			{
+				// The previous selection is gone or no longer fits the frame, so switch right away
+				_current = best != nullptr ? best->depthstencil : T();
+				_challenger = T();
+				_challenger_frames = 0;
+			}
+			else if (best == nullptr || best == current)
+			{
+				_challenger = T();
+				_challenger_frames = 0;
+			}
+			else if (best_score > current_score * _switch_margin)
+			{
+				if (_challenger != best->depthstencil)
+				{
+					_challenger = best->depthstencil;
+					_challenger_frames = 0;
+				}
+
+				if (++_challenger_frames >= switch_frames)
+				{
+					_current = best->depthstencil;
+					_challenger = T();
+					_challenger_frames = 0;
+				}
+			}
+			else
+			{
+				_challenger = T();
+				_challenger_frames = 0;
+			}
+
+			if (info != nullptr)
+			{
+				const auto it = find(_current);
+
+				if (it != _state->candidates.end())
+				{
+					*info = it->info;
+				}
+			}
+
+			return _current;
+		}
+		/// <summary>
+		/// Get the current selection without scoring a new frame.
+		/// </summary>
+		T current() const
+		{
+			const std::lock_guard<std::mutex> lock(_state->mutex);
+
+			return _current;
+		}
+		/// <summary>
+		/// Forget all candidates and the current selection.
+		/// </summary>
+		void reset()
+		{
+			const std::lock_guard<std::mutex> lock(_state->mutex);
+
+			_state->candidates.clear();
+			_state->rebuild();
+			_frame.clear();
+			_current = _challenger = T();
+			_challenger_frames = 0;
+		}
+
+	private:
+		struct frame_stats
+		{
+			unsigned int last_drawcall = 0, vertices = 0;
+		};
+		struct state
+		{
+			/// <summary>
+			/// Check whether the index contains a depth stencil. Readers retry if a writer changed the index in the meantime, instead of taking the mutex.
+			/// </summary>
+			bool contains(T depthstencil) const
+			{
+				while (true)
+				{
+					const unsigned int begin = sequence.load(std::memory_order_acquire);
+
+					if (begin % 2 != 0)
+					{
+						std::this_thread::yield();
+						continue;
+					}
+
+					if (overflow.load(std::memory_order_relaxed))
+					{
+						const std::lock_guard<std::mutex> lock(mutex);
+
+						return std::any_of(candidates.begin(), candidates.end(),
+							[depthstencil](const candidate &c) {
+								return c.depthstencil == depthstencil;
+							});
+					}
+
+					bool found = false;
+
+					for (size_t i = 0, index = hash(depthstencil); i < index_capacity; i++, index = (index + 1) % index_capacity)
+					{
+						const auto slot_state = slots[index].state.load(std::memory_order_relaxed);
+
+						if (slot_state == slot_empty)
+						{
+							break;
+						}
+						if (slot_state == slot_occupied && slots[index].depthstencil.load(std::memory_order_relaxed) == depthstencil)
+						{
+							found = true;
+							break;
+						}
+					}
+
+					std::atomic_thread_fence(std::memory_order_acquire);
+
+					if (sequence.load(std::memory_order_relaxed) == begin)
+					{
+						return found;
+					}
+				}
+			}
+			/// <summary>
+			/// Add a depth stencil to the index after it was added to the candidates. Has to be called with the mutex held.
+			/// </summary>
+			void insert(T depthstencil)
+			{
+				// Erased slots lengthen the probe sequences just like occupied ones, so rebuild the index once they fill too much of it
+				if (overflow.load(std::memory_order_relaxed) || used + 1 > index_capacity * 3 / 4)
+				{
+					rebuild();
+					return;
+				}
+
+				begin_write();
+
+				size_t index = hash(depthstencil);
+
+				while (slots[index].state.load(std::memory_order_relaxed) == slot_occupied)
+				{
+					index = (index + 1) % index_capacity;
+				}
+
+				if (slots[index].state.load(std::memory_order_relaxed) == slot_empty)
+				{
+					used++;
+				}
+
+				slots[index].depthstencil.store(depthstencil, std::memory_order_relaxed);
+				slots[index].state.store(slot_occupied, std::memory_order_relaxed);
+
+				end_write();
+			}
+			/// <summary>
+			/// Fill the index with the current candidates again. Has to be called with the mutex held.
+			/// </summary>
+			void rebuild()
+			{
+				begin_write();
+
+				for (auto &slot : slots)
+				{
+					slot.state.store(slot_empty, std::memory_order_relaxed);
+				}
+
+				used = 0;
+
+				// Keep the probe sequences short, with more candidates than that the readers fall back to the mutex
+				overflow.store(candidates.size() > index_capacity / 2, std::memory_order_relaxed);
+
+				if (!overflow.load(std::memory_order_relaxed))
+				{
+					for (const auto &c : candidates)
+					{
+						size_t index = hash(c.depthstencil);
+
+						while (slots[index].state.load(std::memory_order_relaxed) != slot_empty)
+						{
+							index = (index + 1) % index_capacity;
+						}
+
+						slots[index].depthstencil.store(c.depthstencil, std::memory_order_relaxed);
+						slots[index].state.store(slot_occupied, std::memory_order_relaxed);
+						used++;
+					}
+				}
+
+				end_write();
+			}
+			void erase(T depthstencil)
+			{
+				const std::lock_guard<std::mutex> lock(mutex);
+
+				candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+					[depthstencil](const candidate &c) {
+						return c.depthstencil == depthstencil;
+					}), candidates.end());
+
+				begin_write();
+
+				for (size_t i = 0, index = hash(depthstencil); i < index_capacity && slots[index].state.load(std::memory_order_relaxed) != slot_empty; i++, index = (index + 1) % index_capacity)
+				{
+					if (slots[index].state.load(std::memory_order_relaxed) == slot_occupied && slots[index].depthstencil.load(std::memory_order_relaxed) == depthstencil)
+					{
+						// Keep the slot marked as used, so that probes for other depth stencils continue past it
+						slots[index].state.store(slot_erased, std::memory_order_relaxed);
+						break;
+					}
+				}
+
+				end_write();
+			}
+
+			mutable std::mutex mutex;
+			std::vector<candidate> candidates;
+
+		private:
+			enum : unsigned char
+			{
+				slot_empty,
+				slot_occupied,
+				slot_erased,
+			};
+
+			struct slot
+			{
+				std::atomic<T> depthstencil { T() };
+				std::atomic<unsigned char> state { slot_empty };
+			};
+
+			static size_t hash(T depthstencil)
+			{
+				return static_cast<size_t>((std::hash<T>()(depthstencil) * 0x9E3779B97F4A7C15ull) >> 32) % index_capacity;
+			}
+
+			void begin_write()
+			{
+				sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+			}
+			void end_write()
+			{
+				sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+			}
+
+			// Odd while a writer changes the index
+			std::atomic<unsigned int> sequence { 0 };
+			std::atomic<bool> overflow { false };
+			// Occupied and erased slots, only accessed with the mutex held
+			size_t used = 0;
+			slot slots[index_capacity];
+		};
+
+		static void reset_history(candidate &c)
+		{
+			std::fill_n(c.history, static_cast<size_t>(history_length), 0.0f);
+			c.frames = 0;
+		}
+
+		bool matches_size(const candidate &c) const
+		{
+			return
+				c.width >= _width * (1.0f - _size_tolerance) && c.width <= _width * (1.0f + _size_tolerance) &&
+				c.height >= _height * (1.0f - _size_tolerance) && c.height <= _height * (1.0f + _size_tolerance);
+		}
+
+		typename std::vector<candidate>::iterator find(T depthstencil) const
+		{
+			return std::find_if(_state->candidates.begin(), _state->candidates.end(),
+				[depthstencil](const candidate &c) {
+					return c.depthstencil == depthstencil;
+				});
+		}
+
+		const std::shared_ptr<state> _state;
+		std::unordered_map<T, frame_stats> _frame;
+		const float _size_tolerance, _switch_margin;
+		unsigned int _width = 0, _height = 0;
+		T _current = T(), _challenger = T();
+		unsigned int _challenger_frames = 0;
+	};
+}
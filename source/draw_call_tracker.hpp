@@ -0,0 +1,352 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <utility>
+#include <cstdint>
+
+namespace reshade
+{
+	/// <summary>
+	/// Draw call statistics, sharded per submitting thread so that concurrent draw calls never contend on a shared cache line or wait for each other.
+	/// Also remembers the depth stencil bound to each device context, so the draw path does not have to query it from the driver.
+	/// </summary>
+	/// <typeparam name="C">Device context pointer type.</typeparam>
+	/// <typeparam name="T">Depth stencil pointer type.</typeparam>
+	template <typename C, typename T>
+	class draw_call_tracker
+	{
+	public:
+		struct counters
+		{
+			unsigned int drawcalls = 0, vertices = 0;
+			// Index of the last draw call within the frame, counted on the submitting thread
+			unsigned int last_drawcall = 0;
+		};
+
+		static constexpr size_t binding_capacity = 64, depthstencil_capacity = 128;
+
+		draw_call_tracker() : _instance(next_instance()) { }
+		draw_call_tracker(const draw_call_tracker &) = delete;
+		draw_call_tracker &operator=(const draw_call_tracker &) = delete;
+
+		/// <summary>
+		/// Record the depth stencil currently bound to a device context.
+		/// </summary>
+		/// <param name="context">The device context the depth stencil was bound to.</param>
+		/// <param name="depthstencil">The bound depth stencil, or <c>nullptr</c> if it was unbound.</param>
+		void track_binding(C context, T depthstencil)
+		{
+			binding *available = nullptr;
+
+			// Slots are never emptied again once claimed, so a probe can stop at the first empty one
+			for (size_t i = 0, index = hash(context, binding_capacity); i < binding_capacity; i++, index = (index + 1) % binding_capacity)
+			{
+				auto &slot = _bindings[index];
+				const C key = slot.context.load(std::memory_order_acquire);
+
+				if (key == context)
+				{
+					slot.depthstencil.store(depthstencil, std::memory_order_release);
+					slot.valid.store(true, std::memory_order_release);
+					return;
+				}
+				if (key == nullptr || key == forgotten())
+				{
+					if (available == nullptr)
+					{
+						available = &slot;
+					}
+					if (key == nullptr)
+					{
+						break;
+					}
+				}
+			}
+
+			// Other contexts may claim slots at the same time, so retry until one is won
+			for (size_t i = 0, index = available != nullptr ? available - _bindings : 0; available != nullptr && i < binding_capacity; i++, index = (index + 1) % binding_capacity)
+			{
+				auto &slot = _bindings[index];
+				C expected = slot.context.load(std::memory_order_acquire);
+
+				if ((expected == nullptr || expected == forgotten()) && slot.context.compare_exchange_strong(expected, context, std::memory_order_acq_rel))
+				{
+					slot.depthstencil.store(depthstencil, std::memory_order_release);
+					slot.valid.store(true, std::memory_order_release);
+					return;
+				}
+			}
+
+			// Table is full, lookups for this context fall back to querying the driver
+		}
+		/// <summary>
+		/// Forget the depth stencil binding of a device context, e.g. because its state changed in a way that cannot be tracked or it was destroyed.
+		/// </summary>
+		/// <param name="context">The device context to forget.</param>
+		void forget_binding(C context)
+		{
+			if (const auto slot = find_slot(context))
+			{
+				slot->valid.store(false, std::memory_order_release);
+				slot->depthstencil.store(nullptr, std::memory_order_relaxed);
+				slot->context.store(forgotten(), std::memory_order_release);
+			}
+		}
+		/// <summary>
+		/// Look up the depth stencil currently bound to a device context.
+		/// </summary>
+		/// <param name="context">The device context to look up.</param>
+		/// <param name="depthstencil">Receives the bound depth stencil.</param>
+		/// <returns>Returns <c>false</c> if the binding is unknown and has to be queried from the driver instead.</returns>
+		bool find_binding(C context, T &depthstencil) const
+		{
+			const auto slot = find_slot(context);
+
+			if (slot == nullptr || !slot->valid.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+
+			depthstencil = slot->depthstencil.load(std::memory_order_acquire);
+
+			return true;
+		}
+
+		/// <summary>
+		/// Count a draw call on the calling thread's shard. Never waits for other threads or for a merge in progress.
+		/// </summary>
+		/// <param name="depthstencil">The depth stencil the draw call rendered to, or <c>nullptr</c> to only count it towards the totals.</param>
+		/// <param name="vertices">The number of vertices drawn.</param>
+		void on_draw(T depthstencil, unsigned int vertices)
+		{
+			shard &s = local_shard();
+
+			// Move on to the other frame once the merge asked for it, the merge only ever reads the frame this thread left
+			const unsigned int requested = s.requested_epoch.load(std::memory_order_acquire);
+
+			if (requested != s.epoch)
+			{
+				s.epoch = requested;
+				s.frames[s.epoch % 2].clear();
+				s.acknowledged_epoch.store(s.epoch, std::memory_order_release);
+			}
+
+			auto &frame = s.frames[s.epoch % 2];
+			frame.total.drawcalls += 1;
+			frame.total.vertices += vertices;
+
+			if (depthstencil != nullptr)
+			{
+				if (const auto stats = frame.find_or_insert(depthstencil))
+				{
+					stats->drawcalls += 1;
+					stats->vertices += vertices;
+					stats->last_drawcall = frame.total.drawcalls;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Collect the statistics of all shards. Every draw call is reported exactly once, but only by the merge after the one that followed it,
+		/// since a thread hands over its statistics on the first draw call after a merge. Threads that stopped drawing keep theirs until they draw again.
+		/// </summary>
+		/// <param name="callback">Called with the depth stencil and its counters for every depth stencil that was drawn to.</param>
+		/// <returns>The total counters of all threads that were handed over since the last merge.</returns>
+		template <typename F>
+		counters merge(F callback)
+		{
+			counters result;
+
+			const std::lock_guard<std::mutex> lock(_shards_mutex);
+
+			for (const auto &s : _shards)
+			{
+				const unsigned int acknowledged = s->acknowledged_epoch.load(std::memory_order_acquire);
+
+				if (acknowledged != s->drained_epoch)
+				{
+					const auto &frame = s->frames[s->drained_epoch % 2];
+
+					result.drawcalls += frame.total.drawcalls;
+					result.vertices += frame.total.vertices;
+
+					for (const size_t index : frame.used)
+					{
+						callback(frame.slots[index].first, frame.slots[index].second);
+					}
+
+					s->drained_epoch = acknowledged;
+				}
+
+				// Only ask for the next frame once the previous one was drained, so that the thread never clears a frame that was not reported yet
+				if (s->requested_epoch.load(std::memory_order_relaxed) == acknowledged)
+				{
+					s->requested_epoch.store(acknowledged + 1, std::memory_order_release);
+				}
+			}
+
+			return result;
+		}
+
+	private:
+		struct frame_counters
+		{
+			counters total;
+			// Indices of the occupied slots, in the order the depth stencils were first drawn to
+			std::vector<size_t> used;
+			std::pair<T, counters> slots[depthstencil_capacity] = { };
+
+			counters *find_or_insert(T depthstencil)
+			{
+				for (size_t i = 0, index = hash(depthstencil, depthstencil_capacity); i < depthstencil_capacity; i++, index = (index + 1) % depthstencil_capacity)
+				{
+					auto &slot = slots[index];
+
+					if (slot.first == depthstencil)
+					{
+						return &slot.second;
+					}
+					if (slot.first == nullptr)
+					{
+						slot.first = depthstencil;
+						used.push_back(index);
+						return &slot.second;
+					}
+				}
+
+				// More depth stencils in a single frame than fit, the rest only counts towards the totals
+				return nullptr;
+			}
+			void clear()
+			{
+				for (const size_t index : used)
+				{
+					slots[index] = { };
+				}
+
+				total = counters();
+				used.clear();
+			}
+		};
+		struct alignas(64) shard
+		{
+			std::thread::id owner;
+			// Written by the merge once per frame, read by the owning thread on every draw call
+			std::atomic<unsigned int> requested_epoch = 0;
+			// Written by the owning thread when it moved on to the requested frame
+			std::atomic<unsigned int> acknowledged_epoch = 0;
+			// Only accessed by the owning thread and the merge respectively
+			unsigned int epoch = 0, drained_epoch = 0;
+			frame_counters frames[2];
+		};
+		struct binding
+		{
+			std::atomic<C> context = nullptr;
+			std::atomic<T> depthstencil = nullptr;
+			std::atomic<bool> valid = false;
+		};
+
+		template <typename P>
+		static size_t hash(P pointer, size_t capacity)
+		{
+			// Objects are at least 16 byte aligned, so the lower bits carry no information
+			return static_cast<size_t>(((reinterpret_cast<uintptr_t>(pointer) >> 4) * 0x9E3779B97F4A7C15ull) >> 32) % capacity;
+		}
+		static C forgotten()
+		{
+			// Marks a slot that was used before, so probes continue past it
+			return reinterpret_cast<C>(static_cast<uintptr_t>(1));
+		}
+		static unsigned long long next_instance()
+		{
+			static std::atomic<unsigned long long> s_counter = 0;
+			return ++s_counter;
+		}
+
+		const binding *find_slot(C context) const
+		{
+			for (size_t i = 0, index = hash(context, binding_capacity); i < binding_capacity; i++, index = (index + 1) % binding_capacity)
+			{
+				const auto &slot = _bindings[index];
+				const C key = slot.context.load(std::memory_order_acquire);
+
+				if (key == context)
+				{
+					return &slot;
+				}
+				if (key == nullptr)
+				{
+					break;
+				}
+			}
+
+			return nullptr;
+		}
+		binding *find_slot(C context)
+		{
+			return const_cast<binding *>(static_cast<const draw_call_tracker *>(this)->find_slot(context));
+		}
+
+		shard &local_shard()
+		{
+			// Cache the shards of this thread per instance, so that several runtimes drawing on the same thread do not evict each other on every draw call
+			// Keyed by instance instead of address, so that a tracker reusing the address of a destroyed one is never confused with it
+			struct cache_entry { unsigned long long instance; shard *s; };
+			static thread_local cache_entry t_cache[8] = { };
+			static thread_local unsigned int t_cache_next = 0;
+
+			for (const auto &entry : t_cache)
+			{
+				if (entry.instance == _instance)
+				{
+					return *entry.s;
+				}
+			}
+
+			shard *s = nullptr;
+
+			{ const std::lock_guard<std::mutex> lock(_shards_mutex);
+
+				const auto thread = std::this_thread::get_id();
+				const auto it = std::find_if(_shards.begin(), _shards.end(),
+					[thread](const auto &item) {
+						return item->owner == thread;
+					});
+
+				if (it != _shards.end())
+				{
+					s = it->get();
+				}
+				else
+				{
+					_shards.push_back(std::make_unique<shard>());
+					_shards.back()->owner = thread;
+
+					s = _shards.back().get();
+				}
+			}
+
+			// Replace the oldest entry, a tracker that was evicted finds its shard again through the lookup above
+			auto &entry = t_cache[t_cache_next++ % 8];
+			entry.instance = _instance;
+			entry.s = s;
+
+			return *s;
+		}
+
+		const unsigned long long _instance;
+		std::mutex _shards_mutex;
+		std::vector<std::unique_ptr<shard>> _shards;
+		binding _bindings[binding_capacity];
+	};
+}
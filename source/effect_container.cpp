@@ -0,0 +1,186 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_container.hpp"
+#include "binary_stream.hpp"
+
+namespace reshadefx
+{
+	namespace
+	{
+		const char container_magic[4] = { 'R', 'S', 'F', 'X' };
+
+		void write_header(binary_writer &writer, const effect_container &container)
+		{
+			writer.write_raw(container_magic, 4);
+			writer.write(effect_container::version);
+			writer.write(container.input_hash);
+		}
+
+		bool read_header(binary_reader &reader, effect_container &container)
+		{
+			uint32_t version;
+
+			return reader.expect(container_magic, 4) && reader.read(version) && version == effect_container::version && reader.read(container.input_hash);
+		}
+		bool read_dependencies(binary_reader &reader, std::vector<effect_container::dependency> &dependencies)
+		{
+			uint32_t count;
+
+			if (!reader.read_count(count, 20))
+			{
+				return false;
+			}
+
+			dependencies.resize(count);
+
+			for (auto &dependency : dependencies)
+			{
+				if (!reader.read(dependency.path) || !reader.read(dependency.size) || !reader.read(dependency.modified))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		void hash(uint64_t &value, const std::string &data)
+		{
+			for (const char c : data)
+			{
+				value = (value ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+			}
+
+			// Terminate every string, so that e.g. the macros "AB" = "C" and "A" = "BC" do not hash the same
+			value = (value ^ 0xFF) * 1099511628211ull;
+		}
+	}
+
+	uint64_t hash_preprocessor_inputs(const std::vector<reshade::filesystem::path> &include_paths, const std::vector<std::pair<std::string, std::string>> &macros)
+	{
+		uint64_t value = 14695981039346656037ull;
+
+		hash(value, std::to_string(include_paths.size()));
+
+		for (const auto &include_path : include_paths)
+		{
+			hash(value, include_path.string());
+		}
+		for (const auto &macro : macros)
+		{
+			hash(value, macro.first);
+			hash(value, macro.second);
+		}
+
+		return value;
+	}
+	bool stamp_dependencies(const std::vector<reshade::filesystem::path> &files, std::vector<effect_container::dependency> &dependencies)
+	{
+		dependencies.clear();
+		dependencies.reserve(files.size());
+
+		for (const auto &file : files)
+		{
+			effect_container::dependency dependency;
+			dependency.path = file.string();
+
+			if (!reshade::filesystem::file_stamp(file, dependency.size, dependency.modified))
+			{
+				return false;
+			}
+
+			dependencies.push_back(std::move(dependency));
+		}
+
+		return true;
+	}
+
+	std::string serialize(const effect_container &container)
+	{
+		binary_writer writer;
+
+		write_header(writer, container);
+
+		writer.write(static_cast<uint32_t>(container.dependencies.size()));
+
+		for (const auto &dependency : container.dependencies)
+		{
+			writer.write(dependency.path);
+			writer.write(dependency.size);
+			writer.write(dependency.modified);
+		}
+
+		writer.write(container.source);
+		writer.write(container.backend);
+
+		if (!container.backend.empty())
+		{
+			writer.write(serialize(container.reflection));
+			writer.write(static_cast<uint32_t>(container.code.size()));
+
+			for (const auto &code : container.code)
+			{
+				writer.write(code);
+			}
+		}
+
+		return std::move(writer.data());
+	}
+	bool is_up_to_date(const uint8_t *data, size_t size, uint64_t input_hash)
+	{
+		effect_container container;
+		binary_reader reader(data, size);
+
+		if (!read_header(reader, container) || container.input_hash != input_hash || !read_dependencies(reader, container.dependencies))
+		{
+			return false;
+		}
+
+		for (const auto &dependency : container.dependencies)
+		{
+			uint64_t current_size, current_modified;
+
+			if (!reshade::filesystem::file_stamp(dependency.path, current_size, current_modified) || current_size != dependency.size || current_modified != dependency.modified)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+	bool deserialize(const uint8_t *data, size_t size, effect_container &container)
+	{
+		binary_reader reader(data, size);
+
+		if (!read_header(reader, container) || !read_dependencies(reader, container.dependencies) || !reader.read(container.source) || !reader.read(container.backend))
+		{
+			return false;
+		}
+
+		if (!container.backend.empty())
+		{
+			std::string reflection;
+			uint32_t count;
+
+			if (!reader.read(reflection) || !deserialize(reinterpret_cast<const uint8_t *>(reflection.data()), reflection.size(), container.reflection) || !reader.read_count(count, 4))
+			{
+				return false;
+			}
+
+			container.code.resize(count);
+
+			for (auto &code : container.code)
+			{
+				if (!reader.read(code))
+				{
+					return false;
+				}
+			}
+		}
+
+		return reader.at_end();
+	}
+}
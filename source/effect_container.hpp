@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include "filesystem.hpp"
+#include "effect_reflection.hpp"
+
+namespace reshadefx
+{
+	/// <summary>
+	/// A precompiled effect, which is written to disk after an effect was compiled, so that the next start can load it instead of running the preprocessor again.
+	/// If the backend can load an effect without its syntax tree, it also holds the reflection and the code the backend generated, so that the parser is skipped as well.
+	/// The binary layout starts with a fixed size header and the dependency table, so that checking whether the container is still up to date does not have to look at the rest of it.
+	/// </summary>
+	struct effect_container
+	{
+		/// <summary>
+		/// The version of the binary layout. Containers of a different version are treated as out of date.
+		/// </summary>
+		static constexpr uint32_t version = 3;
+
+		struct dependency
+		{
+			std::string path;
+			uint64_t size = 0, modified = 0;
+		};
+
+		/// <summary>
+		/// The hash of the preprocessor inputs that are not files, as returned by <see cref="hash_preprocessor_inputs"/>.
+		/// </summary>
+		uint64_t input_hash = 0;
+		/// <summary>
+		/// The effect file and every file it included, with their size and modification time at the time they were read.
+		/// </summary>
+		std::vector<dependency> dependencies;
+		/// <summary>
+		/// The preprocessed source code of the effect.
+		/// </summary>
+		std::string source;
+		/// <summary>
+		/// Identifies the code generator that produced <see cref="code"/>, including anything the code depends on besides the source, e.g. the feature level. Empty if the container holds no generated code.
+		/// </summary>
+		std::string backend;
+		/// <summary>
+		/// The reflection of the effect the code was generated with.
+		/// </summary>
+		effect_reflection reflection;
+		/// <summary>
+		/// The code the backend generated, in a layout only that backend knows.
+		/// </summary>
+		std::vector<std::string> code;
+	};
+
+	/// <summary>
+	/// Hash the include paths and macro definitions passed to the preprocessor, in the order they were added.
+	/// </summary>
+	uint64_t hash_preprocessor_inputs(const std::vector<reshade::filesystem::path> &include_paths, const std::vector<std::pair<std::string, std::string>> &macros);
+	/// <summary>
+	/// Record the current size and modification time of the specified files.
+	/// </summary>
+	/// <returns>Returns <c>true</c> if all files exist, <c>false</c> otherwise.</returns>
+	bool stamp_dependencies(const std::vector<reshade::filesystem::path> &files, std::vector<effect_container::dependency> &dependencies);
+
+	/// <summary>
+	/// Write a container to its binary representation.
+	/// </summary>
+	std::string serialize(const effect_container &container);
+	/// <summary>
+	/// Check whether a container was created for the same preprocessor inputs and none of its dependencies changed since. Only reads the header and dependency table.
+	/// </summary>
+	/// <param name="data">The binary representation of the container, e.g. a <see cref="reshade::filesystem::mapped_file"/>.</param>
+	/// <param name="size">The size of the data in bytes.</param>
+	/// <param name="input_hash">The hash of the current preprocessor inputs.</param>
+	bool is_up_to_date(const uint8_t *data, size_t size, uint64_t input_hash);
+	/// <summary>
+	/// Read a container from its binary representation. Every read is checked against the size of the data, so a truncated or corrupted container is rejected instead of read past its end.
+	/// </summary>
+	/// <param name="data">The binary representation of the container.</param>
+	/// <param name="size">The size of the data in bytes.</param>
+	/// <param name="container">Receives the container.</param>
+	/// <returns>Returns <c>true</c> if the container is valid, <c>false</c> otherwise.</returns>
+	bool deserialize(const uint8_t *data, size_t size, effect_container &container);
+}
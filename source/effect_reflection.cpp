@@ -0,0 +1,549 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_reflection.hpp"
+#include "syntax_tree.hpp"
+#include "optimizer.hpp"
+#include "binary_stream.hpp"
+#include <cstring>
+#include <algorithm>
+#include <unordered_set>
+
+namespace reshadefx
+{
+	using namespace nodes;
+
+	namespace
+	{
+		reshade::texture_reference semantic_to_reference(const std::string &semantic)
+		{
+			if (semantic == "COLOR" || semantic == "SV_TARGET")
+			{
+				return reshade::texture_reference::back_buffer;
+			}
+			if (semantic == "DEPTH" || semantic == "SV_DEPTH")
+			{
+				return reshade::texture_reference::depth_buffer;
+			}
+
+			return reshade::texture_reference::none;
+		}
+
+		// Incremented whenever the binary layout below changes, so that data written by an older version is rejected
+		const uint32_t reflection_version = 1;
+
+		void write(binary_writer &writer, const std::unordered_map<std::string, reshade::variant> &annotations)
+		{
+			// Sort the keys, so that the same effect always results in the same bytes
+			std::vector<const std::pair<const std::string, reshade::variant> *> sorted;
+
+			for (const auto &annotation : annotations)
+			{
+				sorted.push_back(&annotation);
+			}
+
+			std::sort(sorted.begin(), sorted.end(), [](auto lhs, auto rhs) { return lhs->first < rhs->first; });
+
+			writer.write(static_cast<uint32_t>(sorted.size()));
+
+			for (const auto annotation : sorted)
+			{
+				writer.write(annotation->first);
+				writer.write(static_cast<uint32_t>(annotation->second.data().size()));
+
+				for (const auto &value : annotation->second.data())
+				{
+					writer.write(value);
+				}
+			}
+		}
+		void write(binary_writer &writer, const std::vector<size_t> &indices)
+		{
+			writer.write(static_cast<uint32_t>(indices.size()));
+
+			for (const auto index : indices)
+			{
+				writer.write(static_cast<uint64_t>(index));
+			}
+		}
+
+		bool read(binary_reader &reader, size_t &value)
+		{
+			uint64_t wide;
+
+			if (!reader.read(wide) || wide > SIZE_MAX)
+			{
+				return false;
+			}
+
+			value = static_cast<size_t>(wide);
+
+			return true;
+		}
+		template <typename T>
+		bool read(binary_reader &reader, T &value)
+		{
+			uint32_t bits;
+
+			if (!reader.read(bits))
+			{
+				return false;
+			}
+
+			value = static_cast<T>(bits);
+
+			return true;
+		}
+		bool read(binary_reader &reader, bool &value)
+		{
+			uint32_t bits;
+
+			if (!reader.read(bits) || bits > 1)
+			{
+				return false;
+			}
+
+			value = bits != 0;
+
+			return true;
+		}
+		bool read(binary_reader &reader, std::unordered_map<std::string, reshade::variant> &annotations)
+		{
+			uint32_t count;
+
+			if (!reader.read_count(count, 8))
+			{
+				return false;
+			}
+
+			annotations.clear();
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				std::string name;
+				uint32_t value_count;
+
+				if (!reader.read(name) || !reader.read_count(value_count, 4))
+				{
+					return false;
+				}
+
+				std::vector<std::string> values(value_count);
+
+				for (auto &value : values)
+				{
+					if (!reader.read(value))
+					{
+						return false;
+					}
+				}
+
+				annotations[name] = reshade::variant(values);
+			}
+
+			return true;
+		}
+		bool read(binary_reader &reader, std::vector<size_t> &indices)
+		{
+			uint32_t count;
+
+			if (!reader.read_count(count, 8))
+			{
+				return false;
+			}
+
+			indices.resize(count);
+
+			for (auto &index : indices)
+			{
+				if (!read(reader, index))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+	}
+
+	effect_reflection reflect(const syntax_tree &ast, reshade::uniform_layout::rules rules)
+	{
+		effect_reflection reflection;
+		reshade::uniform_layout layout(rules);
+		std::unordered_map<const variable_declaration_node *, size_t> texture_indices, sampler_indices;
+
+		// Classify variables the same way the backends do, so that the lists line up with the order in which they visit them
+		for (auto variable : ast.variables)
+		{
+			if (variable->type.is_texture())
+			{
+				texture_info info;
+				info.name = variable->name;
+				info.unique_name = variable->unique_name;
+				info.semantic = variable->semantic;
+				info.width = variable->properties.width;
+				info.height = variable->properties.height;
+				info.levels = variable->properties.levels;
+				info.format = variable->properties.format;
+				info.reference = semantic_to_reference(variable->semantic);
+				info.annotations = variable->annotation_list;
+
+				texture_indices[variable] = reflection.textures.size();
+				reflection.textures.push_back(std::move(info));
+			}
+			else if (variable->type.is_sampler())
+			{
+				sampler_info info;
+				info.name = variable->name;
+				info.unique_name = variable->unique_name;
+				info.srgb = variable->properties.srgb_texture;
+				info.filter = variable->properties.filter;
+				info.address_u = variable->properties.address_u;
+				info.address_v = variable->properties.address_v;
+				info.address_w = variable->properties.address_w;
+				info.min_lod = variable->properties.min_lod;
+				info.max_lod = variable->properties.max_lod;
+				info.lod_bias = variable->properties.lod_bias;
+
+				// Samplers can only be declared after the texture they read from, so it was listed already
+				const auto texture = texture_indices.find(variable->properties.texture);
+				info.texture = texture != texture_indices.end() ? texture->second : reflection.textures.size();
+
+				sampler_indices[variable] = reflection.samplers.size();
+				reflection.samplers.push_back(std::move(info));
+			}
+			else if (variable->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				uniform_info info;
+				info.name = variable->name;
+				info.unique_name = variable->unique_name;
+				info.basetype = static_cast<reshade::uniform_datatype>(variable->type.basetype - 1);
+				info.rows = variable->type.rows;
+				info.columns = variable->type.cols;
+				info.elements = std::max(0, variable->type.array_length);
+				info.offset = layout.add(info.rows, info.columns, info.elements);
+				info.size = info.rows * info.columns * std::max(1u, info.elements) * 4;
+				info.element_stride = layout[layout.member_count() - 1].element_stride;
+				info.column_stride = layout[layout.member_count() - 1].column_stride;
+				info.row_stride = layout[layout.member_count() - 1].row_stride;
+				info.annotations = variable->annotation_list;
+				info.initial_value.resize(info.size / 4);
+
+				if (variable->initializer_expression != nullptr && variable->initializer_expression->id == nodeid::literal_expression)
+				{
+					const auto literal = static_cast<const literal_expression_node *>(variable->initializer_expression);
+
+					// A literal holds at most 16 components, anything beyond that stays zero
+					std::memcpy(info.initial_value.data(), literal->value_uint, std::min(info.initial_value.size(), size_t(16)) * 4);
+				}
+
+				reflection.uniforms.push_back(std::move(info));
+			}
+		}
+
+		reflection.uniform_block_size = layout.total_size();
+
+		for (auto technique : ast.techniques)
+		{
+			technique_info info;
+			info.name = technique->name;
+			info.annotations = technique->annotation_list;
+
+			for (auto pass : technique->pass_list)
+			{
+				pass_info pass_info;
+				pass_info.srgb_write_enable = pass->srgb_write_enable;
+				pass_info.clear_render_targets = pass->clear_render_targets;
+				pass_info.blend_enable = pass->blend_enable;
+				pass_info.stencil_enable = pass->stencil_enable;
+				pass_info.color_write_mask = pass->color_write_mask;
+				pass_info.stencil_read_mask = pass->stencil_read_mask;
+				pass_info.stencil_write_mask = pass->stencil_write_mask;
+				pass_info.blend_op = pass->blend_op;
+				pass_info.blend_op_alpha = pass->blend_op_alpha;
+				pass_info.src_blend = pass->src_blend;
+				pass_info.dest_blend = pass->dest_blend;
+				pass_info.stencil_comparison_func = pass->stencil_comparison_func;
+				pass_info.stencil_reference_value = pass->stencil_reference_value;
+				pass_info.stencil_op_pass = pass->stencil_op_pass;
+				pass_info.stencil_op_fail = pass->stencil_op_fail;
+				pass_info.stencil_op_depth_fail = pass->stencil_op_depth_fail;
+
+				if (pass->vertex_shader != nullptr)
+				{
+					pass_info.vertex_shader = pass->vertex_shader->unique_name;
+				}
+				if (pass->pixel_shader != nullptr)
+				{
+					pass_info.pixel_shader = pass->pixel_shader->unique_name;
+				}
+
+				for (auto target : pass->render_targets)
+				{
+					const auto texture = texture_indices.find(target);
+
+					pass_info.render_targets.push_back(texture != texture_indices.end() ? texture->second : pass_info::no_render_target);
+				}
+
+				while (!pass_info.render_targets.empty() && pass_info.render_targets.back() == pass_info::no_render_target)
+				{
+					pass_info.render_targets.pop_back();
+				}
+
+				std::unordered_set<const variable_declaration_node *> references;
+				find_references(pass->vertex_shader, references);
+				find_references(pass->pixel_shader, references);
+
+				for (auto variable : references)
+				{
+					const auto sampler = sampler_indices.find(variable);
+
+					if (sampler != sampler_indices.end())
+					{
+						pass_info.samplers.push_back(sampler->second);
+					}
+				}
+
+				// The set is unordered, but the bindings derived from this list should not change between runs
+				std::sort(pass_info.samplers.begin(), pass_info.samplers.end());
+
+				info.passes.push_back(std::move(pass_info));
+			}
+
+			reflection.techniques.push_back(std::move(info));
+		}
+
+		return reflection;
+	}
+
+	std::string serialize(const effect_reflection &reflection)
+	{
+		binary_writer writer;
+
+		writer.write(reflection_version);
+		writer.write(static_cast<uint64_t>(reflection.uniform_block_size));
+
+		writer.write(static_cast<uint32_t>(reflection.uniforms.size()));
+
+		for (const auto &uniform : reflection.uniforms)
+		{
+			writer.write(uniform.name);
+			writer.write(uniform.unique_name);
+			writer.write(static_cast<uint32_t>(uniform.basetype));
+			writer.write(uniform.rows);
+			writer.write(uniform.columns);
+			writer.write(uniform.elements);
+			writer.write(static_cast<uint64_t>(uniform.offset));
+			writer.write(static_cast<uint64_t>(uniform.size));
+			writer.write(static_cast<uint64_t>(uniform.element_stride));
+			writer.write(static_cast<uint64_t>(uniform.column_stride));
+			writer.write(static_cast<uint64_t>(uniform.row_stride));
+			write(writer, uniform.annotations);
+			writer.write(static_cast<uint32_t>(uniform.initial_value.size()));
+
+			for (const auto value : uniform.initial_value)
+			{
+				writer.write(value);
+			}
+		}
+
+		writer.write(static_cast<uint32_t>(reflection.textures.size()));
+
+		for (const auto &texture : reflection.textures)
+		{
+			writer.write(texture.name);
+			writer.write(texture.unique_name);
+			writer.write(texture.semantic);
+			writer.write(texture.width);
+			writer.write(texture.height);
+			writer.write(texture.levels);
+			writer.write(static_cast<uint32_t>(texture.format));
+			writer.write(static_cast<uint32_t>(texture.reference));
+			write(writer, texture.annotations);
+		}
+
+		writer.write(static_cast<uint32_t>(reflection.samplers.size()));
+
+		for (const auto &sampler : reflection.samplers)
+		{
+			writer.write(sampler.name);
+			writer.write(sampler.unique_name);
+			writer.write(static_cast<uint64_t>(sampler.texture));
+			writer.write(static_cast<uint32_t>(sampler.srgb));
+			writer.write(static_cast<uint32_t>(sampler.filter));
+			writer.write(static_cast<uint32_t>(sampler.address_u));
+			writer.write(static_cast<uint32_t>(sampler.address_v));
+			writer.write(static_cast<uint32_t>(sampler.address_w));
+			writer.write(sampler.min_lod);
+			writer.write(sampler.max_lod);
+			writer.write(sampler.lod_bias);
+		}
+
+		writer.write(static_cast<uint32_t>(reflection.techniques.size()));
+
+		for (const auto &technique : reflection.techniques)
+		{
+			writer.write(technique.name);
+			write(writer, technique.annotations);
+			writer.write(static_cast<uint32_t>(technique.passes.size()));
+
+			for (const auto &pass : technique.passes)
+			{
+				writer.write(pass.vertex_shader);
+				writer.write(pass.pixel_shader);
+				write(writer, pass.render_targets);
+				write(writer, pass.samplers);
+				writer.write(static_cast<uint32_t>(pass.srgb_write_enable));
+				writer.write(static_cast<uint32_t>(pass.clear_render_targets));
+				writer.write(static_cast<uint32_t>(pass.blend_enable));
+				writer.write(static_cast<uint32_t>(pass.stencil_enable));
+				writer.write(static_cast<uint32_t>(pass.color_write_mask));
+				writer.write(static_cast<uint32_t>(pass.stencil_read_mask));
+				writer.write(static_cast<uint32_t>(pass.stencil_write_mask));
+				writer.write(pass.blend_op);
+				writer.write(pass.blend_op_alpha);
+				writer.write(pass.src_blend);
+				writer.write(pass.dest_blend);
+				writer.write(pass.stencil_comparison_func);
+				writer.write(pass.stencil_reference_value);
+				writer.write(pass.stencil_op_pass);
+				writer.write(pass.stencil_op_fail);
+				writer.write(pass.stencil_op_depth_fail);
+			}
+		}
+
+		return std::move(writer.data());
+	}
+	bool deserialize(const uint8_t *data, size_t size, effect_reflection &reflection)
+	{
+		binary_reader reader(data, size);
+		uint32_t version, count;
+
+		if (!reader.read(version) || version != reflection_version || !read(reader, reflection.uniform_block_size))
+		{
+			return false;
+		}
+
+		if (!reader.read_count(count, 60))
+		{
+			return false;
+		}
+
+		reflection.uniforms.resize(count);
+
+		for (auto &uniform : reflection.uniforms)
+		{
+			uint32_t value_count;
+
+			if (!reader.read(uniform.name) || !reader.read(uniform.unique_name) || !read(reader, uniform.basetype) ||
+				!reader.read(uniform.rows) || !reader.read(uniform.columns) || !reader.read(uniform.elements) ||
+				!read(reader, uniform.offset) || !read(reader, uniform.size) ||
+				!read(reader, uniform.element_stride) || !read(reader, uniform.column_stride) || !read(reader, uniform.row_stride) ||
+				!read(reader, uniform.annotations) || !reader.read_count(value_count, 4))
+			{
+				return false;
+			}
+
+			uniform.initial_value.resize(value_count);
+
+			for (auto &value : uniform.initial_value)
+			{
+				if (!reader.read(value))
+				{
+					return false;
+				}
+			}
+		}
+
+		if (!reader.read_count(count, 36))
+		{
+			return false;
+		}
+
+		reflection.textures.resize(count);
+
+		for (auto &texture : reflection.textures)
+		{
+			if (!reader.read(texture.name) || !reader.read(texture.unique_name) || !reader.read(texture.semantic) ||
+				!reader.read(texture.width) || !reader.read(texture.height) || !reader.read(texture.levels) ||
+				!read(reader, texture.format) || !read(reader, texture.reference) || !read(reader, texture.annotations))
+			{
+				return false;
+			}
+		}
+
+		if (!reader.read_count(count, 48))
+		{
+			return false;
+		}
+
+		reflection.samplers.resize(count);
+
+		for (auto &sampler : reflection.samplers)
+		{
+			if (!reader.read(sampler.name) || !reader.read(sampler.unique_name) || !read(reader, sampler.texture) || !read(reader, sampler.srgb) ||
+				!read(reader, sampler.filter) || !read(reader, sampler.address_u) || !read(reader, sampler.address_v) || !read(reader, sampler.address_w) ||
+				!reader.read(sampler.min_lod) || !reader.read(sampler.max_lod) || !reader.read(sampler.lod_bias))
+			{
+				return false;
+			}
+
+			// A sampler always reads from one of the textures, the backends index the list with it
+			if (sampler.texture >= reflection.textures.size())
+			{
+				return false;
+			}
+		}
+
+		if (!reader.read_count(count, 12))
+		{
+			return false;
+		}
+
+		reflection.techniques.resize(count);
+
+		for (auto &technique : reflection.techniques)
+		{
+			uint32_t pass_count;
+
+			if (!reader.read(technique.name) || !read(reader, technique.annotations) || !reader.read_count(pass_count, 80))
+			{
+				return false;
+			}
+
+			technique.passes.resize(pass_count);
+
+			for (auto &pass : technique.passes)
+			{
+				if (!reader.read(pass.vertex_shader) || !reader.read(pass.pixel_shader) || !read(reader, pass.render_targets) || !read(reader, pass.samplers) ||
+					!read(reader, pass.srgb_write_enable) || !read(reader, pass.clear_render_targets) || !read(reader, pass.blend_enable) || !read(reader, pass.stencil_enable) ||
+					!read(reader, pass.color_write_mask) || !read(reader, pass.stencil_read_mask) || !read(reader, pass.stencil_write_mask) ||
+					!reader.read(pass.blend_op) || !reader.read(pass.blend_op_alpha) || !reader.read(pass.src_blend) || !reader.read(pass.dest_blend) ||
+					!reader.read(pass.stencil_comparison_func) || !reader.read(pass.stencil_reference_value) ||
+					!reader.read(pass.stencil_op_pass) || !reader.read(pass.stencil_op_fail) || !reader.read(pass.stencil_op_depth_fail))
+				{
+					return false;
+				}
+
+				for (const size_t target : pass.render_targets)
+				{
+					if (target >= reflection.textures.size() && target != pass_info::no_render_target)
+					{
+						return false;
+					}
+				}
+				for (const size_t sampler : pass.samplers)
+				{
+					if (sampler >= reflection.samplers.size())
+					{
+						return false;
+					}
+				}
+			}
+		}
+
+		return reader.at_end();
+	}
+}
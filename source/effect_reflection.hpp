@@ -0,0 +1,134 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cfloat>
+#include <cstdint>
+#include <unordered_map>
+#include "variant.hpp"
+#include "uniform_layout.hpp"
+#include "runtime_objects.hpp"
+
+namespace reshadefx
+{
+	#pragma region Forward Declarations
+	class syntax_tree;
+	#pragma endregion
+
+	struct uniform_info
+	{
+		std::string name, unique_name;
+		reshade::uniform_datatype basetype = reshade::uniform_datatype::floating_point;
+		unsigned int rows = 0, columns = 0, elements = 0;
+		/// <summary>
+		/// The offset of the variable from the start of the uniform block, following the layout rules the reflection was created with.
+		/// </summary>
+		size_t offset = 0;
+		/// <summary>
+		/// The size of the variable data in bytes, without any padding the layout rules insert.
+		/// </summary>
+		size_t size = 0;
+		/// <summary>
+		/// The distance in bytes between array elements, between matrix columns and between matrix rows in the uniform block, see <see cref="reshade::uniform_layout::member"/>.
+		/// </summary>
+		size_t element_stride = 0, column_stride = 0, row_stride = 0;
+		std::unordered_map<std::string, reshade::variant> annotations;
+		/// <summary>
+		/// The bit patterns of the initial value of every component, in the type of the variable. Zero if the variable has no literal initializer.
+		/// </summary>
+		std::vector<uint32_t> initial_value;
+	};
+	struct texture_info
+	{
+		std::string name, unique_name, semantic;
+		unsigned int width = 1, height = 1, levels = 1;
+		reshade::texture_format format = reshade::texture_format::rgba8;
+		/// <summary>
+		/// The surface the texture is bound to by its semantic, in which case it has no resource of its own.
+		/// </summary>
+		reshade::texture_reference reference = reshade::texture_reference::none;
+		std::unordered_map<std::string, reshade::variant> annotations;
+	};
+	struct sampler_info
+	{
+		std::string name, unique_name;
+		/// <summary>
+		/// The index of the sampled texture in <see cref="effect_reflection::textures"/>.
+		/// </summary>
+		size_t texture = 0;
+		bool srgb = false;
+		reshade::texture_filter filter = reshade::texture_filter::min_mag_mip_linear;
+		reshade::texture_address_mode address_u = reshade::texture_address_mode::clamp;
+		reshade::texture_address_mode address_v = reshade::texture_address_mode::clamp;
+		reshade::texture_address_mode address_w = reshade::texture_address_mode::clamp;
+		float min_lod = 0.0f, max_lod = FLT_MAX, lod_bias = 0.0f;
+	};
+	struct pass_info
+	{
+		std::string vertex_shader, pixel_shader;
+		/// <summary>
+		/// The indices of the textures the pass renders to, by render target slot. Slots in between that are not rendered to hold <see cref="no_render_target"/>. Empty if the pass renders to the back buffer.
+		/// </summary>
+		std::vector<size_t> render_targets;
+		/// <summary>
+		/// The indices of the samplers (and with them the textures) the entry points of the pass read from.
+		/// </summary>
+		std::vector<size_t> samplers;
+		bool srgb_write_enable = false, clear_render_targets = true;
+		/// <summary>
+		/// The blend and stencil states of the pass, with the values and defaults of <see cref="nodes::pass_declaration_node"/>.
+		/// </summary>
+		bool blend_enable = false, stencil_enable = false;
+		unsigned char color_write_mask = 0xF, stencil_read_mask = 0xFF, stencil_write_mask = 0xFF;
+		unsigned int blend_op = 1, blend_op_alpha = 1, src_blend = 1, dest_blend = 0;
+		unsigned int stencil_comparison_func = 8, stencil_reference_value = 0, stencil_op_pass = 1, stencil_op_fail = 1, stencil_op_depth_fail = 1;
+
+		static constexpr size_t no_render_target = SIZE_MAX;
+	};
+	struct technique_info
+	{
+		std::string name;
+		std::unordered_map<std::string, reshade::variant> annotations;
+		std::vector<pass_info> passes;
+	};
+
+	/// <summary>
+	/// Everything a backend needs to know about the resources of an effect, independent of the syntax tree it was created from. The entries are listed in declaration order.
+	/// </summary>
+	struct effect_reflection
+	{
+		/// <summary>
+		/// The size of the uniform block in bytes, padded according to the layout rules.
+		/// </summary>
+		size_t uniform_block_size = 0;
+		std::vector<uniform_info> uniforms;
+		std::vector<texture_info> textures;
+		std::vector<sampler_info> samplers;
+		std::vector<technique_info> techniques;
+	};
+
+	/// <summary>
+	/// Collect the reflection of an effect from its syntax tree.
+	/// </summary>
+	/// <param name="ast">The syntax tree of the effect.</param>
+	/// <param name="rules">The layout rules of the constant storage the backend uploads the uniform block to.</param>
+	effect_reflection reflect(const syntax_tree &ast, reshade::uniform_layout::rules rules);
+
+	/// <summary>
+	/// Write a reflection to its binary representation, so that it can be stored next to the code a backend generated from the same syntax tree.
+	/// </summary>
+	std::string serialize(const effect_reflection &reflection);
+	/// <summary>
+	/// Read a reflection from its binary representation. Every read is checked against the size of the data, so a truncated or corrupted reflection is rejected instead of read past its end.
+	/// </summary>
+	/// <param name="data">The binary representation of the reflection.</param>
+	/// <param name="size">The size of the data in bytes.</param>
+	/// <param name="reflection">Receives the reflection.</param>
+	/// <returns>Returns <c>true</c> if the reflection is valid, <c>false</c> otherwise.</returns>
+	bool deserialize(const uint8_t *data, size_t size, effect_reflection &reflection);
+}
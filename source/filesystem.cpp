@@ -6,6 +6,8 @@
 #include "filesystem.hpp"
 #include "unicode.hpp"
 
+#ifdef _WIN32
+
 #include <ShlObj.h>
 #include <Shlwapi.h>
 
@@ -106,10 +108,67 @@ namespace reshade::filesystem
 		return utf16_to_utf8(buffer);
 	}
 
+	mapped_file::mapped_file(const path &path)
+	{
+		const HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		LARGE_INTEGER size = { };
+
+		if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && static_cast<ULONGLONG>(size.QuadPart) <= SIZE_MAX)
+		{
+			const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+			if (mapping != nullptr)
+			{
+				_data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				_size = _data != nullptr ? static_cast<size_t>(size.QuadPart) : 0;
+
+				// The view keeps the mapping and the file open, so neither handle is needed anymore
+				CloseHandle(mapping);
+			}
+		}
+
+		CloseHandle(file);
+	}
+	mapped_file::~mapped_file()
+	{
+		if (_data != nullptr)
+		{
+			UnmapViewOfFile(_data);
+		}
+	}
+
 	bool exists(const path &path)
 	{
 		return GetFileAttributesW(path.wstring().c_str()) != INVALID_FILE_ATTRIBUTES;
 	}
+	bool file_stamp(const path &path, uint64_t &size, uint64_t &modified)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA info;
+
+		if (!GetFileAttributesExW(path.wstring().c_str(), GetFileExInfoStandard, &info))
+		{
+			return false;
+		}
+
+		size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+		modified = (static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+
+		return true;
+	}
+	bool create_directory(const path &path)
+	{
+		return CreateDirectoryW(path.wstring().c_str(), nullptr) != FALSE || GetLastError() == ERROR_ALREADY_EXISTS;
+	}
+	bool move_file(const path &source, const path &target)
+	{
+		return MoveFileExW(source.wstring().c_str(), target.wstring().c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+	}
 	path resolve(const path &filename, const std::vector<path> &paths)
 	{
 		for (const auto &path : paths)
@@ -211,3 +270,275 @@ namespace reshade::filesystem
 		return result;
 	}
 }
+
+#else
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Portable implementation used to build the effect compiler front end outside of Windows, which has no Special K configuration and no shell folders
+namespace reshade::filesystem
+{
+	bool path::operator==(const path &other) const
+	{
+		return _data == other._data;
+	}
+	bool path::operator!=(const path &other) const
+	{
+		return !operator==(other);
+	}
+
+	std::wstring path::wstring() const
+	{
+		return utf8_to_utf16(_data);
+	}
+
+	std::ostream &operator<<(std::ostream &stream, const path &path)
+	{
+		return stream << '\'' << path._data << '\'';
+	}
+
+	bool path::is_absolute() const
+	{
+		return !_data.empty() && _data[0] == '/';
+	}
+
+	path path::parent_path() const
+	{
+		const size_t pos = _data.find_last_of('/');
+
+		if (pos == std::string::npos)
+		{
+			return path();
+		}
+
+		return _data.substr(0, pos == 0 ? 1 : pos);
+	}
+	path path::filename() const
+	{
+		return _data.substr(_data.find_last_of('/') + 1);
+	}
+	path path::filename_without_extension() const
+	{
+		const std::string name = filename().string();
+
+		return name.substr(0, name.size() - path(name).extension().size());
+	}
+	std::string path::extension() const
+	{
+		const std::string name = filename().string();
+		const size_t pos = name.find_last_of('.');
+
+		return pos == std::string::npos || pos == 0 ? std::string() : name.substr(pos);
+	}
+
+	path &path::replace_extension(const std::string &extension)
+	{
+		_data.erase(_data.size() - this->extension().size());
+
+		if (!extension.empty() && extension[0] != '.')
+		{
+			_data += '.';
+		}
+
+		_data += extension;
+
+		return *this;
+	}
+
+	path path::operator/(const path &more) const
+	{
+		if (_data.empty() || more.is_absolute())
+		{
+			return more;
+		}
+
+		return _data.back() == '/' ? _data + more._data : _data + '/' + more._data;
+	}
+
+	mapped_file::mapped_file(const path &path)
+	{
+		const int file = open(path.string().c_str(), O_RDONLY);
+
+		if (file < 0)
+		{
+			return;
+		}
+
+		struct stat info;
+
+		if (fstat(file, &info) == 0 && info.st_size > 0)
+		{
+			void *const data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+			if (data != MAP_FAILED)
+			{
+				_data = static_cast<const uint8_t *>(data);
+				_size = static_cast<size_t>(info.st_size);
+			}
+		}
+
+		// The mapping stays valid after the descriptor is closed
+		close(file);
+	}
+	mapped_file::~mapped_file()
+	{
+		if (_data != nullptr)
+		{
+			munmap(const_cast<uint8_t *>(_data), _size);
+		}
+	}
+
+	bool exists(const path &path)
+	{
+		struct stat info;
+
+		return stat(path.string().c_str(), &info) == 0;
+	}
+	bool file_stamp(const path &path, uint64_t &size, uint64_t &modified)
+	{
+		struct stat info;
+
+		if (stat(path.string().c_str(), &info) != 0)
+		{
+			return false;
+		}
+
+		size = static_cast<uint64_t>(info.st_size);
+		modified = static_cast<uint64_t>(info.st_mtim.tv_sec) * 1000000000 + static_cast<uint64_t>(info.st_mtim.tv_nsec);
+
+		return true;
+	}
+	bool create_directory(const path &path)
+	{
+		return mkdir(path.string().c_str(), 0755) == 0 || errno == EEXIST;
+	}
+	bool move_file(const path &source, const path &target)
+	{
+		return std::rename(source.string().c_str(), target.string().c_str()) == 0;
+	}
+	path resolve(const path &filename, const std::vector<path> &paths)
+	{
+		for (const auto &path : paths)
+		{
+			auto result = absolute(filename, path);
+
+			if (exists(result))
+			{
+				return result;
+			}
+		}
+
+		return filename;
+	}
+	path absolute(const path &filename, const path &parent_path)
+	{
+		if (filename.is_absolute())
+		{
+			return filename;
+		}
+
+		return parent_path / filename;
+	}
+
+	path get_module_path(void *)
+	{
+		char result[4096] = { };
+
+		if (readlink("/proc/self/exe", result, sizeof(result) - 1) < 0)
+		{
+			return path();
+		}
+
+		return path(result);
+	}
+
+	path get_profile_path(void)
+	{
+		char result[4096] = { };
+
+		if (getcwd(result, sizeof(result)) == nullptr)
+		{
+			return path();
+		}
+
+		return path(result);
+	}
+
+	path get_special_folder_path(special_folder id)
+	{
+		switch (id)
+		{
+			case special_folder::app_data:
+				if (const char *const config_home = std::getenv("XDG_CONFIG_HOME"))
+				{
+					return config_home;
+				}
+				if (const char *const home = std::getenv("HOME"))
+				{
+					return path(home) / ".config";
+				}
+				break;
+			case special_folder::system:
+			case special_folder::windows:
+				break;
+		}
+
+		return path();
+	}
+
+	std::vector<path> list_files(const path &path, const std::string &mask, bool recursive)
+	{
+		DIR *const dir = opendir(path.string().c_str());
+
+		if (dir == nullptr)
+		{
+			return { };
+		}
+
+		std::vector<filesystem::path> result;
+
+		while (const dirent *const entry = readdir(dir))
+		{
+			const std::string filename = entry->d_name;
+
+			if (filename == "." || filename == "..")
+			{
+				continue;
+			}
+
+			struct stat info;
+
+			if (stat((path / filename).string().c_str(), &info) != 0)
+			{
+				continue;
+			}
+
+			if (S_ISDIR(info.st_mode))
+			{
+				if (recursive)
+				{
+					const auto recursive_result = list_files(path / filename, mask, true);
+					result.insert(result.end(), recursive_result.begin(), recursive_result.end());
+				}
+			}
+			else if (fnmatch(mask.c_str(), filename.c_str(), 0) == 0)
+			{
+				result.push_back(path / filename);
+			}
+		}
+
+		closedir(dir);
+
+		return result;
+	}
+}
+
+#endif
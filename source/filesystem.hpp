@@ -7,6 +7,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <ostream>
 
 namespace reshade::filesystem
@@ -31,6 +32,14 @@ namespace reshade::filesystem
 		std::string &string() { return _data; }
 		const std::string &string() const { return _data; }
 		std::wstring wstring() const;
+		/// <summary>
+		/// Returns the path in the representation the file APIs of the current platform expect, e.g. to open a stream with.
+		/// </summary>
+#ifdef _WIN32
+		std::wstring native() const { return wstring(); }
+#else
+		const std::string &native() const { return _data; }
+#endif
 
 		friend std::ostream &operator<<(std::ostream &stream, const path &path);
 
@@ -54,7 +63,44 @@ namespace reshade::filesystem
 		std::string _data;
 	};
 
+	/// <summary>
+	/// A read-only view of the contents of a file. The file is mapped into memory instead of being read, so only the pages that are actually accessed are loaded from disk.
+	/// </summary>
+	class mapped_file
+	{
+	public:
+		mapped_file() = default;
+		explicit mapped_file(const path &path);
+		~mapped_file();
+
+		mapped_file(const mapped_file &) = delete;
+		mapped_file &operator=(const mapped_file &) = delete;
+
+		/// <summary>
+		/// Returns a boolean indicating whether the file was mapped. Empty files cannot be mapped and are reported as not open.
+		/// </summary>
+		bool is_open() const { return _data != nullptr; }
+		const uint8_t *data() const { return _data; }
+		size_t size() const { return _size; }
+
+	private:
+		const uint8_t *_data = nullptr;
+		size_t _size = 0;
+	};
+
 	bool exists(const path &path);
+	/// <summary>
+	/// Get the size and the time of the last modification of a file. The time is only meaningful in comparison to other times returned by this function.
+	/// </summary>
+	bool file_stamp(const path &path, uint64_t &size, uint64_t &modified);
+	/// <summary>
+	/// Create a directory. Succeeds if it exists already, but does not create missing parent directories.
+	/// </summary>
+	bool create_directory(const path &path);
+	/// <summary>
+	/// Rename a file, replacing the target if it exists. The target is never left partially written, so this can be used to commit a file that was written under a temporary name.
+	/// </summary>
+	bool move_file(const path &source, const path &target);
 	path resolve(const path &filename, const std::vector<path> &paths);
 	path absolute(const path &filename, const path &parent_path);
 
@@ -0,0 +1,115 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "frame_budget_governor.hpp"
+
+namespace reshade
+{
+	void frame_budget_governor::set_settings(const settings &value)
+	{
+		_settings = value;
+
+		if (_settings.budget <= 0.0f)
+		{
+			reset();
+		}
+	}
+
+	bool frame_budget_governor::update(const std::vector<sample> &samples)
+	{
+		if (_settings.budget <= 0.0f)
+		{
+			return false;
+		}
+
+		std::unordered_map<std::string, state> states;
+
+		// Techniques the user disabled are forgotten, so that they start out resumed when they are enabled again
+		for (const auto &sample : samples)
+		{
+			auto &state = states[sample.name] = _states[sample.name];
+
+			if (sample.cost >= 0.0f && !state.suspended)
+			{
+				state.cost = sample.cost;
+			}
+		}
+
+		_states = std::move(states);
+
+		const sample *suspend_candidate = nullptr, *resume_candidate = nullptr;
+		_total_cost = 0.0f;
+
+		for (const auto &sample : samples)
+		{
+			const auto &state = _states[sample.name];
+
+			if (state.suspended)
+			{
+				// The most important suspended technique is resumed first, the one listed first wins on ties
+				if (resume_candidate == nullptr || sample.priority > resume_candidate->priority)
+				{
+					resume_candidate = &sample;
+				}
+			}
+			else
+			{
+				_total_cost += state.cost;
+
+				// The least important technique is suspended first, the most expensive one among those with the same priority
+				if (suspend_candidate == nullptr || sample.priority < suspend_candidate->priority || (sample.priority == suspend_candidate->priority && state.cost > _states[suspend_candidate->name].cost))
+				{
+					suspend_candidate = &sample;
+				}
+			}
+		}
+
+		if (_total_cost > _settings.budget)
+		{
+			_frames_under_budget = 0;
+
+			if (++_frames_over_budget >= _settings.frames_until_suspend && suspend_candidate != nullptr)
+			{
+				_frames_over_budget = 0;
+				_states[suspend_candidate->name].suspended = true;
+
+				return true;
+			}
+		}
+		else if (resume_candidate != nullptr && _total_cost + _states[resume_candidate->name].cost <= _settings.budget * _settings.resume_threshold)
+		{
+			_frames_over_budget = 0;
+
+			if (++_frames_under_budget >= _settings.frames_until_resume)
+			{
+				_frames_under_budget = 0;
+				_states[resume_candidate->name].suspended = false;
+
+				return true;
+			}
+		}
+		else
+		{
+			// Within the hysteresis band nothing changes
+			_frames_over_budget = _frames_under_budget = 0;
+		}
+
+		return false;
+	}
+
+	bool frame_budget_governor::is_suspended(const std::string &name) const
+	{
+		const auto it = _states.find(name);
+
+		return it != _states.end() && it->second.suspended;
+	}
+
+	void frame_budget_governor::reset()
+	{
+		_states.clear();
+		_total_cost = 0.0f;
+		_frames_over_budget = _frames_under_budget = 0;
+	}
+}
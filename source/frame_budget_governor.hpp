@@ -0,0 +1,92 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace reshade
+{
+	/// <summary>
+	/// Keeps the total cost of all enabled techniques below a budget by suspending the least important ones while the budget is exceeded and resuming them once there is room again.
+	/// This class only makes decisions from the timings it is fed and has no dependency on the runtime, so that its behavior can be simulated frame by frame.
+	/// </summary>
+	class frame_budget_governor
+	{
+	public:
+		struct settings
+		{
+			/// <summary>
+			/// The target cost of all techniques together in milliseconds. Zero disables the governor.
+			/// </summary>
+			float budget = 0.0f;
+			/// <summary>
+			/// A suspended technique is only resumed if the total stays below this fraction of the budget afterwards, so that it is not immediately suspended again.
+			/// </summary>
+			float resume_threshold = 0.85f;
+			/// <summary>
+			/// The number of consecutive frames the budget has to be exceeded before a technique is suspended.
+			/// </summary>
+			unsigned int frames_until_suspend = 10;
+			/// <summary>
+			/// The number of consecutive frames there has to be room before a technique is resumed.
+			/// </summary>
+			unsigned int frames_until_resume = 60;
+		};
+		struct sample
+		{
+			std::string name;
+			/// <summary>
+			/// Techniques with a lower priority are suspended first and resumed last.
+			/// </summary>
+			int priority = 0;
+			/// <summary>
+			/// The cost of the technique in the last frame in milliseconds, or a negative value if it was not measured (e.g. because it is suspended).
+			/// </summary>
+			float cost = -1.0f;
+		};
+
+		frame_budget_governor() = default;
+		explicit frame_budget_governor(const settings &value) : _settings(value) { }
+
+		const settings &get_settings() const { return _settings; }
+		void set_settings(const settings &value);
+
+		/// <summary>
+		/// Advance the governor by one frame.
+		/// </summary>
+		/// <param name="samples">All techniques the user enabled, including those that are currently suspended.</param>
+		/// <returns>Returns <c>true</c> if the set of suspended techniques changed.</returns>
+		bool update(const std::vector<sample> &samples);
+
+		/// <summary>
+		/// Returns a boolean indicating whether the technique with the specified name should be skipped.
+		/// </summary>
+		bool is_suspended(const std::string &name) const;
+		/// <summary>
+		/// Returns the estimated cost of all techniques that are not suspended in milliseconds, as of the last update.
+		/// </summary>
+		float total_cost() const { return _total_cost; }
+
+		/// <summary>
+		/// Resume all techniques and forget all measurements, e.g. after the effects were reloaded.
+		/// </summary>
+		void reset();
+
+	private:
+		struct state
+		{
+			float cost = 0.0f;
+			bool suspended = false;
+		};
+
+		settings _settings;
+		float _total_cost = 0.0f;
+		unsigned int _frames_over_budget = 0, _frames_under_budget = 0;
+		std::unordered_map<std::string, state> _states;
+	};
+}
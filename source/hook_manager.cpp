@@ -5,12 +5,16 @@
 
 #include "log.hpp"
 #include "hook_manager.hpp"
+#include "pe_exports.hpp"
+#include "module_name_filter.hpp"
 #include <assert.h>
 #include <mutex>
+#include <atomic>
 #include <algorithm>
 #include <vector>
 #include <unordered_map>
 #include <Windows.h>
+#include <winternl.h>
 
 #include "MinHook.h"
 
@@ -26,13 +30,6 @@ namespace reshade::hooks
 			function_hook,
 			vtable_hook
 		};
-		struct module_export
-		{
-			hook::address address;
-			const char *name;
-			unsigned short ordinal;
-		};
-
 		inline HMODULE load_module(const filesystem::path &path)
 		{
 			return LoadLibraryW(path.wstring().c_str());
@@ -46,37 +43,19 @@ namespace reshade::hooks
 		{
 			return GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_PIN, path.wstring().c_str(), &out_handle) && out_handle != nullptr;
 		}
-		std::vector<module_export> get_module_exports(HMODULE handle)
+		std::vector<pe::export_symbol> get_module_exports(HMODULE handle)
 		{
-			std::vector<module_export> exports;
+			std::vector<pe::export_symbol> exports;
 			const auto imagebase = reinterpret_cast<const BYTE *>(handle);
 			const auto imageheader = reinterpret_cast<const IMAGE_NT_HEADERS *>(imagebase + reinterpret_cast<const IMAGE_DOS_HEADER *>(imagebase)->e_lfanew);
 
-			if (imageheader->Signature != IMAGE_NT_SIGNATURE || imageheader->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].Size == 0)
+			if (imageheader->Signature != IMAGE_NT_SIGNATURE)
 			{
 				return exports;
 			}
 
-			const auto exportdir = reinterpret_cast<const IMAGE_EXPORT_DIRECTORY *>(imagebase + imageheader->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT].VirtualAddress);
-			const auto exportbase = static_cast<WORD>(exportdir->Base);
-
-			if (exportdir->NumberOfFunctions == 0)
-			{
-				return exports;
-			}
-
-			const auto count = static_cast<size_t>(exportdir->NumberOfNames);
-			exports.reserve(count);
-
-			for (size_t i = 0; i < count; i++)
-			{
-				module_export symbol;
-				symbol.ordinal = reinterpret_cast<const WORD *>(imagebase + exportdir->AddressOfNameOrdinals)[i] + exportbase;
-				symbol.name    = reinterpret_cast<const char *>(imagebase + reinterpret_cast<const DWORD *>(imagebase + exportdir->AddressOfNames)[i]);
-				symbol.address = const_cast<void *>(reinterpret_cast<const void *>(imagebase + reinterpret_cast<const DWORD *>(imagebase + exportdir->AddressOfFunctions)[symbol.ordinal - exportbase]));
-
-				exports.push_back(std::move(symbol));
-			}
+			// The loader mapped the whole image, so it can be parsed in place up to its size
+			pe::get_exports(imagebase, imageheader->OptionalHeader.SizeOfImage, pe::image_layout::mapped, exports);
 
 			return exports;
 		}
@@ -84,6 +63,13 @@ namespace reshade::hooks
 		filesystem::path s_export_hook_path;
 		std::vector<std::pair<hook, hook_method>> s_hooks; std::mutex s_mutex_hooks;
 		std::vector<filesystem::path> s_delayed_hook_paths; std::mutex s_mutex_delayed_hook_paths;
+		// Mirrors the base names in 's_delayed_hook_paths', so that loading an unrelated library does not have to take the lock
+		module_name_filter s_delayed_hook_names;
+		// Set by the loader notification when a module in 's_delayed_hook_names' was mapped, which includes modules loaded as a dependency of the library passed to 'LoadLibrary'
+		std::atomic<bool> s_delayed_hook_module_loaded(false);
+		// Without the loader notification a dependency cannot be detected by name, so every load has to check the delayed paths like before
+		std::atomic<bool> s_dll_notification_failed(false);
+		PVOID s_dll_notification_cookie = nullptr;
 		std::unordered_map<hook::address, hook::address *> s_vtable_addresses; std::mutex s_mutex_vtable_addresses;
 
 		bool install(hook::address target, hook::address replacement, hook_method method, std::string name)
@@ -220,47 +206,34 @@ namespace reshade::hooks
 
 			size_t install_count = 0;
 
-      struct hook_record_s {
-        std::string   name;
-        hook::address target;
-        hook::address replacement;
-      };
-
-			std::vector <hook_record_s> matches;
-			matches.reserve(replacement_exports.size());
+			struct hook_record
+			{
+				const char *name;
+				hook::address target;
+				hook::address replacement;
+			};
 
-			LOG(INFO) << "> Dumping matches in export table:";
-			LOG(INFO) << "  +--------------------+---------+----------------------------------------------------+";
-			LOG(INFO) << "  | Address            | Ordinal | Name                                               |";
-			LOG(INFO) << "  +--------------------+---------+----------------------------------------------------+";
+			std::vector<hook_record> matches;
+			const auto target_base = reinterpret_cast<BYTE *>(target_module);
+			const auto replacement_base = reinterpret_cast<BYTE *>(replacement_module);
 
-			// Analyze export table
-			for (const auto &symbol : target_exports)
+			// Both export tables are sorted by name, so they are matched in a single merge pass
+			for (const auto &match : pe::match_exports(target_exports, replacement_exports))
 			{
-				if (symbol.name == nullptr || symbol.address == nullptr)
+				const auto &symbol = target_exports[match.first];
+
+				// Filter uninteresting functions and forwarders, which do not point to code in the target module
+				if (symbol.rva == 0 || symbol.forwarded || replacement_exports[match.second].forwarded ||
+					std::strcmp(symbol.name, "DXGIReportAdapterConfiguration") == 0 ||
+					std::strcmp(symbol.name, "DXGIDumpJournal") == 0)
 				{
 					continue;
 				}
 
-				// Find appropriate replacement
-				const auto it = std::find_if(replacement_exports.cbegin(), replacement_exports.cend(),
-					[&symbol](const module_export &moduleexport) {
-						return std::strcmp(moduleexport.name, symbol.name) == 0;
-					});
-
-				// Filter uninteresting functions
-				if (it != replacement_exports.cend() &&
-					std::strcmp(symbol.name, "DXGIReportAdapterConfiguration") != 0 &&
-					std::strcmp(symbol.name, "DXGIDumpJournal") != 0)
-				{
-					LOG(INFO) << "  | 0x" << std::setw(16) << symbol.address << " | " << std::setw(7) << symbol.ordinal << " | " << std::setw(50) << symbol.name << " |";
-
-					matches.push_back({ symbol.name, symbol.address, it->address });
-				}
+				matches.push_back({ symbol.name, target_base + symbol.rva, replacement_base + replacement_exports[match.second].rva });
 			}
 
-			LOG(INFO) << "  +--------------------+---------+----------------------------------------------------+";
-			LOG(INFO) << "> Found " << matches.size() << " match(es). Installing ...";
+			LOG(INFO) << "> Found " << matches.size() << " match(es) in " << target_exports.size() << " export(s). Installing ...";
 
 			// Hook matching exports
 			for (const auto &match : matches)
@@ -351,13 +324,80 @@ namespace reshade::hooks
 			return reinterpret_cast<T>(find(reinterpret_cast<hook::address>(replacement)).call());
 		}
 
+		// The loader notification is not declared in the SDK headers, the data of the loaded and unloaded notifications share the same layout
+		struct dll_notification_data
+		{
+			ULONG Flags;
+			const UNICODE_STRING *FullDllName;
+			const UNICODE_STRING *BaseDllName;
+			PVOID DllBase;
+			ULONG SizeOfImage;
+		};
+
+		typedef VOID (CALLBACK *LdrDllNotification_pfn)(ULONG NotificationReason, const dll_notification_data *NotificationData, PVOID Context);
+		typedef NTSTATUS (NTAPI *LdrRegisterDllNotification_pfn)(ULONG Flags, LdrDllNotification_pfn NotificationFunction, PVOID Context, PVOID *Cookie);
+		typedef NTSTATUS (NTAPI *LdrUnregisterDllNotification_pfn)(PVOID Cookie);
+
+		VOID CALLBACK on_dll_notification(ULONG NotificationReason, const dll_notification_data *NotificationData, PVOID)
+		{
+			// This runs under the loader lock, so it only flags the load and leaves the hooking to the 'LoadLibrary' call that caused it
+			if (NotificationReason == 1 /* LDR_DLL_NOTIFICATION_REASON_LOADED */ && s_delayed_hook_names.contains(NotificationData->BaseDllName->Buffer, NotificationData->BaseDllName->Length / sizeof(WCHAR)))
+			{
+				s_delayed_hook_module_loaded.store(true, std::memory_order_release);
+			}
+		}
+		void register_dll_notification()
+		{
+			if (s_dll_notification_cookie != nullptr || s_dll_notification_failed.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			const auto register_notification = reinterpret_cast<LdrRegisterDllNotification_pfn>(GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "LdrRegisterDllNotification"));
+
+			if (register_notification == nullptr || register_notification(0, &on_dll_notification, nullptr, &s_dll_notification_cookie) != 0 /* STATUS_SUCCESS */)
+			{
+				LOG(WARNING) << "Failed to register loader notification. Delayed hooks are checked on every library load.";
+
+				s_dll_notification_cookie = nullptr;
+				s_dll_notification_failed.store(true, std::memory_order_release);
+			}
+		}
+		void unregister_dll_notification()
+		{
+			if (s_dll_notification_cookie == nullptr)
+			{
+				return;
+			}
+
+			const auto unregister_notification = reinterpret_cast<LdrUnregisterDllNotification_pfn>(GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "LdrUnregisterDllNotification"));
+
+			if (unregister_notification != nullptr)
+			{
+				unregister_notification(s_dll_notification_cookie);
+			}
+
+			s_dll_notification_cookie = nullptr;
+		}
+		template <typename T>
+		bool may_have_loaded_delayed_module(const T *lpFileName)
+		{
+			if (s_delayed_hook_names.contains(lpFileName) || s_dll_notification_failed.load(std::memory_order_acquire))
+			{
+				return true;
+			}
+
+			// A pending module was loaded as a dependency, the flag is only written when that happens, so the common case is a plain load
+			return s_delayed_hook_module_loaded.load(std::memory_order_acquire) && s_delayed_hook_module_loaded.exchange(false, std::memory_order_acq_rel);
+		}
+
 		HMODULE WINAPI HookLoadLibraryA(LPCSTR lpFileName)
 		{
 			static const auto trampoline = call_unchecked(&HookLoadLibraryA);
 
 			const HMODULE handle = trampoline(lpFileName);
 
-			if (handle == nullptr || handle == g_module_handle)
+			if (handle == nullptr || handle == g_module_handle || !may_have_loaded_delayed_module(lpFileName))
 			{
 				return handle;
 			}
@@ -374,7 +414,14 @@ namespace reshade::hooks
 
 					LOG(INFO) << "Installing delayed hooks for " << path << R"( (Just loaded via 'LoadLibraryA(")" << lpFileName << R"(")') ...)";
 
-					return install(delayed_handle, g_module_handle, hook_method::function_hook);
+					if (!install(delayed_handle, g_module_handle, hook_method::function_hook))
+					{
+						return false;
+					}
+
+					s_delayed_hook_names.erase(path.wstring());
+
+					return true;
 				});
 
 				s_delayed_hook_paths.erase(remove, s_delayed_hook_paths.end());
@@ -399,7 +446,7 @@ namespace reshade::hooks
 
 			const HMODULE handle = trampoline(lpFileName);
 
-			if (handle == nullptr || handle == g_module_handle)
+			if (handle == nullptr || handle == g_module_handle || !may_have_loaded_delayed_module(lpFileName))
 			{
 				return handle;
 			}
@@ -416,7 +463,14 @@ namespace reshade::hooks
 
 					LOG(INFO) << "Installing delayed hooks for " << path << R"( (Just loaded via 'LoadLibraryW(")" << lpFileName << R"(")') ...)";
 
-					return install(delayed_handle, g_module_handle, hook_method::function_hook);
+					if (!install(delayed_handle, g_module_handle, hook_method::function_hook))
+					{
+						return false;
+					}
+
+					s_delayed_hook_names.erase(path.wstring());
+
+					return true;
 				});
 
 				s_delayed_hook_paths.erase(remove, s_delayed_hook_paths.end());
@@ -517,6 +571,8 @@ namespace reshade::hooks
 		}
 
 		s_hooks.clear();
+
+		unregister_dll_notification();
 	}
 	void register_module(const filesystem::path &target_path)
 	{
@@ -550,7 +606,11 @@ namespace reshade::hooks
 			{
 				LOG(INFO) << "> Delayed.";
 
+				const std::lock_guard<std::mutex> lock(s_mutex_delayed_hook_paths);
 				s_delayed_hook_paths.push_back(target_path);
+				s_delayed_hook_names.insert(target_path.wstring());
+
+				register_dll_notification();
 			}
 		}
 	}
@@ -32,7 +32,7 @@ namespace reshade
 	void ini_file::load()
 	{
 		std::string line, section;
-		std::ifstream file(_path.wstring());
+		std::ifstream file(_path.native());
 
 		while (std::getline(file, line))
 		{
@@ -84,7 +84,10 @@ namespace reshade
 			return;
 		}
 
-		std::ofstream file(_path.wstring());
+		// Write to a temporary file first and replace the original with it at the end, so that a crash or a concurrent reader never sees a partially written file
+		const auto temporary_path = _path + ".tmp";
+
+		std::ofstream file(temporary_path.native());
 
 		const auto it = _sections.find("");
 
@@ -142,22 +145,29 @@ namespace reshade
 
 			file << std::endl;
 		}
+
+		file.close();
+
+		if (!file.fail())
+		{
+			filesystem::move_file(temporary_path, _path);
+		}
 	}
 
-	variant ini_file::get(const std::string &section, const std::string &key, const variant &default) const
+	variant ini_file::get(const std::string &section, const std::string &key, const variant &default_value) const
 	{
 		const auto it1 = _sections.find(section);
 
 		if (it1 == _sections.end())
 		{
-			return default;
+			return default_value;
 		}
 
 		const auto it2 = it1->second.find(key);
 
 		if (it2 == it1->second.end())
 		{
-			return default;
+			return default_value;
 		}
 
 		return it2->second;
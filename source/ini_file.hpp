@@ -17,7 +17,7 @@ namespace reshade
 		explicit ini_file(const filesystem::path &path);
 		~ini_file();
 
-		variant get(const std::string &section, const std::string &key, const variant &default = variant()) const;
+		variant get(const std::string &section, const std::string &key, const variant &default_value = variant()) const;
 		void set(const std::string &section, const std::string &key, const variant &value);
 
 	private:
@@ -4,7 +4,18 @@
  */
 
 #include "lexer.hpp"
-#include <unordered_map>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <initializer_list>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define RESHADEFX_LEXER_SSE2 1
+	#include <emmintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#endif
+#endif
 
 namespace reshadefx
 {
@@ -32,7 +43,122 @@ namespace reshadefx
 			IDENT, IDENT, IDENT, IDENT, IDENT, IDENT, IDENT, IDENT, IDENT, IDENT,
 			IDENT, IDENT, IDENT,   '{',   '|',   '}',   '~',  0x00,  0x00,  0x00,
 		};
-		const std::unordered_map<std::string, lexer::tokenid> keyword_lookup = {
+		/// <summary>
+		/// A static perfect hash over a fixed set of words (hash and displace), so that a lookup costs at most two hashes and a single string compare.
+		/// Words whose length does not occur in the set are rejected before any hashing is done.
+		/// </summary>
+		class keyword_table
+		{
+		public:
+			keyword_table(std::initializer_list<std::pair<const char *, lexer::tokenid>> words) : _length_mask(0)
+			{
+				size_t size = 1;
+				while (size < words.size())
+					size *= 2;
+
+				_slots.resize(size);
+				_displacements.resize(std::max(size / 4, size_t(1)));
+
+				// Group the words by their bucket in the first level
+				std::vector<std::vector<std::pair<const char *, lexer::tokenid>>> buckets(_displacements.size());
+
+				for (const auto &word : words)
+				{
+					const size_t length = std::strlen(word.first);
+
+					if (length < 32)
+						_length_mask |= 1u << length;
+
+					buckets[hash(word.first, length, 0) & (_displacements.size() - 1)].push_back(word);
+				}
+
+				std::vector<size_t> order(buckets.size());
+				for (size_t i = 0; i < order.size(); i++)
+					order[i] = i;
+
+				// Place the largest buckets first, while there are still many free slots to choose from
+				std::stable_sort(order.begin(), order.end(), [&buckets](size_t lhs, size_t rhs) { return buckets[lhs].size() > buckets[rhs].size(); });
+
+				std::vector<size_t> candidate_slots;
+
+				for (const size_t index : order)
+				{
+					const auto &bucket = buckets[index];
+
+					if (bucket.empty())
+						break;
+
+					for (unsigned int displacement = 1;; displacement++)
+					{
+						candidate_slots.clear();
+
+						for (const auto &word : bucket)
+						{
+							const size_t slot = hash(word.first, std::strlen(word.first), displacement) & (_slots.size() - 1);
+
+							if (_slots[slot].word != nullptr || std::find(candidate_slots.begin(), candidate_slots.end(), slot) != candidate_slots.end())
+								break;
+
+							candidate_slots.push_back(slot);
+						}
+
+						if (candidate_slots.size() != bucket.size())
+							continue;
+
+						for (size_t i = 0; i < bucket.size(); i++)
+						{
+							auto &slot = _slots[candidate_slots[i]];
+							slot.word = bucket[i].first;
+							slot.length = std::strlen(bucket[i].first);
+							slot.id = bucket[i].second;
+						}
+
+						_displacements[index] = displacement;
+						break;
+					}
+				}
+			}
+
+			bool find(const char *word, size_t length, lexer::tokenid &id) const
+			{
+				if (length >= 32 || (_length_mask & (1u << length)) == 0)
+					return false;
+
+				const auto &slot = _slots[hash(word, length, _displacements[hash(word, length, 0) & (_displacements.size() - 1)]) & (_slots.size() - 1)];
+
+				if (slot.length != length || std::memcmp(slot.word, word, length) != 0)
+					return false;
+
+				id = slot.id;
+
+				return true;
+			}
+
+		private:
+			struct slot
+			{
+				const char *word = nullptr;
+				size_t length = 0;
+				lexer::tokenid id = lexer::tokenid::unknown;
+			};
+
+			static size_t hash(const char *word, size_t length, unsigned int seed)
+			{
+				// FNV-1a, with the seed mixed into the offset basis
+				unsigned int value = 2166136261u ^ (seed * 16777619u);
+
+				for (size_t i = 0; i < length; i++)
+					value = (value ^ static_cast<unsigned char>(word[i])) * 16777619u;
+
+				return value ^ (value >> 15);
+			}
+
+			unsigned int _length_mask;
+			std::vector<slot> _slots;
+			std::vector<unsigned int> _displacements;
+		};
+
+		const keyword_table keyword_lookup = {
 			{ "asm", lexer::tokenid::reserved },
 			{ "asm_fragment", lexer::tokenid::reserved },
 			{ "auto", lexer::tokenid::reserved },
@@ -195,7 +321,7 @@ namespace reshadefx
 			{ "volatile", lexer::tokenid::volatile_ },
 			{ "while", lexer::tokenid::while_ }
 		};
-		const std::unordered_map<std::string, lexer::tokenid> pp_directive_lookup = {
+		const keyword_table pp_directive_lookup = {
 			{ "define", lexer::tokenid::hash_def },
 			{ "undef", lexer::tokenid::hash_undef },
 			{ "if", lexer::tokenid::hash_if },
@@ -256,6 +382,95 @@ namespace reshadefx
 
 			return n;
 		}
+
+#if RESHADEFX_LEXER_SSE2
+		inline unsigned int find_first_set(unsigned int mask)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return index;
+#else
+			return __builtin_ctz(mask);
+#endif
+		}
+
+		// Each of these returns a mask with one bit set for every byte in the 16 byte block that matches the class
+		inline unsigned int classify_space(__m128i block)
+		{
+			// Horizontal tab, vertical tab, form feed and carriage return, but not line feed, which is a token of its own
+			const __m128i control = _mm_andnot_si128(
+				_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')),
+				_mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('\t' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('\r' + 1))));
+
+			return _mm_movemask_epi8(_mm_or_si128(control, _mm_cmpeq_epi8(block, _mm_set1_epi8(' '))));
+		}
+		inline unsigned int classify_identifier(__m128i block)
+		{
+			// Setting bit 5 folds upper case letters onto lower case ones and moves no other character into the letter range
+			// Bytes above 0x7F compare as negative values and therefore never match, just like in the scalar lookup table
+			const __m128i folded = _mm_or_si128(block, _mm_set1_epi8(0x20));
+			const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1)));
+			const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+
+			return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), _mm_cmpeq_epi8(block, _mm_set1_epi8('_'))));
+		}
+		inline unsigned int classify_comment(__m128i block)
+		{
+			// Only these two characters are of interest inside a block comment: a possible end of the comment and a new line
+			return _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('*')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))));
+		}
+#endif
+
+		// Blocks are only loaded while they lie entirely inside the input, the remainder is handled by the scalar loops
+		inline const char *find_space_end(const char *it, const char *end)
+		{
+#if RESHADEFX_LEXER_SSE2
+			for (; end - it >= 16; it += 16)
+			{
+				const unsigned int mask = ~classify_space(_mm_loadu_si128(reinterpret_cast<const __m128i *>(it))) & 0xFFFF;
+
+				if (mask != 0)
+					return it + find_first_set(mask);
+			}
+#endif
+			while (it < end && type_lookup[static_cast<unsigned char>(*it)] == SPACE)
+				it++;
+
+			return it;
+		}
+		inline const char *find_identifier_end(const char *it, const char *end)
+		{
+#if RESHADEFX_LEXER_SSE2
+			for (; end - it >= 16; it += 16)
+			{
+				const unsigned int mask = ~classify_identifier(_mm_loadu_si128(reinterpret_cast<const __m128i *>(it))) & 0xFFFF;
+
+				if (mask != 0)
+					return it + find_first_set(mask);
+			}
+#endif
+			while (it < end && (type_lookup[static_cast<unsigned char>(*it)] == IDENT || type_lookup[static_cast<unsigned char>(*it)] == DIGIT))
+				it++;
+
+			return it;
+		}
+		inline const char *find_comment_character(const char *it, const char *end)
+		{
+#if RESHADEFX_LEXER_SSE2
+			for (; end - it >= 16; it += 16)
+			{
+				const unsigned int mask = classify_comment(_mm_loadu_si128(reinterpret_cast<const __m128i *>(it)));
+
+				if (mask != 0)
+					return it + find_first_set(mask);
+			}
+#endif
+			while (it < end && *it != '*' && *it != '\n')
+				it++;
+
+			return it;
+		}
 	}
 
 	lexer::lexer(const lexer &lexer) :
@@ -416,6 +631,13 @@ namespace reshadefx
 				{
 					while (_cur < _end)
 					{
+						skip(find_comment_character(_cur, _end) - _cur);
+
+						if (_cur == _end)
+						{
+							break;
+						}
+
 						if (*_cur == '\n')
 						{
 							_cur_location.line++;
@@ -539,24 +761,18 @@ namespace reshadefx
 	}
 	void lexer::skip_space()
 	{
-		while (type_lookup[*_cur] == SPACE && _cur < _end)
-		{
-			skip(1);
-		}
+		skip(find_space_end(_cur, _end) - _cur);
 	}
 	void lexer::skip_to_next_line()
 	{
-		while (*_cur != '\n' && _cur < _end)
-		{
-			skip(1);
-		}
+		const auto next_line = static_cast<const char *>(std::memchr(_cur, '\n', _end - _cur));
+
+		skip((next_line != nullptr ? next_line : _end) - _cur);
 	}
 
 	void lexer::parse_identifier(token &tok) const
 	{
-		auto *const begin = _cur, *end = begin;
-
-		do end++; while (type_lookup[*end] == IDENT || type_lookup[*end] == DIGIT);
+		auto *const begin = _cur, *const end = find_identifier_end(begin + 1, _end);
 
 		tok.id = tokenid::identifier;
 		tok.length = end - begin;
@@ -567,12 +783,7 @@ namespace reshadefx
 			return;
 		}
 
-		const auto it = keyword_lookup.find(tok.literal_as_string);
-
-		if (it != keyword_lookup.end())
-		{
-			tok.id = it->second;
-		}
+		keyword_lookup.find(begin, tok.length, tok.id);
 	}
 	bool lexer::parse_pp_directive(token &tok)
 	{
@@ -580,12 +791,8 @@ namespace reshadefx
 		skip_space();
 		parse_identifier(tok);
 
-		const auto it = pp_directive_lookup.find(tok.literal_as_string);
-
-		if (it != pp_directive_lookup.end())
+		if (pp_directive_lookup.find(tok.literal_as_string.data(), tok.literal_as_string.size(), tok.id))
 		{
-			tok.id = it->second;
-
 			return true;
 		}
 		else if (tok.literal_as_string == "line")
@@ -0,0 +1,80 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "module_name_filter.hpp"
+
+namespace reshade::hooks
+{
+	void module_name_filter::insert(const std::wstring &path)
+	{
+		const uint64_t hash = hash_base_name(path.c_str());
+
+		if (hash != 0)
+		{
+			for (auto &slot : _hashes)
+			{
+				if (slot.load(std::memory_order_relaxed) == 0)
+				{
+					slot.store(hash, std::memory_order_release);
+
+					return;
+				}
+			}
+		}
+
+		// There is no room left (or the name cannot be hashed), so fall back to matching everything
+		_overflow.store(true, std::memory_order_release);
+	}
+	void module_name_filter::erase(const std::wstring &path)
+	{
+		const uint64_t hash = hash_base_name(path.c_str());
+
+		if (hash == 0)
+		{
+			return;
+		}
+
+		// Slots are cleared in place instead of compacting the array, so that a concurrent query never misses a name that is moved
+		for (auto &slot : _hashes)
+		{
+			if (slot.load(std::memory_order_relaxed) == hash)
+			{
+				slot.store(0, std::memory_order_release);
+
+				return;
+			}
+		}
+	}
+
+	bool module_name_filter::contains(const char *path) const
+	{
+		return contains(hash_base_name(path));
+	}
+	bool module_name_filter::contains(const wchar_t *path) const
+	{
+		return contains(hash_base_name(path));
+	}
+	bool module_name_filter::contains(const wchar_t *path, size_t length) const
+	{
+		return contains(hash_base_name(path, length));
+	}
+	bool module_name_filter::contains(uint64_t hash) const
+	{
+		if (hash == 0 || _overflow.load(std::memory_order_acquire))
+		{
+			return true;
+		}
+
+		for (const auto &slot : _hashes)
+		{
+			if (slot.load(std::memory_order_acquire) == hash)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,108 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <type_traits>
+
+namespace reshade::hooks
+{
+	/// <summary>
+	/// A small set of module base names (without directory and extension, compared case-insensitively) that can be queried from any thread without taking a lock.
+	/// Modifications have to be serialized by the caller. A query that runs concurrently with a modification sees the name either before or after it, names that are not modified are always seen.
+	/// </summary>
+	class module_name_filter
+	{
+	public:
+		/// <summary>
+		/// The maximum number of names stored. Once exceeded, every query matches, so that no module is ever missed.
+		/// </summary>
+		static constexpr size_t capacity = 16;
+
+		/// <summary>
+		/// Add the base name of the specified path to the set.
+		/// </summary>
+		void insert(const std::wstring &path);
+		/// <summary>
+		/// Remove the base name of the specified path from the set (once, if it was added multiple times).
+		/// </summary>
+		void erase(const std::wstring &path);
+
+		/// <summary>
+		/// Returns a boolean indicating whether the base name of the specified path is in the set. Paths whose base name cannot be compared reliably (because it contains non-ASCII characters) always match.
+		/// </summary>
+		/// <param name="path">A path or module name as passed to <c>LoadLibrary</c>.</param>
+		bool contains(const char *path) const;
+		bool contains(const wchar_t *path) const;
+		/// <summary>
+		/// Returns a boolean indicating whether the base name of the specified path, which does not have to be null-terminated (e.g. a <c>UNICODE_STRING</c> the loader reports), is in the set.
+		/// </summary>
+		/// <param name="path">The path or module name.</param>
+		/// <param name="length">The length of the path in characters.</param>
+		bool contains(const wchar_t *path, size_t length) const;
+
+		/// <summary>
+		/// Hash the lower case base name of the specified path. Returns zero if the base name contains non-ASCII characters.
+		/// </summary>
+		template <typename T>
+		static uint64_t hash_base_name(const T *path) { return hash_base_name(path, std::char_traits<T>::length(path)); }
+		template <typename T>
+		static uint64_t hash_base_name(const T *path, size_t length);
+
+	private:
+		bool contains(uint64_t hash) const;
+
+		std::atomic<uint64_t> _hashes[capacity] = { };
+		std::atomic<bool> _overflow = { false };
+	};
+
+	template <typename T>
+	uint64_t module_name_filter::hash_base_name(const T *path, size_t length)
+	{
+		const T *begin = path, *end = path + length;
+
+		for (const T *it = path; it != end; ++it)
+		{
+			if (*it == T('\\') || *it == T('/') || *it == T(':'))
+			{
+				begin = it + 1;
+			}
+		}
+
+		// "d3d9", "d3d9.dll" and "D3D9.DLL" all name the same module, because LoadLibrary appends the default extension when there is none
+		for (const T *it = end; it > begin; --it)
+		{
+			if (it[-1] == T('.'))
+			{
+				end = it - 1;
+				break;
+			}
+		}
+
+		uint64_t hash = 14695981039346656037ull;
+
+		for (const T *it = begin; it != end; ++it)
+		{
+			auto c = static_cast<uint32_t>(static_cast<typename std::make_unsigned<T>::type>(*it));
+
+			if (c >= 0x80)
+			{
+				return 0;
+			}
+			if (c >= 'A' && c <= 'Z')
+			{
+				c += 'a' - 'A';
+			}
+
+			hash = (hash ^ c) * 1099511628211ull;
+		}
+
+		// Zero marks empty slots and names that cannot be compared
+		return hash != 0 ? hash : 1;
+	}
+}
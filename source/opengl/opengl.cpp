@@ -27,6 +27,7 @@
 #undef glCopyTexSubImage2D
 #undef glCopyTexSubImage3D
 #undef glCullFace
+#undef glDeleteRenderbuffers
 #undef glDeleteTextures
 #undef glDepthFunc
 #undef glDepthMask
@@ -116,6 +117,9 @@ static std::unordered_map<HWND, RECT> s_window_rects;
 static std::unordered_set<HDC> s_pbuffer_device_contexts;
 static std::unordered_map<HGLRC, HGLRC> s_shared_contexts;
 static std::unordered_map<HDC, std::shared_ptr<reshade::opengl::opengl_runtime>> s_runtimes;
+// Runtime of the device context that is current on the calling thread, so that per-draw hooks neither query the device context nor probe 's_runtimes'
+// Kept up to date by 'wglMakeCurrent', which also keeps the runtime alive as long as it is current on any thread
+static thread_local reshade::opengl::opengl_runtime *t_current_runtime = nullptr;
 
 // GL
 HOOK_EXPORT void WINAPI glAccum(GLenum op, GLfloat value)
@@ -146,11 +150,9 @@ HOOK_EXPORT void WINAPI glBegin(GLenum mode)
 {
 	static const auto trampoline = reshade::hooks::call(&glBegin);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count = 0;
+		t_current_runtime->_current_vertex_count = 0;
 	}
 
 	trampoline(mode);
@@ -479,10 +481,26 @@ HOOK_EXPORT void WINAPI glDeleteLists(GLuint list, GLsizei range)
 
 	trampoline(list, range);
 }
+void WINAPI glDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers)
+{
+	static const auto trampoline = reshade::hooks::call(&glDeleteRenderbuffers);
+
+	if (t_current_runtime != nullptr)
+	{
+		t_current_runtime->on_delete_objects(GL_RENDERBUFFER, n, renderbuffers);
+	}
+
+	trampoline(n, renderbuffers);
+}
 HOOK_EXPORT void WINAPI glDeleteTextures(GLsizei n, const GLuint *textures)
 {
 	static const auto trampoline = reshade::hooks::call(&glDeleteTextures);
 
+	if (t_current_runtime != nullptr)
+	{
+		t_current_runtime->on_delete_objects(GL_TEXTURE, n, textures);
+	}
+
 	trampoline(n, textures);
 }
 HOOK_EXPORT void WINAPI glDepthFunc(GLenum func)
@@ -519,11 +537,9 @@ HOOK_EXPORT void WINAPI glDrawArrays(GLenum mode, GLint first, GLsizei count)
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawArrays);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(count);
+		t_current_runtime->on_draw_call(count);
 	}
 
 	trampoline(mode, first, count);
@@ -538,11 +554,9 @@ void WINAPI glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsiz
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawArraysInstanced);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		t_current_runtime->on_draw_call(primcount * count);
 	}
 
 	trampoline(mode, first, count, primcount);
@@ -551,11 +565,9 @@ void WINAPI glDrawArraysInstancedARB(GLenum mode, GLint first, GLsizei count, GL
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawArraysInstancedARB);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		t_current_runtime->on_draw_call(primcount * count);
 	}
 
 	trampoline(mode, first, count, primcount);
@@ -564,11 +576,9 @@ void WINAPI glDrawArraysInstancedEXT(GLenum mode, GLint first, GLsizei count, GL
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawArraysInstancedEXT);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		t_current_runtime->on_draw_call(primcount * count);
 	}
 
 	trampoline(mode, first, count, primcount);
@@ -577,11 +587,9 @@ void WINAPI glDrawArraysInstancedBaseInstance(GLenum mode, GLint first, GLsizei
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawArraysInstancedBaseInstance);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		t_current_runtime->on_draw_call(primcount * count);
 	}
 
 	trampoline(mode, first, count, primcount, baseinstance);
@@ -596,11 +604,9 @@ HOOK_EXPORT void WINAPI glDrawElements(GLenum mode, GLsizei count, GLenum type,
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawElements);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(count);
+		t_current_runtime->on_draw_call(count);
 	}
 
 	trampoline(mode, count, type, indices);
@@ -609,11 +615,9 @@ void WINAPI glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, co
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsBaseVertex);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(count);
+		t_current_runtime->on_draw_call(count);
 	}
 
 	trampoline(mode, count, type, indices, basevertex);
@@ -628,11 +632,9 @@ void WINAPI glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, con
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstanced);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		t_current_runtime->on_draw_call(primcount * count);
 	}
 
 	trampoline(mode, count, type, indices, primcount);
@@ -641,11 +643,9 @@ void WINAPI glDrawElementsInstancedARB(GLenum mode, GLsizei count, GLenum type,
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstancedARB);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		t_current_runtime->on_draw_call(primcount * count);
 	}
 
 	trampoline(mode, count, type, indices, primcount);
@@ -654,11 +654,9 @@ void WINAPI glDrawElementsInstancedEXT(GLenum mode, GLsizei count, GLenum type,
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstancedEXT);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		t_current_runtime->on_draw_call(primcount * count);
 	}
 
 	trampoline(mode, count, type, indices, primcount);
@@ -667,11 +665,9 @@ void WINAPI glDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstancedBaseVertex);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		t_current_runtime->on_draw_call(primcount * count);
 	}
 
 	trampoline(mode, count, type, indices, primcount, basevertex);
@@ -680,11 +676,9 @@ void WINAPI glDrawElementsInstancedBaseInstance(GLenum mode, GLsizei count, GLen
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstancedBaseInstance);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		t_current_runtime->on_draw_call(primcount * count);
 	}
 
 	trampoline(mode, count, type, indices, primcount, baseinstance);
@@ -693,11 +687,9 @@ void WINAPI glDrawElementsInstancedBaseVertexBaseInstance(GLenum mode, GLsizei c
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawElementsInstancedBaseVertexBaseInstance);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(primcount * count);
+		t_current_runtime->on_draw_call(primcount * count);
 	}
 
 	trampoline(mode, count, type, indices, primcount, basevertex, baseinstance);
@@ -712,11 +704,9 @@ void WINAPI glDrawRangeElements(GLenum mode, GLuint start, GLuint end, GLsizei c
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawRangeElements);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(count);
+		t_current_runtime->on_draw_call(count);
 	}
 
 	trampoline(mode, start, end, count, type, indices);
@@ -725,11 +715,9 @@ void WINAPI glDrawRangeElementsBaseVertex(GLenum mode, GLuint start, GLuint end,
 {
 	static const auto trampoline = reshade::hooks::call(&glDrawRangeElementsBaseVertex);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(count);
+		t_current_runtime->on_draw_call(count);
 	}
 
 	trampoline(mode, start, end, count, type, indices, basevertex);
@@ -770,11 +758,9 @@ HOOK_EXPORT void WINAPI glEnd()
 
 	trampoline();
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_draw_call(it->second->_current_vertex_count);
+		t_current_runtime->on_draw_call(t_current_runtime->_current_vertex_count);
 	}
 }
 HOOK_EXPORT void WINAPI glEndList()
@@ -903,11 +889,9 @@ void WINAPI glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum r
 
 	trampoline(target, attachment, renderbuffertarget, renderbuffer);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, renderbuffertarget, renderbuffer, 0);
+		t_current_runtime->on_fbo_attachment(target, attachment, renderbuffertarget, renderbuffer, 0);
 	}
 }
 void WINAPI glFramebufferRenderbufferEXT(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
@@ -916,11 +900,9 @@ void WINAPI glFramebufferRenderbufferEXT(GLenum target, GLenum attachment, GLenu
 
 	trampoline(target, attachment, renderbuffertarget, renderbuffer);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, renderbuffertarget, renderbuffer, 0);
+		t_current_runtime->on_fbo_attachment(target, attachment, renderbuffertarget, renderbuffer, 0);
 	}
 }
 void WINAPI glFramebufferTexture(GLenum target, GLenum attachment, GLuint texture, GLint level)
@@ -929,11 +911,9 @@ void WINAPI glFramebufferTexture(GLenum target, GLenum attachment, GLuint textur
 
 	trampoline(target, attachment, texture, level);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 void WINAPI glFramebufferTextureARB(GLenum target, GLenum attachment, GLuint texture, GLint level)
@@ -942,11 +922,9 @@ void WINAPI glFramebufferTextureARB(GLenum target, GLenum attachment, GLuint tex
 
 	trampoline(target, attachment, texture, level);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 void WINAPI glFramebufferTextureEXT(GLenum target, GLenum attachment, GLuint texture, GLint level)
@@ -955,11 +933,9 @@ void WINAPI glFramebufferTextureEXT(GLenum target, GLenum attachment, GLuint tex
 
 	trampoline(target, attachment, texture, level);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 void WINAPI glFramebufferTexture1D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
@@ -968,11 +944,9 @@ void WINAPI glFramebufferTexture1D(GLenum target, GLenum attachment, GLenum text
 
 	trampoline(target, attachment, textarget, texture, level);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 void WINAPI glFramebufferTexture1DEXT(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
@@ -981,11 +955,9 @@ void WINAPI glFramebufferTexture1DEXT(GLenum target, GLenum attachment, GLenum t
 
 	trampoline(target, attachment, textarget, texture, level);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 void WINAPI glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
@@ -994,11 +966,9 @@ void WINAPI glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum text
 
 	trampoline(target, attachment, textarget, texture, level);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 void WINAPI glFramebufferTexture2DEXT(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
@@ -1007,11 +977,9 @@ void WINAPI glFramebufferTexture2DEXT(GLenum target, GLenum attachment, GLenum t
 
 	trampoline(target, attachment, textarget, texture, level);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 void WINAPI glFramebufferTexture3D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level, GLint zoffset)
@@ -1020,11 +988,9 @@ void WINAPI glFramebufferTexture3D(GLenum target, GLenum attachment, GLenum text
 
 	trampoline(target, attachment, textarget, texture, level, zoffset);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 void WINAPI glFramebufferTexture3DEXT(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level, GLint zoffset)
@@ -1033,11 +999,9 @@ void WINAPI glFramebufferTexture3DEXT(GLenum target, GLenum attachment, GLenum t
 
 	trampoline(target, attachment, textarget, texture, level, zoffset);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, textarget, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, textarget, texture, level);
 	}
 }
 void WINAPI glFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer)
@@ -1046,11 +1010,9 @@ void WINAPI glFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint t
 
 	trampoline(target, attachment, texture, level, layer);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 void WINAPI glFramebufferTextureLayerARB(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer)
@@ -1059,11 +1021,9 @@ void WINAPI glFramebufferTextureLayerARB(GLenum target, GLenum attachment, GLuin
 
 	trampoline(target, attachment, texture, level, layer);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 void WINAPI glFramebufferTextureLayerEXT(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer)
@@ -1072,11 +1032,9 @@ void WINAPI glFramebufferTextureLayerEXT(GLenum target, GLenum attachment, GLuin
 
 	trampoline(target, attachment, texture, level, layer);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
+		t_current_runtime->on_fbo_attachment(target, attachment, GL_TEXTURE, texture, level);
 	}
 }
 HOOK_EXPORT void WINAPI glFrontFace(GLenum mode)
@@ -1575,9 +1533,7 @@ void WINAPI glMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *co
 {
 	static const auto trampoline = reshade::hooks::call(&glMultiDrawArrays);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
 		GLsizei totalcount = 0;
 
@@ -1586,7 +1542,7 @@ void WINAPI glMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *co
 			totalcount += count[i];
 		}
 
-		it->second->on_draw_call(totalcount);
+		t_current_runtime->on_draw_call(totalcount);
 	}
 
 	trampoline(mode, first, count, drawcount);
@@ -1601,9 +1557,7 @@ void WINAPI glMultiDrawElements(GLenum mode, const GLsizei *count, GLenum type,
 {
 	static const auto trampoline = reshade::hooks::call(&glMultiDrawElements);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
 		GLsizei totalcount = 0;
 
@@ -1612,7 +1566,7 @@ void WINAPI glMultiDrawElements(GLenum mode, const GLsizei *count, GLenum type,
 			totalcount += count[i];
 		}
 
-		it->second->on_draw_call(totalcount);
+		t_current_runtime->on_draw_call(totalcount);
 	}
 
 	trampoline(mode, count, type, indices, drawcount);
@@ -1621,9 +1575,7 @@ void WINAPI glMultiDrawElementsBaseVertex(GLenum mode, const GLsizei *count, GLe
 {
 	static const auto trampoline = reshade::hooks::call(&glMultiDrawElementsBaseVertex);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
 		GLsizei totalcount = 0;
 
@@ -1632,7 +1584,7 @@ void WINAPI glMultiDrawElementsBaseVertex(GLenum mode, const GLsizei *count, GLe
 			totalcount += count[i];
 		}
 
-		it->second->on_draw_call(totalcount);
+		t_current_runtime->on_draw_call(totalcount);
 	}
 
 	trampoline(mode, count, type, indices, drawcount, basevertex);
@@ -2517,11 +2469,9 @@ HOOK_EXPORT void WINAPI glVertex2d(GLdouble x, GLdouble y)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex2d);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		t_current_runtime->_current_vertex_count += 2;
 	}
 
 	trampoline(x, y);
@@ -2530,11 +2480,9 @@ HOOK_EXPORT void WINAPI glVertex2dv(const GLdouble *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex2dv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		t_current_runtime->_current_vertex_count += 2;
 	}
 
 	trampoline(v);
@@ -2543,11 +2491,9 @@ HOOK_EXPORT void WINAPI glVertex2f(GLfloat x, GLfloat y)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex2f);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		t_current_runtime->_current_vertex_count += 2;
 	}
 
 	trampoline(x, y);
@@ -2556,11 +2502,9 @@ HOOK_EXPORT void WINAPI glVertex2fv(const GLfloat *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex2fv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		t_current_runtime->_current_vertex_count += 2;
 	}
 
 	trampoline(v);
@@ -2569,11 +2513,9 @@ HOOK_EXPORT void WINAPI glVertex2i(GLint x, GLint y)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex2i);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		t_current_runtime->_current_vertex_count += 2;
 	}
 
 	trampoline(x, y);
@@ -2582,11 +2524,9 @@ HOOK_EXPORT void WINAPI glVertex2iv(const GLint *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex2iv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		t_current_runtime->_current_vertex_count += 2;
 	}
 
 	trampoline(v);
@@ -2595,11 +2535,9 @@ HOOK_EXPORT void WINAPI glVertex2s(GLshort x, GLshort y)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex2s);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		t_current_runtime->_current_vertex_count += 2;
 	}
 
 	trampoline(x, y);
@@ -2608,11 +2546,9 @@ HOOK_EXPORT void WINAPI glVertex2sv(const GLshort *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex2sv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 2;
+		t_current_runtime->_current_vertex_count += 2;
 	}
 
 	trampoline(v);
@@ -2621,11 +2557,9 @@ HOOK_EXPORT void WINAPI glVertex3d(GLdouble x, GLdouble y, GLdouble z)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex3d);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		t_current_runtime->_current_vertex_count += 3;
 	}
 
 	trampoline(x, y, z);
@@ -2634,11 +2568,9 @@ HOOK_EXPORT void WINAPI glVertex3dv(const GLdouble *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex3dv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		t_current_runtime->_current_vertex_count += 3;
 	}
 
 	trampoline(v);
@@ -2647,11 +2579,9 @@ HOOK_EXPORT void WINAPI glVertex3f(GLfloat x, GLfloat y, GLfloat z)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex3f);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		t_current_runtime->_current_vertex_count += 3;
 	}
 
 	trampoline(x, y, z);
@@ -2660,11 +2590,9 @@ HOOK_EXPORT void WINAPI glVertex3fv(const GLfloat *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex3fv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		t_current_runtime->_current_vertex_count += 3;
 	}
 
 	trampoline(v);
@@ -2673,11 +2601,9 @@ HOOK_EXPORT void WINAPI glVertex3i(GLint x, GLint y, GLint z)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex3i);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		t_current_runtime->_current_vertex_count += 3;
 	}
 
 	trampoline(x, y, z);
@@ -2686,11 +2612,9 @@ HOOK_EXPORT void WINAPI glVertex3iv(const GLint *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex3iv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		t_current_runtime->_current_vertex_count += 3;
 	}
 
 	trampoline(v);
@@ -2699,11 +2623,9 @@ HOOK_EXPORT void WINAPI glVertex3s(GLshort x, GLshort y, GLshort z)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex3s);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		t_current_runtime->_current_vertex_count += 3;
 	}
 
 	trampoline(x, y, z);
@@ -2712,11 +2634,9 @@ HOOK_EXPORT void WINAPI glVertex3sv(const GLshort *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex3sv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 3;
+		t_current_runtime->_current_vertex_count += 3;
 	}
 
 	trampoline(v);
@@ -2725,11 +2645,9 @@ HOOK_EXPORT void WINAPI glVertex4d(GLdouble x, GLdouble y, GLdouble z, GLdouble
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex4d);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		t_current_runtime->_current_vertex_count += 4;
 	}
 
 	trampoline(x, y, z, w);
@@ -2738,11 +2656,9 @@ HOOK_EXPORT void WINAPI glVertex4dv(const GLdouble *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex4dv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		t_current_runtime->_current_vertex_count += 4;
 	}
 
 	trampoline(v);
@@ -2751,11 +2667,9 @@ HOOK_EXPORT void WINAPI glVertex4f(GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex4f);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		t_current_runtime->_current_vertex_count += 4;
 	}
 
 	trampoline(x, y, z, w);
@@ -2764,11 +2678,9 @@ HOOK_EXPORT void WINAPI glVertex4fv(const GLfloat *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex4fv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		t_current_runtime->_current_vertex_count += 4;
 	}
 
 	trampoline(v);
@@ -2777,11 +2689,9 @@ HOOK_EXPORT void WINAPI glVertex4i(GLint x, GLint y, GLint z, GLint w)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex4i);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		t_current_runtime->_current_vertex_count += 4;
 	}
 
 	trampoline(x, y, z, w);
@@ -2790,11 +2700,9 @@ HOOK_EXPORT void WINAPI glVertex4iv(const GLint *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex4iv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		t_current_runtime->_current_vertex_count += 4;
 	}
 
 	trampoline(v);
@@ -2803,11 +2711,9 @@ HOOK_EXPORT void WINAPI glVertex4s(GLshort x, GLshort y, GLshort z, GLshort w)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex4s);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		t_current_runtime->_current_vertex_count += 4;
 	}
 
 	trampoline(x, y, z, w);
@@ -2816,11 +2722,9 @@ HOOK_EXPORT void WINAPI glVertex4sv(const GLshort *v)
 {
 	static const auto trampoline = reshade::hooks::call(&glVertex4sv);
 
-	const auto it = s_runtimes.find(wglGetCurrentDC());
-
-	if (it != s_runtimes.end())
+	if (t_current_runtime != nullptr)
 	{
-		it->second->_current_vertex_count += 4;
+		t_current_runtime->_current_vertex_count += 4;
 	}
 
 	trampoline(v);
@@ -3455,6 +3359,8 @@ HOOK_EXPORT BOOL WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 
   if (hdc == 0 && hglrc == 0)
   {
+    t_current_runtime = nullptr;
+
     return trampoline (hdc, hglrc);
   }
 
@@ -3472,7 +3378,9 @@ HOOK_EXPORT BOOL WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 	const std::lock_guard<std::mutex> lock(s_mutex);
 
 	const bool is_pbuffer_device_context = s_pbuffer_device_contexts.find(hdc) != s_pbuffer_device_contexts.end();
-	
+
+	t_current_runtime = nullptr;
+
 	if (hdc_previous != nullptr)
 	{
 		const auto it = s_runtimes.find(hdc_previous);
@@ -3505,6 +3413,8 @@ HOOK_EXPORT BOOL WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 	{
 		it->second->_reference_count++;
 
+		t_current_runtime = it->second.get();
+
 		LOG(INFO) << "> Switched to existing runtime " << it->second << ".";
 	}
 	else
@@ -3544,6 +3454,7 @@ HOOK_EXPORT BOOL WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 		gl3wCopyTexSubImage1D                           = reshade::hooks::call(&glCopyTexSubImage1D);
 		gl3wCopyTexSubImage2D                           = reshade::hooks::call(&glCopyTexSubImage2D);
 		gl3wCullFace                                    = reshade::hooks::call(&glCullFace);
+		gl3wDeleteRenderbuffers                         = reshade::hooks::call(&glDeleteRenderbuffers);
 		gl3wDeleteTextures                              = reshade::hooks::call(&glDeleteTextures);
 		gl3wDepthFunc                                   = reshade::hooks::call(&glDepthFunc);
 		gl3wDepthMask                                   = reshade::hooks::call(&glDepthMask);
@@ -3624,6 +3535,8 @@ HOOK_EXPORT BOOL WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 
 			s_runtimes[hdc] = runtime;
 
+			t_current_runtime = runtime.get();
+
 			LOG(INFO) << "> Switched to new runtime " << runtime << ".";
 		}
 		else
@@ -3696,32 +3609,49 @@ HOOK_EXPORT BOOL WINAPI wglSwapBuffers(HDC hdc)
 {
 	static const auto trampoline = reshade::hooks::call(&wglSwapBuffers);
 
-	const auto it = s_runtimes.find(hdc);
 	const HWND hwnd = WindowFromDC(hdc);
 
-	if (hwnd != nullptr && it != s_runtimes.end())
+	std::shared_ptr<reshade::opengl::opengl_runtime> runtime;
+	RECT rect_previous = { };
+
+	if (hwnd != nullptr)
+	{
+		// Copy what is needed out of the shared tables, so that the lock is not held while presenting
+		const std::lock_guard<std::mutex> lock(s_mutex);
+
+		const auto it = s_runtimes.find(hdc);
+
+		if (it != s_runtimes.end())
+		{
+			runtime = it->second;
+			rect_previous = s_window_rects.at(hwnd);
+		}
+	}
+
+	if (runtime != nullptr)
 	{
-		assert(it->second != nullptr);
 		assert(hdc == wglGetCurrentDC());
 
-		RECT rect, &rectPrevious = s_window_rects.at(hwnd);
+		RECT rect;
 		GetClientRect(hwnd, &rect);
 
-		if (rect.right != rectPrevious.right || rect.bottom != rectPrevious.bottom)
+		if (rect.right != rect_previous.right || rect.bottom != rect_previous.bottom)
 		{
-			LOG(INFO) << "Resizing runtime " << it->second << " on device context " << hdc << " to " << rect.right << "x" << rect.bottom << " ...";
+			LOG(INFO) << "Resizing runtime " << runtime << " on device context " << hdc << " to " << rect.right << "x" << rect.bottom << " ...";
 
-			it->second->on_reset();
+			runtime->on_reset();
 
-			if (!(rect.right == 0 && rect.bottom == 0) && !it->second->on_init(static_cast<unsigned int>(rect.right), static_cast<unsigned int>(rect.bottom)))
+			if (!(rect.right == 0 && rect.bottom == 0) && !runtime->on_init(static_cast<unsigned int>(rect.right), static_cast<unsigned int>(rect.bottom)))
 			{
-				LOG(ERROR) << "Failed to recreate OpenGL runtime environment on runtime " << it->second.get() << ".";
+				LOG(ERROR) << "Failed to recreate OpenGL runtime environment on runtime " << runtime.get() << ".";
 			}
 
-			rectPrevious = rect;
+			const std::lock_guard<std::mutex> lock(s_mutex);
+
+			s_window_rects[hwnd] = rect;
 		}
 
-		it->second->on_present();
+		runtime->on_present();
 	}
 
 	return trampoline(hdc);
@@ -3819,6 +3749,7 @@ HOOK_EXPORT PROC WINAPI wglGetProcAddress(LPCSTR lpszProc)
     //
 
 
+		reshade::hooks::queue(reinterpret_cast<reshade::hook::address>(trampoline("glDeleteRenderbuffers")),                         reinterpret_cast<reshade::hook::address>(&glDeleteRenderbuffers),                                       "glDeleteRenderbuffers");
 		reshade::hooks::queue(reinterpret_cast<reshade::hook::address>(trampoline("glDrawArraysIndirect")),                          reinterpret_cast<reshade::hook::address>(&glDrawArraysIndirect),                                         "glDrawArraysIndirect");
 		reshade::hooks::queue(reinterpret_cast<reshade::hook::address>(trampoline("glDrawArraysInstanced")),                         reinterpret_cast<reshade::hook::address>(&glDrawArraysInstanced),                                        "glDrawArraysInstanced");
 		reshade::hooks::queue(reinterpret_cast<reshade::hook::address>(trampoline("glDrawArraysInstancedEXT")),                      reinterpret_cast<reshade::hook::address>(&glDrawArraysInstancedEXT),                                     "glDrawArraysInstancedEXT");
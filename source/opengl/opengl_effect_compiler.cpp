@@ -5,6 +5,8 @@
 
 #include "opengl_runtime.hpp"
 #include "opengl_effect_compiler.hpp"
+#include "optimizer.hpp"
+#include "log.hpp"
 #include <assert.h>
 #include <iomanip>
 #include <algorithm>
@@ -352,12 +354,6 @@ namespace reshade::opengl
 
 		return code;
 	}
-	static inline uintptr_t align(uintptr_t address, size_t alignment)
-	{
-		if (address % alignment != 0)
-			address += alignment - address % alignment;
-		return address;
-	}
 
 	opengl_effect_compiler::opengl_effect_compiler(opengl_runtime *runtime, const syntax_tree &ast, std::string &errors) :
 		_runtime(runtime),
@@ -370,11 +366,19 @@ namespace reshade::opengl
 
 	bool opengl_effect_compiler::run()
 	{
-		_uniform_storage_offset = _runtime->get_uniform_value_storage().size();
+		// The reflection lays out all uniforms up front, so that the storage for them is allocated in one go
+		_reflection = reshadefx::reflect(_ast, uniform_layout::rules::std140);
+
+		_uniform_buffer_size = _reflection.uniform_block_size;
+		_uniform_storage_offset = _runtime->allocate_uniform_storage(_reflection.uniform_block_size);
 
 		for (auto node : _ast.structs)
 		{
-			visit(_global_code, node);
+			std::stringstream struct_code;
+
+			visit(struct_code, node);
+
+			_struct_code[node] = struct_code.str();
 		}
 
 		for (auto uniform : _ast.variables)
@@ -393,9 +397,13 @@ namespace reshade::opengl
 			}
 			else
 			{
-				visit(_global_code, uniform);
+				std::stringstream variable_code;
+
+				visit(variable_code, uniform);
 
-				_global_code << ";\n";
+				variable_code << ";\n";
+
+				_variable_code[uniform] = variable_code.str();
 			}
 		}
 
@@ -431,6 +439,9 @@ namespace reshade::opengl
 			_runtime->_effect_ubos.emplace_back(ubo, _uniform_buffer_size);
 		}
 
+		LOG(INFO) << "> Generated " << _emitted_code_size << " bytes of shader code after leaving out " << _unreachable_code_size << " bytes unreachable from the entry points and spent "
+		          << std::chrono::duration_cast<std::chrono::milliseconds>(_compile_time).count() << " ms in glCompileShader.";
+
 		return _success;
 	}
 
@@ -2101,26 +2112,24 @@ namespace reshade::opengl
 
 	void opengl_effect_compiler::visit_texture(const variable_declaration_node *node)
 	{
+		const auto &info = _reflection.textures[_texture_index++];
+
 		texture obj;
 		obj.impl = std::make_unique<opengl_tex_data>();
 		const auto obj_data = obj.impl->as<opengl_tex_data>();
-		obj.name = node->name;
-		obj.unique_name = node->unique_name;
-		obj.annotations = node->annotation_list;
-		GLuint width = obj.width = node->properties.width;
-		GLuint height = obj.height = node->properties.height;
-		GLuint levels = obj.levels = node->properties.levels;
+		obj.name = info.name;
+		obj.unique_name = info.unique_name;
+		obj.annotations = info.annotations;
+		GLuint width = obj.width = info.width;
+		GLuint height = obj.height = info.height;
+		GLuint levels = obj.levels = info.levels;
 
 		GLenum internalformat = GL_RGBA8, internalformat_srgb = GL_SRGB8_ALPHA8;
-		literal_to_format(obj.format = node->properties.format, internalformat, internalformat_srgb);
+		literal_to_format(obj.format = info.format, internalformat, internalformat_srgb);
 
-		if (node->semantic == "COLOR" || node->semantic == "SV_TARGET")
-		{
-			_runtime->update_texture_reference(obj, texture_reference::back_buffer);
-		}
-		else if (node->semantic == "DEPTH" || node->semantic == "SV_DEPTH")
+		if (info.reference != texture_reference::none)
 		{
-			_runtime->update_texture_reference(obj, texture_reference::depth_buffer);
+			_runtime->update_texture_reference(obj, info.reference);
 		}
 		else
 		{
@@ -2150,7 +2159,10 @@ namespace reshade::opengl
 	}
 	void opengl_effect_compiler::visit_sampler(const variable_declaration_node *node)
 	{
-		const auto texture = _runtime->find_texture(node->properties.texture->name);
+		const auto &info = _reflection.samplers[_sampler_index++];
+
+		_sampler_variables.push_back(node);
+		const auto texture = _runtime->find_texture(_reflection.textures[info.texture].name);
 
 		if (texture == nullptr)
 		{
@@ -2158,26 +2170,43 @@ namespace reshade::opengl
 			return;
 		}
 
+		opengl_sampler_desc desc = { };
+		desc.wrap_s = literal_to_wrap_mode(info.address_u);
+		desc.wrap_t = literal_to_wrap_mode(info.address_v);
+		desc.wrap_r = literal_to_wrap_mode(info.address_w);
+		literal_to_filter_mode(info.filter, desc.min_filter, desc.mag_filter);
+		desc.lod_bias = info.lod_bias;
+		desc.min_lod = info.min_lod;
+		desc.max_lod = info.max_lod;
+
 		opengl_sampler sampler;
 		sampler.id = 0;
 		sampler.texture = texture->impl->as<opengl_tex_data>();
-		sampler.is_srgb = node->properties.srgb_texture;
+		sampler.is_srgb = info.srgb;
 		sampler.has_mipmaps = texture->levels > 1;
 
-		GLenum minfilter = GL_NONE, magfilter = GL_NONE;
-		literal_to_filter_mode(node->properties.filter, minfilter, magfilter);
+		// Samplers with equal parameters share one sampler object, only the texture they are bound with differs
+		if (const auto id = _runtime->_effect_sampler_descs.find(desc))
+		{
+			sampler.id = *id;
+		}
+		else
+		{
+			glGenSamplers(1, &sampler.id);
+			glSamplerParameteri(sampler.id, GL_TEXTURE_WRAP_S, desc.wrap_s);
+			glSamplerParameteri(sampler.id, GL_TEXTURE_WRAP_T, desc.wrap_t);
+			glSamplerParameteri(sampler.id, GL_TEXTURE_WRAP_R, desc.wrap_r);
+			glSamplerParameteri(sampler.id, GL_TEXTURE_MAG_FILTER, desc.mag_filter);
+			glSamplerParameteri(sampler.id, GL_TEXTURE_MIN_FILTER, desc.min_filter);
+			glSamplerParameterf(sampler.id, GL_TEXTURE_LOD_BIAS, desc.lod_bias);
+			glSamplerParameterf(sampler.id, GL_TEXTURE_MIN_LOD, desc.min_lod);
+			glSamplerParameterf(sampler.id, GL_TEXTURE_MAX_LOD, desc.max_lod);
 
-		glGenSamplers(1, &sampler.id);
-		glSamplerParameteri(sampler.id, GL_TEXTURE_WRAP_S, literal_to_wrap_mode(node->properties.address_u));
-		glSamplerParameteri(sampler.id, GL_TEXTURE_WRAP_T, literal_to_wrap_mode(node->properties.address_v));
-		glSamplerParameteri(sampler.id, GL_TEXTURE_WRAP_R, literal_to_wrap_mode(node->properties.address_w));
-		glSamplerParameteri(sampler.id, GL_TEXTURE_MAG_FILTER, magfilter);
-		glSamplerParameteri(sampler.id, GL_TEXTURE_MIN_FILTER, minfilter);
-		glSamplerParameterf(sampler.id, GL_TEXTURE_LOD_BIAS, node->properties.lod_bias);
-		glSamplerParameterf(sampler.id, GL_TEXTURE_MIN_LOD, node->properties.min_lod);
-		glSamplerParameterf(sampler.id, GL_TEXTURE_MAX_LOD, node->properties.max_lod);
+			_runtime->_effect_sampler_descs.insert(desc, sampler.id);
+		}
 
-		_global_code << "layout(binding = " << _runtime->_effect_samplers.size() << ") uniform sampler2D " << escape_name(node->unique_name) << ";\n";
+		// The declaration is emitted per pass, so that each pass gets its own compact texture unit assignment
+		_sampler_bindings[node] = static_cast<GLsizei>(_runtime->_effect_samplers.size());
 
 		_runtime->_effect_samplers.push_back(std::move(sampler));
 	}
@@ -2201,52 +2230,15 @@ namespace reshade::opengl
 
 		_global_uniforms << ";\n";
 
-		uniform obj;
-		obj.name = node->name;
-		obj.unique_name = node->unique_name;
-		obj.basetype = obj.displaytype = static_cast<uniform_datatype>(node->type.basetype - 1);
-		obj.rows = node->type.rows;
-		obj.columns = node->type.cols;
-		obj.elements = node->type.array_length;
-		obj.storage_size = obj.rows * obj.columns * std::max(1u, obj.elements) * 4;
-		obj.annotations = node->annotation_list;
-
-		// GLSL specification on std140 layout:
-		// 1. If the member is a scalar consuming N basic machine units, the base alignment is N.
-		// 2. If the member is a two- or four-component vector with components consuming N basic machine units, the base alignment is 2N or 4N, respectively.
-		// 3. If the member is a three-component vector with components consuming N basic machine units, the base alignment is 4N.
-		size_t alignment = obj.storage_size;
-		if (obj.rows == 3)
-		{
-			alignment = alignment * 4 / 3;
-		}
-		_uniform_buffer_size = align(_uniform_buffer_size, alignment);
-		obj.storage_offset = _uniform_storage_offset + _uniform_buffer_size;
-		_uniform_buffer_size += obj.storage_size;
-
-		auto &uniform_storage = _runtime->get_uniform_value_storage();
-
-		if (_uniform_storage_offset + _uniform_buffer_size >= static_cast<ptrdiff_t>(uniform_storage.size()))
-		{
-			uniform_storage.resize(uniform_storage.size() + 128);
-		}
-
-		if (node->initializer_expression != nullptr && node->initializer_expression->id == nodeid::literal_expression)
-		{
-			std::memcpy(uniform_storage.data() + obj.storage_offset, &static_cast<const literal_expression_node *>(node->initializer_expression)->value_float, obj.storage_size);
-		}
-		else
-		{
-			std::memset(uniform_storage.data() + obj.storage_offset, 0, obj.storage_size);
-		}
-
-		_runtime->add_uniform(std::move(obj));
+		_runtime->add_uniform(_reflection.uniforms[_uniform_index++], _uniform_storage_offset);
 	}
 	void opengl_effect_compiler::visit_technique(const technique_declaration_node *node)
 	{
+		const auto &info = _reflection.techniques[_technique_index++];
+
 		technique obj;
-		obj.name = node->name;
-		obj.annotations = node->annotation_list;
+		obj.name = info.name;
+		obj.annotations = info.annotations;
 
 		if (_uniform_buffer_size != 0)
 		{
@@ -2254,36 +2246,80 @@ namespace reshade::opengl
 			obj.uniform_storage_offset = _uniform_storage_offset;
 		}
 
-		for (auto pass : node->pass_list)
+		for (size_t i = 0; i < node->pass_list.size(); i++)
 		{
 			obj.passes.emplace_back(std::make_unique<opengl_pass_data>());
-			visit_pass(pass, *static_cast<opengl_pass_data *>(obj.passes.back().get()));
+			visit_pass(node->pass_list[i], info.passes[i], *static_cast<opengl_pass_data *>(obj.passes.back().get()));
+
+			obj.resource_bindings += static_cast<unsigned int>(obj.passes.back()->as<opengl_pass_data>()->samplers.size());
 		}
 
 		_runtime->add_technique(std::move(obj));
 	}
-	void opengl_effect_compiler::visit_pass(const pass_declaration_node *node, opengl_pass_data &pass)
+	void opengl_effect_compiler::visit_pass(const pass_declaration_node *node, const reshadefx::pass_info &info, opengl_pass_data &pass)
 	{
-		pass.color_mask[0] = (node->color_write_mask & (1 << 0)) != 0;
-		pass.color_mask[1] = (node->color_write_mask & (1 << 1)) != 0;
-		pass.color_mask[2] = (node->color_write_mask & (1 << 2)) != 0;
-		pass.color_mask[3] = (node->color_write_mask & (1 << 3)) != 0;
-		pass.stencil_test = node->stencil_enable;
-		pass.stencil_read_mask = node->stencil_read_mask;
-		pass.stencil_mask = node->stencil_write_mask;
-		pass.stencil_func = literal_to_comp_func(node->stencil_comparison_func);
-		pass.stencil_op_z_pass = literal_to_stencil_op(node->stencil_op_pass);
-		pass.stencil_op_fail = literal_to_stencil_op(node->stencil_op_fail);
-		pass.stencil_op_z_fail = literal_to_stencil_op(node->stencil_op_depth_fail);
-		pass.blend = node->blend_enable;
-		pass.blend_eq_color = literal_to_blend_eq(node->blend_op);
-		pass.blend_eq_alpha = literal_to_blend_eq(node->blend_op_alpha);
-		pass.blend_src = literal_to_blend_func(node->src_blend);
-		pass.blend_dest = literal_to_blend_func(node->dest_blend);
-		pass.stencil_reference = node->stencil_reference_value;
+		opengl_blend_state blend_state = { };
+		blend_state.color_mask[0] = (node->color_write_mask & (1 << 0)) != 0;
+		blend_state.color_mask[1] = (node->color_write_mask & (1 << 1)) != 0;
+		blend_state.color_mask[2] = (node->color_write_mask & (1 << 2)) != 0;
+		blend_state.color_mask[3] = (node->color_write_mask & (1 << 3)) != 0;
+		blend_state.enable = node->blend_enable;
+		blend_state.equation_color = literal_to_blend_eq(node->blend_op);
+		blend_state.equation_alpha = literal_to_blend_eq(node->blend_op_alpha);
+		blend_state.src = literal_to_blend_func(node->src_blend);
+		blend_state.dest = literal_to_blend_func(node->dest_blend);
+
+		opengl_stencil_state stencil_state = { };
+		stencil_state.enable = node->stencil_enable;
+		stencil_state.func = literal_to_comp_func(node->stencil_comparison_func);
+		stencil_state.op_fail = literal_to_stencil_op(node->stencil_op_fail);
+		stencil_state.op_z_fail = literal_to_stencil_op(node->stencil_op_depth_fail);
+		stencil_state.op_z_pass = literal_to_stencil_op(node->stencil_op_pass);
+		stencil_state.reference = node->stencil_reference_value;
+		stencil_state.read_mask = node->stencil_read_mask;
+		stencil_state.write_mask = node->stencil_write_mask;
+
+		// Passes with equal states share one index, so that rendering can tell when a state does not have to be set again
+		if (const auto index = _runtime->_effect_blend_descs.find(blend_state))
+		{
+			pass.blend_state = *index;
+		}
+		else
+		{
+			pass.blend_state = _runtime->_effect_blend_descs.insert(blend_state, _runtime->_effect_blend_states.size());
+			_runtime->_effect_blend_states.push_back(blend_state);
+		}
+
+		if (const auto index = _runtime->_effect_stencil_descs.find(stencil_state))
+		{
+			pass.stencil_state = *index;
+		}
+		else
+		{
+			pass.stencil_state = _runtime->_effect_stencil_descs.insert(stencil_state, _runtime->_effect_stencil_states.size());
+			_runtime->_effect_stencil_states.push_back(stencil_state);
+		}
+
 		pass.srgb = node->srgb_write_enable;
 		pass.clear_render_targets = node->clear_render_targets;
 
+		// Only bind the samplers this pass actually reads from, packed into the lowest texture units. The reflection lists them in declaration order.
+		_pass_texture_units.clear();
+
+		for (const size_t sampler : info.samplers)
+		{
+			const auto variable = _sampler_variables[sampler];
+			const auto binding = _sampler_bindings.find(variable);
+
+			if (binding == _sampler_bindings.end())
+			{
+				continue;
+			}
+
+			_pass_texture_units[variable] = static_cast<GLuint>(pass.samplers.size());
+			pass.samplers.push_back(binding->second);
+		}
+
 		glGenFramebuffers(1, &pass.fbo);
 		glBindFramebuffer(GL_FRAMEBUFFER, pass.fbo);
 
@@ -2355,20 +2391,24 @@ namespace reshade::opengl
 		{
 			if (shader_functions[i] != nullptr)
 			{
-				shaders[i] = glCreateShader(shader_types[i]);
-
 				visit_pass_shader(shader_functions[i], shader_types[i], shaders[i]);
+			}
 
+			if (shaders[i] != 0)
+			{
 				glAttachShader(pass.program, shaders[i]);
 			}
 		}
 
 		glLinkProgram(pass.program);
 
+		// The shaders are owned by the shader object cache of the runtime, which deletes them when the effects are unloaded
 		for (unsigned int shader : shaders)
 		{
-			glDetachShader(pass.program, shader);
-			glDeleteShader(shader);
+			if (shader != 0)
+			{
+				glDetachShader(pass.program, shader);
+			}
 		}
 
 		GLint status = GL_FALSE;
@@ -2411,7 +2451,71 @@ namespace reshade::opengl
 			"vec4 _texelFetch(sampler2D s, ivec4 c) { return texelFetch(s, c.xy, c.w); }\n"
 			"#define _textureLodOffset(s, c, offset) textureLodOffset(s, (c).xy, (c).w, offset)\n";
 
-		if (_uniform_buffer_size != 0)
+		// Only the global variables and functions the entry point can reach are emitted, so that the driver does not parse and optimize the rest of the effect again for every shader
+		// Declarations are limited to what that code references as well, so that a shader which does not depend on the rest of its effect is generated the same in every effect and can share one shader object
+		std::unordered_set<const variable_declaration_node *> variables;
+		std::unordered_set<const function_declaration_node *> functions;
+		find_references(node, variables, functions);
+
+		std::string code;
+
+		for (auto variable : _ast.variables)
+		{
+			const auto variable_code = _variable_code.find(variable);
+
+			if (variable_code == _variable_code.end())
+			{
+				continue;
+			}
+
+			if (variables.count(variable) != 0)
+			{
+				code += variable_code->second;
+			}
+			else
+			{
+				_unreachable_code_size += variable_code->second.size();
+			}
+		}
+		for (auto function : _ast.functions)
+		{
+			if (functions.count(function) == 0)
+			{
+				_unreachable_code_size += _functions.at(function).code.size();
+			}
+		}
+
+		for (auto dependency : _functions.at(node).dependencies)
+		{
+			code += _functions.at(dependency).code;
+		}
+
+		code += _functions.at(node).code;
+
+		// Structures are found by name, going backwards so that those used in the fields of a later one are included too
+		std::string structs;
+
+		for (auto it = _ast.structs.rbegin(); it != _ast.structs.rend(); ++it)
+		{
+			const auto &struct_code = _struct_code.at(*it);
+			const auto name = escape_name((*it)->unique_name);
+
+			if (code.find(name) != std::string::npos || structs.find(name) != std::string::npos)
+			{
+				structs.insert(0, struct_code);
+			}
+			else
+			{
+				_unreachable_code_size += struct_code.size();
+			}
+		}
+
+		const bool references_uniforms = std::any_of(variables.begin(), variables.end(),
+			[](const variable_declaration_node *variable) {
+				return !variable->type.is_texture() && !variable->type.is_sampler() && variable->type.has_qualifier(type_node::qualifier_uniform);
+			});
+
+		if (_uniform_buffer_size != 0 && references_uniforms)
 		{
 			source << "layout(std140, binding = 0) uniform _GLOBAL_\n{\n" << _global_uniforms.str() << "};\n";
 		}
@@ -2421,14 +2525,17 @@ namespace reshade::opengl
 			source << "#define discard\n";
 		}
 
-		source << _global_code.str();
-
-		for (auto dependency : _functions.at(node).dependencies)
+		for (auto variable : _ast.variables)
 		{
-			source << _functions.at(dependency).code;
+			const auto texture_unit = _pass_texture_units.find(variable);
+
+			if (texture_unit != _pass_texture_units.end() && variables.count(variable) != 0)
+			{
+				source << "layout(binding = " << texture_unit->second << ") uniform sampler2D " << escape_name(variable->unique_name) << ";\n";
+			}
 		}
 
-		source << _functions.at(node).code;
+		source << structs << code;
 
 		for (auto parameter : node->parameter_list)
 		{
@@ -2640,9 +2747,28 @@ namespace reshade::opengl
 		const GLchar *src = source_str.c_str();
 		const auto len = static_cast<GLsizei>(source_str.size());
 
+		_emitted_code_size += source_str.size();
+
+		const std::string object_key = make_shader_object_key(source_str, "main", std::to_string(shadertype));
+		std::string messages;
+
+		// Passes that generate the same source share the shader object that was created for the first of them
+		if (_runtime->_shader_object_cache.find(object_key, shader, messages))
+		{
+			return;
+		}
+
+		shader = glCreateShader(shadertype);
+
 		glShaderSource(shader, 1, &src, &len);
+
+		// Querying the status waits for the compilation to finish, so it is part of the measured time
+		const auto compile_start = std::chrono::high_resolution_clock::now();
 		glCompileShader(shader);
 		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		_compile_time += std::chrono::high_resolution_clock::now() - compile_start;
+
+		_runtime->_shader_object_cache.count_compilation();
 
 		if (status == GL_FALSE)
 		{
@@ -2652,9 +2778,15 @@ namespace reshade::opengl
 			std::string log(logsize, '\0');
 			glGetShaderInfoLog(shader, logsize, nullptr, &log.front());
 
+			glDeleteShader(shader);
+			shader = 0;
+
 			_errors += log;
 			error(node->location, "internal shader compilation failed");
+			return;
 		}
+
+		_runtime->_shader_object_cache.insert(object_key, shader, messages);
 	}
 	void opengl_effect_compiler::visit_shader_param(std::stringstream &output, type_node type, unsigned int qualifier, const std::string &name, const std::string &semantic, unsigned int shadertype)
 	{
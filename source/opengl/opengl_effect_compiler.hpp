@@ -5,8 +5,10 @@
 
 #pragma once
 
+#include <chrono>
 #include <sstream>
 #include "syntax_tree.hpp"
+#include "effect_reflection.hpp"
 
 namespace reshade::opengl
 {
@@ -61,7 +63,7 @@ namespace reshade::opengl
 		void visit_sampler(const reshadefx::nodes::variable_declaration_node *node);
 		void visit_uniform(const reshadefx::nodes::variable_declaration_node *node);
 		void visit_technique(const reshadefx::nodes::technique_declaration_node *node);
-		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, opengl_pass_data &pass);
+		void visit_pass(const reshadefx::nodes::pass_declaration_node *node, const reshadefx::pass_info &info, opengl_pass_data &pass);
 		void visit_pass_shader(const reshadefx::nodes::function_declaration_node *node, unsigned int shadertype, unsigned int &shader);
 		void visit_shader_param(std::stringstream &output, reshadefx::nodes::type_node type, unsigned int qualifier, const std::string &name, const std::string &semantic, unsigned int shadertype);
 
@@ -75,9 +77,17 @@ namespace reshade::opengl
 		bool _success;
 		const reshadefx::syntax_tree &_ast;
 		std::string &_errors;
-		std::stringstream _global_code, _global_uniforms;
+		std::stringstream _global_uniforms;
+		std::unordered_map<const reshadefx::nodes::struct_declaration_node *, std::string> _struct_code;
 		const reshadefx::nodes::function_declaration_node *_current_function;
 		std::unordered_map<const reshadefx::nodes::function_declaration_node *, function> _functions;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, std::string> _variable_code;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, GLsizei> _sampler_bindings;
+		std::unordered_map<const reshadefx::nodes::variable_declaration_node *, GLuint> _pass_texture_units;
 		GLintptr _uniform_storage_offset = 0, _uniform_buffer_size = 0;
+		size_t _uniform_index = 0, _texture_index = 0, _sampler_index = 0, _technique_index = 0, _emitted_code_size = 0, _unreachable_code_size = 0;
+		std::chrono::high_resolution_clock::duration _compile_time = std::chrono::high_resolution_clock::duration::zero();
+		reshadefx::effect_reflection _reflection;
+		std::vector<const reshadefx::nodes::variable_declaration_node *> _sampler_variables;
 	};
 }
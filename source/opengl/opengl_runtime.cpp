@@ -9,6 +9,7 @@
 #include "input.hpp"
 #include "..\deps\imgui\imgui.h"
 #include <assert.h>
+#include <algorithm>
 
 IMGUI_API
 void
@@ -186,7 +187,10 @@ namespace reshade::opengl
 			GL_DEPTH24_STENCIL8
 		};
 
-		_depth_source_table[0] = defaultdepth;
+		// The default frame buffer may have been resized, so replace its entry
+		_depth_source_tracker.on_release(0);
+		_depth_source_tracker.track(0, defaultdepth.width, defaultdepth.height, defaultdepth);
+		_depth_source_info = defaultdepth;
 
 		glGenTextures(1, &_depth_texture);
 
@@ -254,6 +258,8 @@ namespace reshade::opengl
 		_width = width;
 		_height = height;
 
+		_depth_source_tracker.on_resize(_width, _height);
+
 		_stateblock.capture();
 
 		// Clear errors
@@ -306,12 +312,16 @@ namespace reshade::opengl
 	{
 		runtime::on_reset_effect();
 
-		for (auto &sampler : _effect_samplers)
-		{
-			glDeleteSamplers(1, &sampler.id);
-		}
+		// Samplers with equal parameters share one sampler object, so they are deleted through the cache that owns them
+		_effect_sampler_descs.clear([](GLuint &id) {
+			glDeleteSamplers(1, &id);
+		});
 
 		_effect_samplers.clear();
+		_effect_blend_states.clear();
+		_effect_blend_descs.clear();
+		_effect_stencil_states.clear();
+		_effect_stencil_descs.clear();
 
 		for (auto &uniform_buffer : _effect_ubos)
 		{
@@ -319,6 +329,17 @@ namespace reshade::opengl
 		}
 
 		_effect_ubos.clear();
+
+		_shader_object_cache.clear([](GLuint &shader) {
+			glDeleteShader(shader);
+		});
+
+		// Without effects only the overlay is drawn, which uses the first texture unit
+		_stateblock.set_used_texture_units(1);
+	}
+	shader_object_statistics opengl_runtime::get_shader_statistics() const
+	{
+		return _shader_object_cache.statistics();
 	}
 	void opengl_runtime::on_present()
 	{
@@ -362,14 +383,6 @@ namespace reshade::opengl
 			// Setup vertex input
 			glBindVertexArray(_default_vao);
 
-			// Setup shader resources
-			for (GLsizei i = 0; i < static_cast<GLsizei>(_effect_samplers.size()); i++)
-			{
-				glActiveTexture(GL_TEXTURE0 + i);
-				glBindTexture(GL_TEXTURE_2D, _effect_samplers[i].texture->id[_effect_samplers[i].is_srgb]);
-				glBindSampler(i, _effect_samplers[i].id);
-			}
-
 			// Setup global states
 			glDisable(GL_CULL_FACE);
 			glDisable(GL_DEPTH_TEST);
@@ -423,13 +436,7 @@ namespace reshade::opengl
 			}
 		}
 
-		const auto it = _depth_source_table.find(object | (objecttarget == GL_RENDERBUFFER ? 0x80000000 : 0));
-
-		if (it != _depth_source_table.end())
-		{
-			it->second.drawcall_count = _drawcalls;
-			it->second.vertices_count += vertices;
-		}
+		_depth_source_tracker.on_draw(object | (objecttarget == GL_RENDERBUFFER ? 0x80000000 : 0), _drawcalls, vertices);
 	}
 	void opengl_runtime::on_fbo_attachment(GLenum target, GLenum attachment, GLenum objecttarget, GLuint object, GLint level)
 	{
@@ -451,7 +458,7 @@ namespace reshade::opengl
 
 		const GLuint id = object | (objecttarget == GL_RENDERBUFFER ? 0x80000000 : 0);
 		
-		if (_depth_source_table.find(id) != _depth_source_table.end())
+		if (_depth_source_tracker.is_tracked(id))
 		{
 			return;
 		}
@@ -491,7 +498,23 @@ namespace reshade::opengl
 			glBindTexture(objecttarget, previous);
 		}
 
-		_depth_source_table.emplace(id, info);
+		_depth_source_tracker.track(id, info.width, info.height, info);
+	}
+	void opengl_runtime::on_delete_objects(GLenum objecttarget, GLsizei count, const GLuint *objects)
+	{
+		if (objects == nullptr)
+		{
+			return;
+		}
+
+		for (GLsizei i = 0; i < count; i++)
+		{
+			// Name zero is silently ignored by OpenGL and identifies the default frame buffer here
+			if (objects[i] != 0)
+			{
+				_depth_source_tracker.on_release(objects[i] | (objecttarget == GL_RENDERBUFFER ? 0x80000000 : 0));
+			}
+		}
 	}
 
 	void opengl_runtime::capture_frame(uint8_t *buffer) const
@@ -522,7 +545,25 @@ namespace reshade::opengl
 	}
 	bool opengl_runtime::load_effect(const reshadefx::syntax_tree &ast, std::string &errors)
 	{
-		return opengl_effect_compiler(this, ast, errors).run();
+		if (!opengl_effect_compiler(this, ast, errors).run())
+		{
+			return false;
+		}
+
+		// Only save and restore the texture units effects are going to bind
+		GLuint num_texture_units = 1;
+
+		for (const auto &technique : _techniques)
+		{
+			for (const auto &pass_object : technique.passes)
+			{
+				num_texture_units = std::max(num_texture_units, static_cast<GLuint>(pass_object->as<opengl_pass_data>()->samplers.size()));
+			}
+		}
+
+		_stateblock.set_used_texture_units(num_texture_units);
+
+		return true;
 	}
 	bool opengl_runtime::update_texture(texture &texture, const uint8_t *data)
 	{
@@ -628,6 +669,8 @@ namespace reshade::opengl
 			glBufferSubData(GL_UNIFORM_BUFFER, 0, _effect_ubos[technique.uniform_storage_index].second, get_uniform_value_storage().data() + technique.uniform_storage_offset);
 		}
 
+		const opengl_pass_data *previous_pass = nullptr;
+
 		for (const auto &pass_object : technique.passes)
 		{
 			const opengl_pass_data &pass = *pass_object->as<opengl_pass_data>();
@@ -640,40 +683,64 @@ namespace reshade::opengl
 			glDrawBuffer(GL_COLOR_ATTACHMENT0);
 			glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 
-			// Setup states
+			// Setup states, passes with equal states share the same index, so only those that changed since the previous pass are set again
 			glUseProgram(pass.program);
-			glColorMask(pass.color_mask[0], pass.color_mask[1], pass.color_mask[2], pass.color_mask[3]);
-			glBlendFunc(pass.blend_src, pass.blend_dest);
-			glBlendEquationSeparate(pass.blend_eq_color, pass.blend_eq_alpha);
-			glStencilFunc(pass.stencil_func, pass.stencil_reference, pass.stencil_read_mask);
-			glStencilOp(pass.stencil_op_fail, pass.stencil_op_z_fail, pass.stencil_op_z_pass);
-			glStencilMask(pass.stencil_mask);
 
-			if (pass.srgb)
-			{
-				glEnable(GL_FRAMEBUFFER_SRGB);
-			}
-			else
+			if (previous_pass == nullptr || pass.blend_state != previous_pass->blend_state)
 			{
-				glDisable(GL_FRAMEBUFFER_SRGB);
+				const auto &blend_state = _effect_blend_states[pass.blend_state];
+
+				glColorMask(blend_state.color_mask[0], blend_state.color_mask[1], blend_state.color_mask[2], blend_state.color_mask[3]);
+				glBlendFunc(blend_state.src, blend_state.dest);
+				glBlendEquationSeparate(blend_state.equation_color, blend_state.equation_alpha);
+
+				if (blend_state.enable)
+				{
+					glEnable(GL_BLEND);
+				}
+				else
+				{
+					glDisable(GL_BLEND);
+				}
 			}
 
-			if (pass.blend)
+			if (previous_pass == nullptr || pass.stencil_state != previous_pass->stencil_state)
 			{
-				glEnable(GL_BLEND);
+				const auto &stencil_state = _effect_stencil_states[pass.stencil_state];
+
+				glStencilFunc(stencil_state.func, stencil_state.reference, stencil_state.read_mask);
+				glStencilOp(stencil_state.op_fail, stencil_state.op_z_fail, stencil_state.op_z_pass);
+				glStencilMask(stencil_state.write_mask);
+
+				if (stencil_state.enable)
+				{
+					glEnable(GL_STENCIL_TEST);
+				}
+				else
+				{
+					glDisable(GL_STENCIL_TEST);
+				}
 			}
-			else
+
+			previous_pass = &pass;
+
+			// Setup shader resources
+			for (GLsizei k = 0; k < static_cast<GLsizei>(pass.samplers.size()); k++)
 			{
-				glDisable(GL_BLEND);
+				const auto &sampler = _effect_samplers[pass.samplers[k]];
+
+				glActiveTexture(GL_TEXTURE0 + k);
+				glBindTexture(GL_TEXTURE_2D, sampler.texture->id[sampler.is_srgb]);
+				glBindSampler(k, sampler.id);
 			}
 
-			if (pass.stencil_test)
+			if (pass.srgb)
 			{
-				glEnable(GL_STENCIL_TEST);
+				glEnable(GL_FRAMEBUFFER_SRGB);
 			}
 			else
 			{
-				glDisable(GL_STENCIL_TEST);
+				glDisable(GL_FRAMEBUFFER_SRGB);
 			}
 
 			// Setup render targets
@@ -704,14 +771,16 @@ namespace reshade::opengl
 			// Update shader resources
 			for (GLuint texture_id : pass.draw_textures)
 			{
-				for (GLsizei i = 0; i < static_cast<GLsizei>(_effect_samplers.size()); i++)
+				for (const auto &sampler : _effect_samplers)
 				{
-					const auto texture = _effect_samplers[i].texture;
+					const auto texture = sampler.texture;
 
-					if (_effect_samplers[i].has_mipmaps && (texture->id[0] == texture_id || texture->id[1] == texture_id))
+					// The texture is not necessarily bound to any unit in this pass, so bind it to the active one, the next pass sets up its own units anyway
+					if (sampler.has_mipmaps && (texture->id[0] == texture_id || texture->id[1] == texture_id))
 					{
-						glActiveTexture(GL_TEXTURE0 + i);
+						glBindTexture(GL_TEXTURE_2D, texture_id);
 						glGenerateMipmap(GL_TEXTURE_2D);
+						break;
 					}
 				}
 			}
@@ -724,37 +793,13 @@ namespace reshade::opengl
 
 	void opengl_runtime::detect_depth_source()
 	{
-		GLuint best_match = 0;
-		depth_source_info best_info = { 0, 0, 0, GL_NONE };
-
-		for (auto& it : _depth_source_table)
-		{
-			const auto depthstencil = it.first;
-			auto &depthstencil_info = it.second;
-
-			if (depthstencil_info.drawcall_count == 0)
-			{
-				continue;
-			}
-
-			if (((depthstencil_info.vertices_count * (1.2f - float(depthstencil_info.drawcall_count) / _drawcalls)) >= (best_info.vertices_count * (1.2f - float(best_info.drawcall_count) / _drawcalls))) &&
-				((depthstencil_info.width > _width * 0.95 && depthstencil_info.width < _width * 1.05) && (depthstencil_info.height > _height * 0.95 && depthstencil_info.height < _height * 1.05)))
-			{
-				best_match = depthstencil;
-				best_info = depthstencil_info;
-			}
-
-			depthstencil_info.drawcall_count = depthstencil_info.vertices_count = 0;
-		}
-
-		if (best_match == 0)
-		{
-			best_info = _depth_source_table.at(0);
-		}
+		// Falls back to the default frame buffer (name zero) if there is no better candidate
+		depth_source_info best_info = { _width, _height, 0, GL_DEPTH24_STENCIL8 };
+		GLuint best_match = _depth_source_tracker.update(_drawcalls, &best_info);
 
 		if (_depth_source != best_match || _depth_texture == 0)
 		{
-			const auto &previous_info = _depth_source_table.at(_depth_source);
+			const auto previous_info = _depth_source_info;
 
 			if ((best_info.width != previous_info.width || best_info.height != previous_info.height || best_info.format != previous_info.format) || _depth_texture == 0)
 			{
@@ -771,6 +816,7 @@ namespace reshade::opengl
 			assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
 
 			_depth_source = best_match;
+			_depth_source_info = best_info;
 
 			if (best_match != 0)
 			{
@@ -7,6 +7,9 @@
 
 #include "runtime.hpp"
 #include "opengl_stateblock.hpp"
+#include "depth_source_tracker.hpp"
+#include "shader_object_cache.hpp"
+#include "state_object_cache.hpp"
 
 namespace reshade::opengl
 {
@@ -23,6 +26,34 @@ namespace reshade::opengl
 		bool should_delete = false;
 		GLuint id[2] = { };
 	};
+	/// <summary>
+	/// The blend state of a pass. All members, and the color mask as a whole, are four bytes wide, so that there is no padding and equal states compare equal bytewise.
+	/// </summary>
+	struct opengl_blend_state
+	{
+		GLboolean color_mask[4];
+		GLuint enable;
+		GLenum equation_color, equation_alpha, src, dest;
+	};
+	/// <summary>
+	/// The stencil state of a pass. All members are four bytes wide, so that there is no padding and equal states compare equal bytewise.
+	/// </summary>
+	struct opengl_stencil_state
+	{
+		GLuint enable;
+		GLenum func, op_fail, op_z_fail, op_z_pass;
+		GLint reference;
+		GLuint read_mask, write_mask;
+	};
+	/// <summary>
+	/// The parameters of a sampler object. All members are four bytes wide, so that there is no padding and equal descriptions compare equal bytewise.
+	/// </summary>
+	struct opengl_sampler_desc
+	{
+		GLenum wrap_s, wrap_t, wrap_r, mag_filter, min_filter;
+		GLfloat lod_bias, min_lod, max_lod;
+	};
+
 	struct opengl_pass_data : base_object
 	{
 		~opengl_pass_data()
@@ -33,14 +64,11 @@ namespace reshade::opengl
 
 		GLuint program = 0;
 		GLuint fbo = 0, draw_textures[8] = { };
-		GLint stencil_reference = 0;
-		GLuint stencil_mask = 0, stencil_read_mask = 0;
 		GLsizei viewport_width = 0, viewport_height = 0;
 		GLenum draw_buffers[8] = { };
-		GLenum stencil_func = GL_NONE, stencil_op_fail = GL_NONE, stencil_op_z_fail = GL_NONE, stencil_op_z_pass = GL_NONE;
-		GLenum blend_eq_color = GL_NONE, blend_eq_alpha = GL_NONE, blend_src = GL_NONE, blend_dest = GL_NONE;
-		GLboolean color_mask[4] = { };
-		bool srgb = false, blend = false, stencil_test = false, clear_render_targets = true;
+		size_t blend_state = 0, stencil_state = 0;
+		bool srgb = false, clear_render_targets = true;
+		std::vector<GLsizei> samplers;
 	};
 	struct opengl_sampler
 	{
@@ -52,6 +80,9 @@ namespace reshade::opengl
 
 	class opengl_runtime : public runtime
 	{
+		// The compiler uploads the initial values of an effect's uniforms
+		friend class opengl_effect_compiler;
+
 	public:
 		opengl_runtime(HDC device);
 
@@ -61,12 +92,14 @@ namespace reshade::opengl
 		void on_present();
 		void on_draw_call(unsigned int vertices);
 		void on_fbo_attachment(GLenum target, GLenum attachment, GLenum objecttarget, GLuint object, GLint level);
+		void on_delete_objects(GLenum objecttarget, GLsizei count, const GLuint *objects);
 
 		void capture_frame(uint8_t *buffer) const override;
 		bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) override;
 		bool update_texture(texture &texture, const uint8_t *data) override;
 		bool update_texture_reference(texture &texture, texture_reference id);
 
+		shader_object_statistics get_shader_statistics() const override;
 		void render_technique(const technique &technique) override;
 		void render_imgui_draw_data(ImDrawData *data) override;
 
@@ -76,15 +109,20 @@ namespace reshade::opengl
 		GLuint _default_backbuffer_fbo = 0, _default_backbuffer_rbo[2] = { }, _backbuffer_texture[2] = { };
 		GLuint _depth_source_fbo = 0, _depth_source = 0, _depth_texture = 0, _blit_fbo = 0;
 		std::vector<struct opengl_sampler> _effect_samplers;
+		state_object_cache<opengl_sampler_desc, GLuint> _effect_sampler_descs;
+		std::vector<opengl_blend_state> _effect_blend_states;
+		state_object_cache<opengl_blend_state, size_t> _effect_blend_descs;
+		std::vector<opengl_stencil_state> _effect_stencil_states;
+		state_object_cache<opengl_stencil_state, size_t> _effect_stencil_descs;
 		GLuint _default_vao = 0;
 		std::vector<std::pair<GLuint, GLsizeiptr>> _effect_ubos;
+		shader_object_cache<GLuint> _shader_object_cache;
 
 	private:
 		struct depth_source_info
 		{
 			unsigned int width, height;
 			GLint level, format;
-			unsigned int drawcall_count, vertices_count;
 		};
 
 		bool init_backbuffer_texture();
@@ -97,7 +135,8 @@ namespace reshade::opengl
 		void create_depth_texture(GLuint width, GLuint height, GLenum format);
 
 		opengl_stateblock _stateblock;
-		std::unordered_map<GLuint, depth_source_info> _depth_source_table;
+		depth_source_info _depth_source_info = { };
+		depth_source_tracker<GLuint, depth_source_info> _depth_source_tracker;
 
 		GLuint _imgui_shader_program = 0, _imgui_VertHandle = 0, _imgui_FragHandle = 0;
 		int _imgui_attribloc_tex = 0, _imgui_attribloc_projmtx = 0;
@@ -5,12 +5,20 @@
 
 #include "opengl_loader.hpp"
 #include "opengl_stateblock.hpp"
+#include <algorithm>
 
 namespace reshade::opengl
 {
 	opengl_stateblock::opengl_stateblock()
 	{
 		ZeroMemory(this, sizeof(*this));
+
+		set_used_texture_units(32);
+	}
+
+	void opengl_stateblock::set_used_texture_units(GLuint count)
+	{
+		_num_texture_units = std::min(count, static_cast<GLuint>(ARRAYSIZE(_textures2d)));
 	}
 
 	void opengl_stateblock::capture()
@@ -21,7 +29,14 @@ namespace reshade::opengl
 		glGetIntegerv(GL_CURRENT_PROGRAM, &_program);
 		glGetIntegerv(GL_ACTIVE_TEXTURE, &_active_texture);
 
-		for (GLuint i = 0; i < 32; i++)
+		// Textures are also created and updated on the active unit, so save it even if it is not one of the used ones
+		if (static_cast<GLuint>(_active_texture - GL_TEXTURE0) >= _num_texture_units)
+		{
+			glGetIntegerv(GL_TEXTURE_BINDING_2D, &_active_texture2d);
+			glGetIntegerv(GL_SAMPLER_BINDING, &_active_sampler);
+		}
+
+		for (GLuint i = 0; i < _num_texture_units; i++)
 		{
 			glActiveTexture(GL_TEXTURE0 + i);
 			glGetIntegerv(GL_TEXTURE_BINDING_2D, &_textures2d[i]);
@@ -68,7 +83,7 @@ namespace reshade::opengl
 		glBindBuffer(GL_UNIFORM_BUFFER, _ubo);
 		glUseProgram(_program);
 
-		for (GLuint i = 0; i < 32; i++)
+		for (GLuint i = 0; i < _num_texture_units; i++)
 		{
 			glActiveTexture(GL_TEXTURE0 + i);
 			glBindTexture(GL_TEXTURE_2D, _textures2d[i]);
@@ -76,6 +91,12 @@ namespace reshade::opengl
 		}
 
 		glActiveTexture(_active_texture);
+
+		if (static_cast<GLuint>(_active_texture - GL_TEXTURE0) >= _num_texture_units)
+		{
+			glBindTexture(GL_TEXTURE_2D, _active_texture2d);
+			glBindSampler(_active_texture - GL_TEXTURE0, _active_sampler);
+		}
 		glViewport(_viewport[0], _viewport[1], _viewport[2], _viewport[3]);
 		if (_scissor_test) { glEnable(GL_SCISSOR_TEST); }
 		else { glDisable(GL_SCISSOR_TEST); }
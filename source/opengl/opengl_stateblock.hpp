@@ -14,16 +14,22 @@ namespace reshade::opengl
 	public:
 		opengl_stateblock();
 
+		/// <summary>
+		/// Limit capture and restore to the leading texture units the runtime actually binds, in addition to the active one.
+		/// </summary>
+		void set_used_texture_units(GLuint count);
+
 		void capture();
 		void apply() const;
 
 	private:
+		GLuint _num_texture_units;
 		GLint _vao;
 		GLint _vbo;
 		GLint _ubo;
 		GLint _program;
 		GLint _textures2d[32], _samplers[32];
-		GLint _active_texture;
+		GLint _active_texture, _active_texture2d, _active_sampler;
 		GLint _viewport[4];
 		GLint _scissor_test;
 		GLint _blend;
@@ -0,0 +1,848 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "syntax_tree.hpp"
+#include "optimizer.hpp"
+#include "constant_folding.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace reshadefx
+{
+	using namespace nodes;
+
+	namespace
+	{
+		bool is_constant_condition(const expression_node *condition, bool &value)
+		{
+			if (condition == nullptr || condition->id != nodeid::literal_expression || !condition->type.is_scalar())
+			{
+				return false;
+			}
+
+			const auto literal = static_cast<const literal_expression_node *>(condition);
+
+			value = condition->type.is_floating_point() ? literal->value_float[0] != 0.0f : literal->value_int[0] != 0;
+
+			return true;
+		}
+		bool is_same_type(const type_node &left, const type_node &right)
+		{
+			return left.basetype == right.basetype && left.rows == right.rows && left.cols == right.cols && left.array_length == right.array_length && left.definition == right.definition;
+		}
+
+		class constant_propagation
+		{
+		public:
+			constant_propagation(syntax_tree &ast, optimizer_statistics &stats) : _ast(ast), _stats(stats) { }
+
+			expression_node *visit(expression_node *node)
+			{
+				if (node == nullptr)
+				{
+					return nullptr;
+				}
+
+				switch (node->id)
+				{
+					case nodeid::unary_expression:
+					{
+						const auto unary = static_cast<unary_expression_node *>(node);
+						unary->operand = visit(unary->operand);
+						break;
+					}
+					case nodeid::binary_expression:
+					{
+						const auto binary = static_cast<binary_expression_node *>(node);
+						binary->operands[0] = visit(binary->operands[0]);
+						binary->operands[1] = visit(binary->operands[1]);
+						break;
+					}
+					case nodeid::intrinsic_expression:
+					{
+						const auto intrinsic = static_cast<intrinsic_expression_node *>(node);
+
+						for (auto &argument : intrinsic->arguments)
+						{
+							argument = visit(argument);
+						}
+						break;
+					}
+					case nodeid::conditional_expression:
+					{
+						const auto conditional = static_cast<conditional_expression_node *>(node);
+						conditional->condition = visit(conditional->condition);
+						conditional->expression_when_true = visit(conditional->expression_when_true);
+						conditional->expression_when_false = visit(conditional->expression_when_false);
+
+						bool value;
+
+						if (is_constant_condition(conditional->condition, value))
+						{
+							const auto taken = value ? conditional->expression_when_true : conditional->expression_when_false;
+
+							// Only replace the expression if that does not require an implicit conversion the backends would have to emit
+							if (is_same_type(taken->type, conditional->type))
+							{
+								_stats.pruned_branches++;
+
+								return taken;
+							}
+						}
+						return node;
+					}
+					case nodeid::assignment_expression:
+					{
+						const auto assignment = static_cast<assignment_expression_node *>(node);
+						assignment->left = visit(assignment->left);
+						assignment->right = visit(assignment->right);
+						return node;
+					}
+					case nodeid::expression_sequence:
+						for (auto &expression : static_cast<expression_sequence_node *>(node)->expression_list)
+						{
+							expression = visit(expression);
+						}
+						return node;
+					case nodeid::call_expression:
+						for (auto &argument : static_cast<call_expression_node *>(node)->arguments)
+						{
+							argument = visit(argument);
+						}
+						return node;
+					case nodeid::constructor_expression:
+						for (auto &argument : static_cast<constructor_expression_node *>(node)->arguments)
+						{
+							argument = visit(argument);
+						}
+						break;
+					case nodeid::swizzle_expression:
+					{
+						const auto swizzle = static_cast<swizzle_expression_node *>(node);
+						swizzle->operand = visit(swizzle->operand);
+						return node;
+					}
+					case nodeid::field_expression:
+					{
+						const auto field = static_cast<field_expression_node *>(node);
+						field->operand = visit(field->operand);
+						return node;
+					}
+					case nodeid::initializer_list:
+						for (auto &value : static_cast<initializer_list_node *>(node)->values)
+						{
+							value = visit(value);
+						}
+						return node;
+				}
+
+				const auto folded = fold_constant_expression(_ast, node);
+
+				if (folded != node)
+				{
+					_stats.folded_expressions++;
+				}
+
+				return folded;
+			}
+			statement_node *visit(statement_node *node)
+			{
+				if (node == nullptr)
+				{
+					return nullptr;
+				}
+
+				switch (node->id)
+				{
+					case nodeid::compound_statement:
+					{
+						auto &statements = static_cast<compound_statement_node *>(node)->statement_list;
+
+						for (auto &statement : statements)
+						{
+							statement = visit(statement);
+						}
+
+						statements.erase(std::remove(statements.begin(), statements.end(), nullptr), statements.end());
+						break;
+					}
+					case nodeid::declarator_list:
+						for (auto declarator : static_cast<declarator_list_node *>(node)->declarator_list)
+						{
+							declarator->initializer_expression = visit(declarator->initializer_expression);
+						}
+						break;
+					case nodeid::expression_statement:
+					{
+						const auto statement = static_cast<expression_statement_node *>(node);
+						statement->expression = visit(statement->expression);
+						break;
+					}
+					case nodeid::if_statement:
+					{
+						const auto statement = static_cast<if_statement_node *>(node);
+						statement->condition = visit(statement->condition);
+						statement->statement_when_true = visit(statement->statement_when_true);
+						statement->statement_when_false = visit(statement->statement_when_false);
+
+						bool value;
+
+						if (is_constant_condition(statement->condition, value))
+						{
+							_stats.pruned_branches++;
+
+							return scoped(value ? statement->statement_when_true : statement->statement_when_false);
+						}
+						break;
+					}
+					case nodeid::switch_statement:
+					{
+						const auto statement = static_cast<switch_statement_node *>(node);
+						statement->test_expression = visit(statement->test_expression);
+
+						for (auto casestatement : statement->case_list)
+						{
+							casestatement->statement_list = visit(casestatement->statement_list);
+						}
+						break;
+					}
+					case nodeid::for_statement:
+					{
+						const auto statement = static_cast<for_statement_node *>(node);
+						statement->init_statement = visit(statement->init_statement);
+						statement->condition = visit(statement->condition);
+						statement->increment_expression = visit(statement->increment_expression);
+						statement->statement_list = visit(statement->statement_list);
+
+						bool value;
+
+						if (is_constant_condition(statement->condition, value) && !value)
+						{
+							_stats.pruned_branches++;
+
+							// The loop body never runs, but the initializer still has to
+							return scoped(statement->init_statement);
+						}
+						break;
+					}
+					case nodeid::while_statement:
+					{
+						const auto statement = static_cast<while_statement_node *>(node);
+						statement->condition = visit(statement->condition);
+						statement->statement_list = visit(statement->statement_list);
+
+						bool value;
+
+						if (!statement->is_do_while && is_constant_condition(statement->condition, value) && !value)
+						{
+							_stats.pruned_branches++;
+
+							return nullptr;
+						}
+						break;
+					}
+					case nodeid::return_statement:
+					{
+						const auto statement = static_cast<return_statement_node *>(node);
+						statement->return_value = visit(statement->return_value);
+						break;
+					}
+				}
+
+				return node;
+			}
+
+		private:
+			statement_node *scoped(statement_node *node)
+			{
+				// Declarations must not leak into the enclosing scope when the surrounding statement is removed
+				if (node == nullptr || node->id != nodeid::declarator_list)
+				{
+					return node;
+				}
+
+				const auto compound = _ast.make_node<compound_statement_node>(node->location);
+				compound->statement_list.push_back(node);
+
+				return compound;
+			}
+
+			syntax_tree &_ast;
+			optimizer_statistics &_stats;
+		};
+
+		class reference_collector
+		{
+		public:
+			void visit(const expression_node *node)
+			{
+				if (node == nullptr)
+				{
+					return;
+				}
+
+				switch (node->id)
+				{
+					case nodeid::lvalue_expression:
+						visit(static_cast<const lvalue_expression_node *>(node)->reference);
+						break;
+					case nodeid::unary_expression:
+						visit(static_cast<const unary_expression_node *>(node)->operand);
+						break;
+					case nodeid::binary_expression:
+						visit(static_cast<const binary_expression_node *>(node)->operands[0]);
+						visit(static_cast<const binary_expression_node *>(node)->operands[1]);
+						break;
+					case nodeid::intrinsic_expression:
+						for (auto argument : static_cast<const intrinsic_expression_node *>(node)->arguments)
+						{
+							visit(argument);
+						}
+						break;
+					case nodeid::conditional_expression:
+						visit(static_cast<const conditional_expression_node *>(node)->condition);
+						visit(static_cast<const conditional_expression_node *>(node)->expression_when_true);
+						visit(static_cast<const conditional_expression_node *>(node)->expression_when_false);
+						break;
+					case nodeid::assignment_expression:
+						visit(static_cast<const assignment_expression_node *>(node)->left);
+						visit(static_cast<const assignment_expression_node *>(node)->right);
+						break;
+					case nodeid::expression_sequence:
+						for (auto expression : static_cast<const expression_sequence_node *>(node)->expression_list)
+						{
+							visit(expression);
+						}
+						break;
+					case nodeid::call_expression:
+						for (auto argument : static_cast<const call_expression_node *>(node)->arguments)
+						{
+							visit(argument);
+						}
+						visit(static_cast<const call_expression_node *>(node)->callee);
+						break;
+					case nodeid::constructor_expression:
+						for (auto argument : static_cast<const constructor_expression_node *>(node)->arguments)
+						{
+							visit(argument);
+						}
+						break;
+					case nodeid::swizzle_expression:
+						visit(static_cast<const swizzle_expression_node *>(node)->operand);
+						break;
+					case nodeid::field_expression:
+						visit(static_cast<const field_expression_node *>(node)->operand);
+						break;
+					case nodeid::initializer_list:
+						for (auto value : static_cast<const initializer_list_node *>(node)->values)
+						{
+							visit(value);
+						}
+						break;
+				}
+			}
+			void visit(const statement_node *node)
+			{
+				if (node == nullptr)
+				{
+					return;
+				}
+
+				switch (node->id)
+				{
+					case nodeid::compound_statement:
+						for (auto statement : static_cast<const compound_statement_node *>(node)->statement_list)
+						{
+							visit(statement);
+						}
+						break;
+					case nodeid::declarator_list:
+						for (auto declarator : static_cast<const declarator_list_node *>(node)->declarator_list)
+						{
+							visit(declarator->initializer_expression);
+						}
+						break;
+					case nodeid::expression_statement:
+						visit(static_cast<const expression_statement_node *>(node)->expression);
+						break;
+					case nodeid::if_statement:
+						visit(static_cast<const if_statement_node *>(node)->condition);
+						visit(static_cast<const if_statement_node *>(node)->statement_when_true);
+						visit(static_cast<const if_statement_node *>(node)->statement_when_false);
+						break;
+					case nodeid::switch_statement:
+						visit(static_cast<const switch_statement_node *>(node)->test_expression);
+						for (auto casestatement : static_cast<const switch_statement_node *>(node)->case_list)
+						{
+							visit(casestatement->statement_list);
+						}
+						break;
+					case nodeid::for_statement:
+						visit(static_cast<const for_statement_node *>(node)->init_statement);
+						visit(static_cast<const for_statement_node *>(node)->condition);
+						visit(static_cast<const for_statement_node *>(node)->increment_expression);
+						visit(static_cast<const for_statement_node *>(node)->statement_list);
+						break;
+					case nodeid::while_statement:
+						visit(static_cast<const while_statement_node *>(node)->condition);
+						visit(static_cast<const while_statement_node *>(node)->statement_list);
+						break;
+					case nodeid::return_statement:
+						visit(static_cast<const return_statement_node *>(node)->return_value);
+						break;
+				}
+			}
+			void visit(const variable_declaration_node *node)
+			{
+				if (node == nullptr || !variables.insert(node).second)
+				{
+					return;
+				}
+
+				if (node->type.is_sampler())
+				{
+					visit(node->properties.texture);
+				}
+
+				visit(node->initializer_expression);
+			}
+			void visit(const function_declaration_node *node)
+			{
+				if (node == nullptr || !functions.insert(node).second)
+				{
+					return;
+				}
+
+				visit(node->definition);
+			}
+
+			std::unordered_set<const variable_declaration_node *> variables;
+			std::unordered_set<const function_declaration_node *> functions;
+		};
+
+		bool is_position_semantic(const std::string &semantic)
+		{
+			return semantic == "SV_POSITION" || semantic == "POSITION" || semantic == "VPOS";
+		}
+		bool is_texcoord_semantic(const std::string &semantic)
+		{
+			return semantic == "TEXCOORD" || semantic == "TEXCOORD0";
+		}
+		bool is_float_vector(const type_node &type, unsigned int rows)
+		{
+			return type.is_floating_point() && type.rows == rows && type.cols == 1 && !type.is_array();
+		}
+		bool is_full_screen_vertex_shader(const function_declaration_node *node)
+		{
+			if (!node->return_type.is_void())
+			{
+				return false;
+			}
+
+			unsigned int outputs = 0;
+
+			for (auto parameter : node->parameter_list)
+			{
+				if (!parameter->type.has_qualifier(type_node::qualifier_out))
+				{
+					if (parameter->semantic != "VERTEXID" && parameter->semantic != "SV_VERTEXID")
+					{
+						return false;
+					}
+				}
+				// The pixel shader of a fused pass expects exactly the position followed by the texture coordinate
+				else if (outputs == 0 && is_position_semantic(parameter->semantic) && is_float_vector(parameter->type, 4))
+				{
+					outputs++;
+				}
+				else if (outputs == 1 && is_texcoord_semantic(parameter->semantic) && is_float_vector(parameter->type, 2))
+				{
+					outputs++;
+				}
+				else
+				{
+					return false;
+				}
+			}
+
+			return outputs == 2;
+		}
+
+		class point_wise_analysis
+		{
+		public:
+			explicit point_wise_analysis(const variable_declaration_node *texcoord) : _texcoord(texcoord) { }
+
+			void visit(const expression_node *node)
+			{
+				if (node == nullptr || !valid)
+				{
+					return;
+				}
+
+				switch (node->id)
+				{
+					case nodeid::lvalue_expression:
+						// Any texture access that is not a plain sample of the back buffer at the current pixel is a dependency on other pixels
+						if (static_cast<const lvalue_expression_node *>(node)->reference->type.is_sampler() || static_cast<const lvalue_expression_node *>(node)->reference->type.is_texture())
+						{
+							valid = false;
+						}
+						break;
+					case nodeid::unary_expression:
+						switch (static_cast<const unary_expression_node *>(node)->op)
+						{
+							case unary_expression_node::pre_increase:
+							case unary_expression_node::pre_decrease:
+							case unary_expression_node::post_increase:
+							case unary_expression_node::post_decrease:
+								check_not_modified(static_cast<const unary_expression_node *>(node)->operand);
+								break;
+						}
+						visit(static_cast<const unary_expression_node *>(node)->operand);
+						break;
+					case nodeid::binary_expression:
+						visit(static_cast<const binary_expression_node *>(node)->operands[0]);
+						visit(static_cast<const binary_expression_node *>(node)->operands[1]);
+						break;
+					case nodeid::intrinsic_expression:
+						if (static_cast<const intrinsic_expression_node *>(node)->op == intrinsic_expression_node::texture && is_input_sample(static_cast<const intrinsic_expression_node *>(node)))
+						{
+							break;
+						}
+						for (auto argument : static_cast<const intrinsic_expression_node *>(node)->arguments)
+						{
+							visit(argument);
+						}
+						break;
+					case nodeid::conditional_expression:
+						visit(static_cast<const conditional_expression_node *>(node)->condition);
+						visit(static_cast<const conditional_expression_node *>(node)->expression_when_true);
+						visit(static_cast<const conditional_expression_node *>(node)->expression_when_false);
+						break;
+					case nodeid::assignment_expression:
+						check_not_modified(static_cast<const assignment_expression_node *>(node)->left);
+						visit(static_cast<const assignment_expression_node *>(node)->left);
+						visit(static_cast<const assignment_expression_node *>(node)->right);
+						break;
+					case nodeid::expression_sequence:
+						for (auto expression : static_cast<const expression_sequence_node *>(node)->expression_list)
+						{
+							visit(expression);
+						}
+						break;
+					case nodeid::call_expression:
+					{
+						const auto call = static_cast<const call_expression_node *>(node);
+
+						for (size_t i = 0; i < call->arguments.size(); i++)
+						{
+							if (call->callee->parameter_list[i]->type.has_qualifier(type_node::qualifier_out))
+							{
+								check_not_modified(call->arguments[i]);
+							}
+
+							visit(call->arguments[i]);
+						}
+
+						callees.insert(call->callee);
+						break;
+					}
+					case nodeid::constructor_expression:
+						for (auto argument : static_cast<const constructor_expression_node *>(node)->arguments)
+						{
+							visit(argument);
+						}
+						break;
+					case nodeid::swizzle_expression:
+						visit(static_cast<const swizzle_expression_node *>(node)->operand);
+						break;
+					case nodeid::field_expression:
+						visit(static_cast<const field_expression_node *>(node)->operand);
+						break;
+					case nodeid::initializer_list:
+						for (auto value : static_cast<const initializer_list_node *>(node)->values)
+						{
+							visit(value);
+						}
+						break;
+				}
+			}
+			void visit(const statement_node *node)
+			{
+				if (node == nullptr || !valid)
+				{
+					return;
+				}
+
+				switch (node->id)
+				{
+					case nodeid::compound_statement:
+						for (auto statement : static_cast<const compound_statement_node *>(node)->statement_list)
+						{
+							visit(statement);
+						}
+						break;
+					case nodeid::declarator_list:
+						for (auto declarator : static_cast<const declarator_list_node *>(node)->declarator_list)
+						{
+							visit(declarator->initializer_expression);
+						}
+						break;
+					case nodeid::expression_statement:
+						visit(static_cast<const expression_statement_node *>(node)->expression);
+						break;
+					case nodeid::if_statement:
+						visit(static_cast<const if_statement_node *>(node)->condition);
+						visit(static_cast<const if_statement_node *>(node)->statement_when_true);
+						visit(static_cast<const if_statement_node *>(node)->statement_when_false);
+						break;
+					case nodeid::switch_statement:
+						visit(static_cast<const switch_statement_node *>(node)->test_expression);
+						for (auto casestatement : static_cast<const switch_statement_node *>(node)->case_list)
+						{
+							visit(casestatement->statement_list);
+						}
+						break;
+					case nodeid::for_statement:
+						visit(static_cast<const for_statement_node *>(node)->init_statement);
+						visit(static_cast<const for_statement_node *>(node)->condition);
+						visit(static_cast<const for_statement_node *>(node)->increment_expression);
+						visit(static_cast<const for_statement_node *>(node)->statement_list);
+						break;
+					case nodeid::while_statement:
+						visit(static_cast<const while_statement_node *>(node)->condition);
+						visit(static_cast<const while_statement_node *>(node)->statement_list);
+						break;
+					case nodeid::return_statement:
+						visit(static_cast<const return_statement_node *>(node)->return_value);
+						break;
+				}
+			}
+
+			bool valid = true;
+			const variable_declaration_node *input = nullptr;
+			std::unordered_set<const function_declaration_node *> callees;
+
+		private:
+			bool is_input_sample(const intrinsic_expression_node *node)
+			{
+				if (node->arguments[0]->id != nodeid::lvalue_expression || node->arguments[1]->id != nodeid::lvalue_expression || static_cast<const lvalue_expression_node *>(node->arguments[1])->reference != _texcoord)
+				{
+					return false;
+				}
+
+				const auto sampler = static_cast<const lvalue_expression_node *>(node->arguments[0])->reference;
+				const auto texture = sampler->properties.texture;
+
+				if (!sampler->type.is_sampler() || texture == nullptr || (texture->semantic != "COLOR" && texture->semantic != "SV_TARGET") || (input != nullptr && input != sampler))
+				{
+					return false;
+				}
+
+				input = sampler;
+
+				return true;
+			}
+			void check_not_modified(const expression_node *node)
+			{
+				while (true)
+				{
+					if (node->id == nodeid::swizzle_expression)
+					{
+						node = static_cast<const swizzle_expression_node *>(node)->operand;
+					}
+					else if (node->id == nodeid::field_expression)
+					{
+						node = static_cast<const field_expression_node *>(node)->operand;
+					}
+					else if (node->id == nodeid::binary_expression && static_cast<const binary_expression_node *>(node)->op == binary_expression_node::element_extract)
+					{
+						node = static_cast<const binary_expression_node *>(node)->operands[0];
+					}
+					else
+					{
+						break;
+					}
+				}
+
+				if (node->id == nodeid::lvalue_expression && static_cast<const lvalue_expression_node *>(node)->reference == _texcoord)
+				{
+					valid = false;
+				}
+			}
+
+			const variable_declaration_node *_texcoord;
+		};
+	}
+
+	optimizer_statistics optimize(syntax_tree &ast)
+	{
+		optimizer_statistics stats;
+		constant_propagation propagation(ast, stats);
+
+		for (auto variable : ast.variables)
+		{
+			if (!variable->type.has_qualifier(type_node::qualifier_uniform))
+			{
+				variable->initializer_expression = propagation.visit(variable->initializer_expression);
+			}
+		}
+		for (auto function : ast.functions)
+		{
+			propagation.visit(static_cast<statement_node *>(function->definition));
+		}
+
+		reference_collector references;
+
+		for (auto variable : ast.variables)
+		{
+			if (variable->type.has_qualifier(type_node::qualifier_uniform) || variable->type.is_texture() || variable->type.is_sampler())
+			{
+				references.visit(variable);
+			}
+		}
+		for (auto technique : ast.techniques)
+		{
+			for (auto pass : technique->pass_list)
+			{
+				references.visit(pass->vertex_shader);
+				references.visit(pass->pixel_shader);
+			}
+		}
+
+		const auto function_end = std::remove_if(ast.functions.begin(), ast.functions.end(),
+			[&references](const function_declaration_node *function) {
+				return references.functions.count(function) == 0;
+			});
+		stats.removed_functions = static_cast<unsigned int>(std::distance(function_end, ast.functions.end()));
+		ast.functions.erase(function_end, ast.functions.end());
+
+		const auto variable_end = std::remove_if(ast.variables.begin(), ast.variables.end(),
+			[&references](const variable_declaration_node *variable) {
+				return !variable->type.has_qualifier(type_node::qualifier_uniform) && !variable->type.is_texture() && !variable->type.is_sampler() && references.variables.count(variable) == 0;
+			});
+		stats.removed_variables = static_cast<unsigned int>(std::distance(variable_end, ast.variables.end()));
+		ast.variables.erase(variable_end, ast.variables.end());
+
+		return stats;
+	}
+
+	void find_references(const function_declaration_node *entry_point, std::unordered_set<const variable_declaration_node *> &variables)
+	{
+		reference_collector references;
+		references.visit(entry_point);
+
+		variables.insert(references.variables.begin(), references.variables.end());
+	}
+	void find_references(const function_declaration_node *entry_point, std::unordered_set<const variable_declaration_node *> &variables, std::unordered_set<const function_declaration_node *> &functions)
+	{
+		reference_collector references;
+		references.visit(entry_point);
+
+		variables.insert(references.variables.begin(), references.variables.end());
+		functions.insert(references.functions.begin(), references.functions.end());
+	}
+
+	const variable_declaration_node *find_point_wise_input(const pass_declaration_node *pass)
+	{
+		if (pass->vertex_shader == nullptr || pass->pixel_shader == nullptr || pass->blend_enable || pass->stencil_enable || pass->color_write_mask != 0xF)
+		{
+			return nullptr;
+		}
+
+		for (auto target : pass->render_targets)
+		{
+			if (target != nullptr)
+			{
+				return nullptr;
+			}
+		}
+
+		reference_collector vertex_shader_references;
+		vertex_shader_references.visit(pass->vertex_shader);
+
+		if (vertex_shader_references.functions.size() != 1 || !is_full_screen_vertex_shader(pass->vertex_shader))
+		{
+			return nullptr;
+		}
+
+		// Only parameters and local variables, global variables are not part of the code that is compared to decide whether two vertex shaders are the same
+		for (auto variable : vertex_shader_references.variables)
+		{
+			if (variable->type.has_qualifier(type_node::qualifier_static) || variable->type.has_qualifier(type_node::qualifier_uniform) || variable->type.is_sampler() || variable->type.is_texture())
+			{
+				return nullptr;
+			}
+		}
+
+		const auto pixel_shader = pass->pixel_shader;
+
+		if (!is_float_vector(pixel_shader->return_type, 4) || (pixel_shader->return_semantic != "COLOR" && pixel_shader->return_semantic != "COLOR0" && pixel_shader->return_semantic != "SV_TARGET" && pixel_shader->return_semantic != "SV_TARGET0"))
+		{
+			return nullptr;
+		}
+
+		const variable_declaration_node *texcoord = nullptr;
+
+		for (auto parameter : pixel_shader->parameter_list)
+		{
+			if (parameter->type.has_qualifier(type_node::qualifier_out))
+			{
+				return nullptr;
+			}
+
+			if (is_position_semantic(parameter->semantic) && is_float_vector(parameter->type, 4))
+			{
+				continue;
+			}
+			else if (texcoord == nullptr && is_texcoord_semantic(parameter->semantic) && is_float_vector(parameter->type, 2))
+			{
+				texcoord = parameter;
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		if (texcoord == nullptr)
+		{
+			return nullptr;
+		}
+
+		point_wise_analysis analysis(texcoord);
+		analysis.visit(pixel_shader->definition);
+
+		if (!analysis.valid || analysis.input == nullptr)
+		{
+			return nullptr;
+		}
+
+		// Called functions may compute anything, as long as they do not read from a texture
+		for (auto callee : analysis.callees)
+		{
+			reference_collector references;
+			references.visit(callee);
+
+			for (auto variable : references.variables)
+			{
+				if (variable->type.is_sampler() || variable->type.is_texture())
+				{
+					return nullptr;
+				}
+			}
+		}
+
+		// Chaining the color in the shader only matches writing and reading it through the back buffer if both use the same color space
+		if (analysis.input->properties.srgb_texture != pass->srgb_write_enable)
+		{
+			return nullptr;
+		}
+
+		return analysis.input;
+	}
+}
@@ -0,0 +1,58 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <unordered_set>
+
+namespace reshadefx
+{
+	#pragma region Forward Declarations
+	class syntax_tree;
+
+	namespace nodes
+	{
+		struct variable_declaration_node;
+		struct function_declaration_node;
+		struct pass_declaration_node;
+	}
+	#pragma endregion
+
+	struct optimizer_statistics
+	{
+		unsigned int folded_expressions = 0, pruned_branches = 0, removed_functions = 0, removed_variables = 0;
+	};
+
+	/// <summary>
+	/// Optimize a parsed effect after uniforms were turned into constants. Propagates constants into all expressions, removes branches and loops whose condition became constant
+	/// and finally removes functions and static variables that are no longer reachable from any technique. Uniforms, textures and samplers are always kept, since they are visible to the user.
+	/// </summary>
+	/// <param name="ast">The syntax tree to optimize in place.</param>
+	/// <returns>A summary of what was changed.</returns>
+	optimizer_statistics optimize(syntax_tree &ast);
+
+	/// <summary>
+	/// Collect the variables an entry point references, directly or through any function it calls. Samplers additionally reference the texture they read from.
+	/// </summary>
+	/// <param name="entry_point">The function to start at. Can be <c>nullptr</c>, in which case nothing is added.</param>
+	/// <param name="variables">Receives the referenced variables, in addition to those it contains already.</param>
+	void find_references(const nodes::function_declaration_node *entry_point, std::unordered_set<const nodes::variable_declaration_node *> &variables);
+	/// <summary>
+	/// Collect the variables and functions an entry point references, directly or through any function it calls. The entry point itself is added to the functions.
+	/// </summary>
+	/// <param name="entry_point">The function to start at. Can be <c>nullptr</c>, in which case nothing is added.</param>
+	/// <param name="variables">Receives the referenced variables, in addition to those it contains already.</param>
+	/// <param name="functions">Receives the called functions, in addition to those it contains already.</param>
+	void find_references(const nodes::function_declaration_node *entry_point, std::unordered_set<const nodes::variable_declaration_node *> &variables, std::unordered_set<const nodes::function_declaration_node *> &functions);
+
+	/// <summary>
+	/// Check whether a pass is point-wise, i.e. it only writes the back buffer and computes each pixel from nothing but the back buffer color at that same pixel (and any uniforms).
+	/// Consecutive point-wise passes can be evaluated one after another in a single pixel shader without changing the result. Their vertex shader must not reference any global variables
+	/// or call other functions, so that passes whose vertex shaders compile to the same code are guaranteed to receive the same texture coordinates.
+	/// </summary>
+	/// <param name="pass">The pass to check.</param>
+	/// <returns>The sampler through which the pixel shader reads the back buffer, or <c>nullptr</c> if the pass is not point-wise.</returns>
+	const nodes::variable_declaration_node *find_point_wise_input(const nodes::pass_declaration_node *pass);
+}
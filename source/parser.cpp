@@ -6,6 +6,7 @@
 #include "parser.hpp"
 #include "symbol_table.hpp"
 #include "constant_folding.hpp"
+#include <iterator>
 #include <algorithm>
 
 namespace reshadefx
@@ -1324,7 +1325,7 @@ namespace reshadefx
 					newexpression->type = callexpression->type;
 					newexpression->op = static_cast<enum intrinsic_expression_node::op>(callexpression->callee_name[0]);
 
-					for (size_t i = 0, count = std::min(callexpression->arguments.size(), _countof(newexpression->arguments)); i < count; ++i)
+					for (size_t i = 0, count = std::min(callexpression->arguments.size(), std::size(newexpression->arguments)); i < count; ++i)
 					{
 						newexpression->arguments[i] = callexpression->arguments[i];
 					}
@@ -2819,7 +2820,7 @@ namespace reshadefx
 				return false;
 			}
 
-			const auto parameter = _ast.make_node<variable_declaration_node>(struct location());
+			const auto parameter = _ast.make_node<variable_declaration_node>(reshadefx::location());
 
 			if (!parse_type(parameter->type))
 			{
@@ -0,0 +1,278 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "pe_exports.hpp"
+#include <cstring>
+#include <algorithm>
+
+namespace reshade::pe
+{
+	namespace
+	{
+		/// <summary>
+		/// Reads little-endian values from an image buffer and translates relative virtual addresses to offsets into it, failing instead of reading past its end.
+		/// </summary>
+		class image_reader
+		{
+		public:
+			image_reader(const uint8_t *image, size_t size, image_layout layout) : _image(image), _size(size), _layout(layout) { }
+
+			bool read(size_t offset, uint16_t &value) const
+			{
+				if (!contains(offset, 2))
+				{
+					return false;
+				}
+
+				value = static_cast<uint16_t>(_image[offset] | (_image[offset + 1] << 8));
+
+				return true;
+			}
+			bool read(size_t offset, uint32_t &value) const
+			{
+				if (!contains(offset, 4))
+				{
+					return false;
+				}
+
+				value = static_cast<uint32_t>(_image[offset]) | (static_cast<uint32_t>(_image[offset + 1]) << 8) | (static_cast<uint32_t>(_image[offset + 2]) << 16) | (static_cast<uint32_t>(_image[offset + 3]) << 24);
+
+				return true;
+			}
+			bool read_string(size_t offset, const char *&value) const
+			{
+				// The string has to be terminated within the buffer
+				if (offset >= _size || std::memchr(_image + offset, '\0', _size - offset) == nullptr)
+				{
+					return false;
+				}
+
+				value = reinterpret_cast<const char *>(_image + offset);
+
+				return true;
+			}
+
+			bool contains(size_t offset, size_t length) const
+			{
+				return offset <= _size && length <= _size - offset;
+			}
+
+			bool load_sections(size_t offset, uint16_t count)
+			{
+				_sections.clear();
+				_sections.reserve(count);
+
+				for (uint16_t i = 0; i < count; i++, offset += 40)
+				{
+					section section;
+
+					if (!read(offset + 12, section.virtual_address) || !read(offset + 16, section.raw_size) || !read(offset + 20, section.raw_offset))
+					{
+						return false;
+					}
+
+					_sections.push_back(section);
+				}
+
+				return true;
+			}
+			bool rva_to_offset(uint32_t rva, size_t &offset) const
+			{
+				if (_layout == image_layout::mapped)
+				{
+					offset = rva;
+
+					return true;
+				}
+
+				for (const auto &section : _sections)
+				{
+					if (rva >= section.virtual_address && rva - section.virtual_address < section.raw_size)
+					{
+						offset = static_cast<size_t>(section.raw_offset) + (rva - section.virtual_address);
+
+						return true;
+					}
+				}
+
+				return false;
+			}
+
+		private:
+			struct section
+			{
+				uint32_t virtual_address, raw_size, raw_offset;
+			};
+
+			const uint8_t *_image;
+			size_t _size;
+			image_layout _layout;
+			std::vector<section> _sections;
+		};
+
+		inline bool compare_names(const export_symbol &lhs, const export_symbol &rhs)
+		{
+			return std::strcmp(lhs.name, rhs.name) < 0;
+		}
+
+		bool parse_exports(image_reader &reader, std::vector<export_symbol> &exports)
+		{
+			uint16_t dos_magic = 0;
+			uint32_t nt_offset = 0, nt_signature = 0;
+
+			if (!reader.read(0, dos_magic) || dos_magic != 0x5A4D || !reader.read(0x3C, nt_offset) || !reader.read(nt_offset, nt_signature) || nt_signature != 0x00004550)
+			{
+				return false;
+			}
+
+			const size_t file_header_offset = static_cast<size_t>(nt_offset) + 4, optional_header_offset = file_header_offset + 20;
+			uint16_t section_count = 0, optional_header_size = 0, optional_magic = 0;
+
+			if (!reader.read(file_header_offset + 2, section_count) || !reader.read(file_header_offset + 16, optional_header_size) || !reader.read(optional_header_offset, optional_magic))
+			{
+				return false;
+			}
+
+			// The data directories start at a different offset in PE32 and PE32+ images, because the image base and the stack and heap sizes are 64-bit in the latter
+			size_t data_directory_offset = 0;
+
+			switch (optional_magic)
+			{
+			case 0x10B:
+				data_directory_offset = optional_header_offset + 96;
+				break;
+			case 0x20B:
+				data_directory_offset = optional_header_offset + 112;
+				break;
+			default:
+				return false;
+			}
+
+			uint32_t data_directory_count = 0, export_directory_rva = 0, export_directory_size = 0;
+
+			if (!reader.read(data_directory_offset - 4, data_directory_count) || !reader.load_sections(optional_header_offset + optional_header_size, section_count))
+			{
+				return false;
+			}
+
+			if (data_directory_count == 0)
+			{
+				return true;
+			}
+
+			if (!reader.read(data_directory_offset, export_directory_rva) || !reader.read(data_directory_offset + 4, export_directory_size))
+			{
+				return false;
+			}
+
+			if (export_directory_rva == 0 || export_directory_size == 0)
+			{
+				return true;
+			}
+
+			size_t export_directory_offset = 0;
+			uint32_t base = 0, function_count = 0, name_count = 0, functions_rva = 0, names_rva = 0, ordinals_rva = 0;
+
+			if (!reader.rva_to_offset(export_directory_rva, export_directory_offset) ||
+				!reader.read(export_directory_offset + 16, base) ||
+				!reader.read(export_directory_offset + 20, function_count) ||
+				!reader.read(export_directory_offset + 24, name_count) ||
+				!reader.read(export_directory_offset + 28, functions_rva) ||
+				!reader.read(export_directory_offset + 32, names_rva) ||
+				!reader.read(export_directory_offset + 36, ordinals_rva))
+			{
+				return false;
+			}
+
+			if (function_count == 0 || name_count == 0)
+			{
+				return true;
+			}
+
+			size_t functions_offset = 0, names_offset = 0, ordinals_offset = 0;
+
+			if (!reader.rva_to_offset(functions_rva, functions_offset) || !reader.contains(functions_offset, function_count * size_t(4)) ||
+				!reader.rva_to_offset(names_rva, names_offset) || !reader.contains(names_offset, name_count * size_t(4)) ||
+				!reader.rva_to_offset(ordinals_rva, ordinals_offset) || !reader.contains(ordinals_offset, name_count * size_t(2)))
+			{
+				return false;
+			}
+
+			exports.reserve(name_count);
+
+			for (uint32_t i = 0; i < name_count; i++)
+			{
+				export_symbol symbol;
+				uint16_t index = 0;
+				uint32_t name_rva = 0;
+				size_t name_offset = 0;
+
+				if (!reader.read(ordinals_offset + i * size_t(2), index) || index >= function_count ||
+					!reader.read(functions_offset + index * size_t(4), symbol.rva) ||
+					!reader.read(names_offset + i * size_t(4), name_rva) ||
+					!reader.rva_to_offset(name_rva, name_offset) || !reader.read_string(name_offset, symbol.name))
+				{
+					return false;
+				}
+
+				symbol.ordinal = static_cast<uint16_t>(index + base);
+				// Forwarded exports point to a string like "NTDLL.RtlAllocateHeap" inside of the export directory instead of to code
+				symbol.forwarded = symbol.rva >= export_directory_rva && symbol.rva - export_directory_rva < export_directory_size;
+
+				exports.push_back(symbol);
+			}
+
+			// The loader binary searches the name table, so linkers emit it sorted already and this is only a linear check
+			if (!std::is_sorted(exports.begin(), exports.end(), compare_names))
+			{
+				std::stable_sort(exports.begin(), exports.end(), compare_names);
+			}
+
+			return true;
+		}
+	}
+
+	bool get_exports(const uint8_t *image, size_t size, image_layout layout, std::vector<export_symbol> &exports)
+	{
+		exports.clear();
+
+		image_reader reader(image, size, layout);
+
+		if (!parse_exports(reader, exports))
+		{
+			exports.clear();
+
+			return false;
+		}
+
+		return true;
+	}
+
+	std::vector<std::pair<size_t, size_t>> match_exports(const std::vector<export_symbol> &target, const std::vector<export_symbol> &replacement)
+	{
+		std::vector<std::pair<size_t, size_t>> matches;
+		matches.reserve(std::min(target.size(), replacement.size()));
+
+		for (size_t i = 0, k = 0; i < target.size() && k < replacement.size();)
+		{
+			const int order = std::strcmp(target[i].name, replacement[k].name);
+
+			if (order < 0)
+			{
+				i++;
+			}
+			else if (order > 0)
+			{
+				k++;
+			}
+			else
+			{
+				matches.emplace_back(i++, k++);
+			}
+		}
+
+		return matches;
+	}
+}
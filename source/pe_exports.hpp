@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace reshade::pe
+{
+	/// <summary>
+	/// The layout of a PE image in memory.
+	/// </summary>
+	enum class image_layout
+	{
+		/// <summary>
+		/// The image was mapped by the loader, so relative virtual addresses are offsets into it.
+		/// </summary>
+		mapped,
+		/// <summary>
+		/// The image was read from disk as is, so relative virtual addresses have to be translated through the section table.
+		/// </summary>
+		file,
+	};
+
+	struct export_symbol
+	{
+		/// <summary>
+		/// The relative virtual address of the exported function.
+		/// </summary>
+		uint32_t rva;
+		/// <summary>
+		/// The name of the export, which points into the image buffer.
+		/// </summary>
+		const char *name;
+		/// <summary>
+		/// The biased ordinal of the export.
+		/// </summary>
+		uint16_t ordinal;
+		/// <summary>
+		/// Set if the export forwards to a function in another module, in which case <see cref="rva"/> points to the forwarder string instead of code.
+		/// </summary>
+		bool forwarded;
+	};
+
+	/// <summary>
+	/// Read the named exports of a PE32 or PE32+ image from a byte buffer. Every offset is checked against the buffer size, so a truncated or malformed image cannot cause reads outside of it.
+	/// </summary>
+	/// <param name="image">The image to parse.</param>
+	/// <param name="size">The size of the image buffer in bytes.</param>
+	/// <param name="layout">Whether the image was mapped by the loader or read from disk.</param>
+	/// <param name="exports">Receives the named exports, sorted by name.</param>
+	/// <returns>Returns <c>true</c> if the image is valid (which includes images without an export table), <c>false</c> otherwise.</returns>
+	bool get_exports(const uint8_t *image, size_t size, image_layout layout, std::vector<export_symbol> &exports);
+
+	/// <summary>
+	/// Find all exports that have the same name in both lists. Both lists have to be sorted by name like <see cref="get_exports"/> returns them, so that they can be matched in a single merge pass.
+	/// </summary>
+	/// <param name="target">The exports of the module to hook.</param>
+	/// <param name="replacement">The exports of the module that provides the hooks.</param>
+	/// <returns>The pairs of indices into <paramref name="target"/> and <paramref name="replacement"/> of the exports with matching names, in name order.</returns>
+	std::vector<std::pair<size_t, size_t>> match_exports(const std::vector<export_symbol> &target, const std::vector<export_symbol> &replacement);
+}
@@ -5,6 +5,9 @@
 
 #include "preprocessor.hpp"
 #include <fstream>
+#include <iterator>
+#include <cstring>
+#include <algorithm>
 #include <assert.h>
 
 namespace reshadefx
@@ -32,7 +35,19 @@ namespace reshadefx
 	{
 		assert(!name.empty());
 
-		return _macros.emplace(name, macro).second;
+		macro_definition definition;
+		definition.info = macro;
+		compile_macro_replacement_list(definition);
+
+		if (!_macros.emplace(name, std::move(definition)).second)
+		{
+			return false;
+		}
+
+		// Any cached expansion may refer to this name
+		_macro_generation++;
+
+		return true;
 	}
 	bool preprocessor::add_macro_definition(const std::string &name, const std::string &value)
 	{
@@ -44,7 +59,7 @@ namespace reshadefx
 
 	bool preprocessor::run(const filesystem::path &file_path)
 	{
-		std::ifstream file(file_path.wstring());
+		std::ifstream file(file_path.native());
 
 		if (!file.is_open())
 		{
@@ -90,11 +105,13 @@ namespace reshadefx
 	}
 
 	// Input management
-	lexer &preprocessor::current_lexer()
+	const std::string &preprocessor::current_input() const
 	{
 		assert(!_input_stack.empty());
 
-		return *_input_stack.top()._lexer;
+		const auto &input_level = _input_stack.top();
+
+		return input_level._lexer != nullptr ? input_level._lexer->input_string() : input_level._tokens->text;
 	}
 	std::stack<preprocessor::if_level> &preprocessor::current_if_stack()
 	{
@@ -127,6 +144,16 @@ namespace reshadefx
 
 		consume();
 	}
+	void preprocessor::push(const std::shared_ptr<const token_list> &tokens)
+	{
+		assert(!_input_stack.empty());
+
+		const auto parent = &_input_stack.top();
+
+		_input_stack.emplace(parent->_name, tokens, parent);
+
+		consume();
+	}
 	bool preprocessor::peek(lexer::tokenid token) const
 	{
 		assert(!_input_stack.empty());
@@ -138,11 +165,25 @@ namespace reshadefx
 		assert(!_input_stack.empty());
 
 		auto &input_level = _input_stack.top();
-		_token = input_level._next_token;
+		_token = std::move(input_level._next_token);
 		_token.location.source = _output_location.source;
-		_current_token_raw_data = current_lexer().input_string().substr(_token.offset, _token.length);
+		_current_token_raw_data.assign(current_input(), _token.offset, _token.length);
+
+		if (input_level._lexer != nullptr)
+		{
+			input_level._next_token = input_level._lexer->lex();
+		}
+		else if (input_level._token_index < input_level._tokens->tokens.size())
+		{
+			input_level._next_token = input_level._tokens->tokens[input_level._token_index++];
+		}
+		else
+		{
+			input_level._next_token.id = lexer::tokenid::end_of_file;
+			input_level._next_token.offset = input_level._tokens->text.size();
+			input_level._next_token.length = 0;
+		}
 
-		input_level._next_token = input_level._lexer->lex();
 		input_level._offset = input_level._next_token.offset;
 
 		// Pop input level if lexical analysis has reached the end of it
@@ -199,7 +240,7 @@ namespace reshadefx
 
 			const auto &actual_token = _input_stack.top()._next_token;
 
-			error(actual_token.location, "syntax error: unexpected token '" + current_lexer().input_string().substr(actual_token.offset, actual_token.length) + "'");
+			error(actual_token.location, "syntax error: unexpected token '" + current_input().substr(actual_token.offset, actual_token.length) + "'");
 
 			return false;
 		}
@@ -338,7 +379,7 @@ namespace reshadefx
 			return;
 		}
 
-		if (current_lexer().input_string()[macro_name_end_offset] == '(')
+		if (current_input()[macro_name_end_offset] == '(')
 		{
 			accept(lexer::tokenid::parenthesis_open);
 
@@ -394,7 +435,10 @@ namespace reshadefx
 			return;
 		}
 
-		_macros.erase(macro_name);
+		if (_macros.erase(macro_name) != 0)
+		{
+			_macro_generation++;
+		}
 	}
 	void preprocessor::parse_if()
 	{
@@ -607,7 +651,7 @@ namespace reshadefx
 
 		if (it == _filecache.end())
 		{
-			std::ifstream file(filepath.wstring());
+			std::ifstream file(filepath.native());
 
 			if (!file.is_open())
 			{
@@ -669,7 +713,7 @@ namespace reshadefx
 		// Run shunting-yard algorithm
 		while (!peek(lexer::tokenid::end_of_line))
 		{
-			if (stack_count >= _countof(stack) || rpn_count >= _countof(rpn))
+			if (stack_count >= std::size(stack) || rpn_count >= std::size(rpn))
 			{
 				error(current_token().location, "expression evaluator ran out of stack space");
 				return false;
@@ -977,10 +1021,21 @@ namespace reshadefx
 			return false;
 		}
 
-		const auto &macro = it->second;
-		std::vector<std::string> arguments;
+		auto &macro = it->second;
+
+		if (!macro.info.is_function_like)
+		{
+			if (const auto expansion = expand_object_like_macro(macro))
+			{
+				push(expansion);
+
+				return true;
+			}
+		}
+
+		std::vector<token_list> arguments;
 
-		if (macro.is_function_like)
+		if (macro.info.is_function_like)
 		{
 			if (!accept(lexer::tokenid::parenthesis_open))
 			{
@@ -990,7 +1045,8 @@ namespace reshadefx
 			while (true)
 			{
 				int parentheses_level = 0;
-				std::string argument;
+				bool is_first_token = true;
+				token_list argument;
 
 				while (true)
 				{
@@ -1007,19 +1063,25 @@ namespace reshadefx
 						break;
 					}
 
-					argument += _current_token_raw_data;
-				}
+					// A single space in front of the argument is not part of it
+					if (is_first_token && _current_token_raw_data == " ")
+					{
+						is_first_token = false;
+						continue;
+					}
 
-				if (!argument.empty() && argument.back() == ' ')
-				{
-					argument.pop_back();
+					is_first_token = false;
+
+					append_token(argument, current_token(), _current_token_raw_data.data(), _current_token_raw_data.size(), false);
 				}
-				if (!argument.empty() && argument.front() == ' ')
+
+				if (!argument.tokens.empty() && argument.tokens.back() == lexer::tokenid::space && argument.text.back() == ' ')
 				{
-					argument.erase(0, 1);
+					argument.text.pop_back();
+					argument.tokens.pop_back();
 				}
 
-				arguments.push_back(argument);
+				arguments.push_back(std::move(argument));
 
 				if (parentheses_level < 0)
 				{
@@ -1028,50 +1090,179 @@ namespace reshadefx
 			}
 		}
 
-		std::string input;
-		expand_macro(it->second, arguments, input);
+		const auto expansion = std::make_shared<token_list>();
+		expand_macro(macro, arguments, *expansion);
 
-		push(input);
+		push(expansion);
 
 		return true;
 	}
 
 	// Macro management routines
-	void preprocessor::expand_macro(const macro &macro, const std::vector<std::string> &arguments, std::string &out)
+	void preprocessor::expand_macro(const macro_definition &macro, const std::vector<token_list> &arguments, token_list &out)
+	{
+		size_t expected_size = out.tokens.size();
+
+		for (const auto &piece : macro.replacement)
+		{
+			expected_size += piece.type == macro_replacement_start ? piece.text.tokens.size() : arguments.at(piece.argument).tokens.size();
+		}
+
+		out.tokens.reserve(expected_size);
+
+		for (const auto &piece : macro.replacement)
+		{
+			switch (piece.type)
+			{
+				case macro_replacement_start:
+					append_list(out, piece.text, false);
+					break;
+				case macro_replacement_stringize:
+					out.join_next = true;
+					append_relexed(out, '"' + arguments.at(piece.argument).text + '"', true);
+					break;
+				case macro_replacement_argument:
+					out.join_next = true;
+					expand_argument(arguments.at(piece.argument), out);
+					break;
+			}
+		}
+
+		out.join_next = false;
+	}
+	void preprocessor::expand_argument(const token_list &argument, token_list &out)
 	{
-		for (auto it = macro.replacement_list.begin(); it != macro.replacement_list.end(); ++it)
+		bool is_cached = true;
+
+		for (const auto &token : argument.tokens)
 		{
-			if (*it == macro_replacement_start)
+			if (token == lexer::tokenid::unknown)
 			{
-				switch (*++it)
+				is_cached = false;
+				break;
+			}
+
+			if (token == lexer::tokenid::identifier)
+			{
+				const auto it = _macros.find(token.literal_as_string);
+
+				if (it != _macros.end() && (it->second.info.is_function_like || expand_object_like_macro(it->second) == nullptr))
 				{
-					case macro_replacement_concat:
-						continue;
-					case macro_replacement_stringize:
-						out += '"' + arguments.at(*++it) + '"';
-						break;
-					case macro_replacement_argument:
-						push(arguments.at(*++it) + static_cast<char>(macro_replacement_argument));
-						while (!accept(lexer::tokenid::unknown))
-						{
-							consume();
+					is_cached = false;
+					break;
+				}
+			}
+		}
 
-							if (current_token() == lexer::tokenid::identifier && evaluate_identifier_as_macro())
-							{
-								continue;
-							}
+		// An argument that only refers to object-like macros is assembled from their cached expansions, without going through the input stack
+		// This produces the same result as the loop below, which drops all whitespace between the tokens of an argument
+		if (is_cached)
+		{
+			for (const auto &token : argument.tokens)
+			{
+				const auto it = token == lexer::tokenid::identifier ? _macros.find(token.literal_as_string) : _macros.end();
 
-							out += _current_token_raw_data;
-						}
-						assert(_current_token_raw_data[0] == macro_replacement_argument);
-						break;
+				if (it == _macros.end())
+				{
+					if (token != lexer::tokenid::space)
+					{
+						append_token(out, token, argument.text.data() + token.offset, token.length);
+					}
+					continue;
+				}
+
+				const auto &expansion = *it->second.expansion;
+
+				for (const auto &expanded_token : expansion.tokens)
+				{
+					if (expanded_token != lexer::tokenid::space)
+					{
+						append_token(out, expanded_token, expansion.text.data() + expanded_token.offset, expanded_token.length);
+					}
 				}
 			}
-			else
+
+			return;
+		}
+
+		const auto input = std::make_shared<token_list>(argument);
+
+		// Terminate the argument with a token that cannot appear in the input, so that expansion stops at its end
+		lexer::token terminator;
+		terminator.id = lexer::tokenid::unknown;
+		terminator.literal_as_double = 0;
+		const char terminator_data = macro_replacement_argument;
+		append_token(*input, terminator, &terminator_data, 1, false);
+
+		push(input);
+
+		while (!accept(lexer::tokenid::unknown))
+		{
+			consume();
+
+			if (current_token() == lexer::tokenid::identifier && evaluate_identifier_as_macro())
+			{
+				continue;
+			}
+
+			append_token(out, current_token(), _current_token_raw_data.data(), _current_token_raw_data.size());
+		}
+
+		assert(_current_token_raw_data[0] == macro_replacement_argument);
+	}
+	std::shared_ptr<const preprocessor::token_list> preprocessor::expand_object_like_macro(macro_definition &macro, unsigned int depth)
+	{
+		if (macro.expansion_generation == _macro_generation)
+		{
+			return macro.expansion;
+		}
+
+		// Mark the macro as visited before descending, so that a recursive definition is never cached and keeps being expanded one level at a time
+		macro.expansion.reset();
+		macro.expansion_generation = _macro_generation;
+
+		token_list replacement;
+		expand_macro(macro, std::vector<token_list>(), replacement);
+
+		const auto expansion = std::make_shared<token_list>();
+
+		for (const auto &token : replacement.tokens)
+		{
+			if (token == lexer::tokenid::identifier)
+			{
+				const auto it = _macros.find(token.literal_as_string);
+
+				if (it != _macros.end())
+				{
+					// Function-like macros may take their arguments from text following the expansion, so anything referring to them is expanded on every use
+					if (it->second.info.is_function_like || depth >= 256)
+					{
+						return nullptr;
+					}
+
+					const auto nested_expansion = expand_object_like_macro(it->second, depth + 1);
+
+					if (nested_expansion == nullptr)
+					{
+						return nullptr;
+					}
+
+					append_list(*expansion, *nested_expansion, true);
+					continue;
+				}
+			}
+			else if (token == lexer::tokenid::unknown)
 			{
-				out += *it;
+				// Unknown tokens terminate argument expansion (see 'expand_argument'), so keep them out of the cache
+				return nullptr;
 			}
+
+			append_token(*expansion, token, replacement.text.data() + token.offset, token.length, false);
 		}
+
+		macro.expansion = expansion;
+
+		return expansion;
 	}
 	void preprocessor::create_macro_replacement_list(macro &macro)
 	{
@@ -1152,4 +1343,126 @@ namespace reshadefx
 			macro.replacement_list += _current_token_raw_data;
 		}
 	}
+	void preprocessor::compile_macro_replacement_list(macro_definition &macro)
+	{
+		const auto &replacement_list = macro.info.replacement_list;
+		std::string text;
+
+		for (size_t i = 0; i <= replacement_list.size(); i++)
+		{
+			if (i < replacement_list.size() && replacement_list[i] != macro_replacement_start)
+			{
+				text += replacement_list[i];
+				continue;
+			}
+
+			// Lex each run of text only once here, instead of every time the macro is expanded
+			if (!text.empty())
+			{
+				replacement_piece piece;
+				piece.type = macro_replacement_start;
+				piece.argument = 0;
+				append_relexed(piece.text, text, false);
+
+				macro.replacement.push_back(std::move(piece));
+
+				text.clear();
+			}
+
+			if (i + 1 >= replacement_list.size())
+			{
+				break;
+			}
+
+			// The concatenation operator only separates two runs, which are joined at the seam during expansion
+			if (replacement_list[++i] != macro_replacement_concat)
+			{
+				replacement_piece piece;
+				piece.type = replacement_list[i];
+				piece.argument = static_cast<unsigned char>(replacement_list[++i]);
+
+				macro.replacement.push_back(std::move(piece));
+			}
+		}
+	}
+
+	void preprocessor::append_token(token_list &list, const lexer::token &token, const char *raw_data, size_t raw_length, bool normalize_whitespace)
+	{
+		// The token directly follows the last one in the text, so the two may have to be lexed together (e.g. to implement the ## operator)
+		if (list.join_next)
+		{
+			list.join_next = false;
+
+			if (!list.tokens.empty() && raw_length != 0 &&
+				token != lexer::tokenid::space && token != lexer::tokenid::end_of_line && list.tokens.back() != lexer::tokenid::space && list.tokens.back() != lexer::tokenid::end_of_line &&
+				std::strchr("()[]{},;", list.text.back()) == nullptr && std::strchr("()[]{},;", raw_data[0]) == nullptr)
+			{
+				std::string text = list.text.substr(list.tokens.back().offset);
+				text.append(raw_data, raw_length);
+
+				list.text.resize(list.tokens.back().offset);
+				list.tokens.pop_back();
+
+				append_relexed(list, text, normalize_whitespace);
+				return;
+			}
+		}
+
+		// Whitespace is treated like the lexer would treat it if the whole text of the list was lexed at once: It is dropped at the start of a line and in front of a line break and consecutive whitespace is collapsed
+		if (normalize_whitespace)
+		{
+			if (token == lexer::tokenid::space)
+			{
+				if (list.tokens.empty() || list.tokens.back() == lexer::tokenid::space || list.tokens.back() == lexer::tokenid::end_of_line)
+				{
+					return;
+				}
+			}
+			else if (token == lexer::tokenid::end_of_line && !list.tokens.empty() && list.tokens.back() == lexer::tokenid::space)
+			{
+				list.text.resize(list.tokens.back().offset);
+				list.tokens.pop_back();
+			}
+		}
+
+		// The source file name is not copied, since it is replaced with the current one when the token is consumed anyway
+		list.tokens.emplace_back();
+		auto &stored_token = list.tokens.back();
+		stored_token.id = token.id;
+		stored_token.location.line = list.line;
+		stored_token.location.column = static_cast<unsigned int>(list.text.size() - list.line_offset + 1);
+		stored_token.offset = list.text.size();
+		stored_token.length = raw_length;
+		stored_token.literal_as_double = token.literal_as_double;
+		stored_token.literal_as_string = token.literal_as_string;
+
+		list.text.append(raw_data, raw_length);
+
+		if (token == lexer::tokenid::end_of_line)
+		{
+			list.line++;
+			list.line_offset = list.text.size();
+		}
+	}
+	void preprocessor::append_relexed(token_list &list, const std::string &text, bool normalize_whitespace)
+	{
+		// Lex the text behind a separator, so that its start is not mistaken for the start of a line
+		lexer lexer(';' + text, false, false, true, false);
+		lexer.lex();
+
+		for (auto token = lexer.lex(); token != lexer::tokenid::end_of_file; token = lexer.lex())
+		{
+			append_token(list, token, lexer.input_string().data() + token.offset, token.length, normalize_whitespace);
+		}
+	}
+	void preprocessor::append_list(token_list &list, const token_list &tokens, bool is_separate_input)
+	{
+		// Tokens from the same input are adjacent in the text, while separate inputs are lexed on their own
+		list.join_next = !is_separate_input;
+
+		for (const auto &token : tokens.tokens)
+		{
+			append_token(list, token, tokens.text.data() + token.offset, token.length, !is_separate_input);
+		}
+	}
 }
@@ -42,6 +42,40 @@ namespace reshadefx
 			bool value, skipping;
 			if_level *parent;
 		};
+		/// <summary>
+		/// A sequence of already lexed tokens together with the text they refer to.
+		/// </summary>
+		struct token_list
+		{
+			std::string text;
+			std::vector<lexer::token> tokens;
+			unsigned int line = 1;
+			size_t line_offset = 0;
+			/// <summary>
+			/// Set when the next token that is appended directly follows the last one in the text, rather than coming from a separate input.
+			/// </summary>
+			bool join_next = false;
+		};
+		/// <summary>
+		/// A part of a macro replacement list: Either a run of tokens or a reference to an argument (see 'macro_replacement').
+		/// </summary>
+		struct replacement_piece
+		{
+			char type;
+			unsigned char argument;
+			token_list text;
+		};
+		struct macro_definition
+		{
+			macro info;
+			std::vector<replacement_piece> replacement;
+			/// <summary>
+			/// The fully expanded replacement list of an object-like macro, or <c>nullptr</c> if it depends on a function-like macro.
+			/// Only valid as long as <see cref="expansion_generation"/> matches the current macro generation.
+			/// </summary>
+			std::shared_ptr<const token_list> expansion;
+			unsigned int expansion_generation = 0;
+		};
 		struct input_level
 		{
 			input_level(const std::string &name, const std::string &text, input_level *parent) :
@@ -52,9 +86,20 @@ namespace reshadefx
 				_next_token.id = lexer::tokenid::unknown;
 				_next_token.offset = _next_token.length = 0;
 			}
+			input_level(const std::string &name, const std::shared_ptr<const token_list> &tokens, input_level *parent) :
+				_name(name),
+				_tokens(tokens),
+				_token_index(0),
+				_parent(parent)
+			{
+				_next_token.id = lexer::tokenid::unknown;
+				_next_token.offset = _next_token.length = 0;
+			}
 
 			std::string _name;
 			std::unique_ptr<lexer> _lexer;
+			std::shared_ptr<const token_list> _tokens;
+			size_t _token_index;
 			lexer::token _next_token;
 			size_t _offset;
 			std::stack<if_level> _if_stack;
@@ -64,11 +109,12 @@ namespace reshadefx
 		void error(const location &location, const std::string &message);
 		void warning(const location &location, const std::string &message);
 
-		lexer &current_lexer();
-		inline lexer::token current_token() const { return _token; }
+		const std::string &current_input() const;
+		inline const lexer::token &current_token() const { return _token; }
 		std::stack<if_level> &current_if_stack();
 		if_level &current_if_level();
 		void push(const std::string &input, const std::string &name = std::string());
+		void push(const std::shared_ptr<const token_list> &tokens);
 		bool peek(lexer::tokenid token) const;
 		void consume();
 		void consume_until(lexer::tokenid token);
@@ -92,8 +138,15 @@ namespace reshadefx
 		bool evaluate_expression();
 		bool evaluate_identifier_as_macro();
 
-		void expand_macro(const macro &macro, const std::vector<std::string> &arguments, std::string &out);
+		void expand_macro(const macro_definition &macro, const std::vector<token_list> &arguments, token_list &out);
+		void expand_argument(const token_list &argument, token_list &out);
+		std::shared_ptr<const token_list> expand_object_like_macro(macro_definition &macro, unsigned int depth = 0);
 		void create_macro_replacement_list(macro &macro);
+		static void compile_macro_replacement_list(macro_definition &macro);
+
+		static void append_token(token_list &list, const lexer::token &token, const char *raw_data, size_t raw_length, bool normalize_whitespace = true);
+		static void append_relexed(token_list &list, const std::string &text, bool normalize_whitespace);
+		static void append_list(token_list &list, const token_list &tokens, bool is_separate_input);
 
 		bool _success = true;
 		lexer::token _token;
@@ -101,7 +154,8 @@ namespace reshadefx
 		location _output_location;
 		std::string _output, _errors, _current_token_raw_data;
 		int _recursion_count = 0;
-		std::unordered_map<std::string, macro> _macros;
+		std::unordered_map<std::string, macro_definition> _macros;
+		unsigned int _macro_generation = 1;
 		std::vector<std::string> _pragmas;
 		std::vector<reshade::filesystem::path> _include_paths;
 		std::unordered_map<std::string, std::string> _filecache;
@@ -0,0 +1,158 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "preset_writer.hpp"
+#include "ini_file.hpp"
+
+namespace reshade
+{
+	preset_writer::~preset_writer()
+	{
+		{ const std::lock_guard<std::mutex> lock(_mutex);
+			_exit = true;
+		}
+
+		_signal.notify_all();
+
+		if (_thread.joinable())
+		{
+			_thread.join();
+		}
+
+		// Anything still recorded (e.g. because the thread was never started) is written before the preset is lost
+		flush();
+	}
+
+	void preset_writer::queue(const filesystem::path &path, values changes)
+	{
+		{ const std::lock_guard<std::mutex> lock(_mutex);
+			_requests++;
+
+			auto &entry = _pending[path.string()];
+			entry.deadline = std::chrono::steady_clock::now() + _quiet_period;
+
+			for (auto &section : changes)
+			{
+				auto &target = entry.changes[section.first];
+
+				for (auto &value : section.second)
+				{
+					target[value.first] = std::move(value.second);
+				}
+			}
+
+			if (!_thread.joinable() && !_exit)
+			{
+				_thread = std::thread(&preset_writer::run, this);
+			}
+		}
+
+		_signal.notify_all();
+	}
+	void preset_writer::flush()
+	{
+		// Holding the write lock while taking the recorded changes keeps writes to the same file in the order they were recorded
+		const std::lock_guard<std::mutex> write_lock(_write_mutex);
+
+		std::unordered_map<std::string, pending> recorded;
+
+		{ const std::lock_guard<std::mutex> lock(_mutex);
+			recorded.swap(_pending);
+		}
+
+		for (const auto &entry : recorded)
+		{
+			write(entry.first, entry.second.changes);
+		}
+	}
+
+	size_t preset_writer::requests() const
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+
+		return _requests;
+	}
+	size_t preset_writer::writes() const
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+
+		return _writes;
+	}
+
+	void preset_writer::run()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		while (!_exit)
+		{
+			if (_pending.empty())
+			{
+				_signal.wait(lock);
+				continue;
+			}
+
+			auto due = _pending.begin();
+
+			for (auto it = _pending.begin(); it != _pending.end(); ++it)
+			{
+				if (it->second.deadline < due->second.deadline)
+				{
+					due = it;
+				}
+			}
+
+			// Every new change to a preset pushes its deadline back, so this wakes up again until the preset was left alone for the whole quiet period
+			const auto deadline = due->second.deadline;
+
+			if (std::chrono::steady_clock::now() < deadline)
+			{
+				_signal.wait_until(lock, deadline);
+				continue;
+			}
+
+			const std::string path = due->first;
+
+			lock.unlock();
+
+			{ const std::lock_guard<std::mutex> write_lock(_write_mutex);
+				values changes;
+
+				{ const std::lock_guard<std::mutex> relock(_mutex);
+					const auto it = _pending.find(path);
+
+					// A flush may have written the changes in the meantime already
+					if (it != _pending.end())
+					{
+						changes.swap(it->second.changes);
+						_pending.erase(it);
+					}
+				}
+
+				if (!changes.empty())
+				{
+					write(path, changes);
+				}
+			}
+
+			lock.lock();
+		}
+	}
+	void preset_writer::write(const filesystem::path &path, const values &changes)
+	{
+		{ ini_file preset(path);
+
+			for (const auto &section : changes)
+			{
+				for (const auto &value : section.second)
+				{
+					preset.set(section.first, value.first, value.second);
+				}
+			}
+		}
+
+		const std::lock_guard<std::mutex> lock(_mutex);
+		_writes++;
+	}
+}
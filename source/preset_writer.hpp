@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <condition_variable>
+#include "variant.hpp"
+#include "filesystem.hpp"
+
+namespace reshade
+{
+	/// <summary>
+	/// Writes presets on a background thread. Changes are recorded in memory and only written once a preset has not been changed for a while, so that e.g. dragging a slider results in one write instead of one per frame.
+	/// </summary>
+	class preset_writer
+	{
+	public:
+		/// <summary>
+		/// The values to write, by section and key.
+		/// </summary>
+		using values = std::unordered_map<std::string, std::unordered_map<std::string, variant>>;
+
+		explicit preset_writer(std::chrono::milliseconds quiet_period = std::chrono::milliseconds(500)) : _quiet_period(quiet_period) { }
+		~preset_writer();
+
+		preset_writer(const preset_writer &) = delete;
+		preset_writer &operator=(const preset_writer &) = delete;
+
+		/// <summary>
+		/// Record changes to a preset. They are merged with all changes recorded for it since the last write and replace older values of the same keys.
+		/// </summary>
+		/// <param name="path">The path to the preset file.</param>
+		/// <param name="changes">The values to write.</param>
+		void queue(const filesystem::path &path, values changes);
+		/// <summary>
+		/// Write all recorded changes now and return once they are on disk. Call this before a preset file is read, so that no recorded changes are missed.
+		/// </summary>
+		void flush();
+
+		/// <summary>
+		/// Returns the number of times <see cref="queue"/> was called.
+		/// </summary>
+		size_t requests() const;
+		/// <summary>
+		/// Returns the number of times a preset file was actually written. The difference to <see cref="requests"/> is the number of writes that were coalesced away.
+		/// </summary>
+		size_t writes() const;
+
+	private:
+		struct pending
+		{
+			values changes;
+			std::chrono::steady_clock::time_point deadline;
+		};
+
+		void run();
+		void write(const filesystem::path &path, const values &changes);
+
+		const std::chrono::milliseconds _quiet_period;
+		mutable std::mutex _mutex;
+		std::mutex _write_mutex;
+		std::condition_variable _signal;
+		std::thread _thread;
+		bool _exit = false;
+		size_t _requests = 0, _writes = 0;
+		std::unordered_map<std::string, pending> _pending;
+	};
+}
@@ -0,0 +1,339 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+namespace reshade
+{
+	/// <summary>
+	/// Identifies an element of a <see cref="resource_registry"/>. Handles stay valid until the element is removed, after which they no longer resolve, even if the slot is reused.
+	/// </summary>
+	struct resource_handle
+	{
+		unsigned int index = 0, generation = 0;
+
+		bool operator==(const resource_handle &other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const resource_handle &other) const { return !operator==(other); }
+	};
+
+	/// <summary>
+	/// Stores the textures, uniforms or techniques of all loaded effects. Elements live in fixed size chunks, so their addresses never change while they exist,
+	/// names are hashed once on insertion to make lookups constant time and iteration visits the elements in insertion order (or the order established with <see cref="sort"/>).
+	/// </summary>
+	/// <typeparam name="T">Element type. Has to be default constructible, move assignable and have a <c>name</c> member.</typeparam>
+	template <typename T>
+	class resource_registry
+	{
+		enum : unsigned int
+		{
+			chunk_size = 64
+		};
+
+		struct slot
+		{
+			T value;
+			size_t name_hash = 0;
+			unsigned int index = 0, generation = 1;
+			bool alive = false;
+		};
+
+		template <typename V, typename S>
+		class iterator_base
+		{
+		public:
+			typedef std::random_access_iterator_tag iterator_category;
+			typedef V value_type;
+			typedef ptrdiff_t difference_type;
+			typedef V *pointer;
+			typedef V &reference;
+
+			iterator_base() = default;
+			explicit iterator_base(S *it) : _it(it) { }
+
+			reference operator*() const { return (*_it)->value; }
+			pointer operator->() const { return &(*_it)->value; }
+			reference operator[](difference_type n) const { return _it[n]->value; }
+
+			iterator_base &operator++() { ++_it; return *this; }
+			iterator_base operator++(int) { return iterator_base(_it++); }
+			iterator_base &operator--() { --_it; return *this; }
+			iterator_base operator--(int) { return iterator_base(_it--); }
+			iterator_base &operator+=(difference_type n) { _it += n; return *this; }
+			iterator_base &operator-=(difference_type n) { _it -= n; return *this; }
+			iterator_base operator+(difference_type n) const { return iterator_base(_it + n); }
+			iterator_base operator-(difference_type n) const { return iterator_base(_it - n); }
+			difference_type operator-(const iterator_base &other) const { return _it - other._it; }
+
+			bool operator==(const iterator_base &other) const { return _it == other._it; }
+			bool operator!=(const iterator_base &other) const { return _it != other._it; }
+			bool operator<(const iterator_base &other) const { return _it < other._it; }
+
+		private:
+			S *_it = nullptr;
+		};
+
+	public:
+		typedef iterator_base<T, slot *const> iterator;
+		typedef iterator_base<const T, slot *const> const_iterator;
+
+		resource_registry() = default;
+		resource_registry(const resource_registry &) = delete;
+		resource_registry &operator=(const resource_registry &) = delete;
+
+		/// <summary>
+		/// Add a new element at the end of the iteration order.
+		/// </summary>
+		/// <param name="value">The element to move into the registry. Its name must not change afterwards.</param>
+		/// <returns>A handle to the new element.</returns>
+		resource_handle insert(T &&value)
+		{
+			if (_free_slots.empty())
+			{
+				const auto chunk = new slot[chunk_size];
+				const unsigned int base = static_cast<unsigned int>(_chunks.size() * chunk_size);
+
+				_chunks.emplace_back(chunk);
+
+				// Hand out the lowest indices first
+				for (unsigned int i = chunk_size; i-- > 0;)
+				{
+					chunk[i].index = base + i;
+					_free_slots.push_back(&chunk[i]);
+				}
+			}
+
+			slot *const s = _free_slots.back();
+			_free_slots.pop_back();
+
+			s->value = std::move(value);
+			s->name_hash = std::hash<std::string>()(s->value.name);
+			s->alive = true;
+
+			_order.push_back(s);
+			_names[s->name_hash].push_back(s);
+
+			return { s->index, s->generation };
+		}
+
+		/// <summary>
+		/// Resolve a handle.
+		/// </summary>
+		/// <returns>A pointer to the element, or <c>nullptr</c> if it was removed in the meantime.</returns>
+		T *get(resource_handle handle)
+		{
+			slot *const s = resolve(handle);
+
+			return s != nullptr ? &s->value : nullptr;
+		}
+		const T *get(resource_handle handle) const
+		{
+			slot *const s = resolve(handle);
+
+			return s != nullptr ? &s->value : nullptr;
+		}
+
+		/// <summary>
+		/// Find the element with the specified name. If several elements share the name, the one inserted first is returned.
+		/// </summary>
+		/// <returns>A pointer to the element, or <c>nullptr</c> if there is none.</returns>
+		T *find(const std::string &name)
+		{
+			slot *const s = find_slot(name);
+
+			return s != nullptr ? &s->value : nullptr;
+		}
+		const T *find(const std::string &name) const
+		{
+			slot *const s = find_slot(name);
+
+			return s != nullptr ? &s->value : nullptr;
+		}
+		/// <summary>
+		/// Find the first element with the specified name that also matches a predicate, e.g. to tell apart elements of the same name from different effect files.
+		/// </summary>
+		/// <returns>A pointer to the element, or <c>nullptr</c> if there is none.</returns>
+		template <typename F>
+		T *find(const std::string &name, F predicate)
+		{
+			const auto it = _names.find(std::hash<std::string>()(name));
+
+			if (it == _names.end())
+			{
+				return nullptr;
+			}
+
+			for (slot *const s : it->second)
+			{
+				if (s->value.name == name && predicate(static_cast<const T &>(s->value)))
+				{
+					return &s->value;
+				}
+			}
+
+			return nullptr;
+		}
+		/// <summary>
+		/// Find the handle of the element with the specified name.
+		/// </summary>
+		/// <returns>Returns <c>true</c> if an element was found, <c>false</c> otherwise.</returns>
+		bool find_handle(const std::string &name, resource_handle &handle) const
+		{
+			slot *const s = find_slot(name);
+
+			if (s == nullptr)
+			{
+				return false;
+			}
+
+			handle = { s->index, s->generation };
+
+			return true;
+		}
+
+		/// <summary>
+		/// Remove a single element.
+		/// </summary>
+		/// <returns>Returns <c>true</c> if the element existed, <c>false</c> if the handle was stale.</returns>
+		bool erase(resource_handle handle)
+		{
+			slot *const s = resolve(handle);
+
+			if (s == nullptr)
+			{
+				return false;
+			}
+
+			_order.erase(std::find(_order.begin(), _order.end(), s));
+			release(s);
+
+			return true;
+		}
+		/// <summary>
+		/// Remove all elements from the specified position in the iteration order on.
+		/// </summary>
+		void erase(size_t first)
+		{
+			for (size_t i = first; i < _order.size(); i++)
+			{
+				release(_order[i]);
+			}
+
+			if (first < _order.size())
+			{
+				_order.resize(first);
+			}
+		}
+		/// <summary>
+		/// Remove all elements matching a predicate, e.g. all resources belonging to an effect file.
+		/// </summary>
+		/// <returns>The number of removed elements.</returns>
+		template <typename F>
+		size_t erase_if(F predicate)
+		{
+			const auto it = std::stable_partition(_order.begin(), _order.end(),
+				[&predicate](const slot *s) {
+					return !predicate(static_cast<const T &>(s->value));
+				});
+			const size_t count = _order.end() - it;
+
+			erase(static_cast<size_t>(it - _order.begin()));
+
+			return count;
+		}
+		/// <summary>
+		/// Remove all elements. Handles to them become invalid, but the memory is kept for reuse.
+		/// </summary>
+		void clear()
+		{
+			erase(size_t(0));
+		}
+
+		/// <summary>
+		/// Reorder the elements for iteration. Element addresses and handles are not affected.
+		/// </summary>
+		/// <param name="compare">Strict weak ordering on the elements. Equivalent elements keep their relative order.</param>
+		template <typename F>
+		void sort(F compare)
+		{
+			std::stable_sort(_order.begin(), _order.end(),
+				[&compare](const slot *lhs, const slot *rhs) {
+					return compare(static_cast<const T &>(lhs->value), static_cast<const T &>(rhs->value));
+				});
+		}
+
+		bool empty() const { return _order.empty(); }
+		size_t size() const { return _order.size(); }
+
+		T &operator[](size_t position) { return _order[position]->value; }
+		const T &operator[](size_t position) const { return _order[position]->value; }
+
+		iterator begin() { return iterator(_order.data()); }
+		iterator end() { return iterator(_order.data() + _order.size()); }
+		const_iterator begin() const { return const_iterator(_order.data()); }
+		const_iterator end() const { return const_iterator(_order.data() + _order.size()); }
+
+	private:
+		slot *resolve(resource_handle handle) const
+		{
+			if (handle.index / chunk_size >= _chunks.size())
+			{
+				return nullptr;
+			}
+
+			slot *const s = &_chunks[handle.index / chunk_size][handle.index % chunk_size];
+
+			return s->alive && s->generation == handle.generation ? s : nullptr;
+		}
+		slot *find_slot(const std::string &name) const
+		{
+			const auto it = _names.find(std::hash<std::string>()(name));
+
+			if (it == _names.end())
+			{
+				return nullptr;
+			}
+
+			// Different names can hash to the same value, so compare the full name
+			for (slot *const s : it->second)
+			{
+				if (s->value.name == name)
+				{
+					return s;
+				}
+			}
+
+			return nullptr;
+		}
+		void release(slot *s)
+		{
+			auto &bucket = _names[s->name_hash];
+			bucket.erase(std::find(bucket.begin(), bucket.end(), s));
+
+			if (bucket.empty())
+			{
+				_names.erase(s->name_hash);
+			}
+
+			// Destroy the element now, so that the objects it owns are released immediately
+			s->value = T();
+			s->alive = false;
+			s->generation++;
+
+			_free_slots.push_back(s);
+		}
+
+		std::vector<std::unique_ptr<slot[]>> _chunks;
+		std::vector<slot *> _order, _free_slots;
+		std::unordered_map<size_t, std::vector<slot *>> _names;
+	};
+}
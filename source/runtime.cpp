@@ -8,8 +8,11 @@
 #include "runtime.hpp"
 #include "parser.hpp"
 #include "preprocessor.hpp"
+#include "optimizer.hpp"
+#include "effect_container.hpp"
 #include "input.hpp"
 #include "ini_file.hpp"
+#include <fstream>
 #include <algorithm>
 #include <stb_image.h>
 #include <stb_image_dds.h>
@@ -56,6 +59,73 @@ SK_ImGui_InstallOpenCloseCallback (SK_ImGui_OpenCloseCallback_pfn fn, void* user
 
 namespace reshade
 {
+	static float get_render_scale (const ini_file& preset, const std::string& technique_name)
+	{
+		const float scale =
+			preset.get ("", "Scale" + technique_name, 1.0f).as <float> ();
+
+		return std::min (1.0f, std::max (0.25f, scale));
+	}
+
+	static bool load_effect_container (const filesystem::path& container_path, uint64_t input_hash, reshadefx::effect_container& container)
+	{
+		const filesystem::mapped_file file (container_path);
+
+		if (! file.is_open () || ! reshadefx::is_up_to_date (file.data (), file.size (), input_hash))
+		{
+			return false;
+		}
+
+		if (! reshadefx::deserialize (file.data (), file.size (), container))
+		{
+			return false;
+		}
+
+		LOG(INFO) << "> Read preprocessed source from " << container_path << ".";
+
+		return true;
+	}
+
+	static void store_effect_container (const filesystem::path& container_path, const reshadefx::effect_container& container)
+	{
+		filesystem::create_directory (container_path.parent_path ().parent_path ());
+		filesystem::create_directory (container_path.parent_path ());
+
+		const std::string      data      = reshadefx::serialize (container);
+		const filesystem::path temp_path = container_path + ".tmp";
+
+		{ std::ofstream file (temp_path.native (), std::ios::binary | std::ios::trunc);
+
+			if (! file.write (data.data (), data.size ()))
+			{
+				return;
+			}
+		}
+
+		// Replace the previous container in one step, so that a concurrent start never maps a partially written one
+		if (! filesystem::move_file (temp_path, container_path))
+		{
+			LOG(WARNING) << "Failed to write effect container " << container_path << ".";
+		}
+	}
+
+	/// <summary>
+	/// The clock and framerate text drawn while the menu is closed, together with the geometry generated for it, so that the geometry only has to be generated again when the text changes.
+	/// </summary>
+	struct runtime::overlay_cache
+	{
+		std::string text;
+		unsigned int flags = 0;
+		std::chrono::high_resolution_clock::time_point last_sample;
+
+		std::string geometry_text;
+		const ImFont* geometry_font = nullptr;
+		ImVec2 geometry_position;
+		ImU32 geometry_color = 0;
+		std::vector <ImDrawVert> vertices;
+		std::vector <ImDrawIdx>  indices;
+	};
+
 	filesystem::path runtime::s_reshade_dll_path,
                    runtime::s_target_executable_path,
                    runtime::s_profile_path;
@@ -87,6 +157,13 @@ namespace reshade
 			SK_ImGui_InstallOpenCloseCallback (nullptr, nullptr);
 		}
 		assert ((! _is_initialized) && _techniques.empty ());
+
+		_preset_writer.flush ();
+
+		if (_preset_writer.requests () != 0)
+		{
+			LOG(INFO) << "Saved presets " << _preset_writer.writes () << " time(s) for " << _preset_writer.requests () << " change(s).";
+		}
 	}
 
 	bool runtime::on_init ()
@@ -127,6 +204,9 @@ namespace reshade
 		_texture_count   = 0;
 		_uniform_count   = 0;
 		_technique_count = 0;
+
+		_budget_governor.reset ();
+		_uniform_groups.clear  ();
 	}
 
 	void runtime::on_present ()
@@ -148,6 +228,9 @@ namespace reshade
 
 		// Advance various statistics
 		_framecount++;
+
+		// Pick up the uniform values other threads committed during this frame, so that the next one renders with them
+		apply_uniform_updates ();
 	}
 
 	int runtime::on_present_effect ()
@@ -366,9 +449,7 @@ namespace reshade
 			}
 		}
 
-		int techniques_drawn = 0;
-
-		// Render all enabled techniques
+		// Update the enabled state of all techniques first, so that the backend sees the final set before anything is rendered
 		for ( auto& technique : _techniques )
 		{
 			if (technique.timeleft > 0)
@@ -404,22 +485,96 @@ namespace reshade
 			{
 				technique.average_cpu_duration.clear ();
 				technique.average_gpu_duration.clear ();
+			}
+		}
+
+		// Suspend the least important techniques while their total cost exceeds the frame budget
+		if (_budget_governor.get_settings ().budget > 0.0f)
+		{
+			std::vector <frame_budget_governor::sample> samples;
+
+			for ( const auto& technique : _techniques )
+			{
+				if (! technique.enabled)
+				{
+					continue;
+				}
+
+				frame_budget_governor::sample sample;
+				sample.name     = technique.name;
+				sample.priority = technique.priority;
+
+				if (! technique.suspended)
+				{
+					sample.cost = technique.average_gpu_duration != 0.0f ? technique.average_gpu_duration : technique.average_cpu_duration * 1e-6f;
+				}
+
+				samples.push_back (std::move (sample));
+			}
+
+			_budget_governor.update (samples);
+		}
+
+		for ( auto& technique : _techniques )
+		{
+			technique.suspended = technique.enabled && _budget_governor.is_suspended (technique.name);
+
+			if (technique.suspended)
+			{
+				technique.average_cpu_duration.clear ();
+				technique.average_gpu_duration.clear ();
+			}
+		}
+
+		update_technique_fusion ();
+
+		int techniques_drawn = 0;
+
+		// Render all enabled techniques
+		for ( auto it = _techniques.begin (); it != _techniques.end (); ++it )
+		{
+			auto& technique = *it;
+
+			if (! technique.enabled || technique.suspended)
+			{
 				continue;
 			}
 
+			const unsigned int group_size =
+				get_technique_group_size (technique);
+
+			// Drawn and timed together with the first technique of its group
+			if (group_size == 0)
+			{
+				continue;
+			}
 
 			const auto time_technique_started  = std::chrono::high_resolution_clock::now ();
 
 			render_technique (technique);
-			++techniques_drawn;
+			techniques_drawn += group_size;
 
 			const auto time_technique_finished = std::chrono::high_resolution_clock::now ();
 
-
-			technique.average_cpu_duration.append (
+			const auto duration =
 				std::chrono::duration_cast <std::chrono::nanoseconds> ( time_technique_finished -
-				                                                        time_technique_started ).count ()
-				);
+				                                                        time_technique_started ).count ();
+
+			// The techniques of a group are timed as a unit, each one is charged an equal share, so that their costs still add up to that of the group
+			for ( auto member = it, end = _techniques.end (); member != end; ++member )
+			{
+				if (! member->enabled || member->suspended)
+				{
+					continue;
+				}
+
+				if (member != it && get_technique_group_size (*member) != 0)
+				{
+					break;
+				}
+
+				member->average_cpu_duration.append (duration / group_size);
+			}
 		}
 
 		return techniques_drawn;
@@ -429,6 +584,9 @@ namespace reshade
 	{
 		on_reset_effect ();
 
+		// Loading the effects reads the current preset, which may still have changes waiting to be written
+		_preset_writer.flush ();
+
 		_effect_files.clear ();
 
 		for ( const auto& search_path : _effect_search_paths )
@@ -442,80 +600,50 @@ namespace reshade
 		}
 
 		_reload_remaining_effects = _effect_files.size ();
+
+		// Every effect reads the preset while it is loaded, so it is only read from disk once for all of them
+		_reload_preset =
+			_current_preset >= 0 && ! _effect_files.empty () ? std::make_unique <ini_file> (_preset_files [_current_preset]) : nullptr;
 	}
 
-	void runtime::load_effect (const filesystem::path& path)
+	void runtime::update_effect_render_scale (const std::vector <std::string>& technique_names)
 	{
-		LOG(INFO) << "Compiling " << path << " ...";
-
-		reshadefx::preprocessor pp;
-		                        pp.add_include_path (path.parent_path ());
-
-		for ( const auto& include_path : _effect_search_paths )
-		{
-			if (include_path.empty ())
-			{
-				continue;
-			}
-
-			pp.add_include_path (include_path);
-		}
+		// Techniques in the same file share their textures, so the effect runs at the largest scale any of them asks for
+		_effect_render_scale = 1.0f;
 
-		pp.add_macro_definition ("__RESHADE__",       std::to_string (VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
-		pp.add_macro_definition ("__RESHADE_PERFORMANCE_MODE__", _performance_mode ? "1" : "0");
-		pp.add_macro_definition ("__VENDOR__",        std::to_string (_vendor_id));
-		pp.add_macro_definition ("__DEVICE__",        std::to_string (_device_id));
-		pp.add_macro_definition ("__RENDERER__",      std::to_string (_renderer_id));
-		pp.add_macro_definition ("__APPLICATION__",   std::to_string (std::hash <std::string> () (
-		                                                                s_target_executable_path.filename_without_extension ().string ())));
-		pp.add_macro_definition ("BUFFER_WIDTH",      std::to_string (_width));
-		pp.add_macro_definition ("BUFFER_HEIGHT",     std::to_string (_height));
-		pp.add_macro_definition ("BUFFER_RCP_WIDTH",  std::to_string (1.0f / static_cast <float> (_width)));
-		pp.add_macro_definition ("BUFFER_RCP_HEIGHT", std::to_string (1.0f / static_cast <float> (_height)));
-
-		for ( const auto& definition : _preprocessor_definitions )
+		if (_reload_preset != nullptr && supports_render_scale () && ! technique_names.empty ())
 		{
-			if (definition.empty ())
-			{
-				continue;
-			}
-
-			const size_t equals_index = definition.find_first_of ('=');
-
-			if (equals_index != std::string::npos)
-			{
-				pp.add_macro_definition ( definition.substr   ( 0,
-				                                                  equals_index   ),
-				                            definition.substr ( equals_index + 1 ) );
-			}
+			_effect_render_scale = 0.0f;
 
-			else
+			for ( const auto& technique_name : technique_names )
 			{
-				pp.add_macro_definition (definition);
+				_effect_render_scale = std::max (_effect_render_scale, get_render_scale (*_reload_preset, technique_name));
 			}
 		}
+	}
 
-		if (! pp.run (path))
+	bool runtime::compile_effect (const filesystem::path& path, const std::string& source, std::string& errors)
+	{
+		reshadefx::syntax_tree  ast;
+		reshadefx::parser       parser (ast, errors);
+
+		if (! parser.run (source))
 		{
-			LOG(ERROR) << "Failed to preprocess " << path << ":\n" << pp.current_errors();
-			_errors += path.string () + ":\n" + pp.current_errors();
-			return;
+			return false;
 		}
 
-		std::string            errors;
-		reshadefx::syntax_tree ast;
-		reshadefx::parser      parser (ast, errors);
+		std::vector <std::string> technique_names;
 
-		if (! parser.run (pp.current_output ()))
+		for ( const auto technique : ast.techniques )
 		{
-			LOG(ERROR) << "Failed to compile " << path << ":\n" << errors;
-			_errors += path.string () + ":\n" + errors;
-			return;
+			technique_names.push_back (technique->name);
 		}
 
-		if (_performance_mode && _current_preset >= 0)
+		update_effect_render_scale (technique_names);
+
+		if (_performance_mode && _reload_preset != nullptr)
 		{
-			ini_file preset (_preset_files [_current_preset]);
+			const ini_file& preset = *_reload_preset;
 
 			for ( auto variable : ast.variables )
 			{
@@ -554,14 +682,162 @@ namespace reshade
 			}
 		}
 
-		if (! load_effect (ast, errors))
+		// Propagate the values baked in above and drop the code they made unreachable, so that the shader compiler only sees what the current preset actually uses
+		const auto stats = reshadefx::optimize (ast);
+
+		if (stats.pruned_branches != 0 || stats.removed_functions != 0 || stats.removed_variables != 0)
+		{
+			LOG(INFO) << "> Folded " << stats.folded_expressions << " expressions, pruned " << stats.pruned_branches << " branches and removed "
+			                         << stats.removed_functions  << " functions and " << stats.removed_variables << " variables.";
+		}
+
+		return load_effect (ast, errors);
+	}
+
+	void runtime::load_effect (const filesystem::path& path)
+	{
+		LOG(INFO) << "Compiling " << path << " ...";
+
+		std::vector <filesystem::path>                     include_paths { path.parent_path () };
+		std::vector <std::pair <std::string, std::string>> macros;
+
+		for ( const auto& include_path : _effect_search_paths )
+		{
+			if (include_path.empty ())
+			{
+				continue;
+			}
+
+			include_paths.push_back (include_path);
+		}
+
+		macros.emplace_back ("__RESHADE__",       std::to_string (VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
+		macros.emplace_back ("__RESHADE_PERFORMANCE_MODE__", _performance_mode ? "1" : "0");
+		macros.emplace_back ("__VENDOR__",        std::to_string (_vendor_id));
+		macros.emplace_back ("__DEVICE__",        std::to_string (_device_id));
+		macros.emplace_back ("__RENDERER__",      std::to_string (_renderer_id));
+		macros.emplace_back ("__APPLICATION__",   std::to_string (std::hash <std::string> () (
+		                                            s_target_executable_path.filename_without_extension ().string ())));
+		// These always describe the back buffer, the render scale only changes the size of intermediate render targets
+		macros.emplace_back ("BUFFER_WIDTH",      std::to_string (_width));
+		macros.emplace_back ("BUFFER_HEIGHT",     std::to_string (_height));
+		macros.emplace_back ("BUFFER_RCP_WIDTH",  std::to_string (1.0f / static_cast <float> (_width)));
+		macros.emplace_back ("BUFFER_RCP_HEIGHT", std::to_string (1.0f / static_cast <float> (_height)));
+
+		for ( const auto& definition : _preprocessor_definitions )
+		{
+			if (definition.empty ())
+			{
+				continue;
+			}
+
+			const size_t equals_index = definition.find_first_of ('=');
+
+			if (equals_index != std::string::npos)
+			{
+				macros.emplace_back ( definition.substr   ( 0,
+				                                            equals_index   ),
+				                      definition.substr ( equals_index + 1 ) );
+			}
+
+			else
+			{
+				macros.emplace_back (definition, "1");
+			}
+		}
+
+		// An effect whose files and macros did not change since it was last compiled is read back from its container instead of being preprocessed again
+		const uint64_t         input_hash = reshadefx::hash_preprocessor_inputs (include_paths, macros);
+		const filesystem::path container_path =
+		  s_profile_path + "ReShade\\Cache\\" + path.filename_without_extension () + '-' + std::to_string (std::hash <std::string> () (path.string ())) + ".fxc";
+
+		// The values performance mode bakes into the code come from the preset, which is not part of the container inputs, so generated code is neither reused nor stored in that mode
+		const std::string backend = _performance_mode ? std::string () : generated_effect_backend ();
+
+		reshadefx::effect_container container;
+		std::string                 errors;
+
+		const bool from_container = load_effect_container (container_path, input_hash, container);
+		bool       store_source   = false,
+		           loaded         = false;
+
+		// The backend generated code for this effect before, so it is created from that and the reflection without running the parser
+		if (from_container && ! backend.empty () && container.backend == backend)
+		{
+			std::vector <std::string> technique_names;
+
+			for ( const auto& technique : container.reflection.techniques )
+			{
+				technique_names.push_back (technique.name);
+			}
+
+			update_effect_render_scale (technique_names);
+
+			loaded = load_generated_effect (container.reflection, container.code, errors);
+
+			if (loaded)
+			{
+				LOG(INFO) << "> Loaded the generated code from the container without parsing the source.";
+			}
+
+			else
+			{
+				LOG(WARNING) << "> The generated code in the container cannot be used, compiling the source again.";
+
+				_textures.erase   (_texture_count);
+				_uniforms.erase   (_uniform_count);
+				_techniques.erase (_technique_count);
+
+				errors.clear ();
+			}
+		}
+
+		if (! from_container)
+		{
+			reshadefx::preprocessor pp;
+
+			for ( const auto& include_path : include_paths )
+			{
+				pp.add_include_path (include_path);
+			}
+
+			for ( const auto& macro : macros )
+			{
+				pp.add_macro_definition (macro.first, macro.second);
+			}
+
+			std::vector <filesystem::path> included_files { path };
+
+			if (! pp.run (path, included_files))
+			{
+				LOG(ERROR) << "Failed to preprocess " << path << ":\n" << pp.current_errors();
+				_errors += path.string () + ":\n" + pp.current_errors();
+				return;
+			}
+
+			container.input_hash = input_hash;
+			container.source     = pp.current_output ();
+
+			// A container whose dependencies cannot be stamped could never be validated again
+			store_source = reshadefx::stamp_dependencies (included_files, container.dependencies);
+		}
+
+		if ((! loaded) && (! compile_effect (path, container.source, errors)))
 		{
 			LOG(ERROR) << "Failed to compile " << path << ":\n" << errors;
 			_errors += path.string() + ":\n" + errors;
 
-			_textures.erase   (_textures.begin   () + _texture_count,   _textures.end   ());
-			_uniforms.erase   (_uniforms.begin   () + _uniform_count,   _uniforms.end   ());
-			_techniques.erase (_techniques.begin () + _technique_count, _techniques.end ());
+			_textures.erase   (_texture_count);
+			_uniforms.erase   (_uniform_count);
+			_techniques.erase (_technique_count);
+
+			// The preprocessed source is still stored, so that fixing a later stage does not have to preprocess again
+			if (store_source)
+			{
+				container.backend.clear ();
+				store_effect_container (container_path, container);
+			}
+
 			return;
 		}
 		else if (errors.empty())
@@ -574,12 +850,84 @@ namespace reshade
 			_errors += path.string() + ":\n" + errors;
 		}
 
+		if (! loaded)
+		{
+			container.backend.clear ();
+			container.code.clear    ();
+
+			if ((! backend.empty ()) && take_generated_effect (container.reflection, container.code))
+			{
+				container.backend = backend;
+			}
+
+			if (store_source || (! container.backend.empty ()))
+			{
+				store_effect_container (container_path, container);
+			}
+		}
+
+		const size_t first_uniform = _uniform_count;
+
 		for (size_t i = _uniform_count, max = _uniform_count = _uniforms.size(); i < max; i++)
 		{
 			auto &variable = _uniforms [i];
 
 			variable.effect_filename = path.filename ().string ();
 			variable.hidden          = variable.annotations ["hidden"].as <bool> ();
+
+			auto&      ui      = variable.ui;
+			const auto ui_type = variable.annotations ["ui_type"].as <std::string> ();
+
+			ui.editable = variable.annotations.count ("source") == 0;
+			ui.label    = variable.annotations.count ("ui_label") ? variable.annotations ["ui_label"].as <std::string> () : variable.name;
+			ui.tooltip  = variable.annotations ["ui_tooltip"].as <std::string> ();
+			ui.items    = variable.annotations ["ui_items"  ].as <std::string> ();
+			ui.min_int  = variable.annotations ["ui_min"    ].as <int>   ();
+			ui.max_int  = variable.annotations ["ui_max"    ].as <int>   ();
+			ui.min      = variable.annotations ["ui_min"    ].as <float> ();
+			ui.max      = variable.annotations ["ui_max"    ].as <float> ();
+			ui.step     = variable.annotations ["ui_step"   ].as <float> ();
+
+			switch (variable.displaytype)
+			{
+				case uniform_datatype::boolean:
+					ui.widget = uniform_widget::combo;
+					break;
+				case uniform_datatype::signed_integer:
+				case uniform_datatype::unsigned_integer:
+					ui.widget = ui_type == "drag"  ? uniform_widget::drag  :
+					            ui_type == "combo" ? uniform_widget::combo : uniform_widget::input;
+					break;
+				case uniform_datatype::floating_point:
+					if (ui_type == "drag")
+						ui.widget = uniform_widget::drag;
+					else if (ui_type == "input" || (ui_type.empty () && variable.rows < 3))
+						ui.widget = uniform_widget::input;
+					else if (variable.rows == 3 || variable.rows == 4)
+						ui.widget = uniform_widget::color;
+					else
+						ui.widget = uniform_widget::none;
+					break;
+			}
+		}
+
+		if (first_uniform != _uniform_count)
+		{
+			if (! _uniform_groups.empty () && _uniform_groups.back ().effect_filename == path.filename ().string ())
+			{
+				_uniform_groups.back ().last = _uniform_count;
+			}
+			else
+			{
+				uniform_group group;
+				group.effect_filename = path.filename ().string ();
+				group.first           = first_uniform;
+				group.last            = _uniform_count;
+
+				_uniform_groups.push_back (std::move (group));
+			}
+
+			update_uniform_groups ();
 		}
 
 		for (size_t i = _texture_count, max = _texture_count = _textures.size(); i < max; i++)
@@ -601,9 +949,11 @@ namespace reshade
 			technique.toggle_key_ctrl  = technique.annotations ["togglectrl" ].as <bool> ();
 			technique.toggle_key_shift = technique.annotations ["toggleshift"].as <bool> ();
 			technique.toggle_key_alt   = technique.annotations ["togglealt"  ].as <bool> ();
+			technique.render_scale     = _reload_preset != nullptr ? get_render_scale (*_reload_preset, technique.name) : 1.0f;
 		}
 	}
 
+
 	void runtime::load_textures ()
 	{
 		LOG(INFO) << "Loading image files for textures ...";
@@ -772,6 +1122,10 @@ namespace reshade
 		_show_clock        = config.get ("GENERAL", "ShowClock",        _show_clock).as     <bool> ();
 		_show_framerate    = config.get ("GENERAL", "ShowFPS",          _show_framerate).as <bool> ();
 
+		auto budget_settings   = _budget_governor.get_settings ();
+		budget_settings.budget = config.get ("GENERAL", "FrameBudget",      budget_settings.budget).as <float> ();
+		_budget_governor.set_settings (budget_settings);
+
 		//auto &style = _imgui_context->Style;
 		//style.Alpha = config.get("STYLE", "Alpha", 0.95f).as<float>();
 		//
@@ -905,6 +1259,7 @@ namespace reshade
 		config.set ("GENERAL", "ScreenshotFormat",        _screenshot_format);
 		config.set ("GENERAL", "ShowClock",               _show_clock);
 		config.set ("GENERAL", "ShowFPS",                 _show_framerate);
+		config.set ("GENERAL", "FrameBudget",             _budget_governor.get_settings ().budget);
 
 		const auto &style = _imgui_context->Style;
 
@@ -917,6 +1272,8 @@ namespace reshade
 
 	void runtime::load_preset (const filesystem::path& path)
 	{
+		_preset_writer.flush ();
+
 		ini_file preset (path);
 
 		for ( auto& variable : _uniforms )
@@ -935,12 +1292,13 @@ namespace reshade
 			set_uniform_value (variable, values, 16);
 		}
 
+		bool render_scale_changed = false;
+
 		// Reorder techniques
 		std::vector <std::string> technique_list =
       preset.get ("", "Techniques").data ();
 
-		std::sort ( _techniques.begin (),
-		            _techniques.end   (),
+		_techniques.sort (
 			[&technique_list]
 			(const auto& lhs, const auto& rhs)
 			{
@@ -966,31 +1324,86 @@ namespace reshade
 			technique.toggle_key_ctrl  = preset.get ("", "Key" + technique.name, toggle_key).as <bool> (1);
 			technique.toggle_key_shift = preset.get ("", "Key" + technique.name, toggle_key).as <bool> (2);
 			technique.toggle_key_alt   = preset.get ("", "Key" + technique.name, toggle_key).as <bool> (3);
+
+			technique.priority         = preset.get ("", "Priority" + technique.name, technique.priority).as <int> ();
+
+			render_scale_changed |= get_render_scale (preset, technique.name) != technique.render_scale;
+		}
+
+		// The render scale is baked into the render targets of an effect, so changing it requires compiling the effects again
+		if (render_scale_changed && supports_render_scale () && _reload_remaining_effects == 0)
+		{
+			reload ();
 		}
 	}
 
 	void runtime::save_preset (const filesystem::path& path) const
 	{
-		ini_file preset (path);
+		// Only record the values here, the file is written on a background thread once the preset was left alone for a moment
+		preset_writer::values preset;
 
 		for ( const auto& variable : _uniforms )
 		{
-			if (variable.annotations.count ("source"))
-			{
-				continue;
-			}
+			add_preset_values (preset, variable);
+		}
 
-			float                        values [16] = { };
-			get_uniform_value (variable, values, 16);
+		for ( const auto& technique : _techniques )
+		{
+			add_preset_values (preset, technique);
+		}
+
+		add_preset_technique_list (preset);
+
+		_preset_writer.queue (path, std::move (preset));
+	}
+	void runtime::save_preset (const filesystem::path& path, const uniform& variable) const
+	{
+		// The writer merges this with what was recorded before, so the other values of the preset do not have to be recorded again
+		preset_writer::values preset;
+
+		add_preset_values (preset, variable);
 
-			assert (variable.rows * variable.columns < 16);
+		_preset_writer.queue (path, std::move (preset));
+	}
+	void runtime::save_preset (const filesystem::path& path, const technique& technique) const
+	{
+		preset_writer::values preset;
 
-			preset.set ( variable.effect_filename,
-			               variable.name,
-			                 variant ( values, variable.rows * variable.columns )
-			           );
+		add_preset_values (preset, technique);
+
+		// Toggling a technique changes the list of enabled ones, which is stored as a whole
+		add_preset_technique_list (preset);
+
+		_preset_writer.queue (path, std::move (preset));
+	}
+	void runtime::add_preset_values (preset_writer::values& preset, const uniform& variable) const
+	{
+		if (variable.annotations.count ("source"))
+		{
+			return;
 		}
 
+		float                        values [16] = { };
+		get_uniform_value (variable, values, 16);
+
+		assert (variable.rows * variable.columns < 16);
+
+		preset [variable.effect_filename][variable.name] =
+		  variant ( values, variable.rows * variable.columns );
+	}
+	void runtime::add_preset_values (preset_writer::values& preset, const technique& technique) const
+	{
+		const int toggle_key [4] = { technique.toggle_key,
+		                             technique.toggle_key_ctrl  ? 1 : 0,
+		                             technique.toggle_key_shift ? 1 : 0,
+		                             technique.toggle_key_alt   ? 1 : 0 };
+
+		preset [""]["Key"      + technique.name] = toggle_key;
+		preset [""]["Scale"    + technique.name] = technique.render_scale;
+		preset [""]["Priority" + technique.name] = technique.priority;
+	}
+	void runtime::add_preset_technique_list (preset_writer::values& preset) const
+	{
 		std::vector <std::string> technique_list;
 
 		for ( const auto& technique : _techniques )
@@ -999,16 +1412,9 @@ namespace reshade
 			{
 				technique_list.push_back (technique.name);
 			}
-
-			const int toggle_key [4] = { technique.toggle_key,
-			                             technique.toggle_key_ctrl  ? 1 : 0,
-			                             technique.toggle_key_shift ? 1 : 0,
-			                             technique.toggle_key_alt   ? 1 : 0 };
-
-			preset.set ("", "Key" + technique.name, toggle_key);
 		}
 
-		preset.set("", "Techniques", technique_list);
+		preset [""]["Techniques"] = technique_list;
 	}
 	void runtime::save_screenshot() const
 	{
@@ -1186,6 +1592,9 @@ namespace reshade
 
 				if (filesystem::exists (path) || filesystem::exists (path.parent_path ()))
 				{
+					const bool is_new_preset =
+						! filesystem::exists (path);
+
 					_preset_files.push_back (path);
 
 					_current_preset =
@@ -1194,6 +1603,12 @@ namespace reshade
 					load_preset        (path);
 					save_configuration (    );
 
+					// Changes only record the values they touch from now on, so a new preset starts out with all current values
+					if (is_new_preset)
+					{
+						save_preset (path);
+					}
+
 					ImGui::CloseCurrentPopup ();
 				}
 			}
@@ -1447,6 +1862,19 @@ namespace reshade
 			//	save_configuration ();
 			//}
 
+			auto budget_settings = _budget_governor.get_settings ();
+
+			if (ImGui::DragFloat ("Frame Budget", &budget_settings.budget, 0.1f, 0.0f, 100.0f, budget_settings.budget > 0.0f ? "%.1f ms" : "Off"))
+			{
+				_budget_governor.set_settings (budget_settings);
+
+				save_configuration ();
+			}
+			else if (ImGui::IsItemHovered ())
+			{
+				ImGui::SetTooltip ("Techniques with the lowest priority are suspended while all techniques together take longer than this.\nRight click a technique to change its priority.");
+			}
+
 			copy_vector_to_edit_buffer (_preprocessor_definitions);
 
 			if (ImGui::InputTextMultiline ("Preprocessor Definitions", edit_buffer, sizeof(edit_buffer), ImVec2(0, 100)))
@@ -1546,6 +1974,8 @@ namespace reshade
         gpu_time             += technique.average_gpu_duration;
       }
 
+			const auto shader_statistics = get_shader_statistics ();
+
       ImGui::PushStyleColor  (ImGuiCol_Text, ImColor (1.f, 1.f, 1.f, 1.f));
 			ImGui::BeginGroup      (                              );
 			ImGui::TextUnformatted ("Application:"                );
@@ -1556,6 +1986,10 @@ namespace reshade
 if (gpu_time != 0.0f)
 			ImGui::TextUnformatted ("GPU Runtime:");
 			ImGui::TextUnformatted ("Draw Calls:"                 );
+if (shader_statistics.objects != 0)
+			ImGui::TextUnformatted ("Shaders:"                    );
+if (_preset_writer.requests () != 0)
+			ImGui::TextUnformatted ("Preset Saves:"               );
 			ImGui::Text            ("Frame %llu:", _framecount + 1);
 			ImGui::TextUnformatted ("Timer:"                      );
 			ImGui::EndGroup        (                              );
@@ -1573,6 +2007,10 @@ if (gpu_time != 0.0f)
 if (gpu_time != 0.0f)
 			ImGui::Text       ("%f ms",            gpu_time);
 			ImGui::Text       ("%u (%u vertices)", _drawcalls.load (), _vertices.load ());
+if (shader_statistics.objects != 0)
+			ImGui::Text       ("%zu (%zu compiled, %zu shared)", shader_statistics.objects, shader_statistics.compilations, shader_statistics.hits);
+if (_preset_writer.requests () != 0)
+			ImGui::Text       ("%zu (%zu avoided)", _preset_writer.writes (), _preset_writer.requests () - _preset_writer.writes ());
 			ImGui::Text       ("%f ms",            _last_frame_duration.count () * 1e-6f);
 			ImGui::Text       ("%f ms",            std::fmod(std::chrono::duration_cast<std::chrono::nanoseconds>(_last_present_time - _start_time).count() * 1e-6f, 16777216.0f));
 
@@ -1660,9 +2098,9 @@ if (gpu_time != 0.0f)
 			for (const auto& technique : _techniques)
 			{
 				if (technique.enabled)
-					ImGui::TextColored (ImColor (1.f, 1.f, 1.f, 1.f),       "(%u passes)   ", static_cast <unsigned int> (technique.passes.size ()));
+					ImGui::TextColored (ImColor (1.f, 1.f, 1.f, 1.f),       "(%u passes, %u bindings)   ", static_cast <unsigned int> (technique.passes.size ()), technique.resource_bindings);
 				else
-					ImGui::TextColored (ImColor (0.68f, 0.68f, 0.68f, 1.f), "(%u passes)   ", static_cast <unsigned int> (technique.passes.size ()));
+					ImGui::TextColored (ImColor (0.68f, 0.68f, 0.68f, 1.f), "(%u passes, %u bindings)   ", static_cast <unsigned int> (technique.passes.size ()), technique.resource_bindings);
 			}
 
 			ImGui::EndGroup   ();
@@ -1752,147 +2190,130 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 	{
 		ImGui::PushItemWidth (ImGui::GetWindowWidth () * 0.5f);
 
-		bool        current_tree_is_closed = true;
-		std::string current_filename;
-
-		for (int id = 0; id < static_cast <int> (_uniform_count); id++)
+		// Effects are drawn from the precomputed groups and only the rows that are scrolled into view are submitted, so the cost does not grow with the number of uniforms
+		for ( const auto& group : _uniform_groups )
 		{
-			auto& variable = _uniforms [id];
-
-			if (variable.hidden || variable.annotations.count("source"))
+			if (group.visible.empty ())
 			{
 				continue;
 			}
 
-			if (current_filename != variable.effect_filename)
-			{
-				if (! current_tree_is_closed)
-					ImGui::TreePop ();
+			if (_effects_expanded_state & 1)
+				ImGui::SetNextTreeNodeOpen ((_effects_expanded_state >> 1) != 0);
 
-				if (_effects_expanded_state & 1)
-					ImGui::SetNextTreeNodeOpen ((_effects_expanded_state >> 1) != 0);
-
-				current_filename       = variable.effect_filename;
-				current_tree_is_closed = ! ImGui::TreeNodeEx ( variable.effect_filename.c_str (),
-				                                                 ImGuiTreeNodeFlags_DefaultOpen );
-			}
-			if (current_tree_is_closed)
+			if (! ImGui::TreeNodeEx ( group.effect_filename.c_str (),
+			                            ImGuiTreeNodeFlags_DefaultOpen ))
 			{
 				continue;
 			}
 
-			bool modified = false;
-
-			const auto ui_type    = variable.annotations [      "ui_type"   ].as <std::string> ();
-			const auto ui_label   = variable.annotations.count ("ui_label"  ) ? variable.
-			                                 annotations.at    ("ui_label").as   <std::string> () : variable.name;
-			const auto ui_tooltip = variable.annotations [      "ui_tooltip"].as <std::string> ();
-
-			ImGui::PushID (id);
+			ImGuiListClipper clipper (static_cast <int> (group.visible.size ()));
 
-			switch (variable.displaytype)
+			while (clipper.Step ())
 			{
-				case uniform_datatype::boolean:
+				for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
 				{
-					bool                         data [1] = { };
-					get_uniform_value (variable, data, 1);
+					const int id       = static_cast <int> (group.visible [row]);
+					auto&     variable = _uniforms [id];
+					const auto& ui     = variable.ui;
 
-					int index = data [0] ? 0 : 1;
+					bool modified = false;
 
-					if (ImGui::Combo (ui_label.c_str (), &index, "On\0Off\0"))
-					{
-						data [0] = index == 0;
-						modified = true;
+					ImGui::PushID (id);
 
-						set_uniform_value (variable, data, 1);
-					}
-					else if (ImGui::IsItemHovered () && ImGui::IsMouseDoubleClicked (0))
+					switch (variable.displaytype)
 					{
-						data [0] = ! data[0];
-						modified = true;
+						case uniform_datatype::boolean:
+						{
+							bool                         data [1] = { };
+							get_uniform_value (variable, data, 1);
 
-						set_uniform_value (variable, data, 1);
-					}
-					break;
-				}
+							int index = data [0] ? 0 : 1;
 
-				case uniform_datatype::signed_integer:
-				case uniform_datatype::unsigned_integer:
-				{
-					int                          data [4] = { };
-					get_uniform_value (variable, data, 4);
+							if (ImGui::Combo (ui.label.c_str (), &index, "On\0Off\0"))
+							{
+								data [0] = index == 0;
+								modified = true;
 
-					if (ui_type == "drag")
-					{
-						modified = ImGui::DragIntN (ui_label.c_str (), data, variable.rows,      variable.annotations ["ui_step"].as <float> (),
-						                            variable.annotations ["ui_min"].as <int> (), variable.annotations ["ui_max"].as  <int>   (), nullptr);
-					}
-					else if (ui_type == "combo")
-					{
-						modified = ImGui::Combo (ui_label.c_str (), data, variable.annotations ["ui_items"].as <std::string> ().c_str ());
-					}
-					else
-					{
-						modified = ImGui::InputIntN (ui_label.c_str (), data, variable.rows, 0);
-					}
+								set_uniform_value (variable, data, 1);
+							}
+							else if (ImGui::IsItemHovered () && ImGui::IsMouseDoubleClicked (0))
+							{
+								data [0] = ! data[0];
+								modified = true;
 
-					if (modified)
-					{
-						set_uniform_value (variable, data, 4);
-					}
-					break;
-				}
+								set_uniform_value (variable, data, 1);
+							}
+							break;
+						}
 
-				case uniform_datatype::floating_point:
-				{
-					float                        data [4] = { };
-					get_uniform_value (variable, data, 4);
+						case uniform_datatype::signed_integer:
+						case uniform_datatype::unsigned_integer:
+						{
+							int                          data [4] = { };
+							get_uniform_value (variable, data, 4);
+
+							switch (ui.widget)
+							{
+								case uniform_widget::drag:
+									modified = ImGui::DragIntN (ui.label.c_str (), data, variable.rows, ui.step, ui.min_int, ui.max_int, nullptr);
+									break;
+								case uniform_widget::combo:
+									modified = ImGui::Combo (ui.label.c_str (), data, ui.items.c_str ());
+									break;
+								default:
+									modified = ImGui::InputIntN (ui.label.c_str (), data, variable.rows, 0);
+									break;
+							}
+
+							if (modified)
+							{
+								set_uniform_value (variable, data, 4);
+							}
+							break;
+						}
 
-					if (ui_type == "drag")
-					{
-						modified =
-							ImGui::DragFloatN ( ui_label.c_str (), data, variable.rows, variable.annotations ["ui_step"].as <float> (),
-						                                                              variable.annotations ["ui_min"].as  <float> (),
-						                                                              variable.annotations ["ui_max"].as  <float> (),
-						                        "%.3f", 1.0f
-						                    );
-					}
-					else if (ui_type == "input" || (ui_type.empty () && variable.rows < 3))
-					{
-						modified = ImGui::InputFloatN (ui_label.c_str (), data, variable.rows, 8, 0);
-					}
-					else if (variable.rows == 3)
-					{
-						modified = ImGui::ColorEdit3 (ui_label.c_str (), data);
+						case uniform_datatype::floating_point:
+						{
+							float                        data [4] = { };
+							get_uniform_value (variable, data, 4);
+
+							switch (ui.widget)
+							{
+								case uniform_widget::drag:
+									modified = ImGui::DragFloatN (ui.label.c_str (), data, variable.rows, ui.step, ui.min, ui.max, "%.3f", 1.0f);
+									break;
+								case uniform_widget::input:
+									modified = ImGui::InputFloatN (ui.label.c_str (), data, variable.rows, 8, 0);
+									break;
+								case uniform_widget::color:
+									modified = variable.rows == 3 ? ImGui::ColorEdit3 (ui.label.c_str (), data) :
+									                                ImGui::ColorEdit4 (ui.label.c_str (), data);
+									break;
+							}
+
+							if (modified)
+							{
+								set_uniform_value (variable, data, 4);
+							}
+							break;
+						}
 					}
-					else if (variable.rows == 4)
+
+					if (ImGui::IsItemHovered () && (! ui.tooltip.empty ()))
 					{
-						modified = ImGui::ColorEdit4 (ui_label.c_str (), data);
+						ImGui::SetTooltip ("%s", ui.tooltip.c_str ());
 					}
 
-					if (modified)
+					ImGui::PopID ();
+
+					if (_current_preset >= 0 && modified)
 					{
-						set_uniform_value (variable, data, 4);
+						save_preset (_preset_files [_current_preset], variable);
 					}
-					break;
 				}
 			}
 
-			if (ImGui::IsItemHovered () && (! ui_tooltip.empty ()))
-			{
-				ImGui::SetTooltip ("%s", ui_tooltip.c_str ());
-			}
-
-			ImGui::PopID ();
-
-			if (_current_preset >= 0 && modified)
-			{
-				save_preset (_preset_files [_current_preset]);
-			}
-		}
-
-		if (! current_tree_is_closed)
-		{
 			ImGui::TreePop ();
 		}
 
@@ -1903,6 +2324,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 	{
 		int  hovered_technique_index = -1;
 		bool current_tree_is_closed  = true;
+		bool reload_effects          = false;
 
 		std::string current_filename;
 
@@ -1940,7 +2362,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 			if (ImGui::Checkbox (technique.name.c_str (), &technique.enabled) && _current_preset >= 0)
 			{
-				save_preset (_preset_files [_current_preset]);
+				save_preset (_preset_files [_current_preset], technique);
 			}
 
 			if (ImGui::IsItemActive ())
@@ -1952,6 +2374,55 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 				hovered_technique_index = id;
 			}
 
+			// The render scale and priority are stored in the preset, so they can only be changed while one is selected
+			if (_current_preset >= 0 && ImGui::BeginPopupContextItem ("##TechniqueOptions"))
+			{
+				static const float render_scales [] = { 1.0f, 0.75f, 0.5f, 0.25f };
+
+				if (supports_render_scale ())
+				{
+					ImGui::TextUnformatted ("Render Scale");
+
+					for ( const float render_scale : render_scales )
+					{
+						ImFormatString (edit_buffer, sizeof (edit_buffer), "%d%%", static_cast <int> (render_scale * 100));
+
+						if (ImGui::MenuItem (edit_buffer, nullptr, technique.render_scale == render_scale) && technique.render_scale != render_scale)
+						{
+							technique.render_scale = render_scale;
+
+							save_preset (_preset_files [_current_preset], technique);
+
+							reload_effects = true;
+						}
+					}
+
+					ImGui::Separator ();
+				}
+
+				if (ImGui::InputInt ("Priority", &technique.priority))
+				{
+					save_preset (_preset_files [_current_preset], technique);
+				}
+
+				ImGui::EndPopup ();
+			}
+			else if (ImGui::IsItemHovered () && _current_preset >= 0)
+			{
+				ImGui::SetTooltip ("Right click to change the resolution and frame budget priority of this technique.");
+			}
+
+			if (technique.render_scale != 1.0f && supports_render_scale ())
+			{
+				ImGui::SameLine     ();
+				ImGui::TextDisabled ("%d%%", static_cast <int> (technique.render_scale * 100));
+			}
+			if (technique.suspended)
+			{
+				ImGui::SameLine     ();
+				ImGui::TextDisabled ("(suspended)");
+			}
+
 			assert (technique.toggle_key < 256);
 
 			size_t offset = 0;
@@ -2000,7 +2471,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
         
 					if (_current_preset >= 0)
 					{
-						save_preset (_preset_files [_current_preset]);
+						save_preset (_preset_files [_current_preset], technique);
 					}
 				}
 			}
@@ -2017,6 +2488,13 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 			ImGui::TreePop ();
 		}
 
+		// Compile the effects again only after the list was drawn, since that destroys all techniques
+		if (reload_effects)
+		{
+			reload ();
+			return;
+		}
+
 		if (ImGui::IsMouseDragging () && _selected_technique >= 0)
 		{
 			ImGui::SetTooltip (_techniques [_selected_technique].name.c_str ());
@@ -2038,6 +2516,24 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 		}
 	}
 
+	void runtime::update_uniform_groups ()
+	{
+		for ( auto& group : _uniform_groups )
+		{
+			group.visible.clear ();
+
+			for (size_t i = group.first; i < group.last; i++)
+			{
+				const auto& variable = _uniforms [i];
+
+				if (! variable.hidden && variable.ui.editable)
+				{
+					group.visible.push_back (i);
+				}
+			}
+		}
+	}
+
 	void runtime::filter_techniques (const std::string& filter)
 	{
 		if (filter.empty ())
@@ -2095,6 +2591,109 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 					technique.effect_filename.find (filter) == std::string::npos;
 			}
 		}
+
+		update_uniform_groups ();
+	}
+
+	void runtime::draw_overlay_framerate (ImFont* font)
+	{
+		if (_overlay_cache == nullptr)
+		{
+			_overlay_cache = std::make_unique <overlay_cache> ();
+		}
+
+		auto& cache = *_overlay_cache;
+
+		const auto         now   = std::chrono::high_resolution_clock::now ();
+		const unsigned int flags = (_show_clock ? 1 : 0) | (_show_framerate ? 2 : 0);
+
+		// The values are sampled a few times per second only, which is all that can be read anyway and keeps the text (and with it the geometry) stable in between
+		if (flags != cache.flags || now - cache.last_sample >= std::chrono::milliseconds (250))
+		{
+			char buffer [64];
+
+			cache.text.clear ();
+			cache.flags       = flags;
+			cache.last_sample = now;
+
+			if (_show_clock)
+			{
+				const int hour   =  _date [3]        / 3600;
+				const int minute = (_date [3] - hour * 3600) / 60;
+				ImFormatString (buffer, sizeof (buffer), " %02u%s%02u\n", hour, _date [3] % 2 ? ":" : " ", minute);
+				cache.text += buffer;
+			}
+			if (_show_framerate)
+			{
+				ImFormatString (buffer, sizeof (buffer), "%.0f fps\n%*lld ms\n", ImGui::GetIO ().Framerate,
+				                3, std::chrono::duration_cast <std::chrono::milliseconds> (_last_frame_duration).count ());
+				cache.text += buffer;
+			}
+		}
+
+		// Drawn straight into the overlay draw list instead of a window, laid out like the window that was used before
+		const ImGuiStyle& style     = ImGui::GetStyle ();
+		ImDrawList*       draw_list = ImGui::GetOverlayDrawList ();
+
+		const ImVec2 position (_width - 80.0f + style.WindowPadding.x, style.WindowPadding.y);
+		const ImU32  color    = ImGui::ColorConvertFloat4ToU32 (ImVec4 (_imgui_col_text_fps [0], _imgui_col_text_fps [1], _imgui_col_text_fps [2], 1.0f));
+
+		draw_list->PushTextureID (font->ContainerAtlas->TexID);
+
+		if (cache.text          != cache.geometry_text     || font != cache.geometry_font ||
+		    position.x          != cache.geometry_position.x || position.y != cache.geometry_position.y ||
+		    color               != cache.geometry_color)
+		{
+			const int vertex_offset = draw_list->VtxBuffer.Size,
+			          index_offset  = draw_list->IdxBuffer.Size;
+			const auto base_index   = draw_list->_VtxCurrentIdx;
+
+			ImVec2 line_position = position;
+
+			for (size_t begin = 0, end; begin < cache.text.size (); begin = end + 1)
+			{
+				end = cache.text.find ('\n', begin);
+
+				if (end == std::string::npos)
+					end = cache.text.size ();
+
+				draw_list->AddText (font, font->FontSize, line_position, color, cache.text.data () + begin, cache.text.data () + end);
+
+				line_position.y += font->FontSize + style.ItemSpacing.y;
+			}
+
+			cache.vertices.assign (draw_list->VtxBuffer.Data + vertex_offset, draw_list->VtxBuffer.Data + draw_list->VtxBuffer.Size);
+			cache.indices.resize  (draw_list->IdxBuffer.Size - index_offset);
+
+			for (size_t i = 0; i < cache.indices.size (); i++)
+			{
+				cache.indices [i] = static_cast <ImDrawIdx> (draw_list->IdxBuffer [index_offset + static_cast <int> (i)] - base_index);
+			}
+
+			cache.geometry_text     = cache.text;
+			cache.geometry_font     = font;
+			cache.geometry_position = position;
+			cache.geometry_color    = color;
+		}
+		else if (! cache.indices.empty ())
+		{
+			const auto base_index = draw_list->_VtxCurrentIdx;
+
+			draw_list->PrimReserve (static_cast <int> (cache.indices.size ()), static_cast <int> (cache.vertices.size ()));
+
+			memcpy (draw_list->_VtxWritePtr, cache.vertices.data (), cache.vertices.size () * sizeof (ImDrawVert));
+
+			for (size_t i = 0; i < cache.indices.size (); i++)
+			{
+				draw_list->_IdxWritePtr [i] = static_cast <ImDrawIdx> (base_index + cache.indices [i]);
+			}
+
+			draw_list->_VtxWritePtr   += cache.vertices.size ();
+			draw_list->_IdxWritePtr   += cache.indices.size  ();
+			draw_list->_VtxCurrentIdx += static_cast <unsigned int> (cache.vertices.size ());
+		}
+
+		draw_list->PopTextureID ();
 	}
 
   bool
@@ -2133,6 +2732,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 		  	if (_reload_remaining_effects == 0)
 		  	{
+		  		_reload_preset.reset ();
+
 		  		load_textures ();
 
 		  		if (_current_preset >= 0)
@@ -2285,38 +2886,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 		{
 			if ((! show_splash) && (_show_clock || _show_framerate))
 			{
-				ImGui::SetNextWindowPos  (ImVec2 (_width - 80.f, 0));
-				ImGui::SetNextWindowSize (ImVec2 (80, 100));
-				ImGui::PushFont          (imgui_io.Fonts->Fonts [1]);
-
-				ImGui::PushStyleColor (ImGuiCol_Text,     ImVec4 ( _imgui_col_text_fps [0], _imgui_col_text_fps [1],
-				                                                   _imgui_col_text_fps [2], 1.0f));
-				ImGui::PushStyleColor (ImGuiCol_WindowBg, ImVec4 ());
-
-				ImGui::Begin("FPS", nullptr,
-					ImGuiWindowFlags_NoTitleBar      |
-					ImGuiWindowFlags_NoScrollbar     |
-					ImGuiWindowFlags_NoMove          |
-					ImGuiWindowFlags_NoResize        |
-					ImGuiWindowFlags_NoSavedSettings |
-					ImGuiWindowFlags_NoInputs        |
-					ImGuiWindowFlags_NoFocusOnAppearing);
-
-				if (_show_clock)
-				{
-					const int hour   =  _date [3]        / 3600;
-					const int minute = (_date [3] - hour * 3600) / 60;
-					ImGui::Text (" %02u%s%02u", hour, _date [3] % 2 ? ":" : " ", minute);
-				}
-				if (_show_framerate)
-				{
-					ImGui::Text ("%.0f fps", imgui_io.Framerate);
-					ImGui::Text ("%*lld ms", 3, std::chrono::duration_cast<std::chrono::milliseconds>(_last_frame_duration).count());
-				}
-
-				ImGui::End           ( );
-				ImGui::PopStyleColor (2);
-				ImGui::PopFont       ( );
+				draw_overlay_framerate (imgui_io.Fonts->Fonts [1]);
 			}
 
 
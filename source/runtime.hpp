@@ -5,23 +5,33 @@
 
 #pragma once
 
+#include <mutex>
 #include <chrono>
 #include <atomic>
 #include "filesystem.hpp"
 #include "runtime_objects.hpp"
+#include "resource_registry.hpp"
+#include "uniform_update.hpp"
+#include "frame_budget_governor.hpp"
+#include "shader_object_cache.hpp"
+#include "preset_writer.hpp"
 
 #pragma region Forward Declarations
 struct ImDrawData;
+struct ImFont;
 struct ImFontAtlas;
 struct ImGuiContext;
 
 namespace reshade
 {
 	class input;
+	class ini_file;
 }
 namespace reshadefx
 {
 	class syntax_tree;
+	struct uniform_info;
+	struct effect_reflection;
 }
 
 extern volatile long g_network_traffic;
@@ -62,6 +72,10 @@ namespace reshade
 		/// </summary>
 		unsigned int frame_height() const { return _height; }
 		/// <summary>
+		/// Returns the scale the intermediate render targets of the effect that is currently being compiled are created at. Passes that render at full resolution sample them through an upscaled copy.
+		/// </summary>
+		float effect_render_scale() const { return _effect_render_scale; }
+		/// <summary>
 		/// Create a copy of the current frame.
 		/// </summary>
 		/// <param name="buffer">The buffer to save the copy to. It has to be the size of at least "frame_width() * frame_height() * 4".</param>
@@ -80,29 +94,63 @@ namespace reshade
 		/// Add a new texture.
 		/// </summary>
 		/// <param name="texture">The texture to add.</param>
-		void add_texture(texture &&texture);
+		/// <returns>A handle that stays valid until the texture is removed.</returns>
+		resource_handle add_texture(texture &&texture);
 		/// <summary>
 		/// Add a new uniform.
 		/// </summary>
 		/// <param name="uniform">The uniform to add.</param>
-		void add_uniform(uniform &&uniform);
+		/// <returns>A handle that stays valid until the uniform is removed.</returns>
+		resource_handle add_uniform(uniform &&uniform);
+		/// <summary>
+		/// Add a new uniform described by the reflection of an effect and write its initial value to the uniform storage.
+		/// </summary>
+		/// <param name="info">The reflected uniform.</param>
+		/// <param name="block_offset">The offset of the uniform block of the effect, as returned by <see cref="allocate_uniform_storage"/>.</param>
+		/// <param name="store_as_float">Set to convert the value to floating-point, for backends whose constant storage cannot hold integers.</param>
+		/// <returns>A handle that stays valid until the uniform is removed.</returns>
+		resource_handle add_uniform(const reshadefx::uniform_info &info, size_t block_offset, bool store_as_float = false);
 		/// <summary>
 		/// Add a new technique.
 		/// </summary>
 		/// <param name="technique">The technique to add.</param>
-		void add_technique(technique &&technique);
+		/// <returns>A handle that stays valid until the technique is removed.</returns>
+		resource_handle add_technique(technique &&technique);
 		/// <summary>
 		/// Find the texture with the specified name.
 		/// </summary>
 		/// <param name="name">The name of the texture.</param>
+		/// <returns>A pointer to the texture, which stays valid until the texture is removed, or <c>nullptr</c> if there is none.</returns>
 		texture *find_texture(const std::string &name);
 
 		/// <summary>
-		/// Return a reference to the internal uniform storage buffer.
+		/// Reserve a zero initialized block of uniform storage for an effect.
+		/// </summary>
+		/// <param name="size">The final size of the block in bytes, as computed by the effect's uniform layout.</param>
+		/// <returns>The offset of the block in the uniform storage buffer, which stays the same for as long as the effect is loaded.</returns>
+		size_t allocate_uniform_storage(size_t size);
+		/// <summary>
+		/// Begin a batch of uniform updates. Can be called from any thread.
+		/// </summary>
+		uniform_update begin_update() const { return uniform_update(); }
+		/// <summary>
+		/// Publish a batch of uniform updates. Can be called from any thread. All values of the batch are applied together before the next frame is rendered,
+		/// batches committed later overwrite values of earlier ones.
+		/// </summary>
+		/// <param name="update">The batch to publish.</param>
+		void commit(uniform_update &&update);
+
+
+    bool     toggle_menu   (void);
+    uint32_t draw_callback (void);
+
+	protected:
+		/// <summary>
+		/// Return a reference to the internal uniform storage buffer. It is not synchronized, so only the render thread may access it. Other threads have to use <see cref="begin_update"/> and <see cref="commit"/>.
 		/// </summary>
 		inline std::vector<unsigned char> &get_uniform_value_storage() { return _uniform_data_storage; }
 		/// <summary>
-		/// Get the value of a uniform variable.
+		/// Get the value of a uniform variable. Render thread only, like <see cref="get_uniform_value_storage"/>.
 		/// </summary>
 		/// <param name="variable">The variable to retrieve the value from.</param>
 		/// <param name="data">The buffer to store the value in.</param>
@@ -113,7 +161,7 @@ namespace reshade
 		void get_uniform_value(const uniform &variable, unsigned int *values, size_t count) const;
 		void get_uniform_value(const uniform &variable, float *values, size_t count) const;
 		/// <summary>
-		/// Update the value of a uniform variable.
+		/// Update the value of a uniform variable. Render thread only, like <see cref="get_uniform_value_storage"/>.
 		/// </summary>
 		/// <param name="variable">The variable to update.</param>
 		/// <param name="data">The value data to update the variable to.</param>
@@ -124,11 +172,6 @@ namespace reshade
 		void set_uniform_value(uniform &variable, const unsigned int *values, size_t count);
 		void set_uniform_value(uniform &variable, const float *values, size_t count);
 
-
-    bool     toggle_menu   (void);
-    uint32_t draw_callback (void);
-
-	protected:
 		/// <summary>
 		/// Callback function called when the runtime is initialized.
 		/// </summary>
@@ -164,6 +207,23 @@ namespace reshade
 		/// <param name="pragmas">A list of additional commands to the compiler.</param>
 		/// <param name="errors">A reference to a buffer to store errors which occur during compilation.</param>
 		virtual bool load_effect(const reshadefx::syntax_tree &ast, std::string &errors) = 0;
+		/// <summary>
+		/// Returns an identifier of the code the backend generates from a syntax tree, including anything besides the source that code depends on. Empty if the backend cannot load an effect from generated code.
+		/// </summary>
+		virtual std::string generated_effect_backend() const { return std::string(); }
+		/// <summary>
+		/// Hand out the reflection and the code generated by the last successful call to <see cref="load_effect"/>, so that they can be stored and passed to <see cref="load_generated_effect"/> on the next start.
+		/// </summary>
+		/// <returns>Returns <c>false</c> if the backend did not generate any code it can load again.</returns>
+		virtual bool take_generated_effect(reshadefx::effect_reflection &reflection, std::vector<std::string> &code) { return false; }
+		/// <summary>
+		/// Initialize textures, constants and techniques from the reflection and the code a backend generated for an effect earlier, without parsing its source again.
+		/// </summary>
+		/// <param name="reflection">The reflection of the effect.</param>
+		/// <param name="code">The code returned by <see cref="take_generated_effect"/>.</param>
+		/// <param name="errors">A reference to a buffer to store errors which occur during compilation.</param>
+		/// <returns>Returns <c>false</c> if the code cannot be used, e.g. because it refers to state objects created for other effects, in which case the effect is compiled from its source instead.</returns>
+		virtual bool load_generated_effect(const reshadefx::effect_reflection &reflection, const std::vector<std::string> &code, std::string &errors) { return false; }
 
 		/// <summary>
 		/// Loads image files and updates all textures with image data.
@@ -176,6 +236,22 @@ namespace reshade
 		/// <param name="data">The 32bpp RGBA image data to update the texture to.</param>
 		virtual bool update_texture(texture &texture, const uint8_t *data) = 0;
 
+		/// <summary>
+		/// Returns whether the backend can render intermediate render targets at a reduced scale, see <see cref="effect_render_scale"/>.
+		/// </summary>
+		virtual bool supports_render_scale() const { return false; }
+		/// <summary>
+		/// Called every frame after the enabled state of all techniques was updated and before any of them is rendered. Backends that can merge techniques into fewer passes rebuild their groups here.
+		/// </summary>
+		virtual void update_technique_fusion() { }
+		/// <summary>
+		/// Returns how many enabled techniques a call to <see cref="render_technique"/> draws, starting with the specified one. Zero means the technique is drawn together with a preceding one.
+		/// </summary>
+		virtual unsigned int get_technique_group_size(const technique &technique) const { return 1; }
+		/// <summary>
+		/// Returns how often shaders were compiled for the loaded effects and how many shader objects their passes share.
+		/// </summary>
+		virtual shader_object_statistics get_shader_statistics() const { return { }; }
 		/// <summary>
 		/// Render all passes in a technique.
 		/// </summary>
@@ -196,18 +272,40 @@ namespace reshade
 		ImGuiContext *_imgui_context = nullptr;
 		std::unique_ptr<ImFontAtlas> _imgui_font_atlas;
 		std::unique_ptr<base_object> _imgui_font_atlas_texture;
-		std::vector<texture> _textures;
-		std::vector<uniform> _uniforms;
-		std::vector<technique> _techniques;
+		resource_registry<texture> _textures;
+		resource_registry<uniform> _uniforms;
+		resource_registry<technique> _techniques;
 
 	private:
 		struct key_shortcut { uint8_t keycode; bool ctrl, shift; };
+		struct uniform_group
+		{
+			std::string effect_filename;
+			/// <summary>
+			/// The range of positions in the uniform list the effect occupies.
+			/// </summary>
+			size_t first = 0, last = 0;
+			/// <summary>
+			/// The positions of the uniforms that are listed in the variable editor with the current filter.
+			/// </summary>
+			std::vector<size_t> visible;
+		};
 
 		void reload();
+		void update_effect_render_scale(const std::vector<std::string> &technique_names);
+		bool compile_effect(const filesystem::path &path, const std::string &source, std::string &errors);
 		void load_configuration();
 		void save_configuration() const;
 		void load_preset(const filesystem::path &path);
 		void save_preset(const filesystem::path &path) const;
+		/// <summary>
+		/// Record only what a change to a single uniform or technique affects, instead of reading back every value of the preset, since e.g. a slider that is dragged calls this every frame.
+		/// </summary>
+		void save_preset(const filesystem::path &path, const uniform &variable) const;
+		void save_preset(const filesystem::path &path, const technique &technique) const;
+		void add_preset_values(preset_writer::values &preset, const uniform &variable) const;
+		void add_preset_values(preset_writer::values &preset, const technique &technique) const;
+		void add_preset_technique_list(preset_writer::values &preset) const;
 		void save_screenshot() const;
 
 		void draw_overlay();
@@ -218,8 +316,11 @@ namespace reshade
 		void draw_overlay_menu_about();
 		void draw_overlay_variable_editor();
 		void draw_overlay_technique_editor();
+		void draw_overlay_framerate(ImFont *font);
 
 		void filter_techniques(const std::string &filter);
+		void update_uniform_groups();
+		void apply_uniform_updates();
 
 		const unsigned int _renderer_id;
 		bool _is_initialized = false;
@@ -227,6 +328,8 @@ namespace reshade
 		std::chrono::high_resolution_clock::time_point _start_time, _last_reload_time, _last_present_time;
 		std::chrono::high_resolution_clock::duration _last_frame_duration;
 		std::vector<unsigned char> _uniform_data_storage;
+		std::mutex _uniform_update_mutex;
+		std::vector<uniform_update::value> _uniform_updates;
 		int _date[4] = { };
 		std::string _errors;
 		std::vector<std::string> _preprocessor_definitions;
@@ -235,6 +338,11 @@ namespace reshade
 		filesystem::path _screenshot_path;
 		bool _show_menu = false, _show_error_log = false, _performance_mode = false, _effects_enabled = true;
 		bool _show_clock = false, _show_framerate = false;
+		frame_budget_governor _budget_governor;
+		struct overlay_cache;
+		std::unique_ptr<overlay_cache> _overlay_cache;
+		std::vector<uniform_group> _uniform_groups;
+		mutable preset_writer _preset_writer;
 		bool _overlay_key_setting_active = false, _screenshot_key_setting_active = false, _toggle_key_setting_active = false;
 		float _imgui_col_background[3] = { 0.275f, 0.275f, 0.275f }, _imgui_col_item_background[3] = { 0.447f, 0.447f, 0.447f };
 		float _imgui_col_active[3] = { 0.2f, 0.5f, 0.6f }, _imgui_col_text[3] = { 0.8f, 0.9f, 0.9f }, _imgui_col_text_fps[3] = { 1.0f, 1.0f, 0.0f };
@@ -242,6 +350,8 @@ namespace reshade
 		unsigned int _effects_expanded_state = 2;
 		char _effect_filter_buffer[64] = { };
 		size_t _reload_remaining_effects = 0, _texture_count = 0, _uniform_count = 0, _technique_count = 0;
+		std::unique_ptr<ini_file> _reload_preset;
+		float _effect_render_scale = 1.0f;
     bool _installed_sk_callbacks;
 	};
 }
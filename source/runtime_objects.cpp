@@ -5,32 +5,93 @@
 
 #include "runtime.hpp"
 #include "runtime_objects.hpp"
+#include "uniform_layout.hpp"
+#include "effect_reflection.hpp"
 #include <assert.h>
+#include <iterator>
 #include <algorithm>
 
 namespace reshade
 {
-	void runtime::add_texture(texture &&texture)
+	resource_handle runtime::add_texture(texture &&texture)
 	{
-		_textures.push_back(std::move(texture));
+		return _textures.insert(std::move(texture));
 	}
-	void runtime::add_uniform(uniform &&uniform)
+	resource_handle runtime::add_uniform(uniform &&uniform)
 	{
-		_uniforms.push_back(std::move(uniform));
+		// Variables without strides are stored without padding, column by column
+		if (uniform.storage_row_stride == 0)
+		{
+			uniform.storage_row_stride = 4;
+		}
+		if (uniform.storage_column_stride == 0)
+		{
+			uniform.storage_column_stride = uniform.rows * 4;
+		}
+		if (uniform.storage_element_stride == 0)
+		{
+			uniform.storage_element_stride = uniform.columns * uniform.storage_column_stride;
+		}
+
+		return _uniforms.insert(std::move(uniform));
+	}
+	resource_handle runtime::add_uniform(const reshadefx::uniform_info &info, size_t block_offset, bool store_as_float)
+	{
+		uniform obj;
+		obj.name = info.name;
+		obj.unique_name = info.unique_name;
+		obj.basetype = obj.displaytype = info.basetype;
+		obj.rows = info.rows;
+		obj.columns = info.columns;
+		obj.elements = info.elements;
+		obj.storage_offset = block_offset + info.offset;
+		obj.storage_size = info.size;
+		obj.storage_element_stride = info.element_stride;
+		obj.storage_column_stride = info.column_stride;
+		obj.storage_row_stride = info.row_stride;
+		obj.annotations = info.annotations;
+
+		std::vector<uint32_t> initial_value = info.initial_value;
+
+		if (store_as_float && info.basetype != uniform_datatype::floating_point)
+		{
+			// D3D9 constant registers only hold floats, so integer and boolean values are converted like a cast in the shader would
+			for (auto &component : initial_value)
+			{
+				const float value = info.basetype == uniform_datatype::signed_integer ? static_cast<float>(static_cast<int32_t>(component)) : static_cast<float>(component);
+
+				std::memcpy(&component, &value, 4);
+			}
+		}
+
+		assert(initial_value.size() * 4 <= obj.storage_size);
+
+		uniform_layout::scatter(obj.rows, obj.columns, obj.storage_element_stride, obj.storage_column_stride, obj.storage_row_stride, initial_value.data(), initial_value.size(), _uniform_data_storage.data() + obj.storage_offset);
+
+		if (store_as_float)
+		{
+			obj.basetype = uniform_datatype::floating_point;
+		}
+
+		return _uniforms.insert(std::move(obj));
 	}
-	void runtime::add_technique(technique &&technique)
+	resource_handle runtime::add_technique(technique &&technique)
 	{
-		_techniques.push_back(std::move(technique));
+		return _techniques.insert(std::move(technique));
 	}
 	texture *runtime::find_texture(const std::string &name)
 	{
-		const auto it = std::find_if(_textures.begin(), _textures.end(),
-			[name](const auto &item)
-			{
-				return item.name == name;
-			});
+		return _textures.find(name);
+	}
+
+	size_t runtime::allocate_uniform_storage(size_t size)
+	{
+		const size_t offset = _uniform_data_storage.size();
+
+		// The whole block is allocated at once, so the buffer grows only once per effect
+		_uniform_data_storage.resize(offset + size);
 
-		return it != _textures.end() ? &(*it) : nullptr;
+		return offset;
 	}
 
 	void runtime::get_uniform_value(const uniform &variable, unsigned char *data, size_t size) const
@@ -39,9 +100,9 @@ namespace reshade
 
 		size = std::min(size, variable.storage_size);
 
-		assert(variable.storage_offset + size <= _uniform_data_storage.size());
+		assert(variable.storage_offset < _uniform_data_storage.size());
 
-		std::memcpy(data, &_uniform_data_storage[variable.storage_offset], size);
+		uniform_layout::gather(variable.rows, variable.columns, variable.storage_element_stride, variable.storage_column_stride, variable.storage_row_stride, &_uniform_data_storage[variable.storage_offset], data, size / 4);
 	}
 	void runtime::get_uniform_value(const uniform &variable, bool *values, size_t count) const
 	{
@@ -132,9 +193,9 @@ namespace reshade
 
 		size = std::min(size, variable.storage_size);
 
-		assert(variable.storage_offset + size <= _uniform_data_storage.size());
+		assert(variable.storage_offset < _uniform_data_storage.size());
 
-		std::memcpy(&_uniform_data_storage[variable.storage_offset], data, size);
+		uniform_layout::scatter(variable.rows, variable.columns, variable.storage_element_stride, variable.storage_column_stride, variable.storage_row_stride, data, size / 4, &_uniform_data_storage[variable.storage_offset]);
 	}
 	void runtime::set_uniform_value(uniform &variable, const bool *values, size_t count)
 	{
@@ -242,4 +303,72 @@ namespace reshade
 			}
 		}
 	}
+
+	void runtime::commit(uniform_update &&update)
+	{
+		if (update.empty())
+		{
+			return;
+		}
+
+		const std::lock_guard<std::mutex> lock(_uniform_update_mutex);
+
+		if (_uniform_updates.empty())
+		{
+			_uniform_updates = std::move(update._values);
+		}
+		else
+		{
+			_uniform_updates.insert(_uniform_updates.end(), std::make_move_iterator(update._values.begin()), std::make_move_iterator(update._values.end()));
+		}
+	}
+	void runtime::apply_uniform_updates()
+	{
+		std::vector<uniform_update::value> updates;
+
+		// Take all committed batches at once, so that writers are blocked only for the swap and never see a partially applied batch
+		{
+			const std::lock_guard<std::mutex> lock(_uniform_update_mutex);
+
+			updates.swap(_uniform_updates);
+		}
+
+		for (const auto &value : updates)
+		{
+			const auto variable = _uniforms.find(value.name,
+				[&value](const uniform &candidate) {
+					return candidate.effect_filename == value.effect;
+				});
+
+			if (variable == nullptr)
+			{
+				continue;
+			}
+
+			switch (value.type)
+			{
+				case uniform_datatype::boolean:
+				{
+					bool values[16] = { };
+
+					for (unsigned int i = 0; i < value.count; i++)
+					{
+						values[i] = reinterpret_cast<const unsigned int *>(value.data)[i] != 0;
+					}
+
+					set_uniform_value(*variable, values, value.count);
+					break;
+				}
+				case uniform_datatype::signed_integer:
+					set_uniform_value(*variable, reinterpret_cast<const int *>(value.data), value.count);
+					break;
+				case uniform_datatype::unsigned_integer:
+					set_uniform_value(*variable, reinterpret_cast<const unsigned int *>(value.data), value.count);
+					break;
+				case uniform_datatype::floating_point:
+					set_uniform_value(*variable, reinterpret_cast<const float *>(value.data), value.count);
+					break;
+			}
+		}
+	}
 }
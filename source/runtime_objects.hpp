@@ -12,7 +12,9 @@
 #include "variant.hpp"
 #include "moving_average.hpp"
 
+#ifdef _WIN32
 #include <d3d11.h>
+#endif
 
 namespace reshade
 {
@@ -69,8 +71,16 @@ namespace reshade
 		unsigned_integer,
 		floating_point
 	};
+	enum class uniform_widget
+	{
+		none,
+		input,
+		drag,
+		combo,
+		color
+	};
 
-	class base_object abstract
+	class base_object
 	{
 	public:
 		virtual ~base_object() { }
@@ -114,10 +124,27 @@ namespace reshade
 		uniform_datatype basetype = uniform_datatype::floating_point;
 		uniform_datatype displaytype = uniform_datatype::floating_point;
 		unsigned int rows = 0, columns = 0, elements = 0;
-		size_t storage_offset = 0, storage_size = 0;
+		/// <summary>
+		/// The location of the value in the uniform storage. The size does not include padding, which the layout rules of the backend may insert between array elements and matrix columns, so
+		/// the value has to be copied component by component using the strides (see <see cref="uniform_layout::scatter"/>).
+		/// </summary>
+		size_t storage_offset = 0, storage_size = 0, storage_element_stride = 0, storage_column_stride = 0, storage_row_stride = 0;
 		std::unordered_map<std::string, variant> annotations;
 		bool hidden = false;
+
+		/// <summary>
+		/// The UI annotations, parsed once after the effect was loaded, so that the variable editor does not have to look them up and convert them every frame.
+		/// </summary>
+		struct ui_metadata
+		{
+			uniform_widget widget = uniform_widget::none;
+			bool editable = false;
+			std::string label, tooltip, items;
+			int min_int = 0, max_int = 0;
+			float min = 0.0f, max = 0.0f, step = 0.0f;
+		} ui;
 	};
+#ifdef _WIN32
 	struct disjoint_timer_query final
 	{
 		volatile ID3D11Query* async  = nullptr;
@@ -145,6 +172,7 @@ namespace reshade
 		disjoint_timer_query   disjoint_query;
 		bool                   disjoint_done   = false;
 	};
+#endif
 	struct technique final
 	{
 		#pragma region Constructors and Assignment Operators
@@ -162,9 +190,15 @@ namespace reshade
 		bool enabled = false, hidden = false;
 		int timeout = 0, timeleft = 0, toggle_key = 0;
 		bool toggle_key_ctrl = false, toggle_key_shift = false, toggle_key_alt = false;
+		float render_scale = 1.0f;
+		int priority = 0;
+		bool suspended = false;
 		moving_average<uint64_t, 60> average_cpu_duration;
 		moving_average<float, 60> average_gpu_duration;
+#ifdef _WIN32
 		gpu_interval_timer timer;
+#endif
 		ptrdiff_t uniform_storage_offset = 0, uniform_storage_index = -1;
+		unsigned int resource_bindings = 0;
 	};
 }
\ No newline at end of file
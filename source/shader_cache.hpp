@@ -0,0 +1,114 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace reshade
+{
+	/// <summary>
+	/// Remembers compiled shader bytecode across effect reloads. Entries are keyed on the complete generated source code, which contains the values of all uniforms that were turned into constants,
+	/// so switching back to a previously used preset in performance mode finds the specialized shaders again instead of invoking the shader compiler.
+	/// Each distinct source is stored once and shared between all entry points compiled from it, the least recently used sources are evicted first.
+	/// </summary>
+	class shader_cache
+	{
+	public:
+		struct compiled_shader
+		{
+			std::string bytecode, messages;
+		};
+
+		explicit shader_cache(size_t max_sources = 32) : _max_sources(max_sources) { }
+		shader_cache(const shader_cache &) = delete;
+		shader_cache &operator=(const shader_cache &) = delete;
+
+		/// <summary>
+		/// Look up the compilation result of an entry point.
+		/// </summary>
+		/// <param name="source">The complete source code the entry point is compiled from.</param>
+		/// <param name="entry_point">The name of the entry point function.</param>
+		/// <param name="profile">The shader model profile and any other compiler options that affect the result.</param>
+		/// <param name="result">Receives the bytecode and compiler messages on success.</param>
+		/// <returns>Returns <c>true</c> if the entry point was found, <c>false</c> if it has to be compiled.</returns>
+		bool find(const std::string &source, const std::string &entry_point, const std::string &profile, compiled_shader &result)
+		{
+			const std::lock_guard<std::mutex> lock(_mutex);
+
+			const auto it = _sources.find(source);
+
+			if (it == _sources.end())
+			{
+				return false;
+			}
+
+			const auto shader = it->second.shaders.find(profile + ' ' + entry_point);
+
+			if (shader == it->second.shaders.end())
+			{
+				return false;
+			}
+
+			it->second.last_use = ++_use_counter;
+			result = shader->second;
+
+			return true;
+		}
+		/// <summary>
+		/// Store the successful compilation result of an entry point.
+		/// </summary>
+		/// <param name="source">The complete source code the entry point was compiled from.</param>
+		/// <param name="entry_point">The name of the entry point function.</param>
+		/// <param name="profile">The shader model profile and any other compiler options that affect the result.</param>
+		/// <param name="result">The bytecode and compiler messages to store.</param>
+		void insert(const std::string &source, const std::string &entry_point, const std::string &profile, const compiled_shader &result)
+		{
+			const std::lock_guard<std::mutex> lock(_mutex);
+
+			if (_sources.size() >= _max_sources && _sources.find(source) == _sources.end())
+			{
+				auto oldest = _sources.begin();
+
+				for (auto it = _sources.begin(); it != _sources.end(); ++it)
+				{
+					if (it->second.last_use < oldest->second.last_use)
+					{
+						oldest = it;
+					}
+				}
+
+				_sources.erase(oldest);
+			}
+
+			auto &entry = _sources[source];
+			entry.last_use = ++_use_counter;
+			entry.shaders[profile + ' ' + entry_point] = result;
+		}
+		/// <summary>
+		/// Remove all entries, e.g. because the device changed.
+		/// </summary>
+		void clear()
+		{
+			const std::lock_guard<std::mutex> lock(_mutex);
+
+			_sources.clear();
+		}
+
+	private:
+		struct source_entry
+		{
+			unsigned long long last_use = 0;
+			std::unordered_map<std::string, compiled_shader> shaders;
+		};
+
+		const size_t _max_sources;
+		std::mutex _mutex;
+		unsigned long long _use_counter = 0;
+		std::unordered_map<std::string, source_entry> _sources;
+	};
+}
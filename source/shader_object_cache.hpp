@@ -0,0 +1,138 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+namespace reshade
+{
+	struct shader_object_statistics
+	{
+		/// <summary>
+		/// The number of times the shader compiler was invoked, which does not include shaders taken from the bytecode cache.
+		/// </summary>
+		size_t compilations = 0;
+		/// <summary>
+		/// The number of passes that received a shader object another pass created before.
+		/// </summary>
+		size_t hits = 0;
+		/// <summary>
+		/// The number of distinct shader objects alive.
+		/// </summary>
+		size_t objects = 0;
+
+		shader_object_statistics &operator+=(const shader_object_statistics &other)
+		{
+			compilations += other.compilations;
+			hits += other.hits;
+			objects += other.objects;
+
+			return *this;
+		}
+	};
+
+	/// <summary>
+	/// Build the key under which the shader compiled from the specified source is stored in a <see cref="shader_object_cache"/>.
+	/// </summary>
+	/// <param name="source">The complete source code the entry point is compiled from.</param>
+	/// <param name="entry_point">The name of the entry point function.</param>
+	/// <param name="profile">The shader type and profile and any other compiler options that affect the result.</param>
+	inline std::string make_shader_object_key(const std::string &source, const std::string &entry_point, const std::string &profile)
+	{
+		return profile + ' ' + entry_point + '\n' + source;
+	}
+
+	/// <summary>
+	/// Shares shader objects between all passes of all effects that are compiled from the same generated source code. The code generators only declare what an entry point references,
+	/// so a shader like the vertex shader most effects include from ReShade.fxh is generated identically everywhere and only created once.
+	/// </summary>
+	template <typename T>
+	class shader_object_cache
+	{
+	public:
+		/// <summary>
+		/// Look up a shader object another pass created before.
+		/// </summary>
+		/// <param name="key">The key built by <see cref="make_shader_object_key"/>.</param>
+		/// <param name="object">Receives the shared shader object on success.</param>
+		/// <param name="messages">Receives the compiler messages that were emitted when the shader was compiled, so that they can be reported again.</param>
+		/// <returns>Returns <c>true</c> if the shader object was found, <c>false</c> if it has to be created.</returns>
+		bool find(const std::string &key, T &object, std::string &messages)
+		{
+			const auto it = _entries.find(key);
+
+			if (it == _entries.end())
+			{
+				return false;
+			}
+
+			_statistics.hits++;
+
+			object = it->second.object;
+			messages = it->second.messages;
+
+			return true;
+		}
+		/// <summary>
+		/// Store a successfully created shader object.
+		/// </summary>
+		/// <param name="key">The key built by <see cref="make_shader_object_key"/>.</param>
+		/// <param name="object">The shader object to share.</param>
+		/// <param name="messages">The compiler messages that were emitted when the shader was compiled.</param>
+		void insert(const std::string &key, const T &object, const std::string &messages)
+		{
+			auto &entry = _entries[key];
+			entry.object = object;
+			entry.messages = messages;
+		}
+		/// <summary>
+		/// Record that the shader compiler was invoked for a shader stored in this cache.
+		/// </summary>
+		void count_compilation()
+		{
+			_statistics.compilations++;
+		}
+
+		/// <summary>
+		/// Remove all entries and reset the statistics, e.g. because the effects are unloaded.
+		/// </summary>
+		/// <param name="release">A function called with every shader object before it is removed.</param>
+		template <typename F>
+		void clear(F release)
+		{
+			for (auto &entry : _entries)
+			{
+				release(entry.second.object);
+			}
+
+			_entries.clear();
+			_statistics = shader_object_statistics();
+		}
+		void clear()
+		{
+			clear([](T &) { });
+		}
+
+		shader_object_statistics statistics() const
+		{
+			auto result = _statistics;
+			result.objects = _entries.size();
+
+			return result;
+		}
+
+	private:
+		struct entry
+		{
+			T object;
+			std::string messages;
+		};
+
+		shader_object_statistics _statistics;
+		std::unordered_map<std::string, entry> _entries;
+	};
+}
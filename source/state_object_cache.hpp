@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <cstring>
+#include <utility>
+#include <type_traits>
+#include <unordered_map>
+
+namespace reshade
+{
+	/// <summary>
+	/// Maps state descriptors to the objects created from them, so that all passes with equal states share one object. The hash of a descriptor is only used to find candidates,
+	/// which are then compared in full, so a collision can never hand out an object created for a different descriptor.
+	/// Descriptors are hashed and compared bytewise. They have to be zero-initialized before their members are set, so that any padding between the members compares equal too.
+	/// </summary>
+	template <typename Desc, typename Object>
+	class state_object_cache
+	{
+		static_assert(std::is_trivially_copyable<Desc>::value, "state descriptors are hashed and compared bytewise");
+
+	public:
+		/// <summary>
+		/// Look up the object that was created for a descriptor equal to the specified one.
+		/// </summary>
+		/// <param name="desc">The descriptor to look up.</param>
+		/// <returns>A pointer to the object, or <c>nullptr</c> if none was created for this descriptor yet.</returns>
+		const Object *find(const Desc &desc) const
+		{
+			const auto it = _objects.find(key(desc));
+
+			return it != _objects.end() ? &it->second : nullptr;
+		}
+		/// <summary>
+		/// Store the object that was created for the specified descriptor.
+		/// </summary>
+		/// <param name="desc">The descriptor the object was created from.</param>
+		/// <param name="object">The object to share.</param>
+		/// <returns>A reference to the stored object.</returns>
+		const Object &insert(const Desc &desc, Object object)
+		{
+			return _objects[key(desc)] = std::move(object);
+		}
+
+		/// <summary>
+		/// Returns the number of distinct descriptors stored.
+		/// </summary>
+		size_t size() const { return _objects.size(); }
+
+		/// <summary>
+		/// Remove all entries, e.g. because the effects are unloaded.
+		/// </summary>
+		/// <param name="release">A function called with every object before it is removed.</param>
+		template <typename F>
+		void clear(F release)
+		{
+			for (auto &entry : _objects)
+			{
+				release(entry.second);
+			}
+
+			_objects.clear();
+		}
+		void clear()
+		{
+			_objects.clear();
+		}
+
+	private:
+		struct key
+		{
+			explicit key(const Desc &value) : hash(2166136261)
+			{
+				std::memcpy(&desc, &value, sizeof(Desc));
+
+				for (size_t i = 0; i < sizeof(Desc); ++i)
+				{
+					hash = (hash * 16777619) ^ reinterpret_cast<const unsigned char *>(&desc)[i];
+				}
+			}
+
+			bool operator==(const key &other) const
+			{
+				return hash == other.hash && std::memcmp(&desc, &other.desc, sizeof(Desc)) == 0;
+			}
+
+			Desc desc;
+			size_t hash;
+		};
+		struct key_hash
+		{
+			size_t operator()(const key &value) const { return value.hash; }
+		};
+
+		std::unordered_map<key, Object, key_hash> _objects;
+	};
+}
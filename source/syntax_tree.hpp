@@ -6,6 +6,7 @@
 #pragma once
 
 #include <list>
+#include <algorithm>
 #include "syntax_tree_nodes.hpp"
 
 namespace reshadefx
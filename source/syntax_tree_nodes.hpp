@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <cfloat>
 #include "variant.hpp"
 #include "source_location.hpp"
 #include "runtime_objects.hpp"
@@ -47,13 +48,13 @@ namespace reshadefx
 		pass_declaration,
 		technique_declaration,
 	};
-	class node abstract
+	class node
 	{
 		void operator=(const node &) = delete;
 
 	public:
 		const nodeid id;
-		location location;
+		reshadefx::location location;
 
 	protected:
 		explicit node(nodeid id) : id(id), location() { }
@@ -121,21 +122,21 @@ namespace reshadefx::nodes
 		struct struct_declaration_node *definition;
 	};
 	
-	struct expression_node abstract : public node
+	struct expression_node : public node
 	{
 		type_node type;
 
 	protected:
 		expression_node(nodeid id) : node(id) { }
 	};
-	struct statement_node abstract : public node
+	struct statement_node : public node
 	{
 		std::vector<std::string> attributes;
 
 	protected:
 		statement_node(nodeid id) : node(id) { }
 	};
-	struct declaration_node abstract : public node
+	struct declaration_node : public node
 	{
 		std::string name, unique_name;
 
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <string>
+#include <locale>
 #include <codecvt>
 
 inline std::string utf16_to_utf8(const std::wstring &s)
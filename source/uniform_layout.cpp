@@ -0,0 +1,123 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "uniform_layout.hpp"
+#include <assert.h>
+#include <cstring>
+
+namespace reshade
+{
+	namespace
+	{
+		inline size_t align(size_t offset, size_t alignment)
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		/// <summary>
+		/// Returns the byte offset of a component from the start of a member, given its index in declaration order.
+		/// </summary>
+		inline size_t component_offset(size_t index, unsigned int rows, unsigned int columns, size_t element_stride, size_t column_stride, size_t row_stride)
+		{
+			const size_t element = index / (rows * columns), component = index % (rows * columns);
+
+			// Values list matrix components row by row, the strides say where the block stores each row and column
+			return element * element_stride + (component % columns) * column_stride + (component / columns) * row_stride;
+		}
+	}
+
+	size_t uniform_layout::add(unsigned int rows, unsigned int columns, unsigned int elements)
+	{
+		assert(rows >= 1 && rows <= 4 && columns >= 1 && columns <= 4);
+
+		const bool is_array = elements > 0, is_matrix = columns > 1;
+		const size_t element_count = is_array ? elements : 1;
+
+		// Matrices are stored column by column, so every column is a vector with one component per row
+		const size_t vector_size = rows * 4;
+		size_t offset = 0, size = 0, element_stride = columns * vector_size, column_stride = vector_size, row_stride = 4;
+
+		switch (_rules)
+		{
+			case rules::hlsl_cbuffer:
+			{
+				if (is_array || is_matrix)
+				{
+					// Every array element and matrix column starts on a new register, but the last one is not padded
+					const size_t element_size = (columns - 1) * 16 + vector_size;
+
+					offset = align(_size, 16);
+					size = (element_count - 1) * align(element_size, 16) + element_size;
+					element_stride = align(element_size, 16);
+					column_stride = 16;
+				}
+				else
+				{
+					offset = _size;
+					size = vector_size;
+
+					if (offset / 16 != (offset + size - 1) / 16)
+					{
+						offset = align(offset, 16);
+					}
+				}
+				break;
+			}
+			case rules::d3d9_registers:
+			{
+				offset = align(_size, 16);
+				size = element_count * columns * 16;
+				element_stride = columns * 16;
+				column_stride = 16;
+				break;
+			}
+			case rules::std140:
+			{
+				if (is_matrix)
+				{
+					// Every row is a GLSL column, which is rounded up to the size of a four-component vector, including the last one
+					offset = align(_size, 16);
+					size = element_count * rows * 16;
+					element_stride = rows * 16;
+					column_stride = 4;
+					row_stride = 16;
+				}
+				else if (is_array)
+				{
+					// Array elements are rounded up to the size of a four-component vector, including the last one
+					offset = align(_size, 16);
+					size = element_count * 16;
+					element_stride = 16;
+				}
+				else
+				{
+					offset = align(_size, rows == 1 ? 4 : rows == 2 ? 8 : 16);
+					size = vector_size;
+				}
+				break;
+			}
+		}
+
+		_size = offset + size;
+		_members.push_back({ offset, size, element_stride, column_stride, row_stride });
+
+		return offset;
+	}
+
+	void uniform_layout::scatter(unsigned int rows, unsigned int columns, size_t element_stride, size_t column_stride, size_t row_stride, const void *values, size_t count, void *storage)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			std::memcpy(static_cast<unsigned char *>(storage) + component_offset(i, rows, columns, element_stride, column_stride, row_stride), static_cast<const unsigned char *>(values) + i * 4, 4);
+		}
+	}
+	void uniform_layout::gather(unsigned int rows, unsigned int columns, size_t element_stride, size_t column_stride, size_t row_stride, const void *storage, void *values, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			std::memcpy(static_cast<unsigned char *>(values) + i * 4, static_cast<const unsigned char *>(storage) + component_offset(i, rows, columns, element_stride, column_stride, row_stride), 4);
+		}
+	}
+}
@@ -0,0 +1,96 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace reshade
+{
+	/// <summary>
+	/// Packs the uniform variables of an effect into a single block of memory, following the rules of the constant storage the backend uploads the block to.
+	/// All members are added before any storage is allocated, so that the final size of the block is known up front.
+	/// </summary>
+	class uniform_layout
+	{
+	public:
+		enum class rules
+		{
+			/// <summary>
+			/// HLSL constant buffers (D3D10 and D3D11). Members do not straddle 16 byte boundaries, arrays and matrices start on a new register and have a stride of 16 bytes per element or column.
+			/// </summary>
+			hlsl_cbuffer,
+			/// <summary>
+			/// D3D9 float4 constant registers. Every member starts on a new register and every array element or matrix column occupies a register of its own.
+			/// </summary>
+			d3d9_registers,
+			/// <summary>
+			/// GLSL std140 uniform blocks. Scalars and two-component vectors are aligned to their size, everything else to 16 bytes, arrays and matrices are padded to 16 bytes per element or column.
+			/// The OpenGL code generator declares a floatRxC as matRxC, which GLSL reads as R columns of C components, so every row of the matrix occupies a vector of its own.
+			/// </summary>
+			std140
+		};
+
+		struct member
+		{
+			size_t offset, size;
+			/// <summary>
+			/// The distance in bytes between consecutive array elements, between consecutive matrix columns and between consecutive matrix rows.
+			/// </summary>
+			size_t element_stride, column_stride, row_stride;
+		};
+
+		explicit uniform_layout(rules rules) : _rules(rules) { }
+
+		/// <summary>
+		/// Append a uniform variable to the layout.
+		/// </summary>
+		/// <param name="rows">The number of components in a vector, or the number of rows in a matrix.</param>
+		/// <param name="columns">The number of columns in a matrix, one for scalars and vectors.</param>
+		/// <param name="elements">The array length, or zero if the variable is not an array.</param>
+		/// <returns>The offset of the variable from the start of the block in bytes.</returns>
+		size_t add(unsigned int rows, unsigned int columns, unsigned int elements = 0);
+
+		/// <summary>
+		/// Returns the member that was added at the specified position.
+		/// </summary>
+		const member &operator[](size_t index) const { return _members[index]; }
+		/// <summary>
+		/// Returns the number of members added so far.
+		/// </summary>
+		size_t member_count() const { return _members.size(); }
+		/// <summary>
+		/// Returns the size of the block in bytes, padded to a multiple of 16 bytes. Zero if no member was added.
+		/// </summary>
+		size_t total_size() const { return (_size + 15) & ~size_t(15); }
+		/// <summary>
+		/// Returns the number of float4 registers the block occupies.
+		/// </summary>
+		size_t register_count() const { return total_size() / 16; }
+
+		/// <summary>
+		/// Copy the components of a value to where the layout places them in the block. Components are in declaration order, i.e. array element by array element and matrices row by row.
+		/// </summary>
+		/// <param name="rows">The number of components in a vector, or the number of rows in a matrix.</param>
+		/// <param name="columns">The number of columns in a matrix, one for scalars and vectors.</param>
+		/// <param name="element_stride">The distance between array elements in the block, as returned in <see cref="member::element_stride"/>.</param>
+		/// <param name="column_stride">The distance between matrix columns in the block, as returned in <see cref="member::column_stride"/>.</param>
+		/// <param name="row_stride">The distance between matrix rows in the block, as returned in <see cref="member::row_stride"/>.</param>
+		/// <param name="values">The components to copy, four bytes each.</param>
+		/// <param name="count">The number of components to copy, starting with the first one.</param>
+		/// <param name="storage">The location of the member in the block.</param>
+		static void scatter(unsigned int rows, unsigned int columns, size_t element_stride, size_t column_stride, size_t row_stride, const void *values, size_t count, void *storage);
+		/// <summary>
+		/// Copy the components of a value from where the layout places them in the block into declaration order. This is the inverse of <see cref="scatter"/>.
+		/// </summary>
+		static void gather(unsigned int rows, unsigned int columns, size_t element_stride, size_t column_stride, size_t row_stride, const void *storage, void *values, size_t count);
+
+	private:
+		rules _rules;
+		size_t _size = 0;
+		std::vector<member> _members;
+	};
+}
@@ -0,0 +1,115 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include "runtime_objects.hpp"
+
+namespace reshade
+{
+	/// <summary>
+	/// A batch of uniform values written by a thread other than the render thread. The batch is filled without any synchronization and handed to <see cref="runtime::commit"/> as a whole,
+	/// after which the render thread applies all of its values together before it renders the next frame. Variables are identified by the file name of their effect and their name,
+	/// since different effects often declare variables of the same name, and are resolved only when the batch is applied, so a batch stays valid across effect reloads.
+	/// </summary>
+	class uniform_update
+	{
+	public:
+		struct value
+		{
+			std::string effect, name;
+			uniform_datatype type;
+			unsigned int count;
+			unsigned char data[16 * 4];
+		};
+
+		/// <summary>
+		/// Set the value of the uniform variable with the specified name in the specified effect. Values that were set for the same variable earlier in this batch are replaced.
+		/// </summary>
+		/// <param name="effect">The file name of the effect that declares the variable, e.g. "Tonemap.fx".</param>
+		/// <param name="name">The name of the variable.</param>
+		/// <param name="values">The values to set the variable to. They are converted to the type of the variable when the batch is applied.</param>
+		/// <param name="count">The number of values, at most 16.</param>
+		void set(const std::string &effect, const std::string &name, const bool *values, size_t count)
+		{
+			auto &entry = find_or_add(effect, name, uniform_datatype::boolean, count);
+
+			for (unsigned int i = 0; i < entry.count; i++)
+			{
+				reinterpret_cast<unsigned int *>(entry.data)[i] = values[i] ? 1 : 0;
+			}
+		}
+		void set(const std::string &effect, const std::string &name, const int *values, size_t count)
+		{
+			auto &entry = find_or_add(effect, name, uniform_datatype::signed_integer, count);
+			std::memcpy(entry.data, values, entry.count * sizeof(int));
+		}
+		void set(const std::string &effect, const std::string &name, const unsigned int *values, size_t count)
+		{
+			auto &entry = find_or_add(effect, name, uniform_datatype::unsigned_integer, count);
+			std::memcpy(entry.data, values, entry.count * sizeof(unsigned int));
+		}
+		void set(const std::string &effect, const std::string &name, const float *values, size_t count)
+		{
+			auto &entry = find_or_add(effect, name, uniform_datatype::floating_point, count);
+			std::memcpy(entry.data, values, entry.count * sizeof(float));
+		}
+		template <typename T>
+		void set(const std::string &effect, const std::string &name, T value)
+		{
+			set(effect, name, &value, 1);
+		}
+		/// <summary>
+		/// Set several scalar variables of the same effect at once.
+		/// </summary>
+		/// <param name="effect">The file name of the effect that declares the variables.</param>
+		/// <param name="values">Pairs of variable name and value.</param>
+		template <typename T>
+		void set_many(const std::string &effect, std::initializer_list<std::pair<const char *, T>> values)
+		{
+			for (const auto &it : values)
+			{
+				set(effect, it.first, &it.second, 1);
+			}
+		}
+
+		/// <summary>
+		/// Returns a boolean indicating whether no value was set.
+		/// </summary>
+		bool empty() const { return _values.empty(); }
+
+	private:
+		friend class runtime;
+
+		value &find_or_add(const std::string &effect, const std::string &name, uniform_datatype type, size_t count)
+		{
+			auto it = std::find_if(_values.begin(), _values.end(),
+				[&effect, &name](const value &entry) {
+					return entry.name == name && entry.effect == effect;
+				});
+
+			if (it == _values.end())
+			{
+				_values.emplace_back();
+				it = _values.end() - 1;
+				it->effect = effect;
+				it->name = name;
+			}
+
+			it->type = type;
+			it->count = static_cast<unsigned int>(std::min(count, sizeof(value::data) / 4));
+
+			return *it;
+		}
+
+		std::vector<value> _values;
+	};
+}
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2014 Patrick Mours. All rights reserved.
+# License: https://github.com/crosire/reshade#license
+#
+# Generates the sample PE images the export parser is tested and benchmarked against. They are checked in, so that neither the tests nor the benchmark need a Windows toolchain.
+# The images are minimal, but laid out like linker output: a code section with one stub per function and a read-only data section with the export directory.
+# The file alignment differs from the section alignment, so that parsing them as read from disk has to translate every address through the section table.
+#
+# usage: generate.py [output directory]
+
+import os
+import struct
+import sys
+
+FILE_ALIGNMENT = 0x200
+SECTION_ALIGNMENT = 0x1000
+HEADERS_SIZE = 0x400
+FUNCTION_SIZE = 16
+
+def align(value, alignment):
+	return (value + alignment - 1) & ~(alignment - 1)
+
+def read_definition_file(path):
+	names = []
+	with open(path) as file:
+		for line in file:
+			line = line.split(';', 1)[0].strip()
+			if line and line != 'EXPORTS':
+				names.append(line.split()[0])
+	return names
+
+def build_image(module_name, pe32_plus, functions, named, base=1):
+	"""
+	Builds a DLL image.
+	functions: list of forwarder strings or None for code, indexed by ordinal - base.
+	named: list of (name, function index) in the order they are written to the name table.
+	"""
+	text_size = len(functions) * FUNCTION_SIZE
+	text_rva = SECTION_ALIGNMENT
+	rdata_rva = text_rva + align(text_size, SECTION_ALIGNMENT)
+
+	# Export directory, followed by the address, name pointer and ordinal tables and then all strings
+	functions_offset = 40
+	names_offset = functions_offset + len(functions) * 4
+	ordinals_offset = names_offset + len(named) * 4
+	strings_offset = align(ordinals_offset + len(named) * 2, 4)
+
+	strings = bytearray()
+	def add_string(value):
+		offset = strings_offset + len(strings)
+		strings.extend(value.encode('ascii') + b'\0')
+		return rdata_rva + offset
+
+	module_name_rva = add_string(module_name)
+	name_rvas = [add_string(name) for name, _ in named]
+	function_rvas = []
+	for i, forwarder in enumerate(functions):
+		if forwarder is None:
+			function_rvas.append(text_rva + i * FUNCTION_SIZE)
+		else:
+			function_rvas.append(add_string(forwarder))
+
+	rdata = bytearray()
+	rdata += struct.pack('<IIHHIIIIIII', 0, 0, 0, 0, module_name_rva, base, len(functions), len(named), rdata_rva + functions_offset, rdata_rva + names_offset, rdata_rva + ordinals_offset)
+	rdata += b''.join(struct.pack('<I', rva) for rva in function_rvas)
+	rdata += b''.join(struct.pack('<I', rva) for rva in name_rvas)
+	rdata += b''.join(struct.pack('<H', index) for _, index in named)
+	rdata += bytes(strings_offset - len(rdata))
+	rdata += strings
+	export_directory_size = len(rdata)
+
+	# Every function is 'ret' followed by 'int 3' padding
+	text = b''.join(b'\xC3' + b'\xCC' * (FUNCTION_SIZE - 1) for _ in functions)
+
+	sections = [
+		(b'.text', text_rva, text, 0x60000020),
+		(b'.rdata', rdata_rva, bytes(rdata), 0x40000040),
+	]
+
+	size_of_image = align(rdata_rva + len(rdata), SECTION_ALIGNMENT)
+	data_directories = [(rdata_rva, export_directory_size)] + [(0, 0)] * 15
+
+	optional_header = bytearray()
+	if pe32_plus:
+		optional_header += struct.pack('<HBBIIIII', 0x20B, 14, 0, align(len(text), FILE_ALIGNMENT), align(len(rdata), FILE_ALIGNMENT), 0, 0, text_rva)
+		optional_header += struct.pack('<Q', 0x180000000)
+	else:
+		optional_header += struct.pack('<HBBIIIIII', 0x10B, 14, 0, align(len(text), FILE_ALIGNMENT), align(len(rdata), FILE_ALIGNMENT), 0, 0, text_rva, rdata_rva)
+		optional_header += struct.pack('<I', 0x10000000)
+	optional_header += struct.pack('<IIHHHHHHIIIIHH', SECTION_ALIGNMENT, FILE_ALIGNMENT, 6, 0, 0, 0, 6, 0, 0, size_of_image, HEADERS_SIZE, 0, 2, 0x0140)
+	optional_header += struct.pack('<QQQQ' if pe32_plus else '<IIII', 0x100000, 0x1000, 0x100000, 0x1000)
+	optional_header += struct.pack('<II', 0, len(data_directories))
+	optional_header += b''.join(struct.pack('<II', rva, size) for rva, size in data_directories)
+
+	machine, characteristics = (0x8664, 0x2022) if pe32_plus else (0x14C, 0x2102)
+
+	image = bytearray(b'MZ' + bytes(0x3A) + struct.pack('<I', 0x40))
+	image += b'PE\0\0'
+	image += struct.pack('<HHIIIHH', machine, len(sections), 0, 0, 0, len(optional_header), characteristics)
+	image += optional_header
+
+	raw_offset = HEADERS_SIZE
+	for name, rva, data, flags in sections:
+		raw_size = align(len(data), FILE_ALIGNMENT)
+		image += struct.pack('<8sIIIIIIHHI', name, len(data), rva, raw_size, raw_offset, 0, 0, 0, 0, flags)
+		raw_offset += raw_size
+
+	image += bytes(HEADERS_SIZE - len(image))
+	for _, _, data, _ in sections:
+		image += data + bytes(align(len(data), FILE_ALIGNMENT) - len(data))
+
+	return bytes(image)
+
+def build_sorted_image(module_name, pe32_plus, names, forwarders={}):
+	names = sorted(names, key=lambda name: name.encode('ascii'))
+	functions = [forwarders.get(name) for name in names]
+	return build_image(module_name, pe32_plus, functions, [(name, i) for i, name in enumerate(names)])
+
+def main():
+	output_path = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+	root_path = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', '..')
+
+	reshade_names = read_definition_file(os.path.join(root_path, 'res', 'exports.def'))
+
+	# The OpenGL exports ReShade replaces, together with some it does not, one of which is forwarded like the system module does with a few of its exports
+	opengl_names = [name for name in reshade_names if name.startswith(('gl', 'wgl'))]
+	opengl_names += ['GlmfBeginGlsBlock', 'GlmfCloseMetaFile', 'GlmfEndGlsBlock', 'GlmfEndPlayback', 'GlmfInitPlayback', 'GlmfPlayGlsRecord', 'glDebugEntry', 'wglGetDefaultProcAddress']
+	opengl_forwarders = { 'wglGetDefaultProcAddress': 'GDI32.wglGetDefaultProcAddress' }
+
+	images = {
+		'reshade_x64.dll': build_sorted_image('ReShade64.dll', True, reshade_names),
+		'opengl32_x86.dll': build_sorted_image('opengl32.dll', False, opengl_names, opengl_forwarders),
+		'opengl32_x64.dll': build_sorted_image('opengl32.dll', True, opengl_names, opengl_forwarders),
+		# Hand written export tables are not necessarily sorted, have an ordinal base other than one and exports without a name
+		'unsorted_x86.dll': build_image('unsorted.dll', False, [None, None, None, None, 'KERNEL32.Sleep'], [('Zeta', 0), ('Alpha', 3), ('Gamma', 4), ('Beta', 1)], base=5),
+		# An export table without any exports
+		'empty_exports_x64.dll': build_image('empty.dll', True, [], []),
+	}
+
+	for name, image in images.items():
+		with open(os.path.join(output_path, name), 'wb') as file:
+			file.write(image)
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,323 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "depth_source_tracker.hpp"
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace reshade;
+
+namespace
+{
+	unsigned int failures = 0;
+
+	#define CHECK_EQUAL(actual, expected) check_equal(actual, expected, #actual, __LINE__)
+
+	void check_equal(size_t actual, size_t expected, const char *expression, int line)
+	{
+		if (actual != expected)
+		{
+			std::fprintf(stderr, "line %d: %s is %zu, expected %zu\n", line, expression, actual, expected);
+			failures++;
+		}
+	}
+
+	const unsigned int width = 1920, height = 1080;
+	const unsigned int scene = 1, shadow_map = 2, half_resolution = 3, user_interface = 4;
+
+	struct draw
+	{
+		unsigned int depthstencil, drawcalls, vertices_per_drawcall;
+	};
+
+	/// <summary>
+	/// Submit a frame of draw calls in the specified order and score it, like a runtime does from its draw call hooks and on present.
+	/// </summary>
+	template <typename I>
+	unsigned int render_frame(depth_source_tracker<unsigned int, I> &tracker, const std::vector<draw> &draws, I *info = nullptr)
+	{
+		unsigned int drawcall = 0;
+
+		for (const auto &d : draws)
+		{
+			for (unsigned int i = 0; i < d.drawcalls; i++)
+			{
+				tracker.on_draw(d.depthstencil, ++drawcall, d.vertices_per_drawcall);
+			}
+		}
+
+		return tracker.update(drawcall, info);
+	}
+
+	// The scene is rendered after the shadow map and before the user interface, which draws to a depth stencil that is not tracked
+	const std::vector<draw> typical_frame = { { shadow_map, 5, 100 }, { scene, 10, 500 }, { user_interface, 5, 10 } };
+	// A cut scene that renders a huge shadow map and little of the scene
+	const std::vector<draw> shadow_heavy_frame = { { shadow_map, 10, 2000 }, { scene, 10, 500 }, { user_interface, 5, 10 } };
+
+	void test_selects_scene()
+	{
+		depth_source_tracker<unsigned int> tracker;
+		tracker.on_resize(width, height);
+
+		CHECK_EQUAL(render_frame(tracker, typical_frame), 0);
+
+		tracker.track(scene, width, height);
+		tracker.track(shadow_map, width, height);
+
+		// With a selection, the first frame with draw calls selects right away
+		CHECK_EQUAL(render_frame(tracker, typical_frame), scene);
+		CHECK_EQUAL(tracker.current(), scene);
+
+		// Nothing drawn in a frame does not change the selection
+		CHECK_EQUAL(render_frame(tracker, { }), scene);
+	}
+
+	void test_switch_needs_consecutive_frames()
+	{
+		depth_source_tracker<unsigned int> tracker;
+		tracker.on_resize(width, height);
+		tracker.track(scene, width, height);
+		tracker.track(shadow_map, width, height);
+
+		for (unsigned int i = 0; i < depth_source_tracker<unsigned int>::history_length; i++)
+		{
+			CHECK_EQUAL(render_frame(tracker, typical_frame), scene);
+		}
+
+		// A single unusual frame every now and then is averaged away
+		for (unsigned int i = 0; i < 32; i++)
+		{
+			CHECK_EQUAL(render_frame(tracker, i % 8 == 0 ? shadow_heavy_frame : typical_frame), scene);
+		}
+
+		// Once the shadow map scores better by the margin, it still takes several frames in a row to replace the selection
+		unsigned int frames = 0;
+
+		while (render_frame(tracker, shadow_heavy_frame) == scene && frames < 100)
+		{
+			frames++;
+		}
+
+		CHECK_EQUAL(frames >= depth_source_tracker<unsigned int>::switch_frames, true);
+		CHECK_EQUAL(frames < depth_source_tracker<unsigned int>::history_length, true);
+		CHECK_EQUAL(tracker.current(), shadow_map);
+	}
+
+	void test_size_must_match()
+	{
+		depth_source_tracker<unsigned int> tracker;
+		tracker.on_resize(width, height);
+		tracker.track(scene, width, height);
+		tracker.track(half_resolution, width / 2, height / 2);
+
+		// Within the tolerance still counts as the same size
+		tracker.track(shadow_map, width - 20, height + 20);
+
+		const std::vector<draw> frame = { { half_resolution, 50, 1000 }, { scene, 10, 500 }, { shadow_map, 1, 1 } };
+
+		for (unsigned int i = 0; i < 10; i++)
+		{
+			CHECK_EQUAL(render_frame(tracker, frame), scene);
+		}
+
+		// After a resize the previous selection no longer fits, so the half resolution one is selected without waiting
+		tracker.on_resize(width / 2, height / 2);
+
+		CHECK_EQUAL(render_frame(tracker, frame), half_resolution);
+	}
+
+	void test_release()
+	{
+		std::function<void()> release_scene;
+
+		{ depth_source_tracker<unsigned int> tracker;
+			tracker.on_resize(width, height);
+			tracker.track(scene, width, height);
+			tracker.track(shadow_map, width, height);
+
+			CHECK_EQUAL(render_frame(tracker, typical_frame), scene);
+
+			// A destroyed selection is replaced on the next frame
+			tracker.release_callback(scene)();
+
+			CHECK_EQUAL(tracker.is_tracked(scene), false);
+			CHECK_EQUAL(render_frame(tracker, typical_frame), shadow_map);
+
+			tracker.on_release(shadow_map);
+
+			CHECK_EQUAL(render_frame(tracker, typical_frame), 0);
+
+			// Tracking it again starts from scratch
+			CHECK_EQUAL(tracker.track(scene, width, height), true);
+			CHECK_EQUAL(tracker.track(scene, width, height), false);
+			CHECK_EQUAL(render_frame(tracker, typical_frame), scene);
+
+			release_scene = tracker.release_callback(scene);
+		}
+
+		// The depth stencil may outlive the tracker
+		release_scene();
+	}
+
+	void test_info()
+	{
+		depth_source_tracker<unsigned int, int> tracker;
+		tracker.on_resize(width, height);
+		tracker.track(scene, width, height, 42);
+		tracker.track(shadow_map, width, height, 7);
+
+		int info = 0;
+
+		CHECK_EQUAL(render_frame(tracker, typical_frame, &info), scene);
+		CHECK_EQUAL(info, 42);
+	}
+
+	void test_is_tracked()
+	{
+		depth_source_tracker<unsigned int> tracker;
+		const unsigned int capacity = depth_source_tracker<unsigned int>::index_capacity;
+
+		// Depth stencils come and go much more often than there are slots in the index, the erased ones must not fill it up
+		for (unsigned int i = 0; i < capacity * 8; i++)
+		{
+			tracker.track(1000 + i, width, height);
+
+			if (i >= 4)
+			{
+				tracker.on_release(1000 + i - 4);
+			}
+		}
+
+		CHECK_EQUAL(tracker.is_tracked(1000 + capacity * 8 - 1), true);
+		CHECK_EQUAL(tracker.is_tracked(1000 + capacity * 8 - 4), true);
+		CHECK_EQUAL(tracker.is_tracked(1000 + capacity * 8 - 5), false);
+		CHECK_EQUAL(tracker.is_tracked(1000), false);
+
+		// More candidates than the index holds, so lookups fall back to the list
+		for (unsigned int i = 0; i < capacity; i++)
+		{
+			tracker.track(100000 + i, width, height);
+		}
+
+		unsigned int tracked = 0;
+
+		for (unsigned int i = 0; i < capacity; i++)
+		{
+			tracked += tracker.is_tracked(100000 + i);
+		}
+
+		CHECK_EQUAL(tracked, capacity);
+		CHECK_EQUAL(tracker.is_tracked(100000 + capacity), false);
+
+		for (unsigned int i = 0; i < capacity; i++)
+		{
+			tracker.on_release(100000 + i);
+		}
+
+		CHECK_EQUAL(tracker.is_tracked(100000), false);
+		CHECK_EQUAL(tracker.is_tracked(1000 + capacity * 8 - 1), true);
+
+		tracker.reset();
+
+		CHECK_EQUAL(tracker.is_tracked(1000 + capacity * 8 - 1), false);
+
+		// Zero is a valid handle, e.g. the default framebuffer in OpenGL
+		tracker.track(0, width, height);
+
+		CHECK_EQUAL(tracker.is_tracked(0), true);
+	}
+
+	void test_is_tracked_pointers()
+	{
+		int views[4] = { };
+		depth_source_tracker<const int *> tracker;
+
+		tracker.track(&views[1], width, height);
+
+		CHECK_EQUAL(tracker.is_tracked(&views[0]), false);
+		CHECK_EQUAL(tracker.is_tracked(&views[1]), true);
+		CHECK_EQUAL(tracker.is_tracked(nullptr), false);
+	}
+
+	void test_concurrent_lookups()
+	{
+		depth_source_tracker<unsigned int> tracker;
+		tracker.track(scene, width, height);
+
+		std::atomic<bool> done(false);
+		std::atomic<unsigned int> misses(0), false_positives(0), lookups(0);
+		std::vector<std::thread> threads;
+
+		// The depth stencil that is never released has to be found by every lookup, while others are tracked and released from other threads
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			threads.emplace_back([&]() {
+				while (!done.load())
+				{
+					if (!tracker.is_tracked(scene))
+					{
+						misses++;
+					}
+					if (tracker.is_tracked(user_interface))
+					{
+						false_positives++;
+					}
+
+					lookups++;
+				}
+			});
+		}
+
+		std::thread releaser([&]() {
+			for (unsigned int i = 0; i < 20000; i++)
+			{
+				tracker.release_callback(1000 + (i % 2000))();
+			}
+		});
+
+		for (unsigned int i = 0; i < 20000; i++)
+		{
+			tracker.track(1000 + (i % 2000), width, height);
+		}
+
+		releaser.join();
+
+		while (lookups.load() < 1000)
+		{
+			std::this_thread::yield();
+		}
+
+		done = true;
+
+		for (auto &thread : threads)
+		{
+			thread.join();
+		}
+
+		CHECK_EQUAL(misses.load(), 0);
+		CHECK_EQUAL(false_positives.load(), 0);
+	}
+}
+
+int main()
+{
+	test_selects_scene();
+	test_switch_needs_consecutive_frames();
+	test_size_must_match();
+	test_release();
+	test_info();
+	test_is_tracked();
+	test_is_tracked_pointers();
+	test_concurrent_lookups();
+
+	if (failures != 0)
+	{
+		std::fprintf(stderr, "%u checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,318 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "effect_reflection.hpp"
+#include "parser.hpp"
+#include "preprocessor.hpp"
+#include <cstdio>
+#include <string>
+
+using namespace reshade;
+using namespace reshadefx;
+
+namespace
+{
+	unsigned int failures = 0;
+
+	#define CHECK(expression) check(expression, #expression, __LINE__)
+	#define CHECK_EQUAL(actual, expected) check_equal(actual, expected, #actual, __LINE__)
+
+	void check(bool value, const char *expression, int line)
+	{
+		if (!value)
+		{
+			std::fprintf(stderr, "line %d: %s is false\n", line, expression);
+			failures++;
+		}
+	}
+	void check_equal(size_t actual, size_t expected, const char *expression, int line)
+	{
+		if (actual != expected)
+		{
+			std::fprintf(stderr, "line %d: %s is %zu, expected %zu\n", line, expression, actual, expected);
+			failures++;
+		}
+	}
+
+	const char *const effect = R"(
+uniform float Strength < ui_type = "drag"; ui_min = 0.0; ui_max = 2.0; ui_label = "Strength"; > = 1.5;
+uniform matrix<float, 3, 4> Transform;
+uniform int2 Offset = int2(3, 4);
+uniform float Weights[4];
+uniform bool Toggle < source = "key"; keycode = 32; >;
+
+texture BackBufferTex : COLOR;
+texture DepthBufferTex : DEPTH;
+texture LookupTex < source = "lut.png"; > { Width = 512; Height = 32; Format = RGBA16F; };
+texture HalfTex { Width = 960; Height = 540; MipLevels = 4; };
+
+sampler BackBuffer { Texture = BackBufferTex; SRGBTexture = true; };
+sampler Lookup { Texture = LookupTex; MinFilter = POINT; AddressU = WRAP; MaxLOD = 2.0; MipLODBias = -1.0; };
+sampler Half { Texture = HalfTex; };
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+float4 DownsamplePS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return tex2D(BackBuffer, texcoord) * Strength;
+}
+float4 CombinePS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return tex2D(Half, texcoord) + tex2D(Lookup, texcoord + Offset);
+}
+
+technique Combine < enabled = true; toggle = 0x20; >
+{
+	pass Downsample
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = DownsamplePS;
+		RenderTarget1 = HalfTex;
+		ClearRenderTargets = false;
+	}
+	pass Combine
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = CombinePS;
+		SRGBWriteEnable = true;
+		BlendEnable = true;
+		BlendOp = REVSUBTRACT;
+		SrcBlend = SRCALPHA;
+		DestBlend = INVSRCALPHA;
+		ColorWriteMask = 7;
+		StencilEnable = true;
+		StencilFunc = EQUAL;
+		StencilRef = 3;
+		StencilPass = REPLACE;
+		StencilReadMask = 0x0F;
+	}
+}
+)";
+
+	bool parse_and_reflect(const std::string &source, effect_reflection &reflection)
+	{
+		syntax_tree ast;
+		std::string errors;
+
+		if (!parser(ast, errors).run(source))
+		{
+			std::fprintf(stderr, "failed to parse the effect:\n%s", errors.c_str());
+			return false;
+		}
+
+		reflection = reflect(ast, uniform_layout::rules::hlsl_cbuffer);
+
+		return true;
+	}
+	bool round_trip(const effect_reflection &reflection, effect_reflection &result)
+	{
+		const std::string data = serialize(reflection);
+
+		return deserialize(reinterpret_cast<const uint8_t *>(data.data()), data.size(), result);
+	}
+
+	void test_round_trip()
+	{
+		effect_reflection expected, actual;
+
+		if (!parse_and_reflect(effect, expected))
+		{
+			failures++;
+			return;
+		}
+
+		CHECK(round_trip(expected, actual));
+
+		CHECK_EQUAL(actual.uniform_block_size, expected.uniform_block_size);
+		CHECK_EQUAL(actual.uniforms.size(), 5);
+		CHECK_EQUAL(actual.textures.size(), 4);
+		CHECK_EQUAL(actual.samplers.size(), 3);
+		CHECK_EQUAL(actual.techniques.size(), 1);
+
+		if (failures != 0)
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < expected.uniforms.size(); i++)
+		{
+			const auto &lhs = actual.uniforms[i], &rhs = expected.uniforms[i];
+
+			CHECK(lhs.name == rhs.name && lhs.unique_name == rhs.unique_name && lhs.basetype == rhs.basetype);
+			CHECK(lhs.rows == rhs.rows && lhs.columns == rhs.columns && lhs.elements == rhs.elements);
+			CHECK(lhs.offset == rhs.offset && lhs.size == rhs.size);
+			CHECK(lhs.element_stride == rhs.element_stride && lhs.column_stride == rhs.column_stride && lhs.row_stride == rhs.row_stride);
+			CHECK(lhs.initial_value == rhs.initial_value);
+			CHECK_EQUAL(lhs.annotations.size(), rhs.annotations.size());
+
+			for (const auto &annotation : rhs.annotations)
+			{
+				CHECK(lhs.annotations.count(annotation.first) != 0 && lhs.annotations.at(annotation.first).data() == annotation.second.data());
+			}
+		}
+
+		CHECK(actual.uniforms[0].annotations.at("ui_label").as<std::string>() == "Strength");
+		CHECK(actual.uniforms[2].initial_value[1] == 4);
+		CHECK(actual.uniforms[3].elements == 4 && actual.uniforms[3].element_stride == 16);
+		CHECK(actual.uniforms[4].annotations.at("keycode").as<int>() == 32);
+
+		for (size_t i = 0; i < expected.textures.size(); i++)
+		{
+			const auto &lhs = actual.textures[i], &rhs = expected.textures[i];
+
+			CHECK(lhs.name == rhs.name && lhs.unique_name == rhs.unique_name && lhs.semantic == rhs.semantic);
+			CHECK(lhs.width == rhs.width && lhs.height == rhs.height && lhs.levels == rhs.levels);
+			CHECK(lhs.format == rhs.format && lhs.reference == rhs.reference);
+			CHECK_EQUAL(lhs.annotations.size(), rhs.annotations.size());
+		}
+
+		CHECK(actual.textures[0].reference == texture_reference::back_buffer);
+		CHECK(actual.textures[1].reference == texture_reference::depth_buffer);
+		CHECK(actual.textures[2].format == texture_format::rgba16f && actual.textures[2].annotations.at("source").as<std::string>() == "lut.png");
+		CHECK_EQUAL(actual.textures[3].width, 960);
+		CHECK_EQUAL(actual.textures[3].levels, 4);
+
+		for (size_t i = 0; i < expected.samplers.size(); i++)
+		{
+			const auto &lhs = actual.samplers[i], &rhs = expected.samplers[i];
+
+			CHECK(lhs.name == rhs.name && lhs.unique_name == rhs.unique_name && lhs.texture == rhs.texture && lhs.srgb == rhs.srgb);
+			CHECK(lhs.filter == rhs.filter && lhs.address_u == rhs.address_u && lhs.address_v == rhs.address_v && lhs.address_w == rhs.address_w);
+			CHECK(lhs.min_lod == rhs.min_lod && lhs.max_lod == rhs.max_lod && lhs.lod_bias == rhs.lod_bias);
+		}
+
+		CHECK(actual.samplers[0].srgb);
+		CHECK(actual.samplers[1].address_u == texture_address_mode::wrap && actual.samplers[1].max_lod == 2.0f && actual.samplers[1].lod_bias == -1.0f);
+		CHECK(actual.samplers[2].max_lod == expected.samplers[2].max_lod);
+
+		const auto &technique = actual.techniques[0];
+
+		CHECK(technique.name == "Combine");
+		CHECK(technique.annotations.at("enabled").as<bool>() && technique.annotations.at("toggle").as<int>() == 0x20);
+		CHECK_EQUAL(technique.passes.size(), 2);
+
+		for (size_t i = 0; i < technique.passes.size(); i++)
+		{
+			const auto &lhs = technique.passes[i], &rhs = expected.techniques[0].passes[i];
+
+			CHECK(lhs.vertex_shader == rhs.vertex_shader && lhs.pixel_shader == rhs.pixel_shader);
+			CHECK(lhs.render_targets == rhs.render_targets && lhs.samplers == rhs.samplers);
+			CHECK(lhs.srgb_write_enable == rhs.srgb_write_enable && lhs.clear_render_targets == rhs.clear_render_targets);
+			CHECK(lhs.blend_enable == rhs.blend_enable && lhs.blend_op == rhs.blend_op && lhs.blend_op_alpha == rhs.blend_op_alpha && lhs.src_blend == rhs.src_blend && lhs.dest_blend == rhs.dest_blend);
+			CHECK(lhs.color_write_mask == rhs.color_write_mask);
+			CHECK(lhs.stencil_enable == rhs.stencil_enable && lhs.stencil_read_mask == rhs.stencil_read_mask && lhs.stencil_write_mask == rhs.stencil_write_mask);
+			CHECK(lhs.stencil_comparison_func == rhs.stencil_comparison_func && lhs.stencil_reference_value == rhs.stencil_reference_value);
+			CHECK(lhs.stencil_op_pass == rhs.stencil_op_pass && lhs.stencil_op_fail == rhs.stencil_op_fail && lhs.stencil_op_depth_fail == rhs.stencil_op_depth_fail);
+		}
+
+		// The render target slot is kept, even though nothing renders to the first one
+		const auto &downsample = technique.passes[0], &combine = technique.passes[1];
+
+		CHECK_EQUAL(downsample.render_targets.size(), 2);
+		CHECK(downsample.render_targets[0] == pass_info::no_render_target && downsample.render_targets[1] == 3);
+		CHECK(!downsample.clear_render_targets);
+		CHECK(combine.render_targets.empty() && combine.samplers.size() == 2);
+		CHECK(combine.srgb_write_enable && combine.blend_enable && combine.stencil_enable);
+		CHECK_EQUAL(combine.color_write_mask, 7);
+		CHECK_EQUAL(combine.stencil_read_mask, 0x0F);
+		CHECK_EQUAL(combine.stencil_reference_value, 3);
+
+		// Writing the result again gives the same bytes, the annotations are sorted
+		CHECK(serialize(actual) == serialize(expected));
+	}
+
+	void test_corrupted_data()
+	{
+		effect_reflection reflection, result;
+
+		if (!parse_and_reflect(effect, reflection))
+		{
+			failures++;
+			return;
+		}
+
+		const std::string data = serialize(reflection);
+		unsigned int accepted = 0;
+
+		// Every truncation is rejected, instead of read past the end
+		for (size_t size = 0; size < data.size(); size++)
+		{
+			std::string truncated = data.substr(0, size);
+
+			accepted += deserialize(reinterpret_cast<const uint8_t *>(truncated.data()), truncated.size(), result);
+		}
+
+		CHECK_EQUAL(accepted, 0);
+
+		// Trailing data, another version and an index out of range are rejected as well
+		std::string modified = data + '\0';
+		CHECK(!deserialize(reinterpret_cast<const uint8_t *>(modified.data()), modified.size(), result));
+
+		modified = data;
+		modified[0]++;
+		CHECK(!deserialize(reinterpret_cast<const uint8_t *>(modified.data()), modified.size(), result));
+
+		reflection.samplers[0].texture = reflection.textures.size();
+		modified = serialize(reflection);
+		CHECK(!deserialize(reinterpret_cast<const uint8_t *>(modified.data()), modified.size(), result));
+	}
+
+	void test_corpus(const filesystem::path &directory)
+	{
+		const auto files = filesystem::list_files(directory, "*.fx");
+
+		CHECK(!files.empty());
+
+		for (const auto &path : files)
+		{
+			preprocessor pp;
+			pp.add_include_path(directory);
+			pp.add_macro_definition("BUFFER_WIDTH", "1920");
+			pp.add_macro_definition("BUFFER_HEIGHT", "1080");
+			pp.add_macro_definition("BUFFER_RCP_WIDTH", std::to_string(1.0f / 1920));
+			pp.add_macro_definition("BUFFER_RCP_HEIGHT", std::to_string(1.0f / 1080));
+
+			effect_reflection reflection, result;
+
+			if (!pp.run(path) || !parse_and_reflect(pp.current_output(), reflection))
+			{
+				std::fprintf(stderr, "failed to compile %s\n", path.string().c_str());
+				failures++;
+				continue;
+			}
+
+			CHECK(round_trip(reflection, result) && serialize(result) == serialize(reflection));
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 2)
+	{
+		std::fprintf(stderr, "usage: effect_reflection_test [<directory with effects>]\n");
+		return 2;
+	}
+
+	test_round_trip();
+	test_corrupted_data();
+
+	if (argc == 2)
+	{
+		test_corpus(argv[1]);
+	}
+
+	if (failures != 0)
+	{
+		std::fprintf(stderr, "%u checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
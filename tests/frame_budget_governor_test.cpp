@@ -0,0 +1,265 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "frame_budget_governor.hpp"
+#include <cstdio>
+
+using namespace reshade;
+
+namespace
+{
+	unsigned int failures = 0;
+
+	#define CHECK_EQUAL(actual, expected) check_equal(actual, expected, #actual, __LINE__)
+
+	void check_equal(size_t actual, size_t expected, const char *expression, int line)
+	{
+		if (actual != expected)
+		{
+			std::fprintf(stderr, "line %d: %s is %zu, expected %zu\n", line, expression, actual, expected);
+			failures++;
+		}
+	}
+
+	struct technique
+	{
+		const char *name;
+		int priority;
+		float cost;
+		bool enabled;
+	};
+
+	/// <summary>
+	/// Feed the governor the timings the runtime would measure for the specified number of frames. Suspended techniques are not rendered and therefore not measured.
+	/// </summary>
+	/// <returns>The number of frames in which the set of suspended techniques changed.</returns>
+	unsigned int simulate(frame_budget_governor &governor, const technique *techniques, size_t count, unsigned int frames)
+	{
+		unsigned int changes = 0;
+
+		for (unsigned int frame = 0; frame < frames; frame++)
+		{
+			std::vector<frame_budget_governor::sample> samples;
+
+			for (size_t i = 0; i < count; i++)
+			{
+				if (!techniques[i].enabled)
+				{
+					continue;
+				}
+
+				frame_budget_governor::sample sample;
+				sample.name = techniques[i].name;
+				sample.priority = techniques[i].priority;
+
+				if (!governor.is_suspended(sample.name))
+				{
+					sample.cost = techniques[i].cost;
+				}
+
+				samples.push_back(sample);
+			}
+
+			if (governor.update(samples))
+			{
+				changes++;
+			}
+		}
+
+		return changes;
+	}
+
+	frame_budget_governor::settings make_settings(float budget)
+	{
+		frame_budget_governor::settings settings;
+		settings.budget = budget;
+		settings.frames_until_suspend = 10;
+		settings.frames_until_resume = 60;
+
+		return settings;
+	}
+
+	void test_disabled_without_budget()
+	{
+		const technique techniques[] = {
+			{ "Expensive", 0, 10.0f, true },
+		};
+
+		frame_budget_governor governor;
+
+		CHECK_EQUAL(simulate(governor, techniques, 1, 100), 0);
+		CHECK_EQUAL(governor.is_suspended("Expensive"), false);
+	}
+
+	void test_suspends_by_priority()
+	{
+		const technique techniques[] = {
+			{ "SSAO", 1, 2.0f, true },
+			{ "DOF", 0, 1.5f, true },
+			{ "Sharpen", 2, 0.2f, true },
+		};
+
+		frame_budget_governor governor(make_settings(3.0f));
+
+		// Over budget, but not for long enough yet
+		CHECK_EQUAL(simulate(governor, techniques, 3, 9), 0);
+		CHECK_EQUAL(governor.is_suspended("DOF"), false);
+
+		// The least important technique goes first, which brings the total within the budget
+		CHECK_EQUAL(simulate(governor, techniques, 3, 1), 1);
+		CHECK_EQUAL(governor.is_suspended("DOF"), true);
+		CHECK_EQUAL(governor.is_suspended("SSAO"), false);
+		CHECK_EQUAL(governor.is_suspended("Sharpen"), false);
+
+		// Resuming it would exceed the budget again, so the selection stays stable
+		CHECK_EQUAL(simulate(governor, techniques, 3, 1000), 0);
+		CHECK_EQUAL(governor.is_suspended("DOF"), true);
+	}
+
+	void test_suspends_most_expensive_on_equal_priority()
+	{
+		const technique techniques[] = {
+			{ "Cheap", 0, 0.5f, true },
+			{ "Expensive", 0, 3.0f, true },
+		};
+
+		frame_budget_governor governor(make_settings(2.0f));
+
+		CHECK_EQUAL(simulate(governor, techniques, 2, 10), 1);
+		CHECK_EQUAL(governor.is_suspended("Expensive"), true);
+		CHECK_EQUAL(governor.is_suspended("Cheap"), false);
+	}
+
+	void test_resumes_with_hysteresis()
+	{
+		technique techniques[] = {
+			{ "SSAO", 1, 2.0f, true },
+			{ "DOF", 0, 1.5f, true },
+		};
+
+		frame_budget_governor governor(make_settings(3.0f));
+
+		CHECK_EQUAL(simulate(governor, techniques, 2, 10), 1);
+		CHECK_EQUAL(governor.is_suspended("DOF"), true);
+
+		// The scene got cheaper, but resuming would land above the resume threshold (0.85 * 3.0 ms), so nothing changes
+		techniques[0].cost = 1.2f;
+
+		CHECK_EQUAL(simulate(governor, techniques, 2, 1000), 0);
+		CHECK_EQUAL(governor.is_suspended("DOF"), true);
+
+		// Now there is enough room, but the technique only comes back after the room was there for a while
+		techniques[0].cost = 1.0f;
+
+		CHECK_EQUAL(simulate(governor, techniques, 2, 59), 0);
+		CHECK_EQUAL(simulate(governor, techniques, 2, 1), 1);
+		CHECK_EQUAL(governor.is_suspended("DOF"), false);
+
+		CHECK_EQUAL(simulate(governor, techniques, 2, 1000), 0);
+	}
+
+	void test_no_flicker_at_the_budget()
+	{
+		technique techniques[] = {
+			{ "A", 1, 1.0f, true },
+			{ "B", 0, 1.0f, true },
+		};
+
+		frame_budget_governor governor(make_settings(1.9f));
+
+		// A cost that alternates around the budget every frame never stays over it for long enough
+		unsigned int changes = 0;
+
+		for (unsigned int frame = 0; frame < 1000; frame++)
+		{
+			techniques[0].cost = (frame % 2) == 0 ? 1.0f : 0.8f;
+
+			changes += simulate(governor, techniques, 2, 1);
+		}
+
+		CHECK_EQUAL(changes, 0);
+		CHECK_EQUAL(governor.is_suspended("B"), false);
+	}
+
+	void test_forgets_disabled_techniques()
+	{
+		technique techniques[] = {
+			{ "SSAO", 1, 2.0f, true },
+			{ "DOF", 0, 1.5f, true },
+		};
+
+		frame_budget_governor governor(make_settings(3.0f));
+
+		CHECK_EQUAL(simulate(governor, techniques, 2, 10), 1);
+		CHECK_EQUAL(governor.is_suspended("DOF"), true);
+
+		// A technique the user disabled starts out resumed when it is enabled again
+		techniques[1].enabled = false;
+
+		simulate(governor, techniques, 2, 1);
+
+		CHECK_EQUAL(governor.is_suspended("DOF"), false);
+	}
+
+	void test_fused_group_shares()
+	{
+		// The runtime charges each technique of a fused pass an equal share of the pass, so suspending one of them is judged by its share
+		const technique techniques[] = {
+			{ "Vibrance", 1, 0.3f, true },
+			{ "Curves", 0, 0.3f, true },
+			{ "Tonemap", 2, 0.3f, true },
+			{ "SSAO", 2, 2.0f, true },
+		};
+
+		frame_budget_governor governor(make_settings(2.7f));
+
+		CHECK_EQUAL(simulate(governor, techniques, 4, 10), 1);
+		CHECK_EQUAL(governor.is_suspended("Curves"), true);
+		CHECK_EQUAL(simulate(governor, techniques, 4, 1000), 0);
+	}
+
+	void test_reset()
+	{
+		const technique techniques[] = {
+			{ "Expensive", 0, 10.0f, true },
+		};
+
+		frame_budget_governor governor(make_settings(1.0f));
+
+		CHECK_EQUAL(simulate(governor, techniques, 1, 10), 1);
+		CHECK_EQUAL(governor.is_suspended("Expensive"), true);
+
+		governor.reset();
+
+		CHECK_EQUAL(governor.is_suspended("Expensive"), false);
+
+		// Setting the budget to zero turns the governor off and resumes everything
+		CHECK_EQUAL(simulate(governor, techniques, 1, 10), 1);
+
+		governor.set_settings(make_settings(0.0f));
+
+		CHECK_EQUAL(governor.is_suspended("Expensive"), false);
+	}
+}
+
+int main()
+{
+	test_disabled_without_budget();
+	test_suspends_by_priority();
+	test_suspends_most_expensive_on_equal_priority();
+	test_resumes_with_hysteresis();
+	test_no_flicker_at_the_budget();
+	test_forgets_disabled_techniques();
+	test_fused_group_shares();
+	test_reset();
+
+	if (failures != 0)
+	{
+		std::fprintf(stderr, "%u checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,245 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "mock_com.hpp"
+
+// Just enough of the D3D10 API for the stateblock to compile, with a device that records what it is asked to do instead of rendering
+
+#define D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT 16
+#define D3D10_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT 14
+#define D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT 16
+#define D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT 128
+#define D3D10_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE 16
+#define D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT 8
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32_UINT = 42
+};
+enum D3D10_PRIMITIVE_TOPOLOGY
+{
+	D3D10_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4
+};
+
+struct D3D10_VIEWPORT
+{
+	INT TopLeftX, TopLeftY;
+	UINT Width, Height;
+	FLOAT MinDepth, MaxDepth;
+};
+
+struct ID3D10InputLayout : mock_object { };
+struct ID3D10Buffer : mock_object { };
+struct ID3D10VertexShader : mock_object { };
+struct ID3D10GeometryShader : mock_object { };
+struct ID3D10PixelShader : mock_object { };
+struct ID3D10SamplerState : mock_object { };
+struct ID3D10ShaderResourceView : mock_object { };
+struct ID3D10RasterizerState : mock_object { };
+struct ID3D10BlendState : mock_object { };
+struct ID3D10DepthStencilState : mock_object { };
+struct ID3D10RenderTargetView : mock_object { };
+struct ID3D10DepthStencilView : mock_object { };
+
+struct ID3D10Device : mock_object
+{
+	void IAGetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY *topology)
+	{
+		mock::record(1);
+		*topology = ia_primitive_topology;
+	}
+	void IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY topology)
+	{
+		mock::record(1);
+		ia_primitive_topology = topology;
+	}
+	void IAGetInputLayout(ID3D10InputLayout **input_layout)
+	{
+		mock::record(1);
+		*input_layout = mock::get(ia_input_layout);
+	}
+	void IASetInputLayout(ID3D10InputLayout *input_layout)
+	{
+		mock::record(1);
+		mock::set(ia_input_layout, input_layout);
+	}
+	void IAGetVertexBuffers(UINT start, UINT num, ID3D10Buffer **buffers, UINT *strides, UINT *offsets)
+	{
+		mock::record(num);
+
+		for (UINT i = 0; i < num; i++)
+		{
+			buffers[i] = mock::get(ia_vertex_buffers[start + i]);
+			strides[i] = ia_vertex_strides[start + i];
+			offsets[i] = ia_vertex_offsets[start + i];
+		}
+	}
+	void IASetVertexBuffers(UINT start, UINT num, ID3D10Buffer *const *buffers, const UINT *strides, const UINT *offsets)
+	{
+		mock::record(num);
+
+		for (UINT i = 0; i < num; i++)
+		{
+			mock::set(ia_vertex_buffers[start + i], buffers[i]);
+			ia_vertex_strides[start + i] = strides[i];
+			ia_vertex_offsets[start + i] = offsets[i];
+		}
+	}
+	void IAGetIndexBuffer(ID3D10Buffer **buffer, DXGI_FORMAT *format, UINT *offset)
+	{
+		mock::record(1);
+		*buffer = mock::get(ia_index_buffer);
+		*format = ia_index_format;
+		*offset = ia_index_offset;
+	}
+	void IASetIndexBuffer(ID3D10Buffer *buffer, DXGI_FORMAT format, UINT offset)
+	{
+		mock::record(1);
+		mock::set(ia_index_buffer, buffer);
+		ia_index_format = format;
+		ia_index_offset = offset;
+	}
+
+	void RSGetState(ID3D10RasterizerState **state)
+	{
+		mock::record(1);
+		*state = mock::get(rs_state);
+	}
+	void RSSetState(ID3D10RasterizerState *state)
+	{
+		mock::record(1);
+		mock::set(rs_state, state);
+	}
+	void RSGetViewports(UINT *num, D3D10_VIEWPORT *viewports)
+	{
+		mock::record(viewports != nullptr ? rs_num_viewports : 0);
+
+		if (viewports != nullptr)
+		{
+			std::memcpy(viewports, rs_viewports, *num * sizeof(D3D10_VIEWPORT));
+		}
+
+		*num = rs_num_viewports;
+	}
+	void RSSetViewports(UINT num, const D3D10_VIEWPORT *viewports)
+	{
+		mock::record(num);
+		std::memcpy(rs_viewports, viewports, num * sizeof(D3D10_VIEWPORT));
+		rs_num_viewports = num;
+	}
+
+	void VSGetShader(ID3D10VertexShader **shader)
+	{
+		mock::record(1);
+		*shader = mock::get(vs);
+	}
+	void VSSetShader(ID3D10VertexShader *shader)
+	{
+		mock::record(1);
+		mock::set(vs, shader);
+	}
+	void GSGetShader(ID3D10GeometryShader **shader)
+	{
+		mock::record(1);
+		*shader = mock::get(gs);
+	}
+	void GSSetShader(ID3D10GeometryShader *shader)
+	{
+		mock::record(1);
+		mock::set(gs, shader);
+	}
+	void PSGetShader(ID3D10PixelShader **shader)
+	{
+		mock::record(1);
+		*shader = mock::get(ps);
+	}
+	void PSSetShader(ID3D10PixelShader *shader)
+	{
+		mock::record(1);
+		mock::set(ps, shader);
+	}
+
+	MOCK_SLOT_RANGE(VS, ConstantBuffers, ID3D10Buffer, D3D10_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT)
+	MOCK_SLOT_RANGE(VS, Samplers, ID3D10SamplerState, D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT)
+	MOCK_SLOT_RANGE(VS, ShaderResources, ID3D10ShaderResourceView, D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
+	MOCK_SLOT_RANGE(PS, ConstantBuffers, ID3D10Buffer, D3D10_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT)
+	MOCK_SLOT_RANGE(PS, Samplers, ID3D10SamplerState, D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT)
+	MOCK_SLOT_RANGE(PS, ShaderResources, ID3D10ShaderResourceView, D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
+
+	void OMGetBlendState(ID3D10BlendState **state, FLOAT blend_factor[4], UINT *sample_mask)
+	{
+		mock::record(1);
+		*state = mock::get(om_blend_state);
+		std::memcpy(blend_factor, om_blend_factor, sizeof(om_blend_factor));
+		*sample_mask = om_sample_mask;
+	}
+	void OMSetBlendState(ID3D10BlendState *state, const FLOAT blend_factor[4], UINT sample_mask)
+	{
+		mock::record(1);
+		mock::set(om_blend_state, state);
+		std::memcpy(om_blend_factor, blend_factor, sizeof(om_blend_factor));
+		om_sample_mask = sample_mask;
+	}
+	void OMGetDepthStencilState(ID3D10DepthStencilState **state, UINT *stencil_ref)
+	{
+		mock::record(1);
+		*state = mock::get(om_depth_stencil_state);
+		*stencil_ref = om_stencil_ref;
+	}
+	void OMSetDepthStencilState(ID3D10DepthStencilState *state, UINT stencil_ref)
+	{
+		mock::record(1);
+		mock::set(om_depth_stencil_state, state);
+		om_stencil_ref = stencil_ref;
+	}
+	void OMGetRenderTargets(UINT num, ID3D10RenderTargetView **render_targets, ID3D10DepthStencilView **depth_stencil)
+	{
+		mock::record(num + 1);
+
+		for (UINT i = 0; i < num; i++)
+		{
+			render_targets[i] = mock::get(om_render_targets[i]);
+		}
+
+		*depth_stencil = mock::get(om_depth_stencil);
+	}
+	void OMSetRenderTargets(UINT num, ID3D10RenderTargetView *const *render_targets, ID3D10DepthStencilView *depth_stencil)
+	{
+		mock::record(num + 1);
+
+		for (UINT i = 0; i < num; i++)
+		{
+			mock::set(om_render_targets[i], render_targets[i]);
+		}
+
+		mock::set(om_depth_stencil, depth_stencil);
+	}
+
+	D3D10_PRIMITIVE_TOPOLOGY ia_primitive_topology = D3D10_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	ID3D10InputLayout *ia_input_layout = nullptr;
+	ID3D10Buffer *ia_vertex_buffers[D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = { };
+	UINT ia_vertex_strides[D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = { };
+	UINT ia_vertex_offsets[D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = { };
+	ID3D10Buffer *ia_index_buffer = nullptr;
+	DXGI_FORMAT ia_index_format = DXGI_FORMAT_UNKNOWN;
+	UINT ia_index_offset = 0;
+	ID3D10RasterizerState *rs_state = nullptr;
+	UINT rs_num_viewports = 0;
+	D3D10_VIEWPORT rs_viewports[D3D10_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = { };
+	ID3D10VertexShader *vs = nullptr;
+	ID3D10GeometryShader *gs = nullptr;
+	ID3D10PixelShader *ps = nullptr;
+	ID3D10BlendState *om_blend_state = nullptr;
+	FLOAT om_blend_factor[4] = { };
+	UINT om_sample_mask = 0;
+	ID3D10DepthStencilState *om_depth_stencil_state = nullptr;
+	UINT om_stencil_ref = 0;
+	ID3D10RenderTargetView *om_render_targets[D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT] = { };
+	ID3D10DepthStencilView *om_depth_stencil = nullptr;
+};
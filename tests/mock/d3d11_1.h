@@ -0,0 +1,285 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include "mock_com.hpp"
+#include "d3d10_1.h"
+
+// Just enough of the D3D11 API for the stateblock to compile, with a device context that records what it is asked to do instead of rendering
+// The D3D10 header is included for the vertex buffer slot count the stateblock uses on feature level 10.0 devices
+
+#define D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT 32
+#define D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT 14
+#define D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT 16
+#define D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT 128
+#define D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE 16
+#define D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT 8
+
+enum D3D_FEATURE_LEVEL
+{
+	D3D_FEATURE_LEVEL_10_0 = 0xa000,
+	D3D_FEATURE_LEVEL_11_0 = 0xb000
+};
+enum D3D11_PRIMITIVE_TOPOLOGY
+{
+	D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4
+};
+
+struct D3D11_VIEWPORT
+{
+	FLOAT TopLeftX, TopLeftY, Width, Height, MinDepth, MaxDepth;
+};
+
+struct ID3D11InputLayout : mock_object { };
+struct ID3D11Buffer : mock_object { };
+struct ID3D11VertexShader : mock_object { };
+struct ID3D11HullShader : mock_object { };
+struct ID3D11DomainShader : mock_object { };
+struct ID3D11GeometryShader : mock_object { };
+struct ID3D11PixelShader : mock_object { };
+struct ID3D11ClassInstance : mock_object { };
+struct ID3D11SamplerState : mock_object { };
+struct ID3D11ShaderResourceView : mock_object { };
+struct ID3D11RasterizerState : mock_object { };
+struct ID3D11BlendState : mock_object { };
+struct ID3D11DepthStencilState : mock_object { };
+struct ID3D11RenderTargetView : mock_object { };
+struct ID3D11DepthStencilView : mock_object { };
+
+struct ID3D11Device : mock_object
+{
+	D3D_FEATURE_LEVEL GetFeatureLevel()
+	{
+		return feature_level;
+	}
+
+	D3D_FEATURE_LEVEL feature_level = D3D_FEATURE_LEVEL_11_0;
+};
+
+struct ID3D11DeviceContext : mock_object
+{
+	void IAGetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY *topology)
+	{
+		mock::record(1);
+		*topology = ia_primitive_topology;
+	}
+	void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+	{
+		mock::record(1);
+		ia_primitive_topology = topology;
+	}
+	void IAGetInputLayout(ID3D11InputLayout **input_layout)
+	{
+		mock::record(1);
+		*input_layout = mock::get(ia_input_layout);
+	}
+	void IASetInputLayout(ID3D11InputLayout *input_layout)
+	{
+		mock::record(1);
+		mock::set(ia_input_layout, input_layout);
+	}
+	void IAGetVertexBuffers(UINT start, UINT num, ID3D11Buffer **buffers, UINT *strides, UINT *offsets)
+	{
+		mock::record(num);
+
+		for (UINT i = 0; i < num; i++)
+		{
+			buffers[i] = mock::get(ia_vertex_buffers[start + i]);
+			strides[i] = ia_vertex_strides[start + i];
+			offsets[i] = ia_vertex_offsets[start + i];
+		}
+	}
+	void IASetVertexBuffers(UINT start, UINT num, ID3D11Buffer *const *buffers, const UINT *strides, const UINT *offsets)
+	{
+		mock::record(num);
+
+		for (UINT i = 0; i < num; i++)
+		{
+			mock::set(ia_vertex_buffers[start + i], buffers[i]);
+			ia_vertex_strides[start + i] = strides[i];
+			ia_vertex_offsets[start + i] = offsets[i];
+		}
+	}
+	void IAGetIndexBuffer(ID3D11Buffer **buffer, DXGI_FORMAT *format, UINT *offset)
+	{
+		mock::record(1);
+		*buffer = mock::get(ia_index_buffer);
+		*format = ia_index_format;
+		*offset = ia_index_offset;
+	}
+	void IASetIndexBuffer(ID3D11Buffer *buffer, DXGI_FORMAT format, UINT offset)
+	{
+		mock::record(1);
+		mock::set(ia_index_buffer, buffer);
+		ia_index_format = format;
+		ia_index_offset = offset;
+	}
+
+	void RSGetState(ID3D11RasterizerState **state)
+	{
+		mock::record(1);
+		*state = mock::get(rs_state);
+	}
+	void RSSetState(ID3D11RasterizerState *state)
+	{
+		mock::record(1);
+		mock::set(rs_state, state);
+	}
+	void RSGetViewports(UINT *num, D3D11_VIEWPORT *viewports)
+	{
+		mock::record(viewports != nullptr ? rs_num_viewports : 0);
+
+		if (viewports != nullptr)
+		{
+			std::memcpy(viewports, rs_viewports, *num * sizeof(D3D11_VIEWPORT));
+		}
+
+		*num = rs_num_viewports;
+	}
+	void RSSetViewports(UINT num, const D3D11_VIEWPORT *viewports)
+	{
+		mock::record(num);
+		std::memcpy(rs_viewports, viewports, num * sizeof(D3D11_VIEWPORT));
+		rs_num_viewports = num;
+	}
+
+	void VSGetShader(ID3D11VertexShader **shader, ID3D11ClassInstance **, UINT *num_class_instances)
+	{
+		mock::record(1);
+		*shader = mock::get(vs);
+		*num_class_instances = 0;
+	}
+	void VSSetShader(ID3D11VertexShader *shader, ID3D11ClassInstance *const *, UINT)
+	{
+		mock::record(1);
+		mock::set(vs, shader);
+	}
+	void HSGetShader(ID3D11HullShader **shader, ID3D11ClassInstance **, UINT *num_class_instances)
+	{
+		mock::record(1);
+		*shader = mock::get(hs);
+		*num_class_instances = 0;
+	}
+	void HSSetShader(ID3D11HullShader *shader, ID3D11ClassInstance *const *, UINT)
+	{
+		mock::record(1);
+		mock::set(hs, shader);
+	}
+	void DSGetShader(ID3D11DomainShader **shader, ID3D11ClassInstance **, UINT *num_class_instances)
+	{
+		mock::record(1);
+		*shader = mock::get(ds);
+		*num_class_instances = 0;
+	}
+	void DSSetShader(ID3D11DomainShader *shader, ID3D11ClassInstance *const *, UINT)
+	{
+		mock::record(1);
+		mock::set(ds, shader);
+	}
+	void GSGetShader(ID3D11GeometryShader **shader, ID3D11ClassInstance **, UINT *num_class_instances)
+	{
+		mock::record(1);
+		*shader = mock::get(gs);
+		*num_class_instances = 0;
+	}
+	void GSSetShader(ID3D11GeometryShader *shader, ID3D11ClassInstance *const *, UINT)
+	{
+		mock::record(1);
+		mock::set(gs, shader);
+	}
+	void PSGetShader(ID3D11PixelShader **shader, ID3D11ClassInstance **, UINT *num_class_instances)
+	{
+		mock::record(1);
+		*shader = mock::get(ps);
+		*num_class_instances = 0;
+	}
+	void PSSetShader(ID3D11PixelShader *shader, ID3D11ClassInstance *const *, UINT)
+	{
+		mock::record(1);
+		mock::set(ps, shader);
+	}
+
+	MOCK_SLOT_RANGE(VS, ConstantBuffers, ID3D11Buffer, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT)
+	MOCK_SLOT_RANGE(VS, Samplers, ID3D11SamplerState, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT)
+	MOCK_SLOT_RANGE(VS, ShaderResources, ID3D11ShaderResourceView, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
+	MOCK_SLOT_RANGE(PS, ConstantBuffers, ID3D11Buffer, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT)
+	MOCK_SLOT_RANGE(PS, Samplers, ID3D11SamplerState, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT)
+	MOCK_SLOT_RANGE(PS, ShaderResources, ID3D11ShaderResourceView, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT)
+
+	void OMGetBlendState(ID3D11BlendState **state, FLOAT blend_factor[4], UINT *sample_mask)
+	{
+		mock::record(1);
+		*state = mock::get(om_blend_state);
+		std::memcpy(blend_factor, om_blend_factor, sizeof(om_blend_factor));
+		*sample_mask = om_sample_mask;
+	}
+	void OMSetBlendState(ID3D11BlendState *state, const FLOAT blend_factor[4], UINT sample_mask)
+	{
+		mock::record(1);
+		mock::set(om_blend_state, state);
+		std::memcpy(om_blend_factor, blend_factor, sizeof(om_blend_factor));
+		om_sample_mask = sample_mask;
+	}
+	void OMGetDepthStencilState(ID3D11DepthStencilState **state, UINT *stencil_ref)
+	{
+		mock::record(1);
+		*state = mock::get(om_depth_stencil_state);
+		*stencil_ref = om_stencil_ref;
+	}
+	void OMSetDepthStencilState(ID3D11DepthStencilState *state, UINT stencil_ref)
+	{
+		mock::record(1);
+		mock::set(om_depth_stencil_state, state);
+		om_stencil_ref = stencil_ref;
+	}
+	void OMGetRenderTargets(UINT num, ID3D11RenderTargetView **render_targets, ID3D11DepthStencilView **depth_stencil)
+	{
+		mock::record(num + 1);
+
+		for (UINT i = 0; i < num; i++)
+		{
+			render_targets[i] = mock::get(om_render_targets[i]);
+		}
+
+		*depth_stencil = mock::get(om_depth_stencil);
+	}
+	void OMSetRenderTargets(UINT num, ID3D11RenderTargetView *const *render_targets, ID3D11DepthStencilView *depth_stencil)
+	{
+		mock::record(num + 1);
+
+		for (UINT i = 0; i < num; i++)
+		{
+			mock::set(om_render_targets[i], render_targets[i]);
+		}
+
+		mock::set(om_depth_stencil, depth_stencil);
+	}
+
+	D3D11_PRIMITIVE_TOPOLOGY ia_primitive_topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	ID3D11InputLayout *ia_input_layout = nullptr;
+	ID3D11Buffer *ia_vertex_buffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = { };
+	UINT ia_vertex_strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = { };
+	UINT ia_vertex_offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = { };
+	ID3D11Buffer *ia_index_buffer = nullptr;
+	DXGI_FORMAT ia_index_format = DXGI_FORMAT_UNKNOWN;
+	UINT ia_index_offset = 0;
+	ID3D11RasterizerState *rs_state = nullptr;
+	UINT rs_num_viewports = 0;
+	D3D11_VIEWPORT rs_viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = { };
+	ID3D11VertexShader *vs = nullptr;
+	ID3D11HullShader *hs = nullptr;
+	ID3D11DomainShader *ds = nullptr;
+	ID3D11GeometryShader *gs = nullptr;
+	ID3D11PixelShader *ps = nullptr;
+	ID3D11BlendState *om_blend_state = nullptr;
+	FLOAT om_blend_factor[4] = { };
+	UINT om_sample_mask = 0;
+	ID3D11DepthStencilState *om_depth_stencil_state = nullptr;
+	UINT om_stencil_ref = 0;
+	ID3D11RenderTargetView *om_render_targets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = { };
+	ID3D11DepthStencilView *om_depth_stencil = nullptr;
+};
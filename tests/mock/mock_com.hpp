@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#pragma once
+
+#include <climits>
+#include <cstring>
+#include <utility>
+
+typedef int INT;
+typedef unsigned int UINT;
+typedef float FLOAT;
+
+#define ZeroMemory(destination, length) std::memset((destination), 0, (length))
+#define ARRAYSIZE(a) (sizeof(a) / sizeof(*(a)))
+
+/// <summary>
+/// What the mock pipelines were asked to do since the last reset.
+/// </summary>
+struct mock_statistics
+{
+	// Get and set calls, the slots they transferred and the references they took
+	unsigned int calls = 0, slots = 0, references = 0;
+};
+
+inline mock_statistics g_mock_statistics;
+
+/// <summary>
+/// Stands in for a COM object, so that the references taken and released on it can be checked.
+/// </summary>
+struct mock_object
+{
+	unsigned long AddRef()
+	{
+		g_mock_statistics.references++;
+		return ++references;
+	}
+	unsigned long Release()
+	{
+		return --references;
+	}
+
+	unsigned long references = 1;
+};
+
+namespace mock
+{
+	inline void record(UINT slots)
+	{
+		g_mock_statistics.calls++;
+		g_mock_statistics.slots += slots;
+	}
+
+	/// <summary>
+	/// Hand out a bound object, which takes a reference on it like the getters of a real pipeline do.
+	/// </summary>
+	template <typename T>
+	T *get(T *object)
+	{
+		if (object != nullptr)
+		{
+			object->AddRef();
+		}
+
+		return object;
+	}
+	/// <summary>
+	/// Bind an object, holding a reference on it for as long as it stays bound.
+	/// </summary>
+	template <typename T>
+	void set(T *&slot, T *object)
+	{
+		if (object != nullptr)
+		{
+			object->AddRef();
+		}
+		if (slot != nullptr)
+		{
+			slot->Release();
+		}
+
+		slot = object;
+	}
+}
+
+/// <summary>
+/// Declares the slots of a pipeline stage together with the getter and setter of a range of them.
+/// </summary>
+#define MOCK_SLOT_RANGE(stage, kind, type, count) \
+	type *stage##_##kind[count] = { }; \
+	void stage##Get##kind(UINT start, UINT num, type **objects) \
+	{ \
+		mock::record(num); \
+		for (UINT i = 0; i < num; i++) objects[i] = mock::get(stage##_##kind[start + i]); \
+	} \
+	void stage##Set##kind(UINT start, UINT num, type *const *objects) \
+	{ \
+		mock::record(num); \
+		for (UINT i = 0; i < num; i++) mock::set(stage##_##kind[start + i], objects[i]); \
+	}
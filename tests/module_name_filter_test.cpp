@@ -0,0 +1,210 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "module_name_filter.hpp"
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace reshade::hooks;
+
+namespace
+{
+	unsigned int failures = 0;
+
+	#define CHECK_EQUAL(actual, expected) check_equal(actual, expected, #actual, __LINE__)
+
+	void check_equal(size_t actual, size_t expected, const char *expression, int line)
+	{
+		if (actual != expected)
+		{
+			std::fprintf(stderr, "line %d: %s is %zu, expected %zu\n", line, expression, actual, expected);
+			failures++;
+		}
+	}
+
+	void test_base_names()
+	{
+		module_name_filter filter;
+		filter.insert(L"C:\\Windows\\System32\\d3d9.dll");
+
+		// The directory, the extension and the case do not matter, just like for the loader
+		CHECK_EQUAL(filter.contains("d3d9"), true);
+		CHECK_EQUAL(filter.contains("d3d9.dll"), true);
+		CHECK_EQUAL(filter.contains("D3D9.DLL"), true);
+		CHECK_EQUAL(filter.contains(L"D3D9.dll"), true);
+		CHECK_EQUAL(filter.contains("C:\\Games\\d3d9.dll"), true);
+		CHECK_EQUAL(filter.contains("C:/Games/D3d9.dll"), true);
+		CHECK_EQUAL(filter.contains(L"C:d3d9.dll"), true);
+
+		CHECK_EQUAL(filter.contains("d3d9x.dll"), false);
+		CHECK_EQUAL(filter.contains("d3d9.dll.mui"), false);
+		CHECK_EQUAL(filter.contains("d3d11.dll"), false);
+		CHECK_EQUAL(filter.contains(L"C:\\d3d9.dll\\xinput1_3.dll"), false);
+		CHECK_EQUAL(filter.contains(""), false);
+
+		// The loader reports names that are not null-terminated, only the specified length counts
+		const wchar_t loader_name[] = L"C:\\Windows\\System32\\D3D9.DLLd3d11.dll";
+
+		CHECK_EQUAL(filter.contains(loader_name, 28), true);
+		CHECK_EQUAL(filter.contains(loader_name + 20, 4), true);
+		CHECK_EQUAL(filter.contains(loader_name, 37), false);
+		CHECK_EQUAL(filter.contains(loader_name, 0), false);
+
+		// Only the last dot starts the extension, and only within the base name
+		filter.insert(L"C:\\Program Files\\Game.v1\\steam_api");
+
+		CHECK_EQUAL(filter.contains("steam_api.dll"), true);
+		CHECK_EQUAL(filter.contains("Game.dll"), false);
+	}
+
+	void test_hash_base_name()
+	{
+		CHECK_EQUAL(module_name_filter::hash_base_name("D3D11.DLL") == module_name_filter::hash_base_name(L"c:\\windows\\d3d11"), true);
+		CHECK_EQUAL(module_name_filter::hash_base_name("d3d11") == module_name_filter::hash_base_name("d3d10"), false);
+
+		// Zero is reserved for names that cannot be compared
+		CHECK_EQUAL(module_name_filter::hash_base_name("") != 0, true);
+		CHECK_EQUAL(module_name_filter::hash_base_name(L"d3d9\u00E9.dll"), 0);
+		CHECK_EQUAL(module_name_filter::hash_base_name("d3d9\xC3\xA9.dll"), 0);
+		CHECK_EQUAL(module_name_filter::hash_base_name(L"C:\\\u00C9\\d3d9.dll") == module_name_filter::hash_base_name("d3d9"), true);
+	}
+
+	void test_non_ascii_names_always_match()
+	{
+		module_name_filter filter;
+
+		CHECK_EQUAL(filter.contains(L"C:\\Spiele\\\u00FCberlay.dll"), true);
+		CHECK_EQUAL(filter.contains("d3d9.dll"), false);
+
+		// A name that cannot be hashed cannot be stored either, so everything matches from then on
+		filter.insert(L"\u00FCberlay.dll");
+
+		CHECK_EQUAL(filter.contains("d3d9.dll"), true);
+	}
+
+	void test_erase()
+	{
+		module_name_filter filter;
+		filter.insert(L"C:\\Windows\\System32\\opengl32.dll");
+		filter.insert(L"C:\\Games\\opengl32.dll");
+		filter.insert(L"dxgi.dll");
+
+		// Each erase removes one of the two paths with the same base name
+		filter.erase(L"OPENGL32");
+
+		CHECK_EQUAL(filter.contains("opengl32.dll"), true);
+
+		filter.erase(L"C:\\Games\\opengl32.dll");
+
+		CHECK_EQUAL(filter.contains("opengl32.dll"), false);
+		CHECK_EQUAL(filter.contains("dxgi.dll"), true);
+
+		// Erasing a name that is not in the set does nothing
+		filter.erase(L"d3d8.dll");
+		filter.erase(L"\u00FCberlay.dll");
+
+		CHECK_EQUAL(filter.contains("dxgi.dll"), true);
+
+		filter.erase(L"dxgi.dll");
+
+		CHECK_EQUAL(filter.contains("dxgi.dll"), false);
+
+		// Cleared slots are reused
+		for (size_t i = 0; i < module_name_filter::capacity; i++)
+		{
+			filter.insert(L"module" + std::to_wstring(i) + L".dll");
+		}
+
+		CHECK_EQUAL(filter.contains("module0.dll"), true);
+		CHECK_EQUAL(filter.contains("unrelated.dll"), false);
+	}
+
+	void test_overflow()
+	{
+		module_name_filter filter;
+
+		for (size_t i = 0; i < module_name_filter::capacity; i++)
+		{
+			filter.insert(L"module" + std::to_wstring(i) + L".dll");
+		}
+
+		CHECK_EQUAL(filter.contains("unrelated.dll"), false);
+
+		// One more than fits, so no module may be missed any longer
+		filter.insert(L"module" + std::to_wstring(module_name_filter::capacity) + L".dll");
+
+		CHECK_EQUAL(filter.contains("unrelated.dll"), true);
+		CHECK_EQUAL(filter.contains("module16.dll"), true);
+	}
+
+	void test_concurrent_queries()
+	{
+		module_name_filter filter;
+		filter.insert(L"d3d11.dll");
+
+		std::atomic<bool> done(false);
+		std::atomic<unsigned int> misses(0), queries(0);
+		std::vector<std::thread> threads;
+
+		// The name that is never modified has to be seen by every query, while other names come and go in the slots around it
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			threads.emplace_back([&]() {
+				while (!done.load())
+				{
+					if (!filter.contains(L"C:\\Windows\\System32\\D3D11.DLL"))
+					{
+						misses++;
+					}
+
+					queries++;
+				}
+			});
+		}
+
+		for (unsigned int i = 0; i < 20000; i++)
+		{
+			const std::wstring name = L"module" + std::to_wstring(i % 8) + L".dll";
+
+			filter.insert(name);
+			filter.erase(name);
+		}
+
+		// Make sure the readers ran at all before stopping them
+		while (queries.load() < 1000)
+		{
+			std::this_thread::yield();
+		}
+
+		done = true;
+
+		for (auto &thread : threads)
+		{
+			thread.join();
+		}
+
+		CHECK_EQUAL(misses.load(), 0);
+		CHECK_EQUAL(filter.contains("module0.dll"), false);
+	}
+}
+
+int main()
+{
+	test_base_names();
+	test_hash_base_name();
+	test_non_ascii_names_always_match();
+	test_erase();
+	test_overflow();
+	test_concurrent_queries();
+
+	if (failures != 0)
+	{
+		std::fprintf(stderr, "%u checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
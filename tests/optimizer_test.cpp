@@ -0,0 +1,333 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "optimizer.hpp"
+#include "parser.hpp"
+#include <cstdio>
+#include <algorithm>
+#include <string>
+
+using namespace reshadefx;
+
+namespace
+{
+	unsigned int failures = 0;
+
+	#define CHECK(expression) check(expression, #expression, __LINE__)
+	#define CHECK_EQUAL(actual, expected) check_equal(actual, expected, #actual, __LINE__)
+
+	void check(bool value, const char *expression, int line)
+	{
+		if (!value)
+		{
+			std::fprintf(stderr, "line %d: %s is false\n", line, expression);
+			failures++;
+		}
+	}
+	void check_equal(size_t actual, size_t expected, const char *expression, int line)
+	{
+		if (actual != expected)
+		{
+			std::fprintf(stderr, "line %d: %s is %zu, expected %zu\n", line, expression, actual, expected);
+			failures++;
+		}
+	}
+
+	const char *const point_wise_prelude = R"(
+uniform float Strength;
+
+texture BackBufferTex : COLOR;
+texture DepthBufferTex : DEPTH;
+texture OtherTex { Width = 256; Height = 256; };
+
+sampler BackBuffer { Texture = BackBufferTex; };
+sampler DepthBuffer { Texture = DepthBufferTex; };
+sampler Other { Texture = OtherTex; };
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+void ScaledVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, Strength);
+}
+
+float3 Grade(float3 color)
+{
+	return color * Strength;
+}
+float3 GradeWithDepth(float3 color, float2 texcoord)
+{
+	return color * tex2D(DepthBuffer, texcoord).x;
+}
+)";
+
+	/// <summary>
+	/// Parse an effect with a single pass that uses the specified shaders and states and return the name of the sampler the pass reads the back buffer through, or an empty string if it is not point-wise.
+	/// </summary>
+	std::string find_point_wise_input(const std::string &pixel_shader, const std::string &states = std::string(), const std::string &vertex_shader = "PostProcessVS")
+	{
+		const std::string source = point_wise_prelude + pixel_shader +
+			"\ntechnique Test { pass { VertexShader = " + vertex_shader + "; PixelShader = PS; " + states + " } }\n";
+
+		syntax_tree ast;
+		std::string errors;
+
+		if (!parser(ast, errors).run(source) || ast.techniques.size() != 1)
+		{
+			std::fprintf(stderr, "failed to parse the effect:\n%s", errors.c_str());
+			failures++;
+			return "<error>";
+		}
+
+		const auto input = reshadefx::find_point_wise_input(ast.techniques[0]->pass_list[0]);
+
+		return input != nullptr ? input->name : std::string();
+	}
+
+	void test_point_wise_input()
+	{
+		// Reads nothing but the back buffer at the current pixel, together with uniforms and math in other functions
+		CHECK(find_point_wise_input("float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { return tex2D(BackBuffer, texcoord) * Strength; }") == "BackBuffer");
+		CHECK(find_point_wise_input("float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { float4 color = tex2D(BackBuffer, texcoord); color.rgb = Grade(color.rgb); return color; }") == "BackBuffer");
+		CHECK(find_point_wise_input("float4 PS(float2 texcoord : TEXCOORD0) : COLOR { return 1.0 - tex2D(BackBuffer, texcoord); }") == "BackBuffer");
+
+		// Neighboring pixels or a modified texture coordinate
+		CHECK(find_point_wise_input("float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { return tex2D(BackBuffer, texcoord + 0.01); }").empty());
+		CHECK(find_point_wise_input("float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { texcoord.x += 0.01; return tex2D(BackBuffer, texcoord); }").empty());
+		CHECK(find_point_wise_input("float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { return tex2Dlod(BackBuffer, float4(texcoord, 0, 0)); }").empty());
+
+		// Textures other than the back buffer, directly or through a called function
+		CHECK(find_point_wise_input("float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { return tex2D(BackBuffer, texcoord) * tex2D(DepthBuffer, texcoord).x; }").empty());
+		CHECK(find_point_wise_input("float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { return tex2D(Other, texcoord); }").empty());
+		CHECK(find_point_wise_input("float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { float4 color = tex2D(BackBuffer, texcoord); color.rgb = GradeWithDepth(color.rgb, texcoord); return color; }").empty());
+
+		// Nothing is read from the back buffer at all, so there is no color to chain
+		CHECK(find_point_wise_input("float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { return Strength; }").empty());
+
+		const std::string pixel_shader = "float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { return tex2D(BackBuffer, texcoord) * Strength; }";
+
+		// States that make the result depend on more than the shader output or write somewhere other than the back buffer
+		CHECK(find_point_wise_input(pixel_shader, "RenderTarget = OtherTex;").empty());
+		CHECK(find_point_wise_input(pixel_shader, "BlendEnable = true; DestBlend = ONE;").empty());
+		CHECK(find_point_wise_input(pixel_shader, "StencilEnable = true;").empty());
+		CHECK(find_point_wise_input(pixel_shader, "ColorWriteMask = 7;").empty());
+		CHECK(find_point_wise_input(pixel_shader, "SRGBWriteEnable = true;").empty());
+
+		// A vertex shader that reads a uniform may place the vertices elsewhere, even though its code matches another one
+		CHECK(find_point_wise_input(pixel_shader, std::string(), "ScaledVS").empty());
+	}
+
+	const char *const optimize_prelude = R"(
+texture BackBufferTex : COLOR;
+sampler BackBuffer { Texture = BackBufferTex; };
+
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+)";
+
+	/// <summary>
+	/// Parse an effect with a single pass that uses the specified declarations for its pixel shader, which must be called 'PS', and optimize it.
+	/// Uniforms with an initializer are baked into constants first, like the runtime does in performance mode, since the parser already folds the constants written in the source.
+	/// </summary>
+	optimizer_statistics optimize_effect(syntax_tree &ast, const std::string &declarations)
+	{
+		const std::string source = optimize_prelude + declarations +
+			"\ntechnique Test { pass { VertexShader = PostProcessVS; PixelShader = PS; } }\n";
+
+		std::string errors;
+
+		if (!parser(ast, errors).run(source))
+		{
+			std::fprintf(stderr, "failed to parse the effect:\n%s", errors.c_str());
+			failures++;
+			return optimizer_statistics();
+		}
+
+		for (auto variable : ast.variables)
+		{
+			if (variable->type.has_qualifier(nodes::type_node::qualifier_uniform) && variable->initializer_expression != nullptr)
+			{
+				variable->type.qualifiers ^= nodes::type_node::qualifier_uniform;
+				variable->type.qualifiers |= nodes::type_node::qualifier_static | nodes::type_node::qualifier_const;
+			}
+		}
+
+		return optimize(ast);
+	}
+
+	const nodes::function_declaration_node *find_function(const syntax_tree &ast, const std::string &name)
+	{
+		for (auto function : ast.functions)
+		{
+			if (function->name == name)
+			{
+				return function;
+			}
+		}
+
+		return nullptr;
+	}
+	const nodes::variable_declaration_node *find_variable(const syntax_tree &ast, const std::string &name)
+	{
+		for (auto variable : ast.variables)
+		{
+			if (variable->name == name)
+			{
+				return variable;
+			}
+		}
+
+		return nullptr;
+	}
+	/// <summary>
+	/// Count the statements of the specified kind in the body of the pixel shader, without looking into nested statements.
+	/// </summary>
+	size_t count_statements(const syntax_tree &ast, nodeid id)
+	{
+		const auto function = find_function(ast, "PS");
+
+		if (function == nullptr)
+		{
+			return 0;
+		}
+
+		return std::count_if(function->definition->statement_list.begin(), function->definition->statement_list.end(),
+			[id](const nodes::statement_node *statement) {
+				return statement->id == id;
+			});
+	}
+
+	void test_folded_expressions()
+	{
+		syntax_tree ast;
+
+		// The reference to the constant becomes a literal, after which the product of two literals does too
+		const auto stats = optimize_effect(ast, "uniform float Scale = 2.0;\n"
+			"float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { return tex2D(BackBuffer, texcoord) * (Scale * 0.5); }");
+
+		CHECK_EQUAL(stats.folded_expressions, 2);
+		CHECK_EQUAL(stats.pruned_branches, 0);
+		CHECK_EQUAL(count_statements(ast, nodeid::return_statement), 1);
+
+		const auto ps = find_function(ast, "PS");
+
+		if (ps != nullptr && !ps->definition->statement_list.empty() && ps->definition->statement_list[0]->id == nodeid::return_statement)
+		{
+			const auto product = static_cast<const nodes::return_statement_node *>(ps->definition->statement_list[0])->return_value;
+
+			const auto factor = product->id == nodeid::binary_expression ? static_cast<const nodes::binary_expression_node *>(product)->operands[1] : nullptr;
+
+			CHECK(factor != nullptr && factor->id == nodeid::literal_expression && static_cast<const nodes::literal_expression_node *>(factor)->value_float[0] == 1.0f);
+		}
+	}
+	void test_pruned_branches()
+	{
+		const std::string options = "uniform bool UseBloom = false;\nuniform int Samples = 0;\n";
+
+		{ syntax_tree ast;
+			const auto stats = optimize_effect(ast, options +
+				"float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { float4 color = tex2D(BackBuffer, texcoord); if (UseBloom) color = 0.0; return color; }");
+
+			CHECK_EQUAL(stats.pruned_branches, 1);
+			CHECK_EQUAL(count_statements(ast, nodeid::if_statement), 0);
+			CHECK_EQUAL(count_statements(ast, nodeid::expression_statement), 0);
+		}
+
+		// The other branch takes the place of the statement
+		{ syntax_tree ast;
+			const auto stats = optimize_effect(ast, options +
+				"float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { float4 color = tex2D(BackBuffer, texcoord); if (UseBloom) color = 0.0; else color *= 2.0; return color; }");
+
+			CHECK_EQUAL(stats.pruned_branches, 1);
+			CHECK_EQUAL(count_statements(ast, nodeid::if_statement), 0);
+			CHECK_EQUAL(count_statements(ast, nodeid::expression_statement), 1);
+		}
+
+		// A loop that never runs keeps its initializer, in a scope of its own
+		{ syntax_tree ast;
+			const auto stats = optimize_effect(ast, options +
+				"float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { float4 color = tex2D(BackBuffer, texcoord); for (int i = 0; Samples > 0; i++) color += 1.0; return color; }");
+
+			CHECK_EQUAL(stats.pruned_branches, 1);
+			CHECK_EQUAL(count_statements(ast, nodeid::for_statement), 0);
+			CHECK_EQUAL(count_statements(ast, nodeid::compound_statement), 1);
+		}
+
+		{ syntax_tree ast;
+			const auto stats = optimize_effect(ast, options +
+				"float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { float4 color = tex2D(BackBuffer, texcoord); while (UseBloom) color *= 0.5; return color; }");
+
+			CHECK_EQUAL(stats.pruned_branches, 1);
+			CHECK_EQUAL(count_statements(ast, nodeid::while_statement), 0);
+		}
+
+		// The body of a do-while loop runs once even if the condition is false
+		{ syntax_tree ast;
+			const auto stats = optimize_effect(ast, options +
+				"float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { float4 color = tex2D(BackBuffer, texcoord); do { color *= 0.5; } while (UseBloom); return color; }");
+
+			CHECK_EQUAL(stats.pruned_branches, 0);
+			CHECK_EQUAL(count_statements(ast, nodeid::while_statement), 1);
+		}
+
+		// A loop whose condition stays true is not removed either
+		{ syntax_tree ast;
+			const auto stats = optimize_effect(ast, options +
+				"float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { float4 color = tex2D(BackBuffer, texcoord); for (int i = 0; i < 4; i++) color *= 0.5; return color; }");
+
+			CHECK_EQUAL(stats.pruned_branches, 0);
+			CHECK_EQUAL(count_statements(ast, nodeid::for_statement), 1);
+		}
+	}
+	void test_removed_declarations()
+	{
+		syntax_tree ast;
+
+		// 'Helper' is only called from the pruned branch and the baked option is only read where it was folded, while 'Weight' is written to and stays
+		const auto stats = optimize_effect(ast,
+			"uniform float Strength;\n"
+			"uniform bool UseBloom = false;\n"
+			"static float Weight = 1.0;\n"
+			"static float Unused = 1.0;\n"
+			"float Helper(float x) { return x * 2.0; }\n"
+			"float NeverCalled(float x) { return x; }\n"
+			"float4 PS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target { float4 color = tex2D(BackBuffer, texcoord); if (UseBloom) color.r = Helper(color.r); Weight = color.a; return color * Weight; }");
+
+		CHECK_EQUAL(stats.removed_functions, 2);
+		CHECK_EQUAL(stats.removed_variables, 2);
+		CHECK(find_function(ast, "PS") != nullptr && find_function(ast, "PostProcessVS") != nullptr);
+		CHECK(find_function(ast, "Helper") == nullptr && find_function(ast, "NeverCalled") == nullptr);
+		CHECK(find_variable(ast, "Weight") != nullptr && find_variable(ast, "UseBloom") == nullptr && find_variable(ast, "Unused") == nullptr);
+
+		// Uniforms that were not baked, textures and samplers are visible to the user and stay even if nothing reads them
+		CHECK(find_variable(ast, "Strength") != nullptr && find_variable(ast, "BackBufferTex") != nullptr && find_variable(ast, "BackBuffer") != nullptr);
+	}
+}
+
+int main()
+{
+	test_point_wise_input();
+	test_folded_expressions();
+	test_pruned_branches();
+	test_removed_declarations();
+
+	if (failures != 0)
+	{
+		std::fprintf(stderr, "%u checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,336 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "pe_exports.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <iterator>
+
+using namespace reshade;
+
+namespace
+{
+	unsigned int failures = 0;
+	std::string data_path;
+
+	#define CHECK(expression) check(expression, #expression, __LINE__)
+	#define CHECK_EQUAL(actual, expected) check_equal(actual, expected, #actual, __LINE__)
+
+	void check(bool value, const char *expression, int line)
+	{
+		if (!value)
+		{
+			std::fprintf(stderr, "line %d: %s is false\n", line, expression);
+			failures++;
+		}
+	}
+	void check_equal(size_t actual, size_t expected, const char *expression, int line)
+	{
+		if (actual != expected)
+		{
+			std::fprintf(stderr, "line %d: %s is %zu, expected %zu\n", line, expression, actual, expected);
+			failures++;
+		}
+	}
+
+	std::vector<uint8_t> read_image(const char *name)
+	{
+		std::ifstream file(data_path + '/' + name, std::ios::binary);
+
+		if (!file)
+		{
+			std::fprintf(stderr, "failed to open %s\n", name);
+			failures++;
+		}
+
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	uint16_t read_u16(const std::vector<uint8_t> &image, size_t offset)
+	{
+		return static_cast<uint16_t>(image[offset] | (image[offset + 1] << 8));
+	}
+	uint32_t read_u32(const std::vector<uint8_t> &image, size_t offset)
+	{
+		return read_u16(image, offset) | (static_cast<uint32_t>(read_u16(image, offset + 2)) << 16);
+	}
+	void write_u16(std::vector<uint8_t> &image, size_t offset, uint16_t value)
+	{
+		image[offset] = static_cast<uint8_t>(value);
+		image[offset + 1] = static_cast<uint8_t>(value >> 8);
+	}
+	void write_u32(std::vector<uint8_t> &image, size_t offset, uint32_t value)
+	{
+		write_u16(image, offset, static_cast<uint16_t>(value));
+		write_u16(image, offset + 2, static_cast<uint16_t>(value >> 16));
+	}
+
+	size_t optional_header_offset(const std::vector<uint8_t> &image)
+	{
+		return read_u32(image, 0x3C) + 24;
+	}
+	/// <summary>
+	/// Lay out a file image like the loader does, so that the mapped layout can be tested on the same images.
+	/// </summary>
+	std::vector<uint8_t> map_image(const std::vector<uint8_t> &file)
+	{
+		const size_t optional_header = optional_header_offset(file);
+		const size_t section_count = read_u16(file, optional_header - 18), section_table = optional_header + read_u16(file, optional_header - 4);
+
+		// The size of the image and of the headers are at the same offset in PE32 and PE32+ images
+		std::vector<uint8_t> image(read_u32(file, optional_header + 56));
+		std::memcpy(image.data(), file.data(), read_u32(file, optional_header + 60));
+
+		for (size_t i = 0, offset = section_table; i < section_count; i++, offset += 40)
+		{
+			const uint32_t virtual_size = read_u32(file, offset + 8), virtual_address = read_u32(file, offset + 12), raw_offset = read_u32(file, offset + 20);
+
+			std::memcpy(image.data() + virtual_address, file.data() + raw_offset, virtual_size);
+		}
+
+		return image;
+	}
+	/// <summary>
+	/// Find the export directory of a mapped image, in which the relative virtual addresses are offsets.
+	/// </summary>
+	size_t export_directory_offset(const std::vector<uint8_t> &image)
+	{
+		const size_t optional_header = optional_header_offset(image);
+
+		return read_u32(image, optional_header + (read_u16(image, optional_header) == 0x20B ? 112 : 96));
+	}
+
+	bool get_exports(const std::vector<uint8_t> &image, pe::image_layout layout, std::vector<pe::export_symbol> &exports)
+	{
+		return pe::get_exports(image.data(), image.size(), layout, exports);
+	}
+	const pe::export_symbol *find_export(const std::vector<pe::export_symbol> &exports, const char *name)
+	{
+		for (const auto &symbol : exports)
+		{
+			if (std::strcmp(symbol.name, name) == 0)
+			{
+				return &symbol;
+			}
+		}
+
+		return nullptr;
+	}
+	bool is_sorted(const std::vector<pe::export_symbol> &exports)
+	{
+		for (size_t i = 1; i < exports.size(); i++)
+		{
+			if (std::strcmp(exports[i - 1].name, exports[i].name) >= 0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void test_opengl32(const char *name)
+	{
+		const auto file = read_image(name), image = map_image(file);
+		std::vector<pe::export_symbol> file_exports, mapped_exports;
+
+		CHECK(get_exports(file, pe::image_layout::file, file_exports));
+		CHECK(get_exports(image, pe::image_layout::mapped, mapped_exports));
+
+		// The 360 exports ReShade replaces and eight it does not
+		CHECK_EQUAL(file_exports.size(), 368);
+		CHECK_EQUAL(mapped_exports.size(), 368);
+		CHECK(is_sorted(file_exports));
+
+		for (size_t i = 0; i < file_exports.size() && i < mapped_exports.size(); i++)
+		{
+			CHECK(std::strcmp(file_exports[i].name, mapped_exports[i].name) == 0);
+			CHECK_EQUAL(file_exports[i].rva, mapped_exports[i].rva);
+			CHECK_EQUAL(file_exports[i].ordinal, mapped_exports[i].ordinal);
+			CHECK_EQUAL(file_exports[i].forwarded, mapped_exports[i].forwarded);
+
+			// The linker assigns ordinals in name order, starting at one
+			CHECK_EQUAL(file_exports[i].ordinal, i + 1);
+		}
+
+		// Every function is a 'ret' instruction, forwarded exports point to the forwarder string
+		for (const auto &symbol : mapped_exports)
+		{
+			if (symbol.forwarded)
+			{
+				CHECK(std::strcmp(reinterpret_cast<const char *>(image.data() + symbol.rva), "GDI32.wglGetDefaultProcAddress") == 0);
+			}
+			else
+			{
+				CHECK_EQUAL(image[symbol.rva], 0xC3);
+			}
+		}
+
+		const auto forwarded = find_export(mapped_exports, "wglGetDefaultProcAddress");
+		CHECK(forwarded != nullptr && forwarded->forwarded);
+
+		const auto function = find_export(mapped_exports, "glBegin");
+		CHECK(function != nullptr && !function->forwarded);
+	}
+
+	void test_unsorted_name_table()
+	{
+		const auto file = read_image("unsorted_x86.dll");
+		std::vector<pe::export_symbol> exports;
+
+		CHECK(get_exports(file, pe::image_layout::file, exports));
+		CHECK_EQUAL(exports.size(), 4);
+
+		// The export without a name is left out, the others are sorted and keep the ordinal of their function
+		const char *const names[] = { "Alpha", "Beta", "Gamma", "Zeta" };
+		const size_t ordinals[] = { 8, 6, 9, 5 };
+
+		for (size_t i = 0; i < exports.size() && i < 4; i++)
+		{
+			CHECK(std::strcmp(exports[i].name, names[i]) == 0);
+			CHECK_EQUAL(exports[i].ordinal, ordinals[i]);
+			CHECK_EQUAL(exports[i].forwarded, i == 2);
+		}
+	}
+
+	void test_empty_export_table()
+	{
+		const auto file = read_image("empty_exports_x64.dll");
+		std::vector<pe::export_symbol> exports(1);
+
+		CHECK(get_exports(file, pe::image_layout::file, exports));
+		CHECK_EQUAL(exports.size(), 0);
+	}
+
+	void test_match_exports()
+	{
+		const auto target_file = read_image("opengl32_x64.dll"), replacement_file = read_image("reshade_x64.dll");
+		std::vector<pe::export_symbol> target, replacement;
+
+		CHECK(get_exports(target_file, pe::image_layout::file, target));
+		CHECK(get_exports(replacement_file, pe::image_layout::file, replacement));
+
+		const auto matches = pe::match_exports(target, replacement);
+
+		// Everything but the exports ReShade does not replace
+		CHECK_EQUAL(matches.size(), 360);
+
+		for (size_t i = 0; i < matches.size(); i++)
+		{
+			CHECK(std::strcmp(target[matches[i].first].name, replacement[matches[i].second].name) == 0);
+			CHECK(std::strncmp(target[matches[i].first].name, "Glmf", 4) != 0);
+
+			if (i != 0)
+			{
+				CHECK(matches[i - 1].first < matches[i].first && matches[i - 1].second < matches[i].second);
+			}
+		}
+
+		CHECK_EQUAL(pe::match_exports(target, {}).size(), 0);
+		CHECK_EQUAL(pe::match_exports(target, target).size(), target.size());
+	}
+
+	void test_truncated_images()
+	{
+		const auto file = read_image("opengl32_x86.dll");
+		std::vector<pe::export_symbol> full, exports;
+
+		CHECK(get_exports(file, pe::image_layout::file, full));
+
+		// Every prefix of the image either fails to parse or, if it only lost the parts the parser does not read, parses to the same exports
+		for (size_t size = 0; size < file.size(); size++)
+		{
+			if (!pe::get_exports(file.data(), size, pe::image_layout::file, exports))
+			{
+				CHECK_EQUAL(exports.size(), 0);
+				continue;
+			}
+
+			CHECK_EQUAL(exports.size(), full.size());
+
+			for (size_t i = 0; i < exports.size() && i < full.size(); i++)
+			{
+				CHECK(exports[i].name == full[i].name);
+				CHECK_EQUAL(exports[i].rva, full[i].rva);
+			}
+		}
+
+		// Only the headers are left, so the section table points past the end
+		CHECK(!pe::get_exports(file.data(), 0x400, pe::image_layout::file, exports));
+		CHECK(!pe::get_exports(file.data(), file.size() / 2, pe::image_layout::file, exports));
+	}
+
+	void test_malformed_images()
+	{
+		const auto image = map_image(read_image("opengl32_x64.dll"));
+		const size_t optional_header = optional_header_offset(image), export_directory = export_directory_offset(image);
+		std::vector<pe::export_symbol> exports;
+
+		CHECK(get_exports(image, pe::image_layout::mapped, exports));
+
+		auto corrupted = image;
+		write_u16(corrupted, 0, 0);
+		CHECK(!get_exports(corrupted, pe::image_layout::mapped, exports));
+
+		corrupted = image;
+		write_u32(corrupted, 0x3C, static_cast<uint32_t>(image.size()));
+		CHECK(!get_exports(corrupted, pe::image_layout::mapped, exports));
+
+		corrupted = image;
+		write_u16(corrupted, optional_header, 0x107);
+		CHECK(!get_exports(corrupted, pe::image_layout::mapped, exports));
+
+		// A function index past the end of the address table
+		corrupted = image;
+		write_u16(corrupted, read_u32(image, export_directory + 36), 0xFFFF);
+		CHECK(!get_exports(corrupted, pe::image_layout::mapped, exports));
+
+		// A name outside of the image
+		corrupted = image;
+		write_u32(corrupted, read_u32(image, export_directory + 32), static_cast<uint32_t>(image.size()));
+		CHECK(!get_exports(corrupted, pe::image_layout::mapped, exports));
+
+		// A name table that runs past the end of the image
+		corrupted = image;
+		write_u32(corrupted, export_directory + 24, 0x40000000);
+		CHECK(!get_exports(corrupted, pe::image_layout::mapped, exports));
+
+		// A name that is not terminated before the end of the image
+		corrupted = image;
+		corrupted.resize(corrupted.size() + 4, 'A');
+		write_u32(corrupted, read_u32(image, export_directory + 32), static_cast<uint32_t>(image.size()));
+		CHECK(!get_exports(corrupted, pe::image_layout::mapped, exports));
+		CHECK_EQUAL(exports.size(), 0);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 2)
+	{
+		std::fprintf(stderr, "usage: pe_exports_test <directory with the sample images>\n");
+		return 2;
+	}
+
+	data_path = argv[1];
+
+	test_opengl32("opengl32_x86.dll");
+	test_opengl32("opengl32_x64.dll");
+	test_unsorted_name_table();
+	test_empty_export_table();
+	test_match_exports();
+	test_truncated_images();
+	test_malformed_images();
+
+	if (failures != 0)
+	{
+		std::fprintf(stderr, "%u checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "preset_writer.hpp"
+#include "ini_file.hpp"
+#include <cstdio>
+#include <fstream>
+
+using namespace reshade;
+
+namespace
+{
+	unsigned int failures = 0;
+
+	#define CHECK_EQUAL(actual, expected) check_equal(actual, expected, #actual, __LINE__)
+
+	void check_equal(size_t actual, size_t expected, const char *expression, int line)
+	{
+		if (actual != expected)
+		{
+			std::fprintf(stderr, "line %d: %s is %zu, expected %zu\n", line, expression, actual, expected);
+			failures++;
+		}
+	}
+
+	/// <summary>
+	/// Create a preset with a single value in it, replacing any left over from a previous run.
+	/// </summary>
+	filesystem::path create_preset(const char *name)
+	{
+		const filesystem::path path = name;
+
+		std::ofstream file(path.native(), std::ios::trunc);
+		file << "[Untouched.fx]" << std::endl << "Value=7" << std::endl;
+
+		return path;
+	}
+	int read_value(const filesystem::path &path, const std::string &section, const std::string &key)
+	{
+		return ini_file(path).get(section, key, -1).as<int>();
+	}
+
+	/// <summary>
+	/// Wait for the background thread to write the specified number of times, or give up after a few seconds.
+	/// </summary>
+	void wait_for_writes(const preset_writer &writer, size_t count)
+	{
+		const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+		while (writer.writes() < count && std::chrono::steady_clock::now() < timeout)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+
+	void test_slider_drag_is_one_write()
+	{
+		const auto path = create_preset("preset_writer_test_drag.ini");
+		const std::chrono::milliseconds quiet_period(250);
+
+		preset_writer writer(quiet_period);
+
+		// The whole preset is recorded once, after which dragging a slider records only its own value, every frame for 50 frames before the user lets go
+		writer.queue(path, { { "Bloom.fx", { { "Strength", 0 }, { "Radius", 2 } } } });
+
+		for (int frame = 1; frame <= 50; frame++)
+		{
+			writer.queue(path, { { "Bloom.fx", { { "Strength", frame } } } });
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		wait_for_writes(writer, 1);
+
+		// Nothing else is written once the preset was left alone
+		std::this_thread::sleep_for(quiet_period * 2);
+
+		CHECK_EQUAL(writer.requests(), 51);
+		CHECK_EQUAL(writer.writes(), 1);
+
+		CHECK_EQUAL(read_value(path, "Bloom.fx", "Strength"), 50);
+		CHECK_EQUAL(read_value(path, "Bloom.fx", "Radius"), 2);
+		CHECK_EQUAL(read_value(path, "Untouched.fx", "Value"), 7);
+
+		// The file is written to a temporary file first and then moved over the preset
+		CHECK_EQUAL(filesystem::exists(path + ".tmp"), false);
+
+		std::remove(path.string().c_str());
+	}
+
+	void test_flush_writes_every_preset_once()
+	{
+		const auto first = create_preset("preset_writer_test_first.ini"), second = create_preset("preset_writer_test_second.ini");
+
+		preset_writer writer(std::chrono::hours(1));
+
+		// Changes to different keys and sections of the same preset are merged
+		writer.queue(first, { { "Bloom.fx", { { "Strength", 1 } } } });
+		writer.queue(first, { { "Bloom.fx", { { "Radius", 2 } } }, { "Vignette.fx", { { "Amount", 3 } } } });
+		writer.queue(second, { { "Bloom.fx", { { "Strength", 4 } } } });
+		writer.queue(first, { { "Bloom.fx", { { "Strength", 5 } } } });
+
+		CHECK_EQUAL(writer.writes(), 0);
+
+		writer.flush();
+
+		CHECK_EQUAL(writer.requests(), 4);
+		CHECK_EQUAL(writer.writes(), 2);
+
+		CHECK_EQUAL(read_value(first, "Bloom.fx", "Strength"), 5);
+		CHECK_EQUAL(read_value(first, "Bloom.fx", "Radius"), 2);
+		CHECK_EQUAL(read_value(first, "Vignette.fx", "Amount"), 3);
+		CHECK_EQUAL(read_value(first, "Untouched.fx", "Value"), 7);
+		CHECK_EQUAL(read_value(second, "Bloom.fx", "Strength"), 4);
+
+		// There is nothing left to write
+		writer.flush();
+
+		CHECK_EQUAL(writer.writes(), 2);
+
+		std::remove(first.string().c_str());
+		std::remove(second.string().c_str());
+	}
+
+	void test_destructor_writes_pending_changes()
+	{
+		const auto path = create_preset("preset_writer_test_exit.ini");
+
+		{ preset_writer writer(std::chrono::hours(1));
+			writer.queue(path, { { "Bloom.fx", { { "Strength", 9 } } } });
+		}
+
+		CHECK_EQUAL(read_value(path, "Bloom.fx", "Strength"), 9);
+
+		std::remove(path.string().c_str());
+	}
+}
+
+int main()
+{
+	test_slider_drag_is_one_write();
+	test_flush_writes_every_preset_once();
+	test_destructor_writes_pending_changes();
+
+	if (failures != 0)
+	{
+		std::fprintf(stderr, "%u checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
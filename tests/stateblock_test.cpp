@@ -0,0 +1,261 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "d3d10/d3d10_stateblock.hpp"
+#include "d3d11/d3d11_stateblock.hpp"
+#include <cstdio>
+#include <deque>
+#include <iterator>
+#include <type_traits>
+
+namespace
+{
+	unsigned int failures = 0;
+
+	#define CHECK_EQUAL(actual, expected) check_equal(actual, expected, #actual, __LINE__)
+
+	void check_equal(size_t actual, size_t expected, const char *expression, int line)
+	{
+		if (actual != expected)
+		{
+			std::fprintf(stderr, "line %d: %s is %zu, expected %zu\n", line, expression, actual, expected);
+			failures++;
+		}
+	}
+
+	/// <summary>
+	/// Bind a new object to a slot of a mock pipeline. The objects live until the end of the test, so that their references can still be checked after they were unbound.
+	/// </summary>
+	template <typename T>
+	void bind_new(T *&slot)
+	{
+		static std::deque<T> s_objects;
+		s_objects.emplace_back();
+
+		mock::set(slot, &s_objects.back());
+	}
+	template <typename T, size_t N>
+	void bind_new(T *(&slots)[N], size_t count = N)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			bind_new(slots[i]);
+		}
+	}
+	template <typename T>
+	void unbind(T *&slot)
+	{
+		mock::set(slot, static_cast<T *>(nullptr));
+	}
+
+	/// <summary>
+	/// Call a function with every object slot of two mock pipelines of the same type.
+	/// </summary>
+	template <typename P, typename F>
+	void for_each_slot(const P &actual, const P &expected, F f)
+	{
+		const auto each = [&f](const auto &actual_slots, const auto &expected_slots) {
+			for (size_t i = 0; i < std::size(actual_slots); i++)
+			{
+				f(actual_slots[i], expected_slots[i]);
+			}
+		};
+
+		f(actual.ia_input_layout, expected.ia_input_layout);
+		each(actual.ia_vertex_buffers, expected.ia_vertex_buffers);
+		f(actual.ia_index_buffer, expected.ia_index_buffer);
+		f(actual.rs_state, expected.rs_state);
+		f(actual.vs, expected.vs);
+		each(actual.VS_ConstantBuffers, expected.VS_ConstantBuffers);
+		each(actual.VS_Samplers, expected.VS_Samplers);
+		each(actual.VS_ShaderResources, expected.VS_ShaderResources);
+		f(actual.gs, expected.gs);
+		f(actual.ps, expected.ps);
+		each(actual.PS_ConstantBuffers, expected.PS_ConstantBuffers);
+		each(actual.PS_Samplers, expected.PS_Samplers);
+		each(actual.PS_ShaderResources, expected.PS_ShaderResources);
+		f(actual.om_blend_state, expected.om_blend_state);
+		f(actual.om_depth_stencil_state, expected.om_depth_stencil_state);
+		each(actual.om_render_targets, expected.om_render_targets);
+		f(actual.om_depth_stencil, expected.om_depth_stencil);
+
+		if constexpr (std::is_same<P, ID3D11DeviceContext>::value)
+		{
+			f(actual.hs, expected.hs);
+			f(actual.ds, expected.ds);
+		}
+	}
+
+	/// <summary>
+	/// Fill every slot of the pipeline with an object of its own, like a game that uses all of them would.
+	/// </summary>
+	template <typename P>
+	void bind_game_state(P &pipeline)
+	{
+		bind_new(pipeline.ia_input_layout);
+		bind_new(pipeline.ia_vertex_buffers);
+		bind_new(pipeline.ia_index_buffer);
+		bind_new(pipeline.rs_state);
+		bind_new(pipeline.vs);
+		bind_new(pipeline.VS_ConstantBuffers);
+		bind_new(pipeline.VS_Samplers);
+		bind_new(pipeline.VS_ShaderResources);
+		bind_new(pipeline.gs);
+		bind_new(pipeline.ps);
+		bind_new(pipeline.PS_ConstantBuffers);
+		bind_new(pipeline.PS_Samplers);
+		bind_new(pipeline.PS_ShaderResources);
+		bind_new(pipeline.om_blend_state);
+		bind_new(pipeline.om_depth_stencil_state);
+		bind_new(pipeline.om_render_targets);
+		bind_new(pipeline.om_depth_stencil);
+
+		if constexpr (std::is_same<P, ID3D11DeviceContext>::value)
+		{
+			bind_new(pipeline.hs);
+			bind_new(pipeline.ds);
+		}
+
+		pipeline.rs_num_viewports = 1;
+		pipeline.rs_viewports[0].Width = 1920;
+		pipeline.rs_viewports[0].Height = 1080;
+	}
+	/// <summary>
+	/// Bind what the runtime binds to render its effects, which stays within the slots it reports as used.
+	/// </summary>
+	template <typename P>
+	void render_effects(P &pipeline, UINT constant_buffers, UINT samplers, UINT shader_resources)
+	{
+		unbind(pipeline.ia_input_layout);
+		unbind(pipeline.ia_vertex_buffers[0]);
+		bind_new(pipeline.rs_state);
+		bind_new(pipeline.vs);
+		bind_new(pipeline.ps);
+		bind_new(pipeline.PS_ConstantBuffers, constant_buffers);
+		bind_new(pipeline.PS_Samplers, samplers);
+		bind_new(pipeline.PS_ShaderResources, shader_resources);
+		bind_new(pipeline.om_blend_state);
+		bind_new(pipeline.om_depth_stencil_state);
+		bind_new(pipeline.om_render_targets[0]);
+
+		for (size_t i = 1; i < std::size(pipeline.om_render_targets); i++)
+		{
+			unbind(pipeline.om_render_targets[i]);
+		}
+
+		unbind(pipeline.om_depth_stencil);
+
+		pipeline.rs_viewports[0].Width = 960;
+		pipeline.rs_viewports[0].Height = 540;
+	}
+
+	/// <summary>
+	/// Render one frame with the stateblock saving the game state around the effects, and check that the game finds its state as it left it.
+	/// </summary>
+	/// <returns>What the stateblock asked of the pipeline during the frame, without what the effects did.</returns>
+	template <typename P, typename C, typename A>
+	mock_statistics render_frame(P &pipeline, C capture, A apply_and_release)
+	{
+		const P expected = pipeline;
+
+		g_mock_statistics = mock_statistics();
+
+		capture();
+
+		const mock_statistics statistics = g_mock_statistics;
+
+		render_effects(pipeline, 1, 3, 8);
+
+		g_mock_statistics = statistics;
+
+		apply_and_release();
+
+		size_t changed = 0, leaked = 0;
+
+		// The game holds one reference on its objects and binding them holds another, the stateblock must have released all those it took
+		for_each_slot(pipeline, expected,
+			[&changed, &leaked](const mock_object *actual, const mock_object *expected) {
+				changed += actual != expected;
+				leaked += expected != nullptr && expected->references != 2;
+			});
+
+		CHECK_EQUAL(changed, 0);
+		CHECK_EQUAL(leaked, 0);
+		CHECK_EQUAL(pipeline.rs_viewports[0].Width, 1920);
+
+		return g_mock_statistics;
+	}
+
+	void print(const char *name, const mock_statistics &all_slots, const mock_statistics &used_slots)
+	{
+		std::printf("%-8s all slots: %3u calls %4u slots %4u references, used slots: %3u calls %4u slots %4u references per frame\n",
+			name, all_slots.calls, all_slots.slots, all_slots.references, used_slots.calls, used_slots.slots, used_slots.references);
+	}
+
+	void test_d3d10_stateblock()
+	{
+		ID3D10Device device;
+		bind_game_state(device);
+
+		reshade::d3d10::d3d10_stateblock stateblock(&device);
+
+		const auto all_slots = render_frame(device, [&]() { stateblock.capture(); }, [&]() { stateblock.apply_and_release(); });
+
+		// The runtime of an effect with one constant buffer, 3 samplers and 8 textures
+		stateblock.set_used_slots(1, 1, 3, 8);
+
+		const auto used_slots = render_frame(device, [&]() { stateblock.capture(); }, [&]() { stateblock.apply_and_release(); });
+
+		print("d3d10", all_slots, used_slots);
+
+		// Limiting the slots removes no calls, but every slot left out is neither queried nor set again, each of which took a reference
+		CHECK_EQUAL(used_slots.calls, all_slots.calls);
+		CHECK_EQUAL(all_slots.slots - used_slots.slots, 2 * ((16 - 1) + 2 * ((14 - 1) + (16 - 3) + (128 - 8))));
+		CHECK_EQUAL(all_slots.references - used_slots.references, 2 * ((16 - 1) + 2 * ((14 - 1) + (16 - 3) + (128 - 8))));
+	}
+	void test_d3d11_stateblock()
+	{
+		ID3D11Device device;
+		ID3D11DeviceContext context;
+		bind_game_state(context);
+
+		reshade::d3d11::d3d11_stateblock stateblock(&device);
+
+		const auto all_slots = render_frame(context, [&]() { stateblock.capture(&context); }, [&]() { stateblock.apply_and_release(); });
+
+		stateblock.set_used_slots(1, 1, 3, 8);
+
+		const auto used_slots = render_frame(context, [&]() { stateblock.capture(&context); }, [&]() { stateblock.apply_and_release(); });
+
+		print("d3d11", all_slots, used_slots);
+
+		CHECK_EQUAL(used_slots.calls, all_slots.calls);
+		CHECK_EQUAL(all_slots.slots - used_slots.slots, 2 * ((32 - 1) + 2 * ((14 - 1) + (16 - 3) + (128 - 8))));
+		CHECK_EQUAL(all_slots.references - used_slots.references, 2 * ((32 - 1) + 2 * ((14 - 1) + (16 - 3) + (128 - 8))));
+
+		// Feature level 10.0 devices have fewer vertex buffer slots, which the stateblock must not exceed, and no hull and domain shader stages
+		device.feature_level = D3D_FEATURE_LEVEL_10_0;
+
+		reshade::d3d11::d3d11_stateblock stateblock_10_0(&device);
+
+		const auto all_slots_10_0 = render_frame(context, [&]() { stateblock_10_0.capture(&context); }, [&]() { stateblock_10_0.apply_and_release(); });
+
+		CHECK_EQUAL(all_slots.slots - all_slots_10_0.slots, 2 * (32 - 16) + 2 * 2);
+	}
+}
+
+int main()
+{
+	test_d3d10_stateblock();
+	test_d3d11_stateblock();
+
+	if (failures != 0)
+	{
+		std::fprintf(stderr, "%u checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
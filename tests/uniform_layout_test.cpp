@@ -0,0 +1,268 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "uniform_layout.hpp"
+#include "parser.hpp"
+#include "effect_reflection.hpp"
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+using namespace reshade;
+
+namespace
+{
+	unsigned int failures = 0;
+
+	#define CHECK_EQUAL(actual, expected) check_equal(actual, expected, #actual, __LINE__)
+
+	void check_equal(size_t actual, size_t expected, const char *expression, int line)
+	{
+		if (actual != expected)
+		{
+			std::fprintf(stderr, "line %d: %s is %zu, expected %zu\n", line, expression, actual, expected);
+			failures++;
+		}
+	}
+
+	struct reference
+	{
+		unsigned int rows, columns, elements;
+		size_t offset, size, element_stride, column_stride, row_stride;
+	};
+
+	void check_layout(uniform_layout::rules rules, const reference *members, size_t count, size_t total_size)
+	{
+		uniform_layout layout(rules);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			CHECK_EQUAL(layout.add(members[i].rows, members[i].columns, members[i].elements), members[i].offset);
+			CHECK_EQUAL(layout[i].size, members[i].size);
+
+			if (members[i].elements != 0)
+			{
+				CHECK_EQUAL(layout[i].element_stride, members[i].element_stride);
+			}
+			if (members[i].columns > 1)
+			{
+				CHECK_EQUAL(layout[i].column_stride, members[i].column_stride);
+				CHECK_EQUAL(layout[i].row_stride, members[i].row_stride);
+			}
+		}
+
+		CHECK_EQUAL(layout.total_size(), total_size);
+	}
+
+	// The offsets the HLSL compiler reports for a constant buffer declaring these members in order (with default column-major matrices)
+	void test_hlsl_cbuffer()
+	{
+		const reference members[] = {
+			{ 1, 1, 0, 0, 4 },             // float
+			{ 2, 1, 0, 4, 8 },             // float2, fits into the rest of the first register
+			{ 2, 1, 0, 16, 8 },            // float2, would straddle the register boundary
+			{ 3, 1, 0, 32, 12 },           // float3, would straddle the register boundary
+			{ 1, 1, 0, 44, 4 },            // float, fills the last component
+			{ 1, 1, 4, 48, 52, 16 },       // float[4], every element in a register of its own, the last one is not padded
+			{ 1, 1, 0, 100, 4 },           // float, packed behind the last array element
+			{ 4, 4, 0, 112, 64, 0, 16, 4 },   // float4x4
+			{ 2, 3, 0, 176, 40, 0, 16, 4 },   // float2x3, three columns with two components each
+			{ 1, 1, 0, 216, 4 },           // float, packed behind the last matrix column
+			{ 3, 3, 2, 224, 92, 48, 16, 4 },  // float3x3[2]
+		};
+
+		check_layout(uniform_layout::rules::hlsl_cbuffer, members, sizeof(members) / sizeof(*members), 320);
+	}
+	void test_d3d9_registers()
+	{
+		const reference members[] = {
+			{ 1, 1, 0, 0, 16 },            // float
+			{ 2, 1, 0, 16, 16 },           // float2
+			{ 1, 1, 4, 32, 64, 16 },       // float[4]
+			{ 4, 4, 0, 96, 64, 0, 16, 4 },    // float4x4
+			{ 3, 2, 0, 160, 32, 0, 16, 4 },   // float3x2
+			{ 2, 2, 3, 192, 96, 32, 16, 4 },  // float2x2[3]
+		};
+
+		check_layout(uniform_layout::rules::d3d9_registers, members, sizeof(members) / sizeof(*members), 288);
+	}
+	// The offsets of the GLSL std140 rules for the same members declared in a uniform block. Matrices are added with their HLSL dimensions like the reflection does, the OpenGL code generator declares a floatRxC as matRxC.
+	void test_std140()
+	{
+		const reference members[] = {
+			{ 1, 1, 0, 0, 4 },             // float
+			{ 2, 1, 0, 8, 8 },             // vec2
+			{ 3, 1, 0, 16, 12 },           // vec3
+			{ 1, 1, 0, 28, 4 },            // float, packed behind the vec3
+			{ 1, 1, 4, 32, 64, 16 },       // float[4], the array stride is rounded up to 16
+			{ 2, 1, 0, 96, 8 },            // vec2
+			{ 4, 4, 0, 112, 64, 0, 4, 16 },   // float4x4 as mat4
+			{ 2, 3, 0, 176, 32, 0, 4, 16 },   // float2x3 as mat2x3, two columns with three components each
+			{ 1, 1, 0, 208, 4 },              // float
+			{ 3, 2, 2, 224, 96, 48, 4, 16 },  // float3x2[2] as mat3x2[2], three columns with two components each
+			{ 1, 1, 0, 320, 4 },              // float, not packed behind the last column
+		};
+
+		check_layout(uniform_layout::rules::std140, members, sizeof(members) / sizeof(*members), 336);
+	}
+
+	// The layout as the reflection requests it for an effect compiled by the OpenGL backend
+	void test_std140_reflection()
+	{
+		reshadefx::syntax_tree ast;
+		std::string errors;
+		reshadefx::parser parser(ast, errors);
+
+		if (!parser.run("uniform matrix<float, 2, 3> Transform; uniform float Scale; uniform float4x4 Projection; uniform matrix<float, 3, 2> Weights[2];"))
+		{
+			std::fprintf(stderr, "%s", errors.c_str());
+			failures++;
+			return;
+		}
+
+		const auto reflection = reshadefx::reflect(ast, uniform_layout::rules::std140);
+
+		CHECK_EQUAL(reflection.uniforms.size(), 4);
+
+		if (reflection.uniforms.size() != 4)
+		{
+			return;
+		}
+
+		// float2x3 is a mat2x3, i.e. two vectors of three components, followed directly by the next member
+		CHECK_EQUAL(reflection.uniforms[0].offset, 0);
+		CHECK_EQUAL(reflection.uniforms[0].size, 24);
+		CHECK_EQUAL(reflection.uniforms[0].column_stride, 4);
+		CHECK_EQUAL(reflection.uniforms[0].row_stride, 16);
+		CHECK_EQUAL(reflection.uniforms[1].offset, 32);
+		CHECK_EQUAL(reflection.uniforms[2].offset, 48);
+		CHECK_EQUAL(reflection.uniforms[3].offset, 112);
+		CHECK_EQUAL(reflection.uniforms[3].element_stride, 48);
+		CHECK_EQUAL(reflection.uniform_block_size, 208);
+
+		// Square matrices are not transposed either, the first row of the HLSL matrix is the first GLSL column
+		const uint32_t values[16] = { 11, 12, 13, 14, 21, 22, 23, 24, 31, 32, 33, 34, 41, 42, 43, 44 };
+		uint32_t block[16] = { };
+
+		const auto &projection = reflection.uniforms[2];
+		uniform_layout::scatter(projection.rows, projection.columns, projection.element_stride, projection.column_stride, projection.row_stride, values, 16, block);
+
+		CHECK_EQUAL(std::memcmp(values, block, sizeof(values)), 0);
+	}
+
+	void test_scatter_gather()
+	{
+		// float[4] in a constant buffer: the shader reads the elements from the start of four consecutive registers
+		{
+			uniform_layout layout(uniform_layout::rules::hlsl_cbuffer);
+			layout.add(1, 1, 4);
+
+			const float values[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+			float block[16] = { }, result[4] = { };
+
+			uniform_layout::scatter(1, 1, layout[0].element_stride, layout[0].column_stride, layout[0].row_stride, values, 4, block);
+
+			for (size_t i = 0; i < 4; i++)
+			{
+				CHECK_EQUAL(static_cast<size_t>(block[i * 4]), i + 1);
+			}
+
+			uniform_layout::gather(1, 1, layout[0].element_stride, layout[0].column_stride, layout[0].row_stride, block, result, 4);
+
+			CHECK_EQUAL(std::memcmp(values, result, sizeof(values)), 0);
+		}
+
+		// float2x3 in a constant buffer: the values are listed row by row, but every register holds a column
+		{
+			uniform_layout layout(uniform_layout::rules::hlsl_cbuffer);
+			layout.add(2, 3);
+
+			const uint32_t values[6] = { 11, 12, 13, 21, 22, 23 };
+			const uint32_t expected[12] = { 11, 21, 0, 0, 12, 22, 0, 0, 13, 23, 0, 0 };
+			uint32_t block[12] = { }, result[6] = { };
+
+			uniform_layout::scatter(2, 3, layout[0].element_stride, layout[0].column_stride, layout[0].row_stride, values, 6, block);
+
+			for (size_t i = 0; i < 12; i++)
+			{
+				CHECK_EQUAL(block[i], expected[i]);
+			}
+
+			uniform_layout::gather(2, 3, layout[0].element_stride, layout[0].column_stride, layout[0].row_stride, block, result, 6);
+
+			CHECK_EQUAL(std::memcmp(values, result, sizeof(values)), 0);
+		}
+
+		// float2[2] in D3D9 registers, written only partially
+		{
+			uniform_layout layout(uniform_layout::rules::d3d9_registers);
+			layout.add(2, 1, 2);
+
+			const uint32_t values[3] = { 1, 2, 3 };
+			const uint32_t expected[8] = { 1, 2, 0, 0, 3, 0, 0, 0 };
+			uint32_t block[8] = { };
+
+			uniform_layout::scatter(2, 1, layout[0].element_stride, layout[0].column_stride, layout[0].row_stride, values, 3, block);
+
+			for (size_t i = 0; i < 8; i++)
+			{
+				CHECK_EQUAL(block[i], expected[i]);
+			}
+		}
+
+		// float2x3 in a std140 block: the values are listed row by row and every row is a column of the GLSL mat2x3, so each one starts a new vector
+		{
+			uniform_layout layout(uniform_layout::rules::std140);
+			layout.add(2, 3);
+
+			const uint32_t values[6] = { 11, 12, 13, 21, 22, 23 };
+			const uint32_t expected[8] = { 11, 12, 13, 0, 21, 22, 23, 0 };
+			uint32_t block[8] = { }, result[6] = { };
+
+			CHECK_EQUAL(layout.total_size(), sizeof(block));
+
+			uniform_layout::scatter(2, 3, layout[0].element_stride, layout[0].column_stride, layout[0].row_stride, values, 6, block);
+
+			for (size_t i = 0; i < 8; i++)
+			{
+				CHECK_EQUAL(block[i], expected[i]);
+			}
+
+			uniform_layout::gather(2, 3, layout[0].element_stride, layout[0].column_stride, layout[0].row_stride, block, result, 6);
+
+			CHECK_EQUAL(std::memcmp(values, result, sizeof(values)), 0);
+		}
+
+		// A vector without any padding is copied as is
+		{
+			uniform_layout layout(uniform_layout::rules::std140);
+			layout.add(4, 1);
+
+			const uint32_t values[4] = { 1, 2, 3, 4 };
+			uint32_t block[4] = { };
+
+			uniform_layout::scatter(4, 1, layout[0].element_stride, layout[0].column_stride, layout[0].row_stride, values, 4, block);
+
+			CHECK_EQUAL(std::memcmp(values, block, sizeof(values)), 0);
+		}
+	}
+}
+
+int main()
+{
+	test_hlsl_cbuffer();
+	test_d3d9_registers();
+	test_std140();
+	test_std140_reflection();
+	test_scatter_gather();
+
+	if (failures != 0)
+	{
+		std::fprintf(stderr, "%u checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
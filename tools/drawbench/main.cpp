@@ -0,0 +1,310 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "draw_call_tracker.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <iostream>
+#include <unordered_map>
+#include <algorithm>
+
+using namespace reshade;
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock clock;
+
+	double seconds_since(clock::time_point start)
+	{
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	int usage()
+	{
+		std::cerr <<
+			"usage: drawbench [-n <iterations>] [-t <threads>] [-d <draw calls per thread>]\n"
+			"\n"
+			"Measures counting draw calls submitted from several threads at once, each with its own mock device context that switches between a few depth stencils, while another thread merges the statistics like a present does. "
+			"Compares the draw call tracker with the shared counters and locked table the runtime used before. The best of all iterations is reported.\n";
+
+		return 2;
+	}
+
+	struct alignas(16) mock_depthstencil
+	{
+		unsigned int index;
+	};
+
+	/// <summary>
+	/// Stands in for a device context, so that the fallback of asking the driver for the bound depth stencil costs something without a driver.
+	/// </summary>
+	struct alignas(64) mock_context
+	{
+		void OMSetRenderTargets(mock_depthstencil *depthstencil)
+		{
+			bound = depthstencil;
+		}
+		void OMGetRenderTargets(mock_depthstencil **depthstencil)
+		{
+			queries++;
+			*depthstencil = bound;
+		}
+
+		mock_depthstencil *bound = nullptr;
+		unsigned int queries = 0;
+	};
+
+	/// <summary>
+	/// The draw call path before the statistics were sharded: shared counters, the binding queried from the context and a table under a lock.
+	/// </summary>
+	class locked_tracker
+	{
+	public:
+		typedef draw_call_tracker<mock_context *, mock_depthstencil *>::counters counters;
+
+		void on_draw(mock_context *context, unsigned int vertices)
+		{
+			_vertices += vertices;
+			const unsigned int drawcall = ++_drawcalls;
+
+			mock_depthstencil *depthstencil = nullptr;
+			context->OMGetRenderTargets(&depthstencil);
+
+			if (depthstencil == nullptr)
+			{
+				return;
+			}
+
+			const std::lock_guard<std::mutex> lock(_mutex);
+
+			auto &stats = _per_depthstencil[depthstencil];
+			stats.drawcalls += 1;
+			stats.vertices += vertices;
+			stats.last_drawcall = drawcall;
+		}
+
+		counters merge()
+		{
+			const std::lock_guard<std::mutex> lock(_mutex);
+
+			counters result;
+			result.drawcalls = _drawcalls.exchange(0);
+			result.vertices = _vertices.exchange(0);
+
+			_per_depthstencil.clear();
+
+			return result;
+		}
+
+	private:
+		std::atomic<unsigned int> _drawcalls = 0, _vertices = 0;
+		std::mutex _mutex;
+		std::unordered_map<mock_depthstencil *, counters> _per_depthstencil;
+	};
+
+	const unsigned int depthstencils_per_thread = 4, draws_per_binding = 16, vertices_per_draw = 3;
+
+	/// <summary>
+	/// Submit the draw calls of all threads at once, while the calling thread merges until they are done.
+	/// </summary>
+	/// <returns>The seconds it took to submit all draw calls.</returns>
+	template <typename D, typename M>
+	double run(unsigned int threads, unsigned int draws, D &draw, M merge)
+	{
+		std::vector<mock_context> contexts(threads);
+		std::vector<mock_depthstencil> depthstencils(threads * depthstencils_per_thread);
+		std::vector<std::thread> workers;
+		std::atomic<unsigned int> running(threads);
+		std::atomic<bool> go(false), hand_over(false);
+
+		for (unsigned int i = 0; i < depthstencils.size(); i++)
+		{
+			depthstencils[i].index = i;
+		}
+
+		for (unsigned int t = 0; t < threads; t++)
+		{
+			workers.emplace_back([&, t]() {
+				while (!go.load())
+				{
+					std::this_thread::yield();
+				}
+
+				mock_context &context = contexts[t];
+
+				for (unsigned int i = 0; i < draws; i++)
+				{
+					if (i % draws_per_binding == 0)
+					{
+						draw.bind(&context, &depthstencils[t * depthstencils_per_thread + (i / draws_per_binding) % depthstencils_per_thread]);
+					}
+
+					draw(&context, vertices_per_draw);
+				}
+
+				running--;
+
+				while (!hand_over.load())
+				{
+					std::this_thread::yield();
+				}
+
+				draw.hand_over(&context);
+			});
+		}
+
+		const auto start = clock::now();
+		go = true;
+
+		while (running.load() != 0)
+		{
+			merge();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		const double seconds = seconds_since(start);
+
+		// Statistics are handed over on the first draw call after a merge, so each thread draws once more after the threads stopped, like the next frame would
+		merge();
+		hand_over = true;
+
+		for (auto &worker : workers)
+		{
+			worker.join();
+		}
+
+		merge();
+
+		return seconds;
+	}
+
+	void print(const char *name, unsigned long long draws, double seconds)
+	{
+		std::printf("%-24s %12llu draws %10.2f ms %10.2f ns/draw\n", name, draws, seconds * 1000.0, seconds * 1000000000.0 / draws);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int iterations = 5, threads = std::max(2u, std::thread::hardware_concurrency()), draws = 1000000;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "-n" && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (arg == "-t" && i + 1 < argc)
+		{
+			threads = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (arg == "-d" && i + 1 < argc)
+		{
+			draws = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			return usage();
+		}
+	}
+
+	const unsigned long long expected = static_cast<unsigned long long>(threads) * draws;
+	double tracker_seconds = 0.0, locked_seconds = 0.0;
+
+	for (unsigned int i = 0; i < iterations; i++)
+	{
+		{ draw_call_tracker<mock_context *, mock_depthstencil *> tracker;
+
+			struct
+			{
+				void bind(mock_context *context, mock_depthstencil *depthstencil)
+				{
+					context->OMSetRenderTargets(depthstencil);
+					tracker->track_binding(context, depthstencil);
+				}
+				void operator()(mock_context *context, unsigned int vertices)
+				{
+					mock_depthstencil *depthstencil = nullptr;
+
+					if (!tracker->find_binding(context, depthstencil))
+					{
+						context->OMGetRenderTargets(&depthstencil);
+					}
+
+					tracker->on_draw(depthstencil, vertices);
+				}
+				void hand_over(mock_context *)
+				{
+					// Counts as a draw call, but does not add vertices, so that those still add up
+					tracker->on_draw(nullptr, 0);
+				}
+
+				draw_call_tracker<mock_context *, mock_depthstencil *> *tracker;
+			} draw = { &tracker };
+
+			unsigned long long vertices = 0, per_depthstencil_vertices = 0;
+
+			const double seconds = run(threads, draws, draw,
+				[&]() {
+					vertices += tracker.merge([&](mock_depthstencil *, const auto &counters) {
+						per_depthstencil_vertices += counters.vertices;
+					}).vertices;
+				});
+
+			tracker_seconds = i == 0 ? seconds : std::min(tracker_seconds, seconds);
+
+			// Every draw call is reported exactly once, in total and for the depth stencil it rendered to
+			if (vertices != expected * vertices_per_draw || per_depthstencil_vertices != vertices)
+			{
+				std::cerr << "the tracker merged " << vertices << " vertices, " << per_depthstencil_vertices << " of them per depth stencil, expected " << expected * vertices_per_draw << '\n';
+				return 1;
+			}
+		}
+
+		{ locked_tracker tracker;
+
+			struct
+			{
+				void bind(mock_context *context, mock_depthstencil *depthstencil)
+				{
+					context->OMSetRenderTargets(depthstencil);
+				}
+				void operator()(mock_context *context, unsigned int vertices)
+				{
+					tracker->on_draw(context, vertices);
+				}
+				void hand_over(mock_context *)
+				{
+				}
+
+				locked_tracker *tracker;
+			} draw = { &tracker };
+
+			unsigned long long vertices = 0;
+
+			const double seconds = run(threads, draws, draw,
+				[&]() {
+					vertices += tracker.merge().vertices;
+				});
+
+			locked_seconds = i == 0 ? seconds : std::min(locked_seconds, seconds);
+
+			if (vertices != expected * vertices_per_draw)
+			{
+				std::cerr << "the locked table merged " << vertices << " vertices, expected " << expected * vertices_per_draw << '\n';
+				return 1;
+			}
+		}
+	}
+
+	print("draw call tracker", expected, tracker_seconds);
+	print("locked table", expected, locked_seconds);
+
+	return 0;
+}
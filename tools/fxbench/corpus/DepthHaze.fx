@@ -0,0 +1,86 @@
+#include "ReShade.fxh"
+
+#ifndef DEPTH_HAZE_SAMPLES
+	#define DEPTH_HAZE_SAMPLES 8
+#endif
+
+#define DEPTH_HAZE_GOLDEN_ANGLE 2.39996323
+#define DEPTH_HAZE_TWO_PI (2.0 * 3.14159265)
+#define DEPTH_HAZE_WEIGHT(d, f) saturate(1.0 - abs((d) - (f)) * 4.0)
+
+uniform float FocusDepth < ui_type = "drag"; ui_min = 0.0; ui_max = 1.0; > = 0.1;
+uniform float HazeStart < ui_type = "drag"; ui_min = 0.0; ui_max = 1.0; > = 0.2;
+uniform float HazeEnd < ui_type = "drag"; ui_min = 0.0; ui_max = 1.0; > = 0.9;
+uniform float3 HazeColor < ui_type = "color"; > = float3(0.8, 0.85, 0.9);
+uniform float4x4 HazeTransform = float4x4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+
+texture DepthHazeTex { Width = BUFFER_WIDTH / 2; Height = BUFFER_HEIGHT / 2; Format = RGBA16F; MipLevels = 2; };
+sampler DepthHazeSampler { Texture = DepthHazeTex; MinFilter = LINEAR; MagFilter = LINEAR; AddressU = CLAMP; AddressV = CLAMP; };
+
+struct haze_sample
+{
+	float3 color;
+	float weight;
+};
+
+haze_sample GatherRing(float2 texcoord, float radius, float focus)
+{
+	haze_sample result;
+	result.color = 0.0;
+	result.weight = 0.0;
+
+	[loop]
+	for (int i = 0; i < DEPTH_HAZE_SAMPLES; ++i)
+	{
+		float s, c;
+		sincos(i * DEPTH_HAZE_GOLDEN_ANGLE, s, c);
+
+		const float2 coord = texcoord + float2(c, s) * radius * ReShade::PixelSize * ((i % 2) == 0 ? 1.0 : 0.5);
+		const float depth = ReShade::GetLinearizedDepth(coord);
+		const float weight = DEPTH_HAZE_WEIGHT(depth, focus);
+
+		result.color += tex2Dlod(ReShade::BackBuffer, float4(coord, 0, 0)).rgb * weight;
+		result.weight += weight;
+	}
+
+	return result;
+}
+
+float4 PrepassPS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	const float depth = ReShade::GetLinearizedDepth(texcoord);
+	const float4 transformed = mul(HazeTransform, float4(texcoord, depth, 1.0));
+
+	haze_sample ring = GatherRing(transformed.xy, 4.0, FocusDepth);
+
+	if (ring.weight <= 0.0)
+	{
+		return float4(tex2D(ReShade::BackBuffer, texcoord).rgb, depth);
+	}
+
+	return float4(ring.color / ring.weight, depth);
+}
+float3 HazePS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	const float3 color = tex2D(ReShade::BackBuffer, texcoord).rgb;
+	const float4 blurred = tex2D(DepthHazeSampler, texcoord);
+	const float amount = smoothstep(HazeStart, HazeEnd, blurred.a);
+
+	return lerp(lerp(color, blurred.rgb, amount), HazeColor, amount * amount);
+}
+
+technique DepthHaze
+{
+	pass Prepass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = PrepassPS;
+		RenderTarget = DepthHazeTex;
+	}
+	pass Haze
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = HazePS;
+		SRGBWriteEnable = true;
+	}
+}
@@ -0,0 +1,82 @@
+#include "ReShade.fxh"
+
+#ifndef GAUSSIAN_BLUR_RADIUS
+	#define GAUSSIAN_BLUR_RADIUS 4
+#endif
+#ifndef GAUSSIAN_BLUR_DOWNSCALE
+	#define GAUSSIAN_BLUR_DOWNSCALE 2
+#endif
+
+uniform float BlurOffset < ui_type = "drag"; ui_min = 0.0; ui_max = 2.0; > = 1.0;
+uniform float BlurStrength < ui_type = "drag"; ui_min = 0.0; ui_max = 1.0; > = 0.5;
+
+texture GaussianBlurTex { Width = BUFFER_WIDTH / GAUSSIAN_BLUR_DOWNSCALE; Height = BUFFER_HEIGHT / GAUSSIAN_BLUR_DOWNSCALE; Format = RGBA8; };
+texture GaussianBlurTex2 { Width = BUFFER_WIDTH / GAUSSIAN_BLUR_DOWNSCALE; Height = BUFFER_HEIGHT / GAUSSIAN_BLUR_DOWNSCALE; Format = RGBA8; };
+
+sampler GaussianBlurSampler { Texture = GaussianBlurTex; };
+sampler GaussianBlurSampler2 { Texture = GaussianBlurTex2; };
+
+float3 BlurDirection(sampler s, float2 texcoord, float2 direction)
+{
+	const float Weights[5] = { 0.2270270270, 0.1945945946, 0.1216216216, 0.0540540541, 0.0162162162 };
+
+	float3 color = tex2D(s, texcoord).rgb * Weights[0];
+
+	[unroll]
+	for (int i = 1; i < GAUSSIAN_BLUR_RADIUS + 1; ++i)
+	{
+		const float2 offset = direction * (i * BlurOffset) * ReShade::PixelSize * GAUSSIAN_BLUR_DOWNSCALE;
+
+		color += tex2D(s, texcoord + offset).rgb * Weights[i];
+		color += tex2D(s, texcoord - offset).rgb * Weights[i];
+	}
+
+	return color;
+}
+
+float3 DownsamplePS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return tex2D(ReShade::BackBuffer, texcoord).rgb;
+}
+float3 HorizontalPS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return BlurDirection(GaussianBlurSampler, texcoord, float2(1.0, 0.0));
+}
+float3 VerticalPS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	return BlurDirection(GaussianBlurSampler2, texcoord, float2(0.0, 1.0));
+}
+float3 CombinePS(float4 position : SV_Position, float2 texcoord : TEXCOORD) : SV_Target
+{
+	const float3 original = tex2D(ReShade::BackBuffer, texcoord).rgb;
+	const float3 blurred = tex2D(GaussianBlurSampler, texcoord).rgb;
+
+	return lerp(original, blurred, BlurStrength);
+}
+
+technique GaussianBlur
+{
+	pass Downsample
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = DownsamplePS;
+		RenderTarget = GaussianBlurTex;
+	}
+	pass Horizontal
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = HorizontalPS;
+		RenderTarget = GaussianBlurTex2;
+	}
+	pass Vertical
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = VerticalPS;
+		RenderTarget = GaussianBlurTex;
+	}
+	pass Combine
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = CombinePS;
+	}
+}
@@ -0,0 +1,74 @@
+#include "ReShade.fxh"
+
+uniform float sharp_strength < ui_type = "drag"; ui_min = 0.1; ui_max = 3.0; ui_label = "Shapening strength"; > = 0.65;
+uniform float sharp_clamp < ui_type = "drag"; ui_min = 0.0; ui_max = 1.0; ui_step = 0.005; > = 0.035;
+uniform int pattern < ui_type = "combo"; ui_items = "Fast\0Normal\0Wider\0Pyramid shaped\0"; > = 1;
+uniform float offset_bias < ui_type = "drag"; ui_min = 0.0; ui_max = 6.0; > = 1.0;
+uniform bool show_sharpen < ui_label = "Show sharpening pattern"; > = false;
+
+#define CoefLuma float3(0.2126, 0.7152, 0.0722)
+
+float3 LumaSharpenPass(float4 position : SV_Position, float2 tex : TEXCOORD) : SV_Target
+{
+	const float3 ori = tex2D(ReShade::BackBuffer, tex).rgb;
+	float3 sharp_strength_luma = (CoefLuma * sharp_strength);
+	float3 blur_ori;
+
+	if (pattern == 0)
+	{
+		blur_ori  = tex2D(ReShade::BackBuffer, tex + (ReShade::PixelSize / 3.0) * offset_bias).rgb;
+		blur_ori += tex2D(ReShade::BackBuffer, tex + (-ReShade::PixelSize / 3.0) * offset_bias).rgb;
+		blur_ori /= 2;
+		sharp_strength_luma *= 1.5;
+	}
+	else if (pattern == 1)
+	{
+		blur_ori  = tex2D(ReShade::BackBuffer, tex + float2(ReShade::PixelSize.x, -ReShade::PixelSize.y) * 0.5 * offset_bias).rgb;
+		blur_ori += tex2D(ReShade::BackBuffer, tex - ReShade::PixelSize * 0.5 * offset_bias).rgb;
+		blur_ori += tex2D(ReShade::BackBuffer, tex + ReShade::PixelSize * 0.5 * offset_bias).rgb;
+		blur_ori += tex2D(ReShade::BackBuffer, tex - float2(ReShade::PixelSize.x, -ReShade::PixelSize.y) * 0.5 * offset_bias).rgb;
+		blur_ori *= 0.25;
+	}
+	else if (pattern == 2)
+	{
+		blur_ori  = tex2D(ReShade::BackBuffer, tex + ReShade::PixelSize * float2(0.4, -1.2) * offset_bias).rgb;
+		blur_ori += tex2D(ReShade::BackBuffer, tex - ReShade::PixelSize * float2(1.2, 0.4) * offset_bias).rgb;
+		blur_ori += tex2D(ReShade::BackBuffer, tex + ReShade::PixelSize * float2(1.2, 0.4) * offset_bias).rgb;
+		blur_ori += tex2D(ReShade::BackBuffer, tex - ReShade::PixelSize * float2(0.4, -1.2) * offset_bias).rgb;
+		blur_ori *= 0.25;
+		sharp_strength_luma *= 0.51;
+	}
+	else
+	{
+		blur_ori  = tex2D(ReShade::BackBuffer, tex + float2(0.5 * ReShade::PixelSize.x, -ReShade::PixelSize.y * offset_bias)).rgb;
+		blur_ori += tex2D(ReShade::BackBuffer, tex + float2(offset_bias * -ReShade::PixelSize.x, 0.5 * -ReShade::PixelSize.y)).rgb;
+		blur_ori += tex2D(ReShade::BackBuffer, tex + float2(offset_bias * ReShade::PixelSize.x, 0.5 * ReShade::PixelSize.y)).rgb;
+		blur_ori += tex2D(ReShade::BackBuffer, tex + float2(0.5 * -ReShade::PixelSize.x, ReShade::PixelSize.y * offset_bias)).rgb;
+		blur_ori /= 4.0;
+		sharp_strength_luma *= 0.666;
+	}
+
+	const float3 sharp = ori - blur_ori;
+	const float4 sharp_strength_luma_clamp = float4(sharp_strength_luma * (0.5 / sharp_clamp), 0.5);
+
+	float sharp_luma = saturate(dot(float4(sharp, 1.0), sharp_strength_luma_clamp));
+	sharp_luma = (sharp_clamp * 2.0) * sharp_luma - sharp_clamp;
+
+	float3 outputcolor = ori + sharp_luma;
+
+	if (show_sharpen)
+	{
+		outputcolor = saturate(0.5 + (sharp_luma * 4.0)).rrr;
+	}
+
+	return saturate(outputcolor);
+}
+
+technique LumaSharpen
+{
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = LumaSharpenPass;
+	}
+}
@@ -0,0 +1,52 @@
+#include "ReShade.fxh"
+
+uniform float Gamma < ui_type = "drag"; ui_min = 0.0; ui_max = 2.0; ui_tooltip = "Adjust midtones."; > = 1.0;
+uniform float Exposure < ui_type = "drag"; ui_min = -1.0; ui_max = 1.0; > = 0.0;
+uniform float Saturation < ui_type = "drag"; ui_min = -1.0; ui_max = 1.0; > = 0.0;
+uniform float Bleach < ui_type = "drag"; ui_min = 0.0; ui_max = 1.0; > = 0.0;
+uniform float Defog < ui_type = "drag"; ui_min = 0.0; ui_max = 1.0; > = 0.0;
+uniform float3 FogColor < ui_type = "color"; > = float3(0.0, 0.0, 1.0);
+
+#define TONEMAP_LUMA_COEFFICIENTS float3(0.2126, 0.7152, 0.0722)
+
+float3 ApplyBleach(float3 color)
+{
+	const float3 coefLuma = TONEMAP_LUMA_COEFFICIENTS;
+	const float lum = dot(coefLuma, color);
+
+	const float L = saturate(10.0 * (lum - 0.45));
+	const float3 A2 = Bleach * color;
+
+	const float3 result1 = 2.0f * color * lum;
+	const float3 result2 = 1.0f - 2.0f * (1.0f - lum) * (1.0f - color);
+
+	const float3 newColor = lerp(result1, result2, L);
+	const float3 mixRGB = A2 * newColor;
+
+	return color + ((1.0f - A2) * mixRGB);
+}
+
+float3 TonemapPass(float4 position : SV_Position, float2 texcoord : TexCoord) : SV_Target
+{
+	float3 color = tex2D(ReShade::BackBuffer, texcoord).rgb;
+	color = saturate(color - Defog * FogColor * 2.55);
+	color *= pow(2.0f, Exposure);
+	color = pow(color, Gamma);
+
+	color = ApplyBleach(color);
+
+	const float3 middlegray = dot(color * (1.0 / 3.0), 1.0);
+	const float3 diffcolor = color - middlegray;
+	color = (color + diffcolor * Saturation) / (1 + (diffcolor * Saturation));
+
+	return color;
+}
+
+technique Tonemap
+{
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = TonemapPass;
+	}
+}
@@ -0,0 +1,49 @@
+#include "ReShade.fxh"
+
+uniform int Type < ui_type = "combo"; ui_items = "Original\0New\0TV style\0Untitled 1\0Untitled 2\0Untitled 3\0Untitled 4\0"; > = 0;
+uniform float Ratio < ui_type = "drag"; ui_min = 0.15; ui_max = 6.0; > = 1.0;
+uniform float Radius < ui_type = "drag"; ui_min = -1.0; ui_max = 3.0; > = 2.0;
+uniform float Amount < ui_type = "drag"; ui_min = -2.0; ui_max = 1.0; > = -1.0;
+uniform int Slope < ui_type = "drag"; ui_min = 2; ui_max = 16; > = 2;
+uniform float2 Center < ui_type = "drag"; ui_min = 0.0; ui_max = 1.0; > = float2(0.5, 0.5);
+
+float4 VignettePass(float4 vpos : SV_Position, float2 tex : TexCoord) : SV_Target
+{
+	float4 color = tex2D(ReShade::BackBuffer, tex);
+
+	if (Type == 0)
+	{
+		float2 distance_xy = tex - Center;
+		distance_xy *= float2((ReShade::PixelSize.y / ReShade::PixelSize.x), Ratio);
+		distance_xy /= Radius;
+		const float distance = dot(distance_xy, distance_xy);
+		color.rgb *= (1.0 + pow(distance, Slope * 0.5) * Amount);
+	}
+	else if (Type == 1)
+	{
+		tex = -tex * tex + tex;
+		color.rgb = saturate(((ReShade::ScreenSize.y / ReShade::ScreenSize.x) * (ReShade::ScreenSize.y / ReShade::ScreenSize.x) * Ratio * Ratio * tex.x + tex.y) * 4.0) * color.rgb;
+	}
+	else if (Type == 2)
+	{
+		tex = -tex * tex + tex;
+		color.rgb = saturate(tex.x * tex.y * 100.0) * color.rgb;
+	}
+	else
+	{
+		const float2 centered = tex - Center;
+		const float vignette = saturate(1.0 - dot(centered, centered) * (Type + 1) * abs(Amount));
+		color.rgb *= vignette;
+	}
+
+	return color;
+}
+
+technique Vignette
+{
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = VignettePass;
+	}
+}
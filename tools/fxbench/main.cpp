@@ -0,0 +1,266 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "optimizer.hpp"
+#include "preprocessor.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+using namespace reshade;
+using namespace reshadefx;
+
+namespace
+{
+	enum stage
+	{
+		stage_preprocess,
+		stage_lex,
+		stage_parse,
+		stage_fold,
+		stage_count
+	};
+
+	const char *const stage_names[stage_count] = { "preprocess", "lex", "parse", "fold" };
+
+	struct timings
+	{
+		// The fastest iteration is reported, since it is the least disturbed by the rest of the system
+		double seconds[stage_count] = { 0.0, 0.0, 0.0, 0.0 };
+		size_t bytes[stage_count] = { 0, 0, 0, 0 };
+	};
+
+	typedef std::chrono::high_resolution_clock clock;
+
+	double seconds_since(clock::time_point start)
+	{
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	int usage()
+	{
+		std::cerr <<
+			"usage: fxbench [-n <iterations>] [-D <name>[=<value>]]... <effect or directory>...\n"
+			"\n"
+			"Measures the throughput of the preprocessor, lexer, parser and optimizer over each effect. Directories are searched for '*.fx' files.\n"
+			"Every stage is run on the output of the previous one, so that a stage is timed on its own. The best of all iterations is reported.\n";
+
+		return 2;
+	}
+
+	bool preprocess(const filesystem::path &path, const std::vector<std::pair<std::string, std::string>> &macros, std::string &output, std::vector<filesystem::path> &included_files)
+	{
+		preprocessor pp;
+		pp.add_include_path(path.parent_path());
+
+		// The same macros the runtime defines for every effect, so that the corpus preprocesses as it would in a game
+		pp.add_macro_definition("__RESHADE__", "30008");
+		pp.add_macro_definition("__RESHADE_PERFORMANCE_MODE__", "0");
+		pp.add_macro_definition("__VENDOR__", "0");
+		pp.add_macro_definition("__DEVICE__", "0");
+		pp.add_macro_definition("__RENDERER__", "45056");
+		pp.add_macro_definition("__APPLICATION__", "0");
+		pp.add_macro_definition("BUFFER_WIDTH", "1920");
+		pp.add_macro_definition("BUFFER_HEIGHT", "1080");
+		pp.add_macro_definition("BUFFER_RCP_WIDTH", std::to_string(1.0f / 1920));
+		pp.add_macro_definition("BUFFER_RCP_HEIGHT", std::to_string(1.0f / 1080));
+
+		for (const auto &macro : macros)
+		{
+			pp.add_macro_definition(macro.first, macro.second);
+		}
+
+		included_files.assign(1, path);
+
+		if (!pp.run(path, included_files))
+		{
+			std::cerr << path << ": " << pp.current_errors();
+			return false;
+		}
+
+		output = pp.current_output();
+
+		return true;
+	}
+
+	bool measure(const filesystem::path &path, const std::vector<std::pair<std::string, std::string>> &macros, unsigned int iterations, timings &result)
+	{
+		std::string source;
+		std::vector<filesystem::path> included_files;
+
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			const auto start = clock::now();
+
+			if (!preprocess(path, macros, source, included_files))
+			{
+				return false;
+			}
+
+			const double seconds = seconds_since(start);
+			result.seconds[stage_preprocess] = i == 0 ? seconds : std::min(result.seconds[stage_preprocess], seconds);
+		}
+
+		// The preprocessor reads the effect and every file it includes
+		uint64_t input_size = 0;
+
+		for (const auto &file : included_files)
+		{
+			uint64_t size = 0, modified = 0;
+			filesystem::file_stamp(file, size, modified);
+
+			input_size += size;
+		}
+
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			size_t token_count = 0;
+			const auto start = clock::now();
+
+			lexer lexer(source);
+
+			while (lexer.lex().id != lexer::tokenid::end_of_file)
+			{
+				token_count++;
+			}
+
+			const double seconds = seconds_since(start);
+			result.seconds[stage_lex] = i == 0 ? seconds : std::min(result.seconds[stage_lex], seconds);
+
+			if (token_count == 0)
+			{
+				std::cerr << path << ": no tokens\n";
+				return false;
+			}
+		}
+
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			syntax_tree ast;
+			std::string errors;
+			parser parser(ast, errors);
+
+			auto start = clock::now();
+
+			if (!parser.run(source))
+			{
+				std::cerr << path << ": " << errors;
+				return false;
+			}
+
+			double seconds = seconds_since(start);
+			result.seconds[stage_parse] = i == 0 ? seconds : std::min(result.seconds[stage_parse], seconds);
+
+			// The optimizer changes the tree in place, so it is timed on the tree that was just parsed
+			start = clock::now();
+
+			optimize(ast);
+
+			seconds = seconds_since(start);
+			result.seconds[stage_fold] = i == 0 ? seconds : std::min(result.seconds[stage_fold], seconds);
+		}
+
+		result.bytes[stage_preprocess] = static_cast<size_t>(input_size);
+		result.bytes[stage_lex] = source.size();
+		result.bytes[stage_parse] = source.size();
+		result.bytes[stage_fold] = source.size();
+
+		return true;
+	}
+
+	void print(const std::string &name, const timings &timings)
+	{
+		for (unsigned int stage = 0; stage < stage_count; stage++)
+		{
+			const double megabytes_per_second = timings.seconds[stage] > 0.0 ? timings.bytes[stage] / timings.seconds[stage] / (1024.0 * 1024.0) : 0.0;
+
+			std::printf("%-24s %-10s %10zu bytes %10.1f us %10.2f MB/s\n", name.c_str(), stage_names[stage], timings.bytes[stage], timings.seconds[stage] * 1000000.0, megabytes_per_second);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int iterations = 20;
+	std::vector<filesystem::path> effects;
+	std::vector<std::pair<std::string, std::string>> macros;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+
+		if ((arg == "-n" || arg == "-D") && i + 1 >= argc)
+		{
+			return usage();
+		}
+
+		if (arg == "-n")
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (arg == "-D")
+		{
+			const std::string definition = argv[++i];
+			const size_t equals_index = definition.find('=');
+
+			if (equals_index != std::string::npos)
+			{
+				macros.emplace_back(definition.substr(0, equals_index), definition.substr(equals_index + 1));
+			}
+			else
+			{
+				macros.emplace_back(definition, "1");
+			}
+		}
+		else if (!arg.empty() && arg[0] == '-')
+		{
+			return usage();
+		}
+		else if (filesystem::path(arg).extension() != ".fx")
+		{
+			auto files = filesystem::list_files(arg, "*.fx");
+			std::sort(files.begin(), files.end(), [](const filesystem::path &lhs, const filesystem::path &rhs) { return lhs.string() < rhs.string(); });
+
+			effects.insert(effects.end(), files.begin(), files.end());
+		}
+		else
+		{
+			effects.push_back(arg);
+		}
+	}
+
+	if (effects.empty())
+	{
+		return usage();
+	}
+
+	timings total;
+
+	for (const auto &effect : effects)
+	{
+		timings timings;
+
+		if (!measure(effect, macros, iterations, timings))
+		{
+			return 1;
+		}
+
+		print(effect.filename_without_extension().string(), timings);
+
+		for (unsigned int stage = 0; stage < stage_count; stage++)
+		{
+			total.seconds[stage] += timings.seconds[stage];
+			total.bytes[stage] += timings.bytes[stage];
+		}
+	}
+
+	print("total", total);
+
+	return 0;
+}
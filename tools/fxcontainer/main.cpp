@@ -0,0 +1,273 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "preprocessor.hpp"
+#include "effect_container.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace reshade;
+using namespace reshadefx;
+
+namespace
+{
+	struct options
+	{
+		std::vector<filesystem::path> include_paths;
+		std::vector<std::pair<std::string, std::string>> macros;
+		filesystem::path output, input;
+	};
+
+	int usage()
+	{
+		std::cerr <<
+			"usage: fxcontainer build [-I <directory>]... [-D <name>[=<value>]]... -o <container> <effect>\n"
+			"       fxcontainer check [-I <directory>]... [-D <name>[=<value>]]... <container>\n"
+			"       fxcontainer inspect <container>\n"
+			"\n"
+			"The include paths and macros passed to 'check' have to be the same as those passed to 'build', the directory of the effect is always searched first.\n";
+
+		return 2;
+	}
+
+	bool parse_options(int argc, char *argv[], options &options)
+	{
+		for (int i = 2; i < argc; i++)
+		{
+			const std::string arg = argv[i];
+
+			if ((arg == "-I" || arg == "-D" || arg == "-o") && i + 1 >= argc)
+			{
+				std::cerr << "missing value for option '" << arg << "'\n";
+				return false;
+			}
+
+			if (arg == "-I")
+			{
+				options.include_paths.push_back(argv[++i]);
+			}
+			else if (arg == "-D")
+			{
+				const std::string definition = argv[++i];
+				const size_t equals_index = definition.find('=');
+
+				if (equals_index != std::string::npos)
+				{
+					options.macros.emplace_back(definition.substr(0, equals_index), definition.substr(equals_index + 1));
+				}
+				else
+				{
+					options.macros.emplace_back(definition, "1");
+				}
+			}
+			else if (arg == "-o")
+			{
+				options.output = argv[++i];
+			}
+			else if (!arg.empty() && arg[0] == '-')
+			{
+				std::cerr << "unknown option '" << arg << "'\n";
+				return false;
+			}
+			else if (options.input.empty())
+			{
+				options.input = arg;
+			}
+			else
+			{
+				std::cerr << "more than one input file\n";
+				return false;
+			}
+		}
+
+		if (options.input.empty())
+		{
+			std::cerr << "no input file\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	std::vector<filesystem::path> effect_include_paths(const filesystem::path &effect, const std::vector<filesystem::path> &include_paths)
+	{
+		std::vector<filesystem::path> result = { effect.parent_path() };
+		result.insert(result.end(), include_paths.begin(), include_paths.end());
+
+		return result;
+	}
+
+	int build(const options &options)
+	{
+		if (options.output.empty())
+		{
+			std::cerr << "no output file\n";
+			return 2;
+		}
+
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		effect_container container;
+		const auto include_paths = effect_include_paths(options.input, options.include_paths);
+		container.input_hash = hash_preprocessor_inputs(include_paths, options.macros);
+
+		preprocessor pp;
+
+		for (const auto &include_path : include_paths)
+		{
+			pp.add_include_path(include_path);
+		}
+		for (const auto &macro : options.macros)
+		{
+			pp.add_macro_definition(macro.first, macro.second);
+		}
+
+		std::vector<filesystem::path> included_files = { options.input };
+
+		if (!pp.run(options.input, included_files))
+		{
+			std::cerr << pp.current_errors();
+			return 1;
+		}
+
+		container.source = pp.current_output();
+
+		if (!stamp_dependencies(included_files, container.dependencies))
+		{
+			std::cerr << "an included file disappeared while the effect was preprocessed\n";
+			return 1;
+		}
+
+		const std::string data = serialize(container);
+		const filesystem::path temp_path = options.output + ".tmp";
+
+		{ std::ofstream file(temp_path.string(), std::ios::binary | std::ios::trunc);
+
+			if (!file.write(data.data(), data.size()))
+			{
+				std::cerr << "failed to write " << temp_path << '\n';
+				return 1;
+			}
+		}
+
+		if (!filesystem::move_file(temp_path, options.output))
+		{
+			std::cerr << "failed to write " << options.output << '\n';
+			return 1;
+		}
+
+		const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+		std::cout << "wrote " << data.size() << " bytes with " << container.dependencies.size() << " dependencies to " << options.output << " in " << duration.count() << " us\n";
+
+		return 0;
+	}
+	int check(const options &options)
+	{
+		const filesystem::mapped_file file(options.input);
+		effect_container container;
+
+		// The effect is the first dependency, its directory is the first include path
+		if (!file.is_open() || !deserialize(file.data(), file.size(), container) || container.dependencies.empty())
+		{
+			std::cerr << "failed to read " << options.input << '\n';
+			return 2;
+		}
+
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		const uint64_t input_hash = hash_preprocessor_inputs(effect_include_paths(container.dependencies[0].path, options.include_paths), options.macros);
+		const bool up_to_date = is_up_to_date(file.data(), file.size(), input_hash);
+
+		const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+		std::cout << (up_to_date ? "up to date" : "out of date") << " (checked in " << duration.count() << " us)\n";
+
+		return up_to_date ? 0 : 1;
+	}
+	int inspect(const options &options)
+	{
+		const filesystem::mapped_file file(options.input);
+		effect_container container;
+
+		if (!file.is_open() || !deserialize(file.data(), file.size(), container))
+		{
+			std::cerr << "failed to read " << options.input << '\n';
+			return 1;
+		}
+
+		char input_hash[17];
+		std::snprintf(input_hash, sizeof(input_hash), "%016llx", static_cast<unsigned long long>(container.input_hash));
+
+		std::cout << "version " << effect_container::version << ", " << file.size() << " bytes, input hash " << input_hash << '\n';
+		std::cout << "dependencies:\n";
+
+		for (const auto &dependency : container.dependencies)
+		{
+			uint64_t size, modified;
+			const char *status = "unchanged";
+
+			if (!filesystem::file_stamp(dependency.path, size, modified))
+			{
+				status = "missing";
+			}
+			else if (size != dependency.size || modified != dependency.modified)
+			{
+				status = "changed";
+			}
+
+			std::cout << "  " << dependency.path << " (" << dependency.size << " bytes, " << status << ")\n";
+		}
+
+		std::cout << "source: " << container.source.size() << " bytes\n";
+
+		if (!container.backend.empty())
+		{
+			size_t code_size = 0;
+
+			for (const auto &code : container.code)
+			{
+				code_size += code.size();
+			}
+
+			std::cout << "generated by: " << container.backend << '\n';
+			std::cout << "reflection: " << container.reflection.uniforms.size() << " uniforms, " << container.reflection.textures.size() << " textures, "
+			          << container.reflection.samplers.size() << " samplers, " << container.reflection.techniques.size() << " techniques\n";
+			std::cout << "code: " << container.code.size() << " entries, " << code_size << " bytes\n";
+		}
+
+		return 0;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	options options;
+
+	if (argc < 3 || !parse_options(argc, argv, options))
+	{
+		return usage();
+	}
+
+	const std::string command = argv[1];
+
+	if (command == "build")
+	{
+		return build(options);
+	}
+	if (command == "check")
+	{
+		return check(options);
+	}
+	if (command == "inspect")
+	{
+		return inspect(options);
+	}
+
+	return usage();
+}
@@ -0,0 +1,433 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <unordered_map>
+#include <algorithm>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock clock;
+
+	double seconds_since(clock::time_point start)
+	{
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	int usage()
+	{
+		std::cerr <<
+			"usage: glbench [-n <iterations>] [-t <threads>] [-d <calls per thread>] [-c <device contexts per thread>]\n"
+			"\n"
+			"Replays a scripted stream of immediate mode OpenGL calls through hooks shaped like those of the OpenGL runtime, which call through to a stub dispatch table instead of a driver. "
+			"Every thread switches between a few device contexts of its own. "
+			"Compares finding the current runtime through the thread local pointer 'wglMakeCurrent' keeps, with asking for the current device context and probing the runtime map as the hooks did before, with and without the lock that probe needs to be safe. "
+			"The best of all iterations is reported.\n";
+
+		return 2;
+	}
+
+	typedef struct device_context *HDC;
+	typedef unsigned int GLenum;
+	typedef int GLint;
+	typedef int GLsizei;
+	typedef float GLfloat;
+
+	const GLenum GL_TRIANGLES = 0x0004;
+
+	/// <summary>
+	/// Stands in for the OpenGL runtime, of which the hooks only use the draw call statistics.
+	/// </summary>
+	struct stub_runtime
+	{
+		void on_draw_call(unsigned int vertices)
+		{
+			drawcalls += 1;
+			this->vertices += vertices;
+		}
+
+		unsigned int _current_vertex_count = 0;
+		unsigned long long drawcalls = 0, vertices = 0;
+	};
+
+	/// <summary>
+	/// The driver functions the hooks call through to. They are called through pointers like the trampolines are, so that the compiler cannot fold them into the hooks.
+	/// </summary>
+	struct dispatch_table
+	{
+		HDC(*wglGetCurrentDC)();
+		void(*wglMakeCurrent)(HDC hdc);
+		void(*glBegin)(GLenum mode);
+		void(*glVertex3f)(GLfloat x, GLfloat y, GLfloat z);
+		void(*glEnd)();
+		void(*glDrawArrays)(GLenum mode, GLint first, GLsizei count);
+	};
+
+	thread_local HDC t_current_dc = nullptr;
+	thread_local unsigned long long t_driver_calls = 0;
+
+	const dispatch_table s_stub_table = {
+		[]() { return t_current_dc; },
+		[](HDC hdc) { t_driver_calls++; t_current_dc = hdc; },
+		[](GLenum) { t_driver_calls++; },
+		[](GLfloat, GLfloat, GLfloat) { t_driver_calls++; },
+		[]() { t_driver_calls++; },
+		[](GLenum, GLint, GLsizei) { t_driver_calls++; },
+	};
+	const dispatch_table *volatile s_driver = &s_stub_table;
+
+	std::mutex s_mutex;
+	std::unordered_map<HDC, std::shared_ptr<stub_runtime>> s_runtimes;
+	thread_local stub_runtime *t_current_runtime = nullptr;
+
+	/// <summary>
+	/// Calls the driver only, which is what every hook costs at least.
+	/// </summary>
+	struct no_lookup
+	{
+		static stub_runtime *current_runtime()
+		{
+			return nullptr;
+		}
+	};
+	/// <summary>
+	/// Reads the runtime 'wglMakeCurrent' made current on this thread.
+	/// </summary>
+	struct thread_local_lookup
+	{
+		static stub_runtime *current_runtime()
+		{
+			return t_current_runtime;
+		}
+	};
+	/// <summary>
+	/// Asks the driver for the current device context and probes the runtime map without the lock, which races with 'wglMakeCurrent' changing the map on another thread.
+	/// </summary>
+	struct map_lookup
+	{
+		static stub_runtime *current_runtime()
+		{
+			const auto it = s_runtimes.find(s_driver->wglGetCurrentDC());
+
+			return it != s_runtimes.end() ? it->second.get() : nullptr;
+		}
+	};
+	/// <summary>
+	/// The same probe under the lock 'wglMakeCurrent' holds while it changes the map.
+	/// </summary>
+	struct locked_map_lookup
+	{
+		static stub_runtime *current_runtime()
+		{
+			const std::lock_guard<std::mutex> lock(s_mutex);
+
+			return map_lookup::current_runtime();
+		}
+	};
+
+	void hook_wglMakeCurrent(HDC hdc)
+	{
+		s_driver->wglMakeCurrent(hdc);
+
+		const std::lock_guard<std::mutex> lock(s_mutex);
+
+		const auto it = s_runtimes.find(hdc);
+
+		t_current_runtime = it != s_runtimes.end() ? it->second.get() : nullptr;
+	}
+
+	/// <summary>
+	/// The draw call hooks of the OpenGL runtime, with the way they find the current runtime left to <typeparamref name="L"/>.
+	/// </summary>
+	template <typename L>
+	struct hooks
+	{
+		static void glBegin(GLenum mode)
+		{
+			if (const auto runtime = L::current_runtime())
+			{
+				runtime->_current_vertex_count = 0;
+			}
+
+			s_driver->glBegin(mode);
+		}
+		static void glVertex3f(GLfloat x, GLfloat y, GLfloat z)
+		{
+			if (const auto runtime = L::current_runtime())
+			{
+				runtime->_current_vertex_count += 3;
+			}
+
+			s_driver->glVertex3f(x, y, z);
+		}
+		static void glEnd()
+		{
+			s_driver->glEnd();
+
+			if (const auto runtime = L::current_runtime())
+			{
+				runtime->on_draw_call(runtime->_current_vertex_count);
+			}
+		}
+		static void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+		{
+			if (const auto runtime = L::current_runtime())
+			{
+				runtime->on_draw_call(count);
+			}
+
+			s_driver->glDrawArrays(mode, first, count);
+		}
+	};
+
+	enum class gl_function
+	{
+		wglMakeCurrent,
+		glBegin,
+		glVertex3f,
+		glEnd,
+		glDrawArrays,
+	};
+
+	struct gl_call
+	{
+		gl_function function;
+		HDC hdc;
+		GLfloat x, y, z;
+		GLsizei count;
+	};
+
+	// Every batch draws a triangle in immediate mode and another one from a vertex array, the runtime counts 3 vertices per 'glVertex3f' call
+	const unsigned int calls_per_batch = 6, batches_per_context = 64, vertices_per_batch = 3 * 3 + 3;
+
+	/// <summary>
+	/// Script the calls of one thread, which switches to the next of its device contexts every few batches.
+	/// </summary>
+	std::vector<gl_call> script_stream(const std::vector<HDC> &device_contexts, unsigned int batches)
+	{
+		std::vector<gl_call> script;
+		script.reserve(batches * calls_per_batch + batches / batches_per_context + 1);
+
+		for (unsigned int i = 0; i < batches; i++)
+		{
+			if (i % batches_per_context == 0)
+			{
+				script.push_back({ gl_function::wglMakeCurrent, device_contexts[(i / batches_per_context) % device_contexts.size()] });
+			}
+
+			script.push_back({ gl_function::glBegin });
+
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				script.push_back({ gl_function::glVertex3f, nullptr, static_cast<GLfloat>(k), static_cast<GLfloat>(i % 7), 0.5f });
+			}
+
+			script.push_back({ gl_function::glEnd });
+			script.push_back({ gl_function::glDrawArrays, nullptr, 0.0f, 0.0f, 0.0f, 3 });
+		}
+
+		return script;
+	}
+
+	template <typename L>
+	void replay(const std::vector<gl_call> &script)
+	{
+		for (const gl_call &call : script)
+		{
+			switch (call.function)
+			{
+			case gl_function::wglMakeCurrent:
+				hook_wglMakeCurrent(call.hdc);
+				break;
+			case gl_function::glBegin:
+				hooks<L>::glBegin(GL_TRIANGLES);
+				break;
+			case gl_function::glVertex3f:
+				hooks<L>::glVertex3f(call.x, call.y, call.z);
+				break;
+			case gl_function::glEnd:
+				hooks<L>::glEnd();
+				break;
+			case gl_function::glDrawArrays:
+				hooks<L>::glDrawArrays(GL_TRIANGLES, 0, call.count);
+				break;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Replay the scripts of all threads at once.
+	/// </summary>
+	/// <returns>The seconds it took to replay all scripts.</returns>
+	template <typename L>
+	double run(const std::vector<std::vector<gl_call>> &scripts, unsigned long long &driver_calls)
+	{
+		std::vector<std::thread> workers;
+		std::atomic<unsigned long long> calls(0);
+		std::atomic<bool> go(false);
+
+		for (const auto &script : scripts)
+		{
+			workers.emplace_back([&]() {
+				while (!go.load())
+				{
+					std::this_thread::yield();
+				}
+
+				t_driver_calls = 0;
+
+				replay<L>(script);
+
+				calls += t_driver_calls;
+			});
+		}
+
+		const auto start = clock::now();
+		go = true;
+
+		for (auto &worker : workers)
+		{
+			worker.join();
+		}
+
+		const double seconds = seconds_since(start);
+
+		driver_calls = calls.load();
+
+		return seconds;
+	}
+
+	void print(const char *name, unsigned long long calls, double seconds)
+	{
+		std::printf("%-24s %12llu calls %10.2f ms %10.2f ns/call\n", name, calls, seconds * 1000.0, seconds * 1000000000.0 / calls);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int iterations = 5, threads = 1, calls = 6000000, contexts = 4;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "-n" && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (arg == "-t" && i + 1 < argc)
+		{
+			threads = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (arg == "-d" && i + 1 < argc)
+		{
+			calls = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (arg == "-c" && i + 1 < argc)
+		{
+			contexts = std::max(1, std::atoi(argv[++i]));
+		}
+		else
+		{
+			return usage();
+		}
+	}
+
+	const unsigned int batches = std::max(1u, calls / calls_per_batch);
+
+	std::vector<std::vector<HDC>> device_contexts(threads);
+	std::vector<std::vector<gl_call>> scripts;
+
+	for (unsigned int t = 0; t < threads; t++)
+	{
+		for (unsigned int i = 0; i < contexts; i++)
+		{
+			device_contexts[t].push_back(reinterpret_cast<HDC>(static_cast<uintptr_t>(0x10000 + (t * contexts + i) * 0x100)));
+		}
+
+		scripts.push_back(script_stream(device_contexts[t], batches));
+	}
+
+	unsigned long long expected_calls = 0;
+
+	for (const auto &script : scripts)
+	{
+		expected_calls += script.size();
+	}
+
+	const unsigned long long expected_drawcalls = 2ull * batches * threads, expected_vertices = static_cast<unsigned long long>(vertices_per_batch) * batches * threads;
+
+	double seconds[4] = { };
+	const char *const names[4] = { "stub dispatch table", "thread local runtime", "unlocked map probe", "locked map probe" };
+
+	for (unsigned int i = 0; i < iterations; i++)
+	{
+		for (unsigned int variant = 0; variant < 4; variant++)
+		{
+			s_runtimes.clear();
+
+			for (const auto &thread_device_contexts : device_contexts)
+			{
+				for (HDC hdc : thread_device_contexts)
+				{
+					s_runtimes.emplace(hdc, std::make_shared<stub_runtime>());
+				}
+			}
+
+			unsigned long long driver_calls = 0;
+			double variant_seconds = 0.0;
+
+			switch (variant)
+			{
+			case 0:
+				variant_seconds = run<no_lookup>(scripts, driver_calls);
+				break;
+			case 1:
+				variant_seconds = run<thread_local_lookup>(scripts, driver_calls);
+				break;
+			case 2:
+				variant_seconds = run<map_lookup>(scripts, driver_calls);
+				break;
+			case 3:
+				variant_seconds = run<locked_map_lookup>(scripts, driver_calls);
+				break;
+			}
+
+			seconds[variant] = i == 0 ? variant_seconds : std::min(seconds[variant], variant_seconds);
+
+			unsigned long long drawcalls = 0, vertices = 0;
+
+			for (const auto &runtime : s_runtimes)
+			{
+				drawcalls += runtime.second->drawcalls;
+				vertices += runtime.second->vertices;
+			}
+
+			// Every call reaches the driver, and every lookup that finds the runtime counts the same draw calls
+			if (driver_calls != expected_calls || (variant != 0 && (drawcalls != expected_drawcalls || vertices != expected_vertices)))
+			{
+				std::cerr << "the " << names[variant] << " passed " << driver_calls << " calls to the driver and counted " << drawcalls << " draw calls with " << vertices << " vertices, expected " << expected_calls << " calls and " << expected_drawcalls << " draw calls with " << expected_vertices << " vertices\n";
+				return 1;
+			}
+		}
+	}
+
+	for (unsigned int variant = 0; variant < 4; variant++)
+	{
+		print(names[variant], expected_calls, seconds[variant]);
+	}
+
+	return 0;
+}
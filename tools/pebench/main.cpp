@@ -0,0 +1,172 @@
+/**
+ * Copyright (C) 2014 Patrick Mours. All rights reserved.
+ * License: https://github.com/crosire/reshade#license
+ */
+
+#include "pe_exports.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+
+using namespace reshade;
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock clock;
+
+	double seconds_since(clock::time_point start)
+	{
+		return std::chrono::duration<double>(clock::now() - start).count();
+	}
+
+	int usage()
+	{
+		std::cerr <<
+			"usage: pebench [-n <iterations>] <target image> <replacement image>\n"
+			"\n"
+			"Measures parsing the export tables of two PE images as read from disk and matching them by name, once with a merge of the sorted tables and once with a search through the replacement exports for every target export. The best of all iterations is reported.\n";
+
+		return 2;
+	}
+
+	bool read_image(const char *path, std::vector<uint8_t> &image)
+	{
+		std::ifstream file(path, std::ios::binary);
+
+		if (!file)
+		{
+			std::cerr << "failed to open " << path << '\n';
+			return false;
+		}
+
+		image.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+		return true;
+	}
+
+	/// <summary>
+	/// The matching the hook installation did before the export tables were merged, kept as the baseline.
+	/// </summary>
+	std::vector<std::pair<size_t, size_t>> match_exports_by_search(const std::vector<pe::export_symbol> &target, const std::vector<pe::export_symbol> &replacement)
+	{
+		std::vector<std::pair<size_t, size_t>> matches;
+
+		for (size_t i = 0; i < target.size(); i++)
+		{
+			const auto it = std::find_if(replacement.cbegin(), replacement.cend(),
+				[&symbol = target[i]](const pe::export_symbol &moduleexport) {
+					return std::strcmp(moduleexport.name, symbol.name) == 0;
+				});
+
+			if (it != replacement.cend())
+			{
+				matches.emplace_back(i, it - replacement.cbegin());
+			}
+		}
+
+		return matches;
+	}
+
+	void print(const char *name, size_t count, double seconds)
+	{
+		std::printf("%-24s %10zu exports %10.2f us\n", name, count, seconds * 1000000.0);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int iterations = 1000;
+	std::vector<const char *> paths;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+
+		if (arg == "-n" && i + 1 < argc)
+		{
+			iterations = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (!arg.empty() && arg[0] == '-')
+		{
+			return usage();
+		}
+		else
+		{
+			paths.push_back(argv[i]);
+		}
+	}
+
+	if (paths.size() != 2)
+	{
+		return usage();
+	}
+
+	std::vector<uint8_t> target_image, replacement_image;
+
+	if (!read_image(paths[0], target_image) || !read_image(paths[1], replacement_image))
+	{
+		return 1;
+	}
+
+	std::vector<pe::export_symbol> target, replacement;
+	std::vector<std::pair<size_t, size_t>> merged, searched;
+	double parse_target_seconds = 0.0, parse_replacement_seconds = 0.0, merge_seconds = 0.0, search_seconds = 0.0;
+
+	for (unsigned int i = 0; i < iterations; i++)
+	{
+		auto start = clock::now();
+
+		if (!pe::get_exports(target_image.data(), target_image.size(), pe::image_layout::file, target))
+		{
+			std::cerr << paths[0] << " is not a valid image\n";
+			return 1;
+		}
+
+		double seconds = seconds_since(start);
+		parse_target_seconds = i == 0 ? seconds : std::min(parse_target_seconds, seconds);
+
+		start = clock::now();
+
+		if (!pe::get_exports(replacement_image.data(), replacement_image.size(), pe::image_layout::file, replacement))
+		{
+			std::cerr << paths[1] << " is not a valid image\n";
+			return 1;
+		}
+
+		seconds = seconds_since(start);
+		parse_replacement_seconds = i == 0 ? seconds : std::min(parse_replacement_seconds, seconds);
+
+		start = clock::now();
+
+		merged = pe::match_exports(target, replacement);
+
+		seconds = seconds_since(start);
+		merge_seconds = i == 0 ? seconds : std::min(merge_seconds, seconds);
+
+		start = clock::now();
+
+		searched = match_exports_by_search(target, replacement);
+
+		seconds = seconds_since(start);
+		search_seconds = i == 0 ? seconds : std::min(search_seconds, seconds);
+	}
+
+	// Both tables are sorted and names are unique, so both matchers have to find the same pairs in the same order
+	if (merged != searched)
+	{
+		std::cerr << "the merge found " << merged.size() << " matches, the search " << searched.size() << '\n';
+		return 1;
+	}
+
+	print("parse target", target.size(), parse_target_seconds);
+	print("parse replacement", replacement.size(), parse_replacement_seconds);
+	print("match by merge", merged.size(), merge_seconds);
+	print("match by search", searched.size(), search_seconds);
+
+	return 0;
+}